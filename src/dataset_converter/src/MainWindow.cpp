@@ -6,6 +6,8 @@
 #include <QDoubleSpinBox>
 #include <QSettings>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QtConcurrent/QtConcurrent>
 #include <QGraphicsBlurEffect>
 
 #include "worker/DatasetParser.h"
@@ -44,11 +46,30 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Setup visualization manager
     this->m_scenarioVisualization = new ScenarioVisualization(this->ui->canvas, this);
-    this->m_laneletVisualisation = new LaneletVisualisation(this->ui->canvas, this);
+    this->m_laneletRegistry = std::make_shared<LaneletElementRegistry>();
+    this->m_laneletSnapshotTracker = new LaneletSnapshotTracker(this->m_laneletRegistry, this);
+    this->m_laneletAutosave = new LaneletAutosave(this->m_laneletSnapshotTracker, this);
+    this->m_laneletValidator = new LaneletValidator(this->m_laneletSnapshotTracker, this);
+    this->m_laneletAutosave->setScaleFactor(this->m_scenarioVisualization->scaleFactor());
+    this->m_laneletVisualisation = new LaneletVisualisation(this->ui->canvas, this->m_laneletRegistry, this);
+    this->m_sceneExporter = new SceneExporter(this->ui->canvas->scene(), this);
+    this->m_regionOfInterestLayer = new RegionOfInterestLayer(this->ui->canvas->scene(), this);
+    this->m_placementWatcher = new QFutureWatcher<PlacementSearch>(this);
+    connect(this->m_placementWatcher, &QFutureWatcher<PlacementSearch>::finished,
+            this, &MainWindow::onPlacementsFound);
+    this->m_laneWatcher = new QFutureWatcher<std::vector<dataset_converter_common::ExtractedLane>>(this);
+    connect(this->m_laneWatcher, &QFutureWatcher<std::vector<dataset_converter_common::ExtractedLane>>::finished,
+            this, &MainWindow::onLanesExtracted);
+    connect(this->m_sceneExporter, &SceneExporter::error, this, &MainWindow::onErrorDuringLoading);
 
     // Setup graphics view handler
     this->m_graphicsViewZoomHandler = new GraphicsViewZoomHandler(this->ui->canvas);
     this->m_graphicsViewClickHandler = new GraphicsViewClickHandler(this->ui->canvas);
+    this->m_graphicsViewClickHandler->setSpatialIndex(this->m_laneletVisualisation->spatialIndex());
+    connect(this->m_graphicsViewZoomHandler, &GraphicsViewZoomHandler::zoomed, this, [this]()
+    {
+        this->m_laneletVisualisation->setLevelOfDetail(this->m_graphicsViewZoomHandler->levelOfDetail());
+    });
 
     // Setup tool button
     this->ui->buttonGroup->setId(this->ui->btn_selection, static_cast<int>(EditorMode::SELECT));
@@ -56,6 +77,7 @@ MainWindow::MainWindow(QWidget *parent)
     this->ui->buttonGroup->setId(this->ui->btn_add_path, static_cast<int>(EditorMode::WAY_TOOL));
     this->ui->buttonGroup->setId(this->ui->btn_add_lanelet,
                                  static_cast<int>(EditorMode::LANELET_TOOL));
+    this->ui->buttonGroup->setId(this->ui->btn_region, static_cast<int>(EditorMode::REGION_TOOL));
     connect(this->ui->buttonGroup, &QButtonGroup::idClicked, this,
             &MainWindow::onToolSelectionChanged);
 
@@ -64,10 +86,29 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Setup save scenario dialog
     this->m_saveScenarioDialog = new SaveScenarioDialog(this);
+    this->m_frameWindowAnalysis = new FrameWindowAnalysis(this);
+    connect(this->m_frameWindowAnalysis, &FrameWindowAnalysis::countsChanged, this->m_saveScenarioDialog,
+            &SaveScenarioDialog::setFrameCounts);
+    connect(this->m_saveScenarioDialog, &SaveScenarioDialog::frameRangeChanged, this->m_frameWindowAnalysis,
+            &FrameWindowAnalysis::setFrameRange);
+    connect(this->m_regionOfInterestLayer, &RegionOfInterestLayer::regionChanged, this->m_saveScenarioDialog,
+            &SaveScenarioDialog::setRegionDefined);
+    connect(this->m_frameWindowAnalysis, &FrameWindowAnalysis::retentionChanged, this,
+            [this](const dataset_converter_common::Retention &retention)
+            {
+                this->ui->lbl_retained->setText(QString("%1 / %2 objects, %3 / %4 states")
+                                                    .arg(retention.objects).arg(retention.total_objects)
+                                                    .arg(retention.states).arg(retention.total_states));
+            });
 
     // Setup save scenario dialog
     this->m_loadScenarioDialog = new LoadScenarioDialog(this);
 
+    // Setup scenario search dialog
+    this->m_scenarioSearchDialog = new ScenarioSearchDialog(this);
+    connect(this->m_scenarioSearchDialog, &ScenarioSearchDialog::matchActivated, this,
+            &MainWindow::onScenarioSearchMatchActivated);
+
     // Setup input methods
     connect(this->ui->spinner_shift_x, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
             this->m_scenarioVisualization, &ScenarioVisualization::setScenarioShiftX);
@@ -75,6 +116,18 @@ MainWindow::MainWindow(QWidget *parent)
             this->m_scenarioVisualization, &ScenarioVisualization::setScenarioShiftY);
     connect(this->ui->spinner_rotation, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
             this->m_scenarioVisualization, &ScenarioVisualization::setScenarioRotation);
+    auto updateFrameWindowAnalysis = [this]()
+    {
+        this->m_frameWindowAnalysis->setTransformation(this->ui->spinner_shift_x->value(),
+                                                       this->ui->spinner_shift_y->value(),
+                                                       this->ui->spinner_rotation->value());
+    };
+    connect(this->ui->spinner_shift_x, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+            updateFrameWindowAnalysis);
+    connect(this->ui->spinner_shift_y, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+            updateFrameWindowAnalysis);
+    connect(this->ui->spinner_rotation, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+            updateFrameWindowAnalysis);
 
     connect(this->ui->btn_skip_forward, &QToolButton::pressed, this,
             &MainWindow::onSkipFramesForward);
@@ -114,6 +167,10 @@ MainWindow::MainWindow(QWidget *parent)
             &MainWindow::onSaveLaneletMapDialogRequested);
     connect(this->ui->action_export_as_svg, &QAction::triggered, this,
             &MainWindow::onExportLaneletMapDialogRequested);
+    connect(this->ui->action_suggest_placement, &QAction::triggered, this,
+            &MainWindow::onSuggestPlacementRequested);
+    connect(this->ui->action_search_scenarios, &QAction::triggered, this,
+            &MainWindow::onScenarioSearchDialogRequested);
     connect(this->ui->action_quit, &QAction::triggered, this, &MainWindow::close);
     connect(this->ui->action_node_tool, &QAction::triggered, this->ui->btn_add_node,
             &QToolButton::animateClick);
@@ -131,6 +188,14 @@ MainWindow::MainWindow(QWidget *parent)
             &MainWindow::onLoadTransformationDialogRequested);
     connect(this->ui->action_save_scenario, &QAction::triggered, this,
             &MainWindow::onSaveScenarioDialogRequested);
+    connect(this->ui->action_show_trails, &QAction::toggled, this->m_scenarioVisualization,
+            &ScenarioVisualization::setTrajectoryTrailsVisible);
+    connect(this->ui->action_show_heatmap, &QAction::toggled, this->m_scenarioVisualization,
+            &ScenarioVisualization::setOccupancyHeatmapVisible);
+    for (auto action : {this->ui->action_heatmap_cars, this->ui->action_heatmap_vulnerable,
+                        this->ui->action_heatmap_heavy, this->ui->action_heatmap_other}) {
+        connect(action, &QAction::toggled, this, &MainWindow::onHeatmapTypesChanged);
+    }
 
     // Setup dataset parser
     m_datasetParser = new DatasetParser();
@@ -143,14 +208,23 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_datasetParser, &DatasetParser::error, this, &MainWindow::onErrorDuringLoading);
 
     // Setup lanelet parser
-    m_laneletHandler = new LaneletHandler();
+    m_laneletHandler = new LaneletHandler(this->m_laneletRegistry);
     m_laneletHandler->moveToThread(&this->m_workerThread);
     connect(&m_workerThread, &QThread::finished, m_laneletHandler, &QObject::deleteLater);
     connect(this, &MainWindow::requestLaneletMap, m_laneletHandler, &LaneletHandler::parseLanelet);
     connect(this, &MainWindow::storeLaneletMap, m_laneletHandler, &LaneletHandler::writeLanelet);
-    connect(this, &MainWindow::exportLaneletMap, m_laneletHandler,
-            &LaneletHandler::writeLaneletImage);
-    connect(m_laneletHandler, &LaneletHandler::loaded, this, &MainWindow::onLaneletMapLoaded);
+    connect(this, &MainWindow::addLaneletCandidates, m_laneletHandler, &LaneletHandler::addLaneletCandidates);
+    connect(m_laneletHandler, &LaneletHandler::nodesAdded, this->m_laneletVisualisation,
+            &LaneletVisualisation::visualizeNodes);
+    connect(m_laneletHandler, &LaneletHandler::waysAdded, this->m_laneletVisualisation,
+            &LaneletVisualisation::visualizeWays);
+    connect(m_laneletHandler, &LaneletHandler::laneletsAdded, this->m_laneletVisualisation,
+            &LaneletVisualisation::visualizeLanelets);
+    connect(m_laneletHandler, &LaneletHandler::loaded, this->m_laneletVisualisation,
+            &LaneletVisualisation::finishPopulation);
+    connect(this->m_laneletVisualisation, &LaneletVisualisation::populationProgress, this,
+            &MainWindow::onProgressDuringLoading);
+    connect(this->m_laneletVisualisation, &LaneletVisualisation::populated, this, &MainWindow::onLaneletMapLoaded);
     connect(m_laneletHandler, &LaneletHandler::progress, this,
             &MainWindow::onProgressDuringLoading);
     connect(m_laneletHandler, &LaneletHandler::error, this, &MainWindow::onErrorDuringLoading);
@@ -165,7 +239,18 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_scenarioHandler, &ScenarioHandler::loaded, this, &MainWindow::onScenarioLoaded);
     connect(m_scenarioHandler, &ScenarioHandler::progress, this, &MainWindow::onProgressDuringLoading);
     connect(m_scenarioHandler, &ScenarioHandler::error, this, &MainWindow::onErrorDuringLoading);
+    connect(m_scenarioHandler, &ScenarioHandler::warning, this, &MainWindow::onWarningDuringStoring);
     // Add new
+    connect(this->m_graphicsViewClickHandler, &GraphicsViewClickHandler::requestAddRegionVertex,
+            this->m_regionOfInterestLayer, &RegionOfInterestLayer::addVertex);
+    connect(this->m_graphicsViewClickHandler, &GraphicsViewClickHandler::requestNewRegionPolygon,
+            this->m_regionOfInterestLayer, &RegionOfInterestLayer::newPolygon);
+    connect(this->m_graphicsViewClickHandler, &GraphicsViewClickHandler::requestRemoveRegionVertex,
+            this->m_regionOfInterestLayer, &RegionOfInterestLayer::removeLastVertex);
+    connect(this->m_graphicsViewClickHandler, &GraphicsViewClickHandler::requestClearRegion,
+            this->m_regionOfInterestLayer, &RegionOfInterestLayer::clear);
+    connect(this->m_graphicsViewClickHandler, &GraphicsViewClickHandler::requestRegionFromLanelets, this,
+            &MainWindow::onRegionFromLaneletsRequested);
     connect(this->m_graphicsViewClickHandler, &GraphicsViewClickHandler::requestAddNode,
             this->m_laneletHandler, &LaneletHandler::addNode);
     connect(m_laneletHandler, &LaneletHandler::nodeAdded, this->m_laneletVisualisation,
@@ -193,22 +278,32 @@ MainWindow::MainWindow(QWidget *parent)
             &GraphicsViewClickHandler::actionToRemoveNodeTriggered);
     connect(this->m_graphicsViewClickHandler, &GraphicsViewClickHandler::requestRemoveNode,
             this->m_laneletVisualisation, &LaneletVisualisation::removeNode);
-    connect(this->m_laneletVisualisation, &LaneletVisualisation::nodeRemovedFromVisualisation,
-            this->m_laneletHandler, &LaneletHandler::removeNode);
 
     connect(this->ui->action_delete_way, &QAction::triggered, this->m_graphicsViewClickHandler,
             &GraphicsViewClickHandler::actionToRemoveWayTriggered);
     connect(this->m_graphicsViewClickHandler, &GraphicsViewClickHandler::requestRemoveWay,
             this->m_laneletVisualisation, &LaneletVisualisation::removeWay);
-    connect(this->m_laneletVisualisation, &LaneletVisualisation::wayRemovedFromVisualisation,
-            this->m_laneletHandler, &LaneletHandler::removeWay);
 
     connect(this->ui->action_delete_lanelet, &QAction::triggered, this->m_graphicsViewClickHandler,
             &GraphicsViewClickHandler::actionToRemoveLaneletTriggered);
     connect(this->m_graphicsViewClickHandler, &GraphicsViewClickHandler::requestRemoveLanelet,
             this->m_laneletVisualisation, &LaneletVisualisation::removeLanelet);
-    connect(this->m_laneletVisualisation, &LaneletVisualisation::laneletRemovedFromVisualisation,
-            this->m_laneletHandler, &LaneletHandler::removeLanelet);
+
+    connect(this->ui->action_delete_selection, &QAction::triggered, this->m_laneletVisualisation,
+            &LaneletVisualisation::removeSelection);
+    connect(this->ui->action_snap_to_nodes, &QAction::toggled, this->m_laneletVisualisation,
+            &LaneletVisualisation::setSnapToNodes);
+    connect(this->ui->action_validate_map, &QAction::toggled, this->m_laneletValidator,
+            &LaneletValidator::setEnabled);
+    connect(this->m_laneletValidator, &LaneletValidator::issuesChanged, this->m_laneletVisualisation,
+            &LaneletVisualisation::setIssues);
+    connect(this->ui->action_repair_map, &QAction::triggered, this, [this]()
+    {
+        this->m_laneletVisualisation->repairIssues(this->m_laneletValidator->issues());
+    });
+    connect(this->ui->action_generate_lanelets, &QAction::triggered, this, &MainWindow::onGenerateLaneletsRequested);
+    connect(this->m_laneletVisualisation, &LaneletVisualisation::elementsRemovedFromVisualisation,
+            this->m_laneletHandler, &LaneletHandler::removeElements);
 
     // Enable disable
     connect(this->m_graphicsViewClickHandler, &GraphicsViewClickHandler::selectedLaneletChanged,
@@ -241,11 +336,37 @@ MainWindow::MainWindow(QWidget *parent)
     // Move window to last position and restore full screen state
     this->restoreWindowStates();
 }
+void MainWindow::onHeatmapTypesChanged()
+{
+    using dataset_converter_common::OccupancyHistogram;
+    auto bit = [](cpm_scenario::ExtendedObjectType type)
+    {
+        return 1u << OccupancyHistogram::TypeIndex(type);
+    };
+    uint32_t typeMask = 0;
+    if (this->ui->action_heatmap_cars->isChecked()) {
+        typeMask |= bit(cpm_scenario::ExtendedObjectType::CAR);
+    }
+    if (this->ui->action_heatmap_vulnerable->isChecked()) {
+        typeMask |= bit(cpm_scenario::ExtendedObjectType::PEDESTRIAN)
+            | bit(cpm_scenario::ExtendedObjectType::BICYCLE_MOTORCYCLES);
+    }
+    if (this->ui->action_heatmap_heavy->isChecked()) {
+        typeMask |= bit(cpm_scenario::ExtendedObjectType::TRUCK_BUS)
+            | bit(cpm_scenario::ExtendedObjectType::TRAILER);
+    }
+    if (this->ui->action_heatmap_other->isChecked()) {
+        typeMask |= bit(cpm_scenario::ExtendedObjectType::VAN) | bit(cpm_scenario::ExtendedObjectType::UNKNOWN);
+    }
+    this->m_scenarioVisualization->setOccupancyHeatmapTypeMask(typeMask);
+}
 MainWindow::~MainWindow()
 {
     // Make sure that worker thread
     this->m_workerThread.quit();
     this->m_workerThread.wait();
+    this->m_placementWatcher->waitForFinished();
+    this->m_laneWatcher->waitForFinished();
     QMainWindow::~QMainWindow();
 }
 
@@ -275,6 +396,7 @@ void MainWindow::onLoadDatasetDialogRequested()
     // Extract data from dialog
     QString datasetName = this->m_loadDatasetDialog->datasetName();
     QDir datasetRootDirectoryPath = this->m_loadDatasetDialog->datasetRootDirectory();
+    qreal smoothingWindow = this->m_loadDatasetDialog->smoothingWindow();
 
     // Check if directory is valid and exists
     if (!datasetRootDirectoryPath.exists()) {
@@ -291,7 +413,7 @@ void MainWindow::onLoadDatasetDialogRequested()
     this->m_progressDialog->show();
 
     // Request dataset from worker thread
-    emit requestDataset(datasetName, datasetRootDirectoryPath.absolutePath());
+    emit requestDataset(datasetName, datasetRootDirectoryPath.absolutePath(), smoothingWindow);
 }
 void MainWindow::onLoadScenarioDialogRequested()
 {
@@ -366,6 +488,10 @@ void MainWindow::onLoadLaneletMapDialogRequested()
     this->m_progressDialog->setValue(0);
     this->m_progressDialog->show();
 
+    // Autosave next to the opened map
+    this->m_laneletAutosave->setFileName(file.absoluteFilePath() + ".autosave.osm");
+    this->m_laneletAutosave->setScaleFactor(this->m_scenarioVisualization->scaleFactor());
+
     // Request lanelet map form worker thread
     emit requestLaneletMap(file.absoluteFilePath(), this->m_scenarioVisualization->scaleFactor());
 }
@@ -403,8 +529,13 @@ void MainWindow::onSaveLaneletMapDialogRequested()
     // Get file information from dialog
     QFileInfo file(dialog.selectedFiles().first());
 
-    // Advise worker to write data
-    emit storeLaneletMap(file.absoluteFilePath(), this->m_scenarioVisualization->scaleFactor());
+    // Autosave next to the stored map
+    this->m_laneletAutosave->setFileName(file.absoluteFilePath() + ".autosave.osm");
+    this->m_laneletAutosave->setScaleFactor(this->m_scenarioVisualization->scaleFactor());
+
+    // Advise worker to write data, the snapshot decouples it from the items edited in the gui
+    emit storeLaneletMap(file.absoluteFilePath(), this->m_laneletSnapshotTracker->snapshot(),
+                         this->m_scenarioVisualization->scaleFactor());
 }
 void MainWindow::onSaveScenarioDialogRequested()
 {
@@ -417,6 +548,14 @@ void MainWindow::onSaveScenarioDialogRequested()
     auto fromFrame = this->m_saveScenarioDialog->fromFrame();
     auto scenarioName = this->m_saveScenarioDialog->scenarioName();
     auto exportFullTrajectories = this->m_saveScenarioDialog->exportFullTrajectories();
+    auto framesPerSecond = this->m_framesPerSecond.value(this->m_scenarioVisualization->scenario().get(), 0.0);
+    auto abortOnCollision = this->m_saveScenarioDialog->abortOnCollision();
+
+    // The region is drawn in the scene, the export works in scenario meters
+    QList<QPolygonF> region;
+    for (const auto &polygon : this->m_regionOfInterestLayer->polygons()) {
+        region.push_back(this->m_scenarioVisualization->mapToScenario(polygon));
+    }
 
     qDebug() << filePath;
 
@@ -428,16 +567,62 @@ void MainWindow::onSaveScenarioDialogRequested()
         return;
     }
 
+    // Trajectories are matched to the lanelets in the worker, the map is copied here as the items live in this thread
+    dataset_converter_common::MapMatcherPtr mapMatcher;
+    QList<qint64> lanelets;
+    auto mapLanelets = this->laneletsInScenario();
+    if (!mapLanelets.empty()) {
+        mapMatcher = std::make_shared<const dataset_converter_common::MapMatcher>(mapLanelets);
+        if (this->m_saveScenarioDialog->onlySelectedLanelets()) {
+            for (auto item : this->ui->canvas->scene()->selectedItems()) {
+                if (auto lanelet = qgraphicsitem_cast<LaneletItem *>(item)) {
+                    lanelets.push_back(this->m_laneletRegistry->id(lanelet));
+                }
+            }
+        }
+    }
+    if (this->m_saveScenarioDialog->onlySelectedLanelets() && lanelets.empty()) {
+        ErrorDialog messageBox(this, "No lanelet selected. Select the lanelets the exported objects have to use or "
+                                     "export all objects.");
+        messageBox.exec();
+        return;
+    }
+
     // Make progress dialog
     this->m_progressDialog->setLabelText("<html><b>Loading dataset please wait.</b><br>You may not "
                                          "cancel the loading process.</html>");
     this->m_progressDialog->setValue(0);
     this->m_progressDialog->show();
 
-
     // Request dataset from worker thread
-    emit storeScenario(scenarioName, filePath, fromFrame, toFrame, exportFullTrajectories);
+    this->m_storeWarning.clear();
+    emit storeScenario(scenarioName, filePath, fromFrame, toFrame, exportFullTrajectories, framesPerSecond,
+                       abortOnCollision, region, mapMatcher, lanelets);
+}
+std::vector<dataset_converter_common::MapLanelet> MainWindow::laneletsInScenario() const
+{
+    std::vector<dataset_converter_common::MapLanelet> mapLanelets;
+    QMutexLocker locker(this->m_laneletRegistry->mutex());
+    for (auto lanelet : this->m_laneletRegistry->lanelets()) {
+        auto outline = lanelet->computeOutline();
+        if (!outline.valid) continue;
+
+        // The outline is the left way followed by the right way against the driving direction
+        auto polygon = this->m_scenarioVisualization->mapToScenario(lanelet->mapToScene(outline.polygon));
+        int leftSize = lanelet->leftWayItem()->nodes().size();
+        dataset_converter_common::MapLanelet mapLanelet;
+        mapLanelet.id = static_cast<long>(this->m_laneletRegistry->id(lanelet));
+        for (int i = 0; i < leftSize && i < polygon.size(); ++i) {
+            mapLanelet.left.emplace_back(polygon[i].x(), polygon[i].y());
+        }
+        for (int i = polygon.size() - 1; i >= leftSize; --i) {
+            mapLanelet.right.emplace_back(polygon[i].x(), polygon[i].y());
+        }
+        mapLanelets.push_back(std::move(mapLanelet));
+    }
+    return mapLanelets;
 }
+
 void MainWindow::updateInformationForSaveScenarioDialog()
 {
     auto scenario = m_scenarioVisualization->scenario();
@@ -457,8 +642,8 @@ void MainWindow::onExportLaneletMapDialogRequested()
     QFileDialog dialog(this);
     dialog.setViewMode(QFileDialog::Detail);
     dialog.setAcceptMode(QFileDialog::AcceptSave);
-    dialog.setNameFilter("*.svg");
-    dialog.selectNameFilter("*.svg");
+    dialog.setNameFilters({"SVG (*.svg)", "PDF (*.pdf)", "PNG (*.png)"});
+    dialog.selectNameFilter("SVG (*.svg)");
     dialog.selectFile(QDir::homePath() + "/Lanelet.svg");
 
     auto currentScenario = this->m_scenarioVisualization->scenario();
@@ -482,11 +667,22 @@ void MainWindow::onExportLaneletMapDialogRequested()
     if (!dialog.exec())
         return;
 
-    // Get file information from dialog
+    // Get file information from dialog, the suffix selects the format
     QFileInfo file(dialog.selectedFiles().first());
+    if (file.suffix().isEmpty()) {
+        QString suffix = dialog.selectedNameFilter().section("*", 1).chopped(1);
+        file.setFile(file.absoluteFilePath() + suffix);
+    }
 
-    // Advise worker to write data
-    emit exportLaneletMap(file.absoluteFilePath(), this->ui->canvas->scene());
+    // Ask for the resolution, vector formats keep it as physical size
+    bool ok;
+    int dpi = QInputDialog::getInt(this, "Export Resolution", "Dots per inch:", 96, 24, 2400, 1, &ok);
+    if (!ok)
+        return;
+
+    // The scene is recorded now and written in the background
+    if (!this->m_sceneExporter->exportScene(file.absoluteFilePath(), dpi))
+        this->onErrorDuringLoading("The previous export is still running.");
 }
 void MainWindow::onSaveTransformationDialogRequested()
 {
@@ -529,6 +725,136 @@ void MainWindow::onSaveTransformationDialogRequested()
     transformationSettings.setValue("alpha_scenario", this->ui->slider_alpha_scenario->value());
     transformationSettings.setValue("alpha_background", this->ui->slider_alpha_background->value());
 }
+void MainWindow::onSuggestPlacementRequested()
+{
+    auto scenario = this->m_scenarioVisualization->scenario();
+    if (!scenario || this->m_placementWatcher->isRunning())
+        return;
+
+    // Use the frame range chosen for the export if there is one
+    size_t fromFrame = 0;
+    size_t toFrame = 0;
+    if (this->m_saveScenarioDialog->toFrame() > this->m_saveScenarioDialog->fromFrame()) {
+        fromFrame = this->m_saveScenarioDialog->fromFrame();
+        toFrame = this->m_saveScenarioDialog->toFrame();
+    }
+
+    this->m_progressDialog->setLabelText("<html><b>Searching placements please wait.</b></html>");
+    this->m_progressDialog->setValue(0);
+    this->m_progressDialog->show();
+
+    this->m_placementScenario = scenario;
+    this->m_placementWatcher->setFuture(QtConcurrent::run([scenario, fromFrame, toFrame]()
+    {
+        dataset_converter_common::PlacementOptimizer optimizer(scenario, fromFrame, toFrame);
+        return PlacementSearch{optimizer.FindBest(5), optimizer.GetTotal()};
+    }));
+}
+void MainWindow::onGenerateLaneletsRequested()
+{
+    auto scenario = this->m_scenarioVisualization->scenario();
+    if (!scenario || this->m_laneWatcher->isRunning())
+        return;
+
+    this->m_progressDialog->setLabelText("<html><b>Searching lanes please wait.</b></html>");
+    this->m_progressDialog->setValue(0);
+    this->m_progressDialog->show();
+
+    // Lanes are searched within the lab after the current transformation
+    double scaleFactor = this->m_scenarioVisualization->scaleFactor();
+    double shiftX = this->m_scenarioVisualization->scenarioShiftX() / scaleFactor;
+    double shiftY = this->m_scenarioVisualization->scenarioShiftY() / scaleFactor;
+    double rotation = this->m_scenarioVisualization->scenarioRotation();
+    this->m_laneWatcher->setFuture(QtConcurrent::run([scenario, shiftX, shiftY, rotation]()
+    {
+        dataset_converter_common::LaneExtractor extractor(scenario, shiftX, shiftY, rotation,
+                                                          dataset_converter_common::PlacementOptimizer::LabBounds());
+        return extractor.GetLanes();
+    }));
+}
+void MainWindow::onLanesExtracted()
+{
+    auto lanes = this->m_laneWatcher->result();
+    if (lanes.empty()) {
+        this->m_progressDialog->close();
+        this->onErrorDuringLoading("No lanes were found in the trajectories inside the lab.");
+        return;
+    }
+
+    // Transformed scenario meters only differ from the scene by the scale factor
+    double scaleFactor = this->m_scenarioVisualization->scaleFactor();
+    auto toScene = [scaleFactor](const std::vector<Eigen::Vector2d> &bound)
+    {
+        QPolygonF polygon;
+        for (const auto &point : bound) {
+            polygon << QPointF(point.x(), point.y()) * scaleFactor;
+        }
+        return polygon;
+    };
+    QList<QPolygonF> leftBounds;
+    QList<QPolygonF> rightBounds;
+    for (const auto &lane : lanes) {
+        leftBounds.push_back(toScene(lane.left));
+        rightBounds.push_back(toScene(lane.right));
+    }
+    qDebug() << "[MainWindow]" << lanes.size() << "lanes found in the trajectories";
+    emit addLaneletCandidates(leftBounds, rightBounds);
+}
+void MainWindow::onScenarioSearchDialogRequested()
+{
+    this->m_scenarioSearchDialog->show();
+    this->m_scenarioSearchDialog->raise();
+    this->m_scenarioSearchDialog->activateWindow();
+}
+void MainWindow::onScenarioSearchMatchActivated(const QString &datasetName,
+                                                const QString &scenarioName,
+                                                long fromFrame,
+                                                long toFrame)
+{
+    // Scenarios are listed by name only, recordings of different datasets share names
+    int row = datasetName == this->m_datasetParser->datasetName()
+              ? this->m_scenarioListModel->stringList().indexOf(scenarioName) : -1;
+    if (row < 0) {
+        this->onErrorDuringLoading(QString("Load the %1 dataset to open scenario %2.").arg(datasetName, scenarioName));
+        return;
+    }
+
+    this->ui->list_scenario->setCurrentIndex(this->m_scenarioListModel->index(row, 0));
+    this->m_saveScenarioDialog->setFrameRange(fromFrame, toFrame);
+    this->ui->slider_time->setValue(static_cast<int>(fromFrame));
+}
+void MainWindow::onPlacementsFound()
+{
+    this->m_progressDialog->close();
+    auto search = this->m_placementWatcher->result();
+    const auto &placements = search.placements;
+    if (this->m_placementScenario != this->m_scenarioVisualization->scenario())
+        return;
+    if (placements.empty()) {
+        this->onErrorDuringLoading("The scenario has no objects in the selected frames.");
+        return;
+    }
+
+    QStringList items;
+    for (const auto &placement : placements) {
+        items << QString("Shift %1 m, %2 m, rotation %3 deg: %4 % of object frames")
+            .arg(placement.shift_x, 0, 'f', 2)
+            .arg(placement.shift_y, 0, 'f', 2)
+            .arg(placement.rotation, 0, 'f', 1)
+            .arg(100.0 * placement.object_frames / qMax<uint64_t>(1, search.total), 0, 'f', 1);
+    }
+
+    bool ok;
+    QString item = QInputDialog::getItem(this, "Suggest Placement", "Placement:", items, 0, false, &ok);
+    if (!ok)
+        return;
+
+    // The spinners forward the values to the visualisation
+    const auto &placement = placements.at(items.indexOf(item));
+    this->ui->spinner_shift_x->setValue(placement.shift_x);
+    this->ui->spinner_shift_y->setValue(placement.shift_y);
+    this->ui->spinner_rotation->setValue(placement.rotation);
+}
 void MainWindow::onLoadTransformationDialogRequested()
 {
     // Open save as dialog
@@ -587,6 +913,20 @@ void MainWindow::onToolSelectionChanged(int id)
     this->m_graphicsViewClickHandler->setEditorMode(static_cast<EditorMode>(id));
 }
 
+void MainWindow::onRegionFromLaneletsRequested()
+{
+    QList<QPolygonF> polygons;
+    {
+        QMutexLocker locker(this->m_laneletRegistry->mutex());
+        for (auto lanelet : this->m_laneletRegistry->lanelets()) {
+            auto outline = lanelet->computeOutline();
+            if (outline.valid) polygons.push_back(lanelet->mapToScene(outline.polygon));
+        }
+    }
+    qDebug() << "[MainWindow] Region of interest made of" << polygons.size() << "lanelets";
+    this->m_regionOfInterestLayer->setPolygons(polygons);
+}
+
 void MainWindow::onDatasetLoaded()
 {
     // Dataset is loaded close the progress dialog
@@ -603,11 +943,27 @@ void MainWindow::onDatasetLoaded()
     }
     this->m_scenarioListModel->setStringList(listScenarioNames);
 
+    // Rates are rebuilt from the held scenarios, scenarios loaded from a scenario file have no known rate
+    QHash<const cpm_scenario::Scenario *, double> framesPerSecond;
+    for (const auto &scenario : this->m_datasetParser->loadedDatasetScenarios()) {
+        framesPerSecond.insert(scenario.get(), scenario->GetFramesPerSecond());
+    }
+    for (const auto &scenario : this->m_scenarios) {
+        auto rate = this->m_framesPerSecond.constFind(scenario.get());
+        if (rate != this->m_framesPerSecond.constEnd() && !framesPerSecond.contains(scenario.get())) {
+            framesPerSecond.insert(scenario.get(), rate.value());
+        }
+    }
+    this->m_framesPerSecond = framesPerSecond;
+    this->m_scenarioSearchDialog->addLoadedScenarios(this->m_datasetParser->datasetName(),
+                                                     this->m_datasetParser->loadedDatasetScenarios());
+
     // Trigger selection so that first scenario is loaded
     this->ui->list_scenario->setCurrentIndex(this->m_scenarioListModel->index(0, 0));
 
     this->ui->action_save_transformation->setEnabled(true);
     this->ui->action_load_transformation->setEnabled(true);
+    this->ui->action_suggest_placement->setEnabled(true);
     this->ui->scenario_widget->setEnabled(true);
     this->ui->lbl_scenario->setEnabled(true);
     this->ui->list_scenario->setEnabled(true);
@@ -639,6 +995,11 @@ void MainWindow::onErrorDuringLoading(const QString &message)
     ErrorDialog messageBox(this, "<html><b>Process aborted with message:</b><br>" + message + "</html>");
     messageBox.exec();
 }
+void MainWindow::onWarningDuringStoring(const QString &message)
+{
+    if (!this->m_storeWarning.isEmpty()) this->m_storeWarning += "<br>";
+    this->m_storeWarning += message;
+}
 void MainWindow::onSelectedScenarioChanged(const QItemSelection &selection)
 {
     // Get selected scenario
@@ -649,6 +1010,9 @@ void MainWindow::onSelectedScenarioChanged(const QItemSelection &selection)
     int numberOfFrames = static_cast<int>(scenario->GetNumberOfFrames());
 
     this->m_scenarioVisualization->setScenario(scenario);
+    this->m_saveScenarioDialog->setFrameCounts(nullptr);
+    this->ui->lbl_retained->setText("-");
+    this->m_frameWindowAnalysis->setScenario(scenario);
 
     // Update interface
     this->ui->lbl_start_time->setText("0");
@@ -681,6 +1045,13 @@ void MainWindow::onScenarioStored()
 {
     // Dataset is loaded close the progress dialog
     this->m_progressDialog->close();
+
+    // Warnings of the export, such as lab conflicts, are reported once the file is written
+    if (!this->m_storeWarning.isEmpty()) {
+        ErrorDialog messageBox(this, "<html><b>Scenario stored with warning:</b><br>" + this->m_storeWarning + "</html>");
+        this->m_storeWarning.clear();
+        messageBox.exec();
+    }
 }
 void MainWindow::onScenarioLoaded()
 {
@@ -702,6 +1073,7 @@ void MainWindow::onScenarioLoaded()
 
     this->ui->action_save_transformation->setEnabled(true);
     this->ui->action_load_transformation->setEnabled(true);
+    this->ui->action_suggest_placement->setEnabled(true);
     this->ui->scenario_widget->setEnabled(true);
     this->ui->lbl_scenario->setEnabled(true);
     this->ui->list_scenario->setEnabled(true);
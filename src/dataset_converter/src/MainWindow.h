@@ -8,14 +8,24 @@
 #include <worker/ScenarioHandler.h>
 #include <dialog/LoadScenarioDialog.h>
 #include <QTimer>
+#include <QFutureWatcher>
+#include <QHash>
+#include <dataset_converter_common/analysis/PlacementOptimizer.h>
+#include <dataset_converter_common/analysis/LaneExtractor.h>
 
 #include "visualisation/GraphicsViewZoomHandler.h"
 #include "visualisation/GraphicsViewClickHandler.h"
 #include "dialog/LoadDatasetDialog.h"
 #include "dialog/SaveScenarioDialog.h"
+#include "dialog/ScenarioSearchDialog.h"
 #include "worker/DatasetParser.h"
 #include "worker/LaneletHandler.h"
+#include "worker/LaneletAutosave.h"
+#include "worker/LaneletValidator.h"
+#include "worker/FrameWindowAnalysis.h"
 #include "visualisation/ScenarioVisualization.h"
+#include "visualisation/SceneExporter.h"
+#include "visualisation/RegionOfInterestLayer.h"
 
 namespace Ui
 {
@@ -34,14 +44,24 @@ private:
     LoadDatasetDialog *m_loadDatasetDialog; ///< Load data set dialog
     LoadScenarioDialog *m_loadScenarioDialog; ///< Load scenario dialog
     SaveScenarioDialog *m_saveScenarioDialog; ///< Save scenario dialog
+    FrameWindowAnalysis *m_frameWindowAnalysis; ///< Objects inside the lab per frame, suggests export frames
+    ScenarioSearchDialog *m_scenarioSearchDialog; ///< Search of frame windows across indexed scenarios
     QProgressDialog *m_progressDialog; ///< Progress dialog
 
     DatasetParser *m_datasetParser; ///< Data set parser worker class
     LaneletHandler *m_laneletHandler; ///< Lanelet handler worker class
+    LaneletElementRegistryPtr m_laneletRegistry; ///< Lanelet elements shared by handler and visualisation
+    LaneletSnapshotTracker *m_laneletSnapshotTracker; ///< Copy of the lanelet editor model for background services
+    LaneletAutosave *m_laneletAutosave; ///< Periodic background saves of the lanelet editor
+    LaneletValidator *m_laneletValidator; ///< Continuous background validation of the lanelet editor
+    SceneExporter *m_sceneExporter; ///< Background export of the scene to svg, pdf or png
+    RegionOfInterestLayer *m_regionOfInterestLayer; ///< Region the scenario export is restricted to
     ScenarioHandler *m_scenarioHandler; ///< Scenario handler worker class
     QThread m_workerThread; ///< Worker thread
+    QString m_storeWarning; ///< Warning of the running export, shown once the scenario is stored
 
     cpm_scenario::ScenarioPtrs m_scenarios; ///< Current scenario
+    QHash<const cpm_scenario::Scenario *, double> m_framesPerSecond; ///< Frame rate of the held dataset scenarios
 
     ScenarioVisualization *m_scenarioVisualization; ///< Scenario and background visualisation service
     LaneletVisualisation *m_laneletVisualisation; ///< Lanelet visualisation service
@@ -53,6 +73,19 @@ private:
 
     QTimer *m_playbackTimer; ///< Timer for playback
 
+    /**
+     * Result of a placement search.
+     */
+    struct PlacementSearch
+    {
+        std::vector<dataset_converter_common::Placement> placements; ///< Best placements, best first
+        uint64_t total = 0; ///< Object frames of the searched frame range
+    };
+
+    QFutureWatcher<PlacementSearch> *m_placementWatcher; ///< Running placement search
+    cpm_scenario::ScenarioPtr m_placementScenario; ///< Scenario the running placement search belongs to
+    QFutureWatcher<std::vector<dataset_converter_common::ExtractedLane>> *m_laneWatcher; ///< Running lane extraction
+
     /**
      * Restores the window state form last usage.
      */
@@ -68,6 +101,12 @@ private:
      */
     void updateInformationForSaveScenarioDialog();
 
+    /**
+     * Collects the bounds of all lanelets in scenario meters for the map matching.
+     * @return Lanelets with their registry id, which is also their id in a stored map.
+     */
+    [[nodiscard]] std::vector<dataset_converter_common::MapLanelet> laneletsInScenario() const;
+
     /**
      * Load a transformation file if one is found.
      * @param file Possible transformation file.
@@ -138,6 +177,39 @@ private slots:
      * Open the save transformation dialog if requested by the user.
      */
     void onSaveTransformationDialogRequested();
+    /**
+     * Searches placements of the current scenario in the background if requested by the user.
+     */
+    void onSuggestPlacementRequested();
+    /**
+     * Lets the user pick one of the found placements and applies it.
+     */
+    void onPlacementsFound();
+    /**
+     * Searches lanes in the trajectories of the current scenario in the background if requested by the user.
+     */
+    void onGenerateLaneletsRequested();
+    /**
+     * Adds the found lanes as lanelets to the editor.
+     */
+    void onLanesExtracted();
+
+    /**
+     * Open the scenario search dialog if requested by the user.
+     */
+    void onScenarioSearchDialogRequested();
+
+    /**
+     * Selects the scenario and frames of a search match if the scenario is loaded.
+     * @param datasetName Dataset of the match.
+     * @param scenarioName Scenario of the match.
+     * @param fromFrame First frame of the match.
+     * @param toFrame Last frame of the match.
+     */
+    void onScenarioSearchMatchActivated(const QString &datasetName,
+                                        const QString &scenarioName,
+                                        long fromFrame,
+                                        long toFrame);
 
     /**
      * Triggered if the user clicks the skip frame forward button.
@@ -156,11 +228,21 @@ private slots:
      */
     void onStartStopPlayback();
 
+    /**
+     * Triggered if the user changes the object types shown in the occupancy heatmap.
+     */
+    void onHeatmapTypesChanged();
+
     /**
      * Triggered if the user changes the current selected edit tool.
      */
     void onToolSelectionChanged(int id);
 
+    /**
+     * Replaces the region of interest with the outlines of all lanelets.
+     */
+    void onRegionFromLaneletsRequested();
+
     /**
      * Triggered if the user changes the current selected scenario.
      */
@@ -179,21 +261,27 @@ private slots:
      */
     void onProgressDuringLoading(int current, int max);
     void onErrorDuringLoading(const QString &message);
+    void onWarningDuringStoring(const QString &message);
 
 signals:
     /*
      * Signals to trigger a task for the worker thread.
      */
-    void requestDataset(QString datasetName, QString datasetRootDirectoryPath);
+    void requestDataset(QString datasetName, QString datasetRootDirectoryPath, qreal smoothingWindow);
     void requestScenario(QString datasetName, QString datasetRootDirectoryPath);
     void requestLaneletMap(QString laneletMapFilePath, qreal scaleFactor);
-    void storeLaneletMap(QString laneletMapFilePath, qreal scaleFactor);
+    void storeLaneletMap(QString laneletMapFilePath, LaneletSnapshot snapshot, qreal scaleFactor);
+    void addLaneletCandidates(QList<QPolygonF> leftBounds, QList<QPolygonF> rightBounds);
     void storeScenario(QString name,
                        QString rootDirectoryPath,
                        size_t fromFrame,
                        size_t toFrame,
-                       bool exportFullTrajectories);
-    void exportLaneletMap(QString laneletMapFilePath, QGraphicsScene *scene);
+                       bool exportFullTrajectories,
+                       double framesPerSecond,
+                       bool abortOnCollision,
+                       QList<QPolygonF> region,
+                       dataset_converter_common::MapMatcherPtr mapMatcher,
+                       QList<qint64> lanelets);
 
 };
 
@@ -23,6 +23,11 @@ LoadDatasetDialog::LoadDatasetDialog(QWidget *parent)
 
     // Open the systems file browser then button is pressed
     connect(this->ui->btn_browse, &QToolButton::pressed, this, &LoadDatasetDialog::onBrowseButtonPressed);
+
+    // The window is only used by a filter
+    connect(this->ui->combo_smoothing, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        this->ui->spinner_smoothing_window->setEnabled(index > 0);
+    });
 }
 void LoadDatasetDialog::onBrowseButtonPressed()
 {
@@ -52,6 +57,8 @@ void LoadDatasetDialog::onAcceptButtonPressed()
     // Copy data from the ui to the data model
     this->m_dataset_name = this->ui->combo_dataset->currentText();
     this->m_dataset_root_directory.setPath(this->ui->edit_browse->text());
+    this->m_smoothing_window =
+        this->ui->combo_smoothing->currentIndex() > 0 ? this->ui->spinner_smoothing_window->value() : 0.0;
 }
 
 const QDir &LoadDatasetDialog::datasetRootDirectory() const
@@ -63,3 +70,8 @@ const QString &LoadDatasetDialog::datasetName() const
 {
     return m_dataset_name;
 }
+
+qreal LoadDatasetDialog::smoothingWindow() const
+{
+    return m_smoothing_window;
+}
@@ -23,6 +23,7 @@ private:
 
     QDir m_dataset_root_directory; ///< Selected root directory
     QString m_dataset_name; ///< Selected dataset
+    qreal m_smoothing_window = 0.0; ///< Selected smoothing window in seconds, 0 if the trajectories are kept
 
 private slots:
     /**
@@ -53,6 +54,12 @@ public:
      * @return Selected dataset.
      */
     [[nodiscard]] const QString &datasetName() const;
+
+    /**
+     * Getter for the selected smoothing window.
+     * @return Duration of the smoothing window in seconds, 0 if the trajectories should not be smoothed.
+     */
+    [[nodiscard]] qreal smoothingWindow() const;
 };
 
 #endif // LOADDATASETDIALOG_H
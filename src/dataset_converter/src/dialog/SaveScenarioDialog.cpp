@@ -3,6 +3,7 @@
 
 #include <QPushButton>
 #include <QSpinBox>
+#include <QDoubleSpinBox>
 
 SaveScenarioDialog::SaveScenarioDialog(QWidget *parent)
     : QDialog(parent), ui(new Ui::SaveScenarioDialog)
@@ -33,6 +34,25 @@ SaveScenarioDialog::SaveScenarioDialog(QWidget *parent)
             &QSpinBox::setMinimum);
     connect(this->ui->spinner_to_frame, QOverload<int>::of(&QSpinBox::valueChanged), this->ui->spinner_from_frame,
             &QSpinBox::setMaximum);
+
+    // Report the frames of the export while they are edited
+    auto onFrameRangeChanged = [this]()
+    {
+        emit frameRangeChanged(this->ui->spinner_from_frame->value(), this->ui->spinner_to_frame->value());
+    };
+    connect(this->ui->spinner_from_frame, QOverload<int>::of(&QSpinBox::valueChanged), this, onFrameRangeChanged);
+    connect(this->ui->spinner_to_frame, QOverload<int>::of(&QSpinBox::valueChanged), this, onFrameRangeChanged);
+
+    // Search frame windows again if the requirements change
+    connect(this->ui->spinner_window_length, QOverload<int>::of(&QSpinBox::valueChanged), this,
+            &SaveScenarioDialog::updateWindowSuggestions);
+    connect(this->ui->spinner_min_vehicles, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+            &SaveScenarioDialog::updateWindowSuggestions);
+    connect(this->ui->spinner_min_pedestrians, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+            &SaveScenarioDialog::updateWindowSuggestions);
+    connect(this->ui->combo_window_suggestions, QOverload<int>::of(&QComboBox::activated), this,
+            &SaveScenarioDialog::onWindowSuggestionActivated);
+    this->updateWindowSuggestions();
 }
 
 void SaveScenarioDialog::onBrowseButtonPressed()
@@ -66,6 +86,8 @@ void SaveScenarioDialog::onAcceptButtonPressed()
     this->m_scenarioRootPath.setPath(this->ui->edit_browse->text());
     this->m_scenarioName = this->ui->edit_name->text();
     this->m_export_full_trajectories = this->ui->radio_full_trajectory->isChecked();
+    this->m_abortOnCollision = this->ui->check_abort_on_collision->isChecked();
+    this->m_onlySelectedLanelets = this->ui->check_selected_lanelets->isChecked();
 }
 
 void SaveScenarioDialog::suggestInput(const QString &name, const QDir &targetDirectory)
@@ -82,6 +104,74 @@ void SaveScenarioDialog::setFrameLimits(long fromFrame, long toFrame)
     this->ui->spinner_to_frame->setValue(static_cast<int>(toFrame));
 }
 
+void SaveScenarioDialog::setFrameCounts(const dataset_converter_common::FrameCountsPtr &counts)
+{
+    this->m_frameCounts = counts;
+    this->updateWindowSuggestions();
+}
+
+void SaveScenarioDialog::setRegionDefined(bool defined)
+{
+    this->ui->lbl_region_value->setText(defined ? "Objects inside the region of interest" : "Objects inside the lab area");
+}
+
+void SaveScenarioDialog::updateWindowSuggestions()
+{
+    this->ui->combo_window_suggestions->clear();
+    if (!this->m_frameCounts) {
+        this->ui->combo_window_suggestions->addItem("Analysing scenario...");
+        this->ui->combo_window_suggestions->setEnabled(false);
+        return;
+    }
+
+    using dataset_converter_common::FrameCounts;
+    auto length = static_cast<size_t>(this->ui->spinner_window_length->value());
+    std::vector<dataset_converter_common::WindowRequirement> requirements = {
+        {FrameCounts::kVehicleTypes, this->ui->spinner_min_vehicles->value()},
+        {FrameCounts::kPedestrianTypes, this->ui->spinner_min_pedestrians->value()},
+    };
+    auto windows = this->m_frameCounts->FindWindows(length, requirements, 5);
+    if (windows.empty()) {
+        this->ui->combo_window_suggestions->addItem("No matching frames");
+        this->ui->combo_window_suggestions->setEnabled(false);
+        return;
+    }
+
+    this->ui->combo_window_suggestions->setEnabled(true);
+    for (const auto &window : windows) {
+        // Offsets into the counts, the counts start at the first frame with an object
+        size_t begin = window.from_frame - this->m_frameCounts->GetFirstFrame();
+        size_t end = begin + (window.to_frame - window.from_frame + 1);
+        double frames = static_cast<double>(end - begin);
+        QString text = QString("Frames %1 - %2: %3 vehicles, %4 pedestrians")
+            .arg(window.from_frame)
+            .arg(window.to_frame)
+            .arg(this->m_frameCounts->Sum(FrameCounts::kVehicleTypes, begin, end) / frames, 0, 'f', 1)
+            .arg(this->m_frameCounts->Sum(FrameCounts::kPedestrianTypes, begin, end) / frames, 0, 'f', 1);
+        this->ui->combo_window_suggestions->addItem(
+            text, QVariant::fromValue(QPoint(static_cast<int>(window.from_frame), static_cast<int>(window.to_frame))));
+    }
+}
+
+void SaveScenarioDialog::onWindowSuggestionActivated(int index)
+{
+    QVariant data = this->ui->combo_window_suggestions->itemData(index);
+    if (!data.isValid())
+        return;
+
+    QPoint window = data.toPoint();
+    this->setFrameRange(window.x(), window.y());
+}
+
+void SaveScenarioDialog::setFrameRange(long fromFrame, long toFrame)
+{
+    // Widen the limits first, they follow the other spinner
+    this->ui->spinner_from_frame->setMaximum(this->ui->spinner_to_frame->maximum());
+    this->ui->spinner_to_frame->setMinimum(this->ui->spinner_from_frame->minimum());
+    this->ui->spinner_to_frame->setValue(static_cast<int>(toFrame));
+    this->ui->spinner_from_frame->setValue(static_cast<int>(fromFrame));
+}
+
 const QString &SaveScenarioDialog::scenarioName() const
 {
     return m_scenarioName;
@@ -106,3 +196,13 @@ bool SaveScenarioDialog::exportFullTrajectories() const
 {
     return m_export_full_trajectories;
 }
+
+bool SaveScenarioDialog::abortOnCollision() const
+{
+    return m_abortOnCollision;
+}
+
+bool SaveScenarioDialog::onlySelectedLanelets() const
+{
+    return m_onlySelectedLanelets;
+}
@@ -5,6 +5,7 @@
 #include <QDir>
 #include <QString>
 #include <QFileDialog>
+#include <dataset_converter_common/analysis/FrameStatistics.h>
 
 // Reference to the class defined by the .ui file
 namespace Ui
@@ -26,6 +27,14 @@ private:
     size_t m_fromFrame = 0; ///< Frame to start scenario with
     size_t m_toFrame = 0; ///< Frame to stop scenario with
     bool m_export_full_trajectories = false; ///< Flag if the full trajectory should be exported
+    bool m_abortOnCollision = false; ///< Flag if the export should be aborted if objects collide in the lab
+    bool m_onlySelectedLanelets = false; ///< Flag if only objects using the selected lanelets should be exported
+    dataset_converter_common::FrameCountsPtr m_frameCounts; ///< Objects inside the lab per frame, source of suggestions
+
+    /**
+     * Searches frame windows matching the window length and minimal object counts and offers them as suggestions.
+     */
+    void updateWindowSuggestions();
 
 private slots:
     /**
@@ -38,6 +47,12 @@ private slots:
      */
     void onAcceptButtonPressed();
 
+    /**
+     * Triggered if the user picks a suggested frame window.
+     * @param index Index of the suggestion.
+     */
+    void onWindowSuggestionActivated(int index);
+
 public:
     /**
      * Loads .ui file as set connections.
@@ -75,6 +90,18 @@ public:
      */
     [[nodiscard]] bool exportFullTrajectories() const;
 
+    /**
+     * Getter for the selected collision handling.
+     * @return Whether the export should be aborted if objects collide in the lab.
+     */
+    [[nodiscard]] bool abortOnCollision() const;
+
+    /**
+     * Getter for the selected lanelet filter.
+     * @return Whether only objects using the selected lanelets should be exported.
+     */
+    [[nodiscard]] bool onlySelectedLanelets() const;
+
 public slots:
 
     /**
@@ -90,6 +117,33 @@ public slots:
      * @param toFrame Max frame.
      */
     void setFrameLimits(long fromFrame, long toFrame);
+
+    /**
+     * Selects the frames to export within the current limits.
+     * @param fromFrame First frame.
+     * @param toFrame Last frame.
+     */
+    void setFrameRange(long fromFrame, long toFrame);
+
+    /**
+     * Updates the frame window suggestions.
+     * @param counts Objects inside the lab per frame for the current scenario and transformation.
+     */
+    void setFrameCounts(const dataset_converter_common::FrameCountsPtr &counts);
+
+    /**
+     * Shows whether the export is restricted to the region of interest.
+     * @param defined Whether a region of interest is defined.
+     */
+    void setRegionDefined(bool defined);
+
+signals:
+    /**
+     * Emitted while the user changes the frames of the export.
+     * @param fromFrame First frame.
+     * @param toFrame Last frame.
+     */
+    void frameRangeChanged(long fromFrame, long toFrame);
 };
 
 #endif // SAVESCENARIODIALOG_H
@@ -0,0 +1,175 @@
+#include "ScenarioSearchDialog.h"
+#include "ui_scenariosearchdialog.h"
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QPushButton>
+#include <QtConcurrent/QtConcurrent>
+
+ScenarioSearchDialog::ScenarioSearchDialog(QWidget *parent)
+    : QDialog(parent), ui(new Ui::ScenarioSearchDialog)
+{
+    // Load .ui file
+    this->ui->setupUi(this);
+    this->ui->table_matches->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    // Remove icons from the buttons
+    for (auto &item : this->ui->btn_dialog->buttons()) {
+        item->setIcon(QIcon());
+    }
+    connect(this->ui->btn_dialog, &QDialogButtonBox::rejected, this, &ScenarioSearchDialog::reject);
+
+    this->m_indexingWatcher = new QFutureWatcher<IndexingResult>(this);
+    connect(this->m_indexingWatcher, &QFutureWatcher<IndexingResult>::finished, this,
+            &ScenarioSearchDialog::onIndexingFinished);
+
+    connect(this->ui->btn_browse, &QToolButton::pressed, this, &ScenarioSearchDialog::onBrowseButtonPressed);
+    connect(this->ui->btn_add_scenarios, &QPushButton::clicked, this, &ScenarioSearchDialog::onAddScenariosPressed);
+    connect(this->ui->btn_search, &QPushButton::clicked, this, &ScenarioSearchDialog::onSearchPressed);
+    connect(this->ui->table_matches, &QTableWidget::cellDoubleClicked, this, &ScenarioSearchDialog::onMatchActivated);
+}
+
+ScenarioSearchDialog::~ScenarioSearchDialog()
+{
+    this->m_indexingWatcher->waitForFinished();
+}
+
+void ScenarioSearchDialog::addLoadedScenarios(const QString &datasetName,
+                                              const dataset_converter_common::DatasetScenarioPtrs &scenarios)
+{
+    // A reloaded dataset replaces its earlier scenarios
+    this->m_scenarios.erase(std::remove_if(this->m_scenarios.begin(), this->m_scenarios.end(),
+                                           [&datasetName](const auto &scenario)
+                                           {
+                                               return scenario.first == datasetName;
+                                           }),
+                            this->m_scenarios.end());
+    for (const auto &scenario : scenarios) {
+        this->m_scenarios.push_back({datasetName, scenario});
+    }
+    this->ui->btn_add_scenarios->setEnabled(!this->m_scenarios.isEmpty() && !this->m_indexingWatcher->isRunning());
+}
+
+void ScenarioSearchDialog::onBrowseButtonPressed()
+{
+    // The index may not exist yet, it is created by adding scenarios
+    QString filePath = QFileDialog::getSaveFileName(this, tr("Scenario Index"), this->ui->edit_index->text(),
+                                                    tr("Scenario Index (*.index)"), nullptr,
+                                                    QFileDialog::DontConfirmOverwrite);
+    if (filePath.isEmpty()) return;
+    this->ui->edit_index->setText(filePath);
+}
+
+bool ScenarioSearchDialog::loadIndex()
+{
+    QString filePath = this->ui->edit_index->text();
+    if (this->m_index && filePath == this->m_indexFilePath) return true;
+
+    auto index = std::make_shared<dataset_converter_common::ScenarioIndex>();
+    if (!index->Load(filePath.toStdString())) {
+        this->ui->lbl_status->setText(tr("The index file could not be read."));
+        return false;
+    }
+    this->m_index = index;
+    this->m_indexFilePath = filePath;
+    return true;
+}
+
+ScenarioSearchDialog::IndexingResult ScenarioSearchDialog::addToIndex(const QString &filePath,
+                                                                      const DatasetScenarios &scenarios)
+{
+    // Extend an existing index, but never overwrite a file that is no index
+    auto index = std::make_shared<dataset_converter_common::ScenarioIndex>();
+    if (QFileInfo::exists(filePath) && !index->Load(filePath.toStdString())) {
+        return {nullptr, tr("The index file could not be read.")};
+    }
+    for (const auto &scenario : scenarios) {
+        index->Add(scenario.first.toStdString(), scenario.second, scenario.second->GetFramesPerSecond());
+    }
+    if (!index->Save(filePath.toStdString())) {
+        return {nullptr, tr("The index file could not be written.")};
+    }
+    return {index, QString()};
+}
+
+void ScenarioSearchDialog::onAddScenariosPressed()
+{
+    QString filePath = this->ui->edit_index->text();
+    if (filePath.isEmpty() || this->m_scenarios.isEmpty() || this->m_indexingWatcher->isRunning()) return;
+
+    this->ui->btn_add_scenarios->setEnabled(false);
+    this->ui->lbl_status->setText(tr("Indexing %1 scenarios ...").arg(this->m_scenarios.size()));
+    this->m_indexFilePath = filePath;
+    this->m_index = nullptr;
+    this->m_indexingScenarios = this->m_scenarios;
+    this->m_indexingWatcher->setFuture(QtConcurrent::run(&ScenarioSearchDialog::addToIndex, filePath,
+                                                         this->m_indexingScenarios));
+}
+
+void ScenarioSearchDialog::onIndexingFinished()
+{
+    IndexingResult result = this->m_indexingWatcher->result();
+    DatasetScenarios indexedScenarios;
+    indexedScenarios.swap(this->m_indexingScenarios);
+    if (!result.index) {
+        this->ui->btn_add_scenarios->setEnabled(!this->m_scenarios.isEmpty());
+        this->ui->lbl_status->setText(result.error);
+        return;
+    }
+
+    // Indexed scenarios are only needed by the index, their states are released
+    this->m_scenarios.erase(std::remove_if(this->m_scenarios.begin(), this->m_scenarios.end(),
+                                           [&indexedScenarios](const auto &scenario)
+                                           {
+                                               return indexedScenarios.contains(scenario);
+                                           }),
+                            this->m_scenarios.end());
+    this->ui->btn_add_scenarios->setEnabled(!this->m_scenarios.isEmpty());
+    this->m_index = result.index;
+    this->ui->lbl_status->setText(tr("%1 scenarios indexed.").arg(this->m_index->GetNumberOfScenarios()));
+}
+
+void ScenarioSearchDialog::onSearchPressed()
+{
+    if (this->m_indexingWatcher->isRunning() || !this->loadIndex()) return;
+
+    // Parse one condition per line
+    std::vector<dataset_converter_common::IndexCondition> conditions;
+    for (const auto &line : this->ui->edit_conditions->toPlainText().split('\n', Qt::SkipEmptyParts)) {
+        dataset_converter_common::IndexCondition condition;
+        if (!dataset_converter_common::ScenarioIndex::ParseCondition(line.trimmed().toStdString(), condition)) {
+            this->ui->lbl_status->setText(tr("Invalid condition: %1").arg(line.trimmed()));
+            return;
+        }
+        conditions.push_back(condition);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    this->m_matches = this->m_index->Query(this->ui->spinner_window->value(), conditions);
+    qDebug() << "[ScenarioSearchDialog] Found" << this->m_matches.size() << "windows in" << timer.elapsed() << "ms";
+
+    this->ui->table_matches->setRowCount(static_cast<int>(this->m_matches.size()));
+    for (size_t i = 0; i < this->m_matches.size(); i++) {
+        const auto &match = this->m_matches[i];
+        auto row = static_cast<int>(i);
+        this->ui->table_matches->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(match.dataset)));
+        this->ui->table_matches->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(match.scenario)));
+        this->ui->table_matches->setItem(row, 2, new QTableWidgetItem(QString::number(match.from_frame)));
+        this->ui->table_matches->setItem(row, 3, new QTableWidgetItem(QString::number(match.to_frame)));
+    }
+    this->ui->lbl_status->setText(tr("%1 windows in %2 scenarios.").arg(this->m_matches.size())
+                                      .arg(this->m_index->GetNumberOfScenarios()));
+}
+
+void ScenarioSearchDialog::onMatchActivated(int row)
+{
+    if (row < 0 || row >= static_cast<int>(this->m_matches.size())) return;
+    const auto &match = this->m_matches[static_cast<size_t>(row)];
+    emit matchActivated(QString::fromStdString(match.dataset), QString::fromStdString(match.scenario),
+                        match.from_frame, match.to_frame);
+}
@@ -0,0 +1,120 @@
+#ifndef SCENARIOSEARCHDIALOG_H
+#define SCENARIOSEARCHDIALOG_H
+
+#include <memory>
+#include <vector>
+
+#include <QDialog>
+#include <QFutureWatcher>
+#include <QString>
+#include <dataset_converter_common/DatasetScenario.h>
+#include <dataset_converter_common/analysis/ScenarioIndex.h>
+
+// Reference to the class defined by the .ui file
+namespace Ui
+{
+class ScenarioSearchDialog;
+}
+
+/**
+ * Dialog that adds loaded scenarios to a scenario index file and searches windows of all indexed scenarios.
+ * Adding runs in the background, searching is fast enough for the gui thread.
+ */
+class ScenarioSearchDialog: public QDialog
+{
+Q_OBJECT
+private:
+    /**
+     * Result of a background indexing run.
+     */
+    struct IndexingResult
+    {
+        std::shared_ptr<dataset_converter_common::ScenarioIndex> index; ///< Updated index, nullptr on error
+        QString error; ///< Error message
+    };
+
+    typedef QList<QPair<QString, dataset_converter_common::DatasetScenarioPtr>> DatasetScenarios;
+
+    Ui::ScenarioSearchDialog *ui; ///< Instance of the .ui file class.
+
+    std::shared_ptr<dataset_converter_common::ScenarioIndex> m_index; ///< Index of the current index file
+    QString m_indexFilePath; ///< File the index was loaded from
+    DatasetScenarios m_scenarios; ///< Loaded scenarios that are not indexed yet with their dataset name
+    DatasetScenarios m_indexingScenarios; ///< Scenarios of the running indexing
+    std::vector<dataset_converter_common::IndexMatch> m_matches; ///< Matches of the last search
+    QFutureWatcher<IndexingResult> *m_indexingWatcher = nullptr; ///< Watches the running indexing
+
+    /**
+     * Loads the index file of the line edit unless it is loaded already.
+     * @return Whether an index is available.
+     */
+    bool loadIndex();
+
+    /**
+     * Adds scenarios to an index file. Runs on a worker thread.
+     * @param filePath Index file to extend or create.
+     * @param scenarios Scenarios with their dataset name.
+     * @return Updated index or error.
+     */
+    static IndexingResult addToIndex(const QString &filePath, const DatasetScenarios &scenarios);
+
+private slots:
+    /**
+     * Triggered if user uses the browse button to set the index file.
+     */
+    void onBrowseButtonPressed();
+
+    /**
+     * Triggered if the user wants to add the loaded scenarios to the index.
+     */
+    void onAddScenariosPressed();
+
+    /**
+     * Takes over the index of a finished indexing run.
+     */
+    void onIndexingFinished();
+
+    /**
+     * Triggered if the user starts a search.
+     */
+    void onSearchPressed();
+
+    /**
+     * Triggered if the user double clicks a match.
+     * @param row Row of the match.
+     */
+    void onMatchActivated(int row);
+
+public:
+    /**
+     * Loads .ui file as set connections.
+     * @param parent Parent for qt memory management.
+     */
+    explicit ScenarioSearchDialog(QWidget *parent = nullptr);
+
+    /**
+     * Waits for a running indexing.
+     */
+    ~ScenarioSearchDialog() override;
+
+public slots:
+    /**
+     * Offers the scenarios of a loaded dataset for indexing, replaces the scenarios offered by an earlier load of it.
+     * @param datasetName Name of the dataset.
+     * @param scenarios Parsed scenarios of the dataset.
+     */
+    void addLoadedScenarios(const QString &datasetName,
+                            const dataset_converter_common::DatasetScenarioPtrs &scenarios);
+
+signals:
+    /**
+     * Emitted if the user picks a match.
+     * @param datasetName Dataset of the match.
+     * @param scenarioName Scenario of the match.
+     * @param fromFrame First frame of the match.
+     * @param toFrame Last frame of the match.
+     */
+    void matchActivated(QString datasetName, QString scenarioName, long fromFrame, long toFrame);
+};
+
+#endif // SCENARIOSEARCHDIALOG_H
@@ -12,8 +12,14 @@
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QCommandLineOption>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QTimer>
 #include <QMessageBox>
+#include <QTextStream>
+#include <cmath>
+#include <memory>
 
 #include "MainWindow.h"
 #include "visualisation/graphics_items/ColorDefinition.h"
@@ -79,6 +85,227 @@ void load_style()
 void register_metadata()
 {
     qRegisterMetaType<size_t>("size_t");
+    qRegisterMetaType<NodeItem *>("NodeItem*");
+    qRegisterMetaType<WayItem *>("WayItem*");
+    qRegisterMetaType<LaneletItem *>("LaneletItem*");
+    qRegisterMetaType<QList<NodeItem *>>("QList<NodeItem*>");
+    qRegisterMetaType<QList<WayItem *>>("QList<WayItem*>");
+    qRegisterMetaType<QList<LaneletItem *>>("QList<LaneletItem*>");
+    qRegisterMetaType<LaneletSnapshot>("LaneletSnapshot");
+    qRegisterMetaType<QList<QPolygonF>>("QList<QPolygonF>");
+    qRegisterMetaType<QList<qint64>>("QList<qint64>");
+    qRegisterMetaType<dataset_converter_common::MapMatcherPtr>("dataset_converter_common::MapMatcherPtr");
+}
+
+/**
+ * Prints the best placements of the scenarios of a dataset as csv without opening the gui.
+ * @param datasetName Name of the dataset.
+ * @param datasetRootDirectoryPath Dataset root path.
+ * @param scenarioName Scenario to place, empty places all scenarios.
+ * @param fromFrame First frame to consider.
+ * @param toFrame Last frame to consider, 0 considers all frames.
+ * @param count Number of placements per scenario.
+ * @param smoothingWindow Duration of the smoothing window in seconds, 0 to keep the recorded trajectories.
+ * @return Exit code.
+ */
+int suggest_placements(const QString &datasetName,
+                       const QString &datasetRootDirectoryPath,
+                       const QString &scenarioName,
+                       size_t fromFrame,
+                       size_t toFrame,
+                       size_t count,
+                       double smoothingWindow)
+{
+    QString errorMessage;
+    DatasetParser datasetParser;
+    QObject::connect(&datasetParser, &DatasetParser::error, [&errorMessage](const QString &message)
+    {
+        errorMessage = message;
+    });
+    datasetParser.loadScenariosFromDataset(datasetName, datasetRootDirectoryPath, smoothingWindow);
+    if (!errorMessage.isEmpty()) {
+        qCritical("[CpmSC] %s", qUtf8Printable(errorMessage));
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << "scenario,rank,shift_x,shift_y,rotation,object_frames,total_object_frames\n";
+    for (const auto &scenario : datasetParser.loadedScenarios()) {
+        QString name = QString::fromStdString(scenario->GetName());
+        if (!scenarioName.isEmpty() && name != scenarioName) continue;
+
+        qInfo("[CpmSC] Searching placements of %s.", qUtf8Printable(name));
+        dataset_converter_common::PlacementOptimizer optimizer(scenario, fromFrame, toFrame);
+        auto placements = optimizer.FindBest(count);
+        for (size_t rank = 0; rank < placements.size(); rank++) {
+            const auto &placement = placements[rank];
+            out << name << "," << rank + 1 << "," << QString::number(placement.shift_x, 'f', 3) << ","
+                << QString::number(placement.shift_y, 'f', 3) << "," << QString::number(placement.rotation, 'f', 2)
+                << "," << placement.object_frames << "," << optimizer.GetTotal() << "\n";
+        }
+        out.flush();
+    }
+    return 0;
+}
+
+/**
+ * Adds the scenarios of a dataset to a scenario index file without opening the gui. An existing index is extended.
+ * @param datasetName Name of the dataset.
+ * @param datasetRootDirectoryPath Dataset root path.
+ * @param indexFilePath Index file to extend or create.
+ * @param smoothingWindow Duration of the smoothing window in seconds, 0 to keep the recorded trajectories.
+ * @return Exit code.
+ */
+int build_index(const QString &datasetName,
+                const QString &datasetRootDirectoryPath,
+                const QString &indexFilePath,
+                double smoothingWindow)
+{
+    dataset_converter_common::ScenarioIndex index;
+    if (QFileInfo::exists(indexFilePath) && !index.Load(indexFilePath.toStdString())) {
+        qCritical("[CpmSC] Index file %s could not be read.", qUtf8Printable(indexFilePath));
+        return 1;
+    }
+
+    QString errorMessage;
+    DatasetParser datasetParser;
+    QObject::connect(&datasetParser, &DatasetParser::error, [&errorMessage](const QString &message)
+    {
+        errorMessage = message;
+    });
+    datasetParser.loadScenariosFromDataset(datasetName, datasetRootDirectoryPath, smoothingWindow);
+    if (!errorMessage.isEmpty()) {
+        qCritical("[CpmSC] %s", qUtf8Printable(errorMessage));
+        return 1;
+    }
+
+    for (const auto &scenario : datasetParser.loadedDatasetScenarios()) {
+        qInfo("[CpmSC] Indexing %s.", scenario->GetName().c_str());
+        index.Add(datasetName.toStdString(), scenario, scenario->GetFramesPerSecond());
+    }
+    if (!index.Save(indexFilePath.toStdString())) {
+        qCritical("[CpmSC] Index file %s could not be written.", qUtf8Printable(indexFilePath));
+        return 1;
+    }
+    qInfo("[CpmSC] Index contains %zu scenarios.", index.GetNumberOfScenarios());
+    return 0;
+}
+
+/**
+ * Prints the windows of all indexed scenarios that meet all conditions as csv without opening the gui.
+ * @param indexFilePath Index file to search.
+ * @param windowSeconds Length of a window in seconds.
+ * @param conditionTexts Conditions like pedestrian:moving:3, see ScenarioIndex::ParseCondition.
+ * @return Exit code.
+ */
+int query_index(const QString &indexFilePath, double windowSeconds, const QStringList &conditionTexts)
+{
+    std::vector<dataset_converter_common::IndexCondition> conditions;
+    for (const auto &text : conditionTexts) {
+        dataset_converter_common::IndexCondition condition;
+        if (!dataset_converter_common::ScenarioIndex::ParseCondition(text.toStdString(), condition)) {
+            qCritical("[CpmSC] Invalid condition %s.", qUtf8Printable(text));
+            return 1;
+        }
+        conditions.push_back(condition);
+    }
+
+    dataset_converter_common::ScenarioIndex index;
+    if (!index.Load(indexFilePath.toStdString())) {
+        qCritical("[CpmSC] Index file %s could not be read.", qUtf8Printable(indexFilePath));
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    auto matches = index.Query(windowSeconds, conditions);
+    qInfo("[CpmSC] Found %zu windows in %zu scenarios in %lld ms.", matches.size(), index.GetNumberOfScenarios(),
+          timer.elapsed());
+
+    QTextStream out(stdout);
+    out << "dataset,scenario,from_frame,to_frame,from_time,to_time\n";
+    for (const auto &match : matches) {
+        out << QString::fromStdString(match.dataset) << "," << QString::fromStdString(match.scenario) << ","
+            << match.from_frame << "," << match.to_frame << ","
+            << QString::number(static_cast<double>(match.from_frame) / match.frames_per_second, 'f', 2) << ","
+            << QString::number(static_cast<double>(match.to_frame + 1) / match.frames_per_second, 'f', 2) << "\n";
+    }
+    out.flush();
+    return 0;
+}
+
+/**
+ * Writes the criticality metrics of the scenarios of a dataset as csv side files and prints the most critical windows
+ * as csv without opening the gui.
+ * @param datasetName Name of the dataset.
+ * @param datasetRootDirectoryPath Dataset root path.
+ * @param outputDirectoryPath Directory for the side files.
+ * @param scenarioName Scenario to measure, empty measures all scenarios.
+ * @param fromFrame First frame to measure.
+ * @param toFrame Last frame to measure, 0 measures all frames.
+ * @param windowSeconds Length of a window in seconds.
+ * @param count Number of windows per scenario.
+ * @param smoothingWindow Duration of the smoothing window in seconds, 0 to keep the recorded trajectories.
+ * @return Exit code.
+ */
+int measure_criticality(const QString &datasetName,
+                        const QString &datasetRootDirectoryPath,
+                        const QString &outputDirectoryPath,
+                        const QString &scenarioName,
+                        long fromFrame,
+                        long toFrame,
+                        double windowSeconds,
+                        size_t count,
+                        double smoothingWindow)
+{
+    QDir outputDirectory(outputDirectoryPath);
+    if (!outputDirectory.exists()) {
+        qCritical("[CpmSC] Output directory %s does not exist.", qUtf8Printable(outputDirectoryPath));
+        return 1;
+    }
+
+    QString errorMessage;
+    DatasetParser datasetParser;
+    QObject::connect(&datasetParser, &DatasetParser::error, [&errorMessage](const QString &message)
+    {
+        errorMessage = message;
+    });
+    datasetParser.loadScenariosFromDataset(datasetName, datasetRootDirectoryPath, smoothingWindow);
+    if (!errorMessage.isEmpty()) {
+        qCritical("[CpmSC] %s", qUtf8Printable(errorMessage));
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << "scenario,rank,from_frame,to_frame,critical_frames,min_ttc\n";
+    for (const auto &scenario : datasetParser.loadedDatasetScenarios()) {
+        QString name = QString::fromStdString(scenario->GetName());
+        if (!scenarioName.isEmpty() && name != scenarioName) continue;
+
+        QElapsedTimer timer;
+        timer.start();
+        dataset_converter_common::CriticalityMetrics metrics(scenario, scenario->GetFramesPerSecond(), fromFrame,
+                                                             toFrame);
+        qInfo("[CpmSC] Measured %zu frames of %s in %lld ms.", metrics.GetFrames().size(), qUtf8Printable(name),
+              timer.elapsed());
+
+        std::string filePath = outputDirectory.absoluteFilePath("Criticality_" + name).toStdString();
+        if (!metrics.WriteCsv(filePath + "_frames.csv", filePath + "_pairs.csv")) {
+            qCritical("[CpmSC] Criticality side files of %s could not be written.", qUtf8Printable(name));
+            return 1;
+        }
+
+        auto length = static_cast<size_t>(qMax(1.0, windowSeconds * scenario->GetFramesPerSecond()));
+        auto windows = metrics.FindWindows(length, count);
+        for (size_t rank = 0; rank < windows.size(); rank++) {
+            const auto &window = windows[rank];
+            out << name << "," << rank + 1 << "," << window.from_frame << "," << window.to_frame << ","
+                << window.critical_frames << ","
+                << (std::isfinite(window.min_ttc) ? QString::number(window.min_ttc, 'f', 2) : QString()) << "\n";
+        }
+    }
+    out.flush();
+    return 0;
 }
 
 QString getStyleSheet()
@@ -94,7 +321,16 @@ int main(int argc, char *argv[])
     qInfo("Executing %s, version %i.%i.%i", APPLICATION_NAME, MAJOR_VERSION, MINOR_VERSION, REVISION);
     load_application_information();
 
-    QApplication application(argc, argv);
+    // The placement search, the scenario index and the criticality metrics run without a display
+    bool headless = false;
+    for (int i = 1; i < argc; i++) {
+        QString argument(argv[i]);
+        if (argument == "--suggest-placement" || argument == "--build-index" || argument == "--query-index"
+            || argument == "--criticality")
+            headless = true;
+    }
+    std::unique_ptr<QCoreApplication> application(
+        headless ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
 
     QCommandLineParser commandLineParser;
     commandLineParser.setApplicationDescription(
@@ -110,16 +346,90 @@ int main(int argc, char *argv[])
     commandLineParser.addOption(datasetRootDirectoryOption);
     commandLineParser.addOption(outputDirectoryOption);
 
-    commandLineParser.process(application);
+    QCommandLineOption suggestPlacementOption(
+        "suggest-placement", "Print the best shifts and rotations of the dataset scenarios and exit");
+    QCommandLineOption scenarioOption(QStringList() << "s" << "scenario", "Scenario to place", "<scenario>", "");
+    QCommandLineOption fromFrameOption("from-frame", "First frame to place", "<frame>", "0");
+    QCommandLineOption toFrameOption("to-frame", "Last frame to place, 0 for all", "<frame>", "0");
+    QCommandLineOption placementCountOption("placements", "Number of placements per scenario", "<count>", "5");
+    commandLineParser.addOption(suggestPlacementOption);
+    commandLineParser.addOption(scenarioOption);
+    commandLineParser.addOption(fromFrameOption);
+    commandLineParser.addOption(toFrameOption);
+    commandLineParser.addOption(placementCountOption);
+
+    QCommandLineOption buildIndexOption(
+        "build-index", "Add the dataset scenarios to a scenario index file and exit", "<index_file>");
+    QCommandLineOption queryIndexOption(
+        "query-index", "Print the windows of all indexed scenarios that meet all conditions and exit", "<index_file>");
+    QCommandLineOption windowOption("window", "Length of a searched window in seconds", "<seconds>", "20");
+    QCommandLineOption conditionOption(
+        "require", "Condition of a searched window like pedestrian:moving:3 or car:minimum:5, can be repeated",
+        "<condition>");
+    commandLineParser.addOption(buildIndexOption);
+    commandLineParser.addOption(queryIndexOption);
+    commandLineParser.addOption(windowOption);
+    commandLineParser.addOption(conditionOption);
+
+    QCommandLineOption criticalityOption(
+        "criticality", "Write the criticality metrics of the dataset scenarios to the output path, print the most "
+                       "critical windows and exit");
+    QCommandLineOption windowCountOption("windows", "Number of critical windows per scenario", "<count>", "3");
+    commandLineParser.addOption(criticalityOption);
+    commandLineParser.addOption(windowCountOption);
+
+    QCommandLineOption smoothingOption(
+        "smoothing", "Smooth the trajectories while parsing with a Savitzky-Golay window of this length, 0 to keep "
+                     "the recorded trajectories", "<seconds>", "0");
+    commandLineParser.addOption(smoothingOption);
+
+    commandLineParser.process(*application);
 
     // Get values from the command line parser
     QString outputDirectoryPath = commandLineParser.value(outputDirectoryOption);
     QString datasetRootDirectoryPath = commandLineParser.value(datasetRootDirectoryOption);
     QString datasetName = commandLineParser.value(datasetNameOption);
+    double smoothingWindow = qMax(0.0, commandLineParser.value(smoothingOption).toDouble());
 
     qInfo("[CpmSC] Register metadata.");
     register_metadata();
 
+    if (commandLineParser.isSet(buildIndexOption)) {
+        std::setlocale(LC_ALL, "C");
+        return build_index(datasetName,
+                           datasetRootDirectoryPath,
+                           commandLineParser.value(buildIndexOption),
+                           smoothingWindow);
+    }
+    if (commandLineParser.isSet(queryIndexOption)) {
+        std::setlocale(LC_ALL, "C");
+        return query_index(commandLineParser.value(queryIndexOption),
+                           commandLineParser.value(windowOption).toDouble(),
+                           commandLineParser.values(conditionOption));
+    }
+    if (commandLineParser.isSet(criticalityOption)) {
+        std::setlocale(LC_ALL, "C");
+        return measure_criticality(datasetName,
+                                   datasetRootDirectoryPath,
+                                   outputDirectoryPath,
+                                   commandLineParser.value(scenarioOption),
+                                   commandLineParser.value(fromFrameOption).toLong(),
+                                   commandLineParser.value(toFrameOption).toLong(),
+                                   commandLineParser.value(windowOption).toDouble(),
+                                   qMax(1u, commandLineParser.value(windowCountOption).toUInt()),
+                                   smoothingWindow);
+    }
+    if (headless) {
+        std::setlocale(LC_ALL, "C");
+        return suggest_placements(datasetName,
+                                  datasetRootDirectoryPath,
+                                  commandLineParser.value(scenarioOption),
+                                  commandLineParser.value(fromFrameOption).toULongLong(),
+                                  commandLineParser.value(toFrameOption).toULongLong(),
+                                  qMax(1u, commandLineParser.value(placementCountOption).toUInt()),
+                                  smoothingWindow);
+    }
+
     qInfo("[CpmSC] Loading style.");
     load_style();
 
@@ -0,0 +1,78 @@
+#include "BackgroundImageLoader.h"
+
+#include <cmath>
+
+#include <QFile>
+#include <QFutureWatcher>
+#include <QCryptographicHash>
+#include <QtConcurrent/QtConcurrent>
+
+BackgroundImageLoader::BackgroundImageLoader(QObject *parent)
+    : QObject(parent), m_sharedImageCache(std::make_shared<SharedImageCache>())
+{}
+
+QString BackgroundImageLoader::cacheKey(const QString &path, qreal scaleFactor)
+{
+    return QString("%1@%2").arg(path).arg(scaleFactor, 0, 'g', 17);
+}
+
+bool BackgroundImageLoader::cachedPixmap(const QString &path, qreal scaleFactor, QPixmap &pixmap) const
+{
+    auto cached = this->m_pixmapCache.object(cacheKey(path, scaleFactor));
+    if (!cached) return false;
+    pixmap = *cached;
+    return true;
+}
+
+void BackgroundImageLoader::request(const QString &path, qreal scaleFactor)
+{
+    QString key = cacheKey(path, scaleFactor);
+    if (this->m_pixmapCache.contains(key)) {
+        emit imageReady(path, scaleFactor, *this->m_pixmapCache.object(key));
+        return;
+    }
+    if (this->m_pendingKeys.contains(key)) return;
+    this->m_pendingKeys.insert(key);
+
+    auto watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, path, scaleFactor, key]()
+    {
+        // Pixmaps may only be created in the gui thread
+        QPixmap pixmap = QPixmap::fromImage(watcher->result());
+        this->m_pendingKeys.remove(key);
+        if (!pixmap.isNull()) {
+            int cost = qMax(1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024);
+            this->m_pixmapCache.insert(key, new QPixmap(pixmap), cost);
+        }
+        emit imageReady(path, scaleFactor, pixmap);
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&BackgroundImageLoader::loadScaledImage, this->m_sharedImageCache, path,
+                                         scaleFactor));
+}
+
+QImage BackgroundImageLoader::loadScaledImage(const std::shared_ptr<SharedImageCache> &cache, const QString &path,
+                                              qreal scaleFactor)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return {};
+    QByteArray data = file.readAll();
+
+    // Hash the content so that copies of the same background share one decoded image
+    QString contentKey = cacheKey(QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex()),
+                                 scaleFactor);
+    {
+        QMutexLocker locker(&cache->mutex);
+        if (auto cached = cache->images.object(contentKey)) return *cached;
+    }
+
+    QImage image = QImage::fromData(data);
+    if (image.isNull()) return {};
+    int width = std::floor(static_cast<qreal>(image.width()) * scaleFactor);
+    int height = std::floor(static_cast<qreal>(image.height()) * scaleFactor);
+    QImage scaled = image.scaled(width, height, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    QMutexLocker locker(&cache->mutex);
+    cache->images.insert(contentKey, new QImage(scaled), qMax(1, static_cast<int>(scaled.sizeInBytes() / 1024)));
+    return scaled;
+}
@@ -0,0 +1,87 @@
+#ifndef BACKGROUNDIMAGELOADER_H
+#define BACKGROUNDIMAGELOADER_H
+
+#include <memory>
+
+#include <QObject>
+#include <QCache>
+#include <QSet>
+#include <QMutex>
+#include <QImage>
+#include <QPixmap>
+
+/**
+ * Service that decodes and scales background images on worker threads. Scaled pixmaps are cached by path and scale
+ * factor. Images with identical content, e.g. recordings of the same inD location, are decoded only once.
+ */
+class BackgroundImageLoader: public QObject
+{
+Q_OBJECT
+private:
+    /**
+     * Cache of scaled images keyed by content hash and scale factor. Shared with the worker threads, the shared
+     * pointer keeps it alive for tasks that are still running on destruction.
+     */
+    struct SharedImageCache
+    {
+        QMutex mutex; ///< Guards the cache
+        QCache<QString, QImage> images{256 * 1024}; ///< Scaled images, cost in kilobytes
+    };
+
+    std::shared_ptr<SharedImageCache> m_sharedImageCache; ///< Images shared between worker threads
+    QCache<QString, QPixmap> m_pixmapCache{256 * 1024}; ///< Pixmaps ready for display, cost in kilobytes
+    QSet<QString> m_pendingKeys; ///< Requests that are currently processed
+
+    /**
+     * Generates the key of a path and scale factor.
+     * @param path Image path.
+     * @param scaleFactor Scale factor of the image.
+     * @return Cache key.
+     */
+    static QString cacheKey(const QString &path, qreal scaleFactor);
+
+    /**
+     * Decodes and scales an image. Runs on a worker thread.
+     * @param cache Cache of already scaled images.
+     * @param path Image path.
+     * @param scaleFactor Scale factor to apply.
+     * @return Scaled image, null if the image could not be read.
+     */
+    static QImage loadScaledImage(const std::shared_ptr<SharedImageCache> &cache, const QString &path,
+                                  qreal scaleFactor);
+
+public:
+    /**
+     * Creates the loader.
+     * @param parent Possible parent or qt pointer destruction.
+     */
+    explicit BackgroundImageLoader(QObject *parent = nullptr);
+
+    /**
+     * Looks up an already scaled pixmap.
+     * @param path Image path.
+     * @param scaleFactor Scale factor of the image.
+     * @param pixmap Output for the pixmap, only written on a hit.
+     * @return True if the pixmap was cached, false otherwise.
+     */
+    bool cachedPixmap(const QString &path, qreal scaleFactor, QPixmap &pixmap) const;
+
+public slots:
+    /**
+     * Requests an image to be decoded and scaled in the background. Emits imageReady when done.
+     * @param path Image path.
+     * @param scaleFactor Scale factor to apply.
+     */
+    void request(const QString &path, qreal scaleFactor);
+
+signals:
+    /**
+     * Emitted if a requested image is ready.
+     * @param path Image path.
+     * @param scaleFactor Scale factor that was applied.
+     * @param pixmap Scaled pixmap, null if the image could not be read.
+     */
+    void imageReady(QString path, qreal scaleFactor, QPixmap pixmap);
+};
+
+#endif // BACKGROUNDIMAGELOADER_H
@@ -29,7 +29,7 @@ PointerType GetFirstItemInList(QList<ListType> list)
 {
     for (auto item : list) {
         // Cast
-        auto *itemOfCorrectType = dynamic_cast<PointerType>(item);
+        auto *itemOfCorrectType = qgraphicsitem_cast<PointerType>(item);
         // Check if valid
         if (!itemOfCorrectType) continue;
         // Return found item
@@ -49,12 +49,30 @@ bool GraphicsViewClickHandler::eventFilter(QObject *object, QEvent *event)
     auto scenePosition = this->m_canvas->mapToScene(mouseEvent->pos());
     auto globalPosition = mouseEvent->globalPos();
 
-    auto itemsUnderCursor = this->m_canvas->scene()->items({scenePosition.x() - 1, scenePosition.y() - 1, 2, 2});
     auto itemsSelected = this->m_canvas->scene()->selectedItems();
 
-    auto nodeUnderCursor = GetFirstItemInList<NodeItem *, QGraphicsItem *>(itemsUnderCursor);
-    auto pathUnderCursor = GetFirstItemInList<WayItem *, QGraphicsItem *>(itemsUnderCursor);
-    auto laneletUnderCursor = GetFirstItemInList<LaneletItem *, QGraphicsItem *>(itemsUnderCursor);
+    NodeItem *nodeUnderCursor = nullptr;
+    WayItem *pathUnderCursor = nullptr;
+    LaneletItem *laneletUnderCursor = nullptr;
+    if (this->m_spatialIndex) {
+        // Hit distances are given in view pixels, so they stay usable at every zoom level
+        qreal pixel = 1.0 / qMax(1e-6, this->m_canvas->transform().m11());
+        qreal nodeRadius = qMax(HitRadius, HitDistance * pixel);
+        if (this->m_mode == EditorMode::WAY_TOOL) nodeRadius = qMax(HitRadius, ConnectDistance * pixel);
+        nodeUnderCursor = this->m_spatialIndex->nearestNode(scenePosition, nodeRadius);
+        pathUnderCursor = this->m_spatialIndex->nearestWay(scenePosition, qMax(HitRadius, HitDistance * pixel));
+        if (this->m_mode == EditorMode::LANELET_TOOL) {
+            laneletUnderCursor = GetFirstItemInList<LaneletItem *, QGraphicsItem *>(
+                this->m_canvas->scene()->items(scenePosition));
+        }
+    }
+    else {
+        auto itemsUnderCursor =
+            this->m_canvas->scene()->items({scenePosition.x() - 1, scenePosition.y() - 1, 2, 2});
+        nodeUnderCursor = GetFirstItemInList<NodeItem *, QGraphicsItem *>(itemsUnderCursor);
+        pathUnderCursor = GetFirstItemInList<WayItem *, QGraphicsItem *>(itemsUnderCursor);
+        laneletUnderCursor = GetFirstItemInList<LaneletItem *, QGraphicsItem *>(itemsUnderCursor);
+    }
     auto selectedNode = GetFirstItemInList<NodeItem *, QGraphicsItem *>(itemsSelected);
     auto selectedWay = GetFirstItemInList<WayItem *, QGraphicsItem *>(itemsSelected);
     auto selectedLanelet = GetFirstItemInList<LaneletItem *, QGraphicsItem *>(itemsSelected);
@@ -90,12 +108,66 @@ bool GraphicsViewClickHandler::eventFilter(QObject *object, QEvent *event)
                 return handleRightClickLanelet(globalPosition, selectedLanelet);
             }
             break;
+        case EditorMode::REGION_TOOL:
+            if (mouseEvent->button() == Qt::LeftButton) {
+                emit requestAddRegionVertex(scenePosition);
+                return true;
+            }
+            else if (mouseEvent->button() == Qt::RightButton) {
+                return handleRightClickRegion(globalPosition);
+            }
+            break;
     }
 
     // Let QGraphicsView handle all unexpected cases
     Q_UNUSED(object)
     return false;
 }
+bool GraphicsViewClickHandler::handleRightClickRegion(const QPoint &globalPosition)
+{
+    QMenu menu(m_canvas);
+    QAction actionNew(QIcon(":resources/icons/pen-tool.svg"), "New Polygon", &menu);
+    connect(&actionNew, &QAction::triggered, this, [this]()
+    {
+        emit requestNewRegionPolygon();
+        qDebug() << "[GraphicsViewClickHandler] Request new region polygon!";
+    });
+    menu.addAction(&actionNew);
+
+    QAction actionRemoveVertex(QIcon(":resources/icons/node_remove.svg"), "Remove Last Vertex", &menu);
+    connect(&actionRemoveVertex, &QAction::triggered, this, [this]()
+    {
+        emit requestRemoveRegionVertex();
+        qDebug() << "[GraphicsViewClickHandler] Request remove region vertex!";
+    });
+    menu.addAction(&actionRemoveVertex);
+
+    QAction actionLanelets(QIcon(":resources/icons/lanelet.svg"), "Region from Lanelets", &menu);
+    connect(&actionLanelets, &QAction::triggered, this, [this]()
+    {
+        emit requestRegionFromLanelets();
+        qDebug() << "[GraphicsViewClickHandler] Request region from lanelets!";
+    });
+    menu.addAction(&actionLanelets);
+
+    QAction actionClear(QIcon(":resources/icons/trash.svg"), "Clear Region", &menu);
+    connect(&actionClear, &QAction::triggered, this, [this]()
+    {
+        emit requestClearRegion();
+        qDebug() << "[GraphicsViewClickHandler] Request clear region!";
+    });
+    menu.addAction(&actionClear);
+
+    QRect mask = menu.rect();
+    mask.setSize(menu.sizeHint());
+
+    QPainterPath path;
+    path.addRoundedRect(mask, 6, 6);
+    menu.setMask(path.toFillPolygon().toPolygon());
+
+    menu.exec(globalPosition);
+    return true;
+}
 bool GraphicsViewClickHandler::handleRightClickLanelet(const QPoint &globalPosition, LaneletItem *selectedLanelet)
 {
     if (!selectedLanelet) return true;
@@ -357,6 +429,10 @@ void GraphicsViewClickHandler::showMetadataMenuWay(const QPoint &globalPosition,
 
     menu.exec(globalPosition);
 }
+void GraphicsViewClickHandler::setSpatialIndex(const LaneletSpatialIndex *spatialIndex)
+{
+    this->m_spatialIndex = spatialIndex;
+}
 EditorMode GraphicsViewClickHandler::editorMode() const
 {
     return this->m_mode;
@@ -14,7 +14,8 @@ enum class EditorMode
     SELECT = 0, ///< Move and select nodes
     NODE_TOOL = 1, ///< Add new nodes
     WAY_TOOL = 2, ///< Add new ways
-    LANELET_TOOL = 3 ///< Add new lanelets
+    LANELET_TOOL = 3, ///< Add new lanelets
+    REGION_TOOL = 4 ///< Draw the region of interest of the export
 };
 
 class WayItem;
@@ -34,6 +35,11 @@ private:
 
     // Intern access to get elements under mouse
     QGraphicsView *const m_canvas; ///< Canvas
+    const LaneletSpatialIndex *m_spatialIndex = nullptr; ///< Index for hit tests, scene is queried if not set
+
+    static constexpr qreal HitRadius = 2.0; ///< Minimum hit distance in scene units, matches the item sizes
+    static constexpr qreal HitDistance = 4.0; ///< Hit distance in view pixels
+    static constexpr qreal ConnectDistance = 12.0; ///< Distance in view pixels to connect a way to an existing node
 
     LaneletItem *m_selectedLanelet = nullptr; ///< Buffer for the selected lanelet item
     WayItem *m_selectedWay = nullptr; ///< Buffer for the selected way item
@@ -143,6 +149,13 @@ private:
                                 LaneletItem *laneletUnderCursor,
                                 LaneletItem *selectedLanelet);
 
+    /**
+     * Show context menu to edit the drawn polygon, clear the region of interest or take it from the lanelets.
+     * @param globalPosition Position to show the context menu.
+     * @return True if used, false otherwise.
+     */
+    bool handleRightClickRegion(const QPoint &globalPosition);
+
     /**
      * Set the new selected lanelet and emits signals.
      * @param selectedLanelet New selected lanelet.
@@ -174,6 +187,12 @@ public:
      */
     explicit GraphicsViewClickHandler(QGraphicsView *view);
 
+    /**
+     * Setter for the spatial index used for hit tests instead of querying the scene.
+     * @param spatialIndex Index of all lanelet nodes and ways.
+     */
+    void setSpatialIndex(const LaneletSpatialIndex *spatialIndex);
+
     /**
      * Getter for the current selected edit.
      * @return Selected edit mode.
@@ -281,6 +300,32 @@ signals:
      */
     void requestAddWayToLanelet(LaneletItem *lanelet, WayItem *way);
 
+    /**
+     * User requests a vertex to be added to the region of interest.
+     * @param position Position of the vertex.
+     */
+    void requestAddRegionVertex(QPointF position);
+
+    /**
+     * User requests to finish the drawn polygon of the region of interest and start a new one.
+     */
+    void requestNewRegionPolygon();
+
+    /**
+     * User requests to remove the last vertex of the drawn polygon of the region of interest.
+     */
+    void requestRemoveRegionVertex();
+
+    /**
+     * User requests the region of interest to be made of the outlines of all lanelets.
+     */
+    void requestRegionFromLanelets();
+
+    /**
+     * User requests to remove the region of interest.
+     */
+    void requestClearRegion();
+
     /**
      * Triggered of the selected lanelet changed. Used to disable the context menu if no is selected.
      * @param lanelet Lanelet that is selected, maybe nullptr.
@@ -6,6 +6,7 @@
 #include <qmath.h>
 #include <QGestureEvent>
 #include <QDebug>
+#include <QStyleOptionGraphicsItem>
 
 
 GraphicsViewZoomHandler::GraphicsViewZoomHandler(QGraphicsView *view)
@@ -26,6 +27,11 @@ void GraphicsViewZoomHandler::zoom(double factor)
     emit zoomed();
 }
 
+qreal GraphicsViewZoomHandler::levelOfDetail() const
+{
+    return QStyleOptionGraphicsItem::levelOfDetailFromTransform(this->m_canvas->transform());
+}
+
 bool GraphicsViewZoomHandler::eventFilter(QObject *object, QEvent *event)
 {
     if (event->type() == QEvent::MouseMove) {
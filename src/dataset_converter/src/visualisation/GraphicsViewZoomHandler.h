@@ -47,6 +47,12 @@ public:
      */
     void zoom(double factor);
 
+    /**
+     * @brief levelOfDetail Calculates the level of detail of the current view transformation.
+     * @return Device pixels per scene unit, as used by the graphics items to decide what to draw.
+     */
+    [[nodiscard]] qreal levelOfDetail() const;
+
 signals:
     /**
      * @brief zoomed Signal emitted if the zoom process is complete.
@@ -0,0 +1,206 @@
+#include "LaneletSpatialIndex.h"
+
+#include <limits>
+
+#include <QtMath>
+
+#include "visualisation/graphics_items/NodeItem.h"
+#include "visualisation/graphics_items/WayItem.h"
+
+// Squared distance between a point and a line segment
+static qreal SquaredDistanceToSegment(const QPointF &point, const QPointF &from, const QPointF &to)
+{
+    QPointF direction = to - from;
+    qreal squaredLength = QPointF::dotProduct(direction, direction);
+    qreal t = squaredLength > 0 ? QPointF::dotProduct(point - from, direction) / squaredLength : 0;
+    QPointF difference = point - (from + qBound(0.0, t, 1.0) * direction);
+    return QPointF::dotProduct(difference, difference);
+}
+
+QPoint LaneletSpatialIndex::cellOf(const QPointF &point)
+{
+    return {qFloor(point.x() / CellSize), qFloor(point.y() / CellSize)};
+}
+
+template<typename Function>
+void LaneletSpatialIndex::forEachCell(const QPointF &from, const QPointF &to, Function function)
+{
+    // Grid traversal, steps into the neighbouring cell whose border is crossed first
+    QPoint cell = cellOf(from);
+    QPoint last = cellOf(to);
+    QPointF delta = to - from;
+    const qreal infinity = std::numeric_limits<qreal>::infinity();
+    int stepX = delta.x() > 0 ? 1 : -1;
+    int stepY = delta.y() > 0 ? 1 : -1;
+    qreal tDeltaX = delta.x() != 0 ? CellSize / qAbs(delta.x()) : infinity;
+    qreal tDeltaY = delta.y() != 0 ? CellSize / qAbs(delta.y()) : infinity;
+    qreal tMaxX = delta.x() != 0 ? ((cell.x() + (stepX > 0 ? 1 : 0)) * CellSize - from.x()) / delta.x() : infinity;
+    qreal tMaxY = delta.y() != 0 ? ((cell.y() + (stepY > 0 ? 1 : 0)) * CellSize - from.y()) / delta.y() : infinity;
+
+    function(cell);
+    int steps = qAbs(last.x() - cell.x()) + qAbs(last.y() - cell.y());
+    for (int i = 0; i < steps; i++) {
+        if (tMaxX < tMaxY) {
+            cell.rx() += stepX;
+            tMaxX += tDeltaX;
+        }
+        else {
+            cell.ry() += stepY;
+            tMaxY += tDeltaY;
+        }
+        function(cell);
+    }
+}
+
+void LaneletSpatialIndex::insertSegment(WayItem *way, const QPolygonF &polyline, int index)
+{
+    Segment segment{way, index};
+    forEachCell(polyline.at(index), polyline.at(index + 1), [this, &segment](const QPoint &cell)
+    {
+        this->m_segmentCells[cell].push_back(segment);
+    });
+}
+
+void LaneletSpatialIndex::removeSegment(WayItem *way, const QPolygonF &polyline, int index)
+{
+    Segment segment{way, index};
+    forEachCell(polyline.at(index), polyline.at(index + 1), [this, &segment](const QPoint &cell)
+    {
+        auto segments = this->m_segmentCells.find(cell);
+        if (segments == this->m_segmentCells.end()) return;
+        int position = segments->indexOf(segment);
+        if (position < 0) return;
+        // Order within a cell does not matter
+        (*segments)[position] = segments->last();
+        segments->removeLast();
+        if (segments->isEmpty()) this->m_segmentCells.erase(segments);
+    });
+}
+
+void LaneletSpatialIndex::updateNode(NodeItem *node)
+{
+    QPoint cell = cellOf(node->pos());
+    auto cellOfNode = this->m_cellOfNode.find(node);
+    if (cellOfNode != this->m_cellOfNode.end()) {
+        if (cellOfNode.value() == cell) return;
+        this->removeNode(node);
+    }
+    this->m_nodeCells[cell].push_back(node);
+    this->m_cellOfNode.insert(node, cell);
+}
+
+void LaneletSpatialIndex::removeNode(const NodeItem *node)
+{
+    auto cellOfNode = this->m_cellOfNode.find(node);
+    if (cellOfNode == this->m_cellOfNode.end()) return;
+    auto nodes = this->m_nodeCells.find(cellOfNode.value());
+    this->m_cellOfNode.erase(cellOfNode);
+    if (nodes == this->m_nodeCells.end()) return;
+    int position = nodes->indexOf(const_cast<NodeItem *>(node));
+    if (position < 0) return;
+    (*nodes)[position] = nodes->last();
+    nodes->removeLast();
+    if (nodes->isEmpty()) this->m_nodeCells.erase(nodes);
+}
+
+void LaneletSpatialIndex::updateWay(WayItem *way)
+{
+    this->removeWay(way);
+    const QPolygonF &polyline = way->polyline();
+    for (int i = 0; i < polyline.size() - 1; i++) {
+        this->insertSegment(way, polyline, i);
+    }
+    this->m_indexedPolylines.insert(way, polyline);
+}
+
+void LaneletSpatialIndex::updateWayNode(WayItem *way, int nodeIndex)
+{
+    auto indexed = this->m_indexedPolylines.find(way);
+    const QPolygonF &polyline = way->polyline();
+    if (indexed == this->m_indexedPolylines.end() || indexed->size() != polyline.size()) {
+        this->updateWay(way);
+        return;
+    }
+    for (int segment = qMax(0, nodeIndex - 1); segment <= qMin(nodeIndex, polyline.size() - 2); segment++) {
+        this->removeSegment(way, *indexed, segment);
+    }
+    (*indexed)[nodeIndex] = polyline.at(nodeIndex);
+    for (int segment = qMax(0, nodeIndex - 1); segment <= qMin(nodeIndex, polyline.size() - 2); segment++) {
+        this->insertSegment(way, *indexed, segment);
+    }
+}
+
+void LaneletSpatialIndex::removeWay(const WayItem *way)
+{
+    auto indexed = this->m_indexedPolylines.find(way);
+    if (indexed == this->m_indexedPolylines.end()) return;
+    QPolygonF polyline = indexed.value();
+    this->m_indexedPolylines.erase(indexed);
+    for (int i = 0; i < polyline.size() - 1; i++) {
+        this->removeSegment(const_cast<WayItem *>(way), polyline, i);
+    }
+}
+
+void LaneletSpatialIndex::clear()
+{
+    this->m_nodeCells.clear();
+    this->m_cellOfNode.clear();
+    this->m_segmentCells.clear();
+    this->m_indexedPolylines.clear();
+}
+
+NodeItem *LaneletSpatialIndex::nearestNode(const QPointF &point, qreal radius, const NodeItem *ignore) const
+{
+    QPoint first = cellOf(point - QPointF(radius, radius));
+    QPoint last = cellOf(point + QPointF(radius, radius));
+    NodeItem *nearest = nullptr;
+    qreal nearestDistance = radius * radius;
+    for (int x = first.x(); x <= last.x(); x++) {
+        for (int y = first.y(); y <= last.y(); y++) {
+            auto nodes = this->m_nodeCells.constFind({x, y});
+            if (nodes == this->m_nodeCells.constEnd()) continue;
+            for (auto node : *nodes) {
+                if (node == ignore || !node->isVisible()) continue;
+                QPointF difference = node->pos() - point;
+                qreal distance = QPointF::dotProduct(difference, difference);
+                if (distance > nearestDistance) continue;
+                nearest = node;
+                nearestDistance = distance;
+            }
+        }
+    }
+    return nearest;
+}
+
+WayItem *LaneletSpatialIndex::nearestWay(const QPointF &point, qreal radius) const
+{
+    QPoint first = cellOf(point - QPointF(radius, radius));
+    QPoint last = cellOf(point + QPointF(radius, radius));
+    WayItem *nearest = nullptr;
+    qreal nearestDistance = radius * radius;
+    for (int x = first.x(); x <= last.x(); x++) {
+        for (int y = first.y(); y <= last.y(); y++) {
+            auto segments = this->m_segmentCells.constFind({x, y});
+            if (segments == this->m_segmentCells.constEnd()) continue;
+            for (const auto &segment : *segments) {
+                const QPolygonF &polyline = *this->m_indexedPolylines.constFind(segment.way);
+                qreal distance =
+                    SquaredDistanceToSegment(point, polyline.at(segment.index), polyline.at(segment.index + 1));
+                if (distance > nearestDistance) continue;
+                nearest = segment.way;
+                nearestDistance = distance;
+            }
+        }
+    }
+    return nearest;
+}
+
+qreal LaneletSpatialIndex::snapRadius() const
+{
+    return m_snapRadius;
+}
+
+void LaneletSpatialIndex::setSnapRadius(qreal snapRadius)
+{
+    m_snapRadius = snapRadius;
+}
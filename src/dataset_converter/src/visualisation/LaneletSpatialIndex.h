@@ -0,0 +1,142 @@
+#ifndef LANELETSPATIALINDEX_H
+#define LANELETSPATIALINDEX_H
+
+#include <QHash>
+#include <QPoint>
+#include <QPolygonF>
+#include <QVector>
+
+class NodeItem;
+class WayItem;
+
+/**
+ * Uniform grid over node positions and way segments used by the editor for hit tests and snapping. Nodes are stored in
+ * the cell containing them, segments in every cell they pass through. Items report their changes themselves, so a
+ * moved node only updates its own cell and the two segments next to it. Queries only visit the cells around the query
+ * point and are therefore independent of the map size.
+ */
+class LaneletSpatialIndex
+{
+private:
+    static constexpr qreal CellSize = 32.0; ///< Edge length of a cell in scene units
+
+    /**
+     * Reference to a single segment of a way.
+     */
+    struct Segment
+    {
+        WayItem *way = nullptr; ///< Way the segment belongs to
+        int index = 0; ///< Segment i connects node i and i + 1
+
+        bool operator==(const Segment &other) const
+        {
+            return way == other.way && index == other.index;
+        }
+    };
+
+    QHash<QPoint, QVector<NodeItem *>> m_nodeCells; ///< Nodes per cell
+    QHash<const NodeItem *, QPoint> m_cellOfNode; ///< Cell of each indexed node
+    QHash<QPoint, QVector<Segment>> m_segmentCells; ///< Segments per cell
+    QHash<const WayItem *, QPolygonF> m_indexedPolylines; ///< Node positions of each way as they were indexed
+    qreal m_snapRadius = 0; ///< Distance in scene units in which dragged nodes snap to other nodes, 0 to disable
+
+    /**
+     * Calculates the cell containing a point.
+     * @param point Point in scene coordinates.
+     * @return Cell coordinates.
+     */
+    static QPoint cellOf(const QPointF &point);
+
+    /**
+     * Visits all cells a line passes through.
+     * @param from Start of the line.
+     * @param to End of the line.
+     * @param function Called with each cell.
+     */
+    template<typename Function>
+    static void forEachCell(const QPointF &from, const QPointF &to, Function function);
+
+    /**
+     * Adds a segment to all cells it passes through.
+     * @param way Way the segment belongs to.
+     * @param polyline Node positions of the way.
+     * @param index Index of the segment.
+     */
+    void insertSegment(WayItem *way, const QPolygonF &polyline, int index);
+
+    /**
+     * Removes a segment from all cells it passes through.
+     * @param way Way the segment belongs to.
+     * @param polyline Node positions of the way at the time the segment was inserted.
+     * @param index Index of the segment.
+     */
+    void removeSegment(WayItem *way, const QPolygonF &polyline, int index);
+
+public:
+    /**
+     * Inserts a node or moves it to the cell of its current position.
+     * @param node Node to update.
+     */
+    void updateNode(NodeItem *node);
+
+    /**
+     * Removes a node.
+     * @param node Node to remove.
+     */
+    void removeNode(const NodeItem *node);
+
+    /**
+     * Inserts a way or reindexes all of its segments.
+     * @param way Way to update.
+     */
+    void updateWay(WayItem *way);
+
+    /**
+     * Reindexes the two segments next to a moved node of a way.
+     * @param way Way the node belongs to.
+     * @param nodeIndex Index of the moved node in the way.
+     */
+    void updateWayNode(WayItem *way, int nodeIndex);
+
+    /**
+     * Removes a way.
+     * @param way Way to remove.
+     */
+    void removeWay(const WayItem *way);
+
+    /**
+     * Removes all nodes and ways.
+     */
+    void clear();
+
+    /**
+     * Finds the visible node closest to a point.
+     * @param point Point in scene coordinates.
+     * @param radius Maximum distance in scene units.
+     * @param ignore Node that is not considered, for example the node that is dragged.
+     * @return Closest node or nullptr if there is none within the radius.
+     */
+    [[nodiscard]] NodeItem *nearestNode(const QPointF &point, qreal radius, const NodeItem *ignore = nullptr) const;
+
+    /**
+     * Finds the way with the segment closest to a point.
+     * @param point Point in scene coordinates.
+     * @param radius Maximum distance in scene units.
+     * @return Closest way or nullptr if there is none within the radius.
+     */
+    [[nodiscard]] WayItem *nearestWay(const QPointF &point, qreal radius) const;
+
+    /**
+     * Getter for the snap radius.
+     * @return Distance in scene units in which dragged nodes snap to other nodes, 0 if disabled.
+     */
+    [[nodiscard]] qreal snapRadius() const;
+
+    /**
+     * Setter for the snap radius.
+     * @param snapRadius Distance in scene units in which dragged nodes snap to other nodes, 0 to disable.
+     */
+    void setSnapRadius(qreal snapRadius);
+};
+
+#endif // LANELETSPATIALINDEX_H
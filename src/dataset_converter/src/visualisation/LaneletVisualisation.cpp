@@ -1,35 +1,139 @@
 #include "LaneletVisualisation.h"
+#include "visualisation/graphics_items/EditTransaction.h"
+#include "visualisation/graphics_items/LevelOfDetail.h"
 #include <QDebug>
+#include <QSet>
+#include <QTimer>
+#include <utility>
 
-LaneletVisualisation::LaneletVisualisation(QGraphicsView *canvas, QObject *parent)
-    : QObject(parent), m_canvas(canvas), m_scene(canvas->scene())
+LaneletVisualisation::LaneletVisualisation(QGraphicsView *canvas, LaneletElementRegistryPtr registry, QObject *parent)
+    : QObject(parent), m_canvas(canvas), m_scene(canvas->scene()), m_registry(std::move(registry))
 {}
 QGraphicsView *LaneletVisualisation::canvas() const
 {
     return m_canvas;
 }
+const LaneletSpatialIndex *LaneletVisualisation::spatialIndex() const
+{
+    return &m_spatialIndex;
+}
+void LaneletVisualisation::setSnapToNodes(bool enabled)
+{
+    this->m_spatialIndex.setSnapRadius(enabled ? SnapRadius : 0);
+}
+void LaneletVisualisation::setLevelOfDetail(qreal levelOfDetail)
+{
+    bool nodesVisible = levelOfDetail >= LevelOfDetail::NODES;
+    if (nodesVisible == this->m_nodesVisible) return;
+    this->m_nodesVisible = nodesVisible;
+    for (auto node : this->m_registry->nodes()) {
+        if (node->scene() != this->m_scene) continue;
+        node->setVisible(nodesVisible || node->isSelected());
+    }
+}
+void LaneletVisualisation::addNodeToScene(NodeItem *node)
+{
+    node->setVisible(this->m_nodesVisible || node->isSelected());
+    this->m_scene->addItem(node);
+    node->setSpatialIndex(&this->m_spatialIndex);
+    this->m_spatialIndex.updateNode(node);
+}
+void LaneletVisualisation::addWayToScene(WayItem *way)
+{
+    this->m_scene->addItem(way);
+    way->setSpatialIndex(&this->m_spatialIndex);
+    this->m_spatialIndex.updateWay(way);
+}
 
 void LaneletVisualisation::visualizeNode(NodeItem *node)
 {
-    this->m_scene->addItem(node);
-    this->m_nodes.push_back(node);
+    this->addNodeToScene(node);
+    // Nodes placed by the user are always shown
+    node->setVisible(true);
     qDebug() << "[LaneletVisualisation] Node visualized!";
 }
 void LaneletVisualisation::visualizeWay(WayItem *way)
 {
-    this->m_scene->addItem(way);
-    this->m_ways.push_back(way);
+    this->addWayToScene(way);
     way->setSelected(true);
     qDebug() << "[LaneletVisualisation] Way visualized!";
 }
 void LaneletVisualisation::visualizeLanelet(LaneletItem *lanelet)
 {
     this->m_scene->addItem(lanelet);
-    this->m_lanelets.push_back(lanelet);
     lanelet->updateElement();
     lanelet->setSelected(true);
     qDebug() << "[LaneletVisualisation] Lanelet visualized!";
 }
+void LaneletVisualisation::visualizeNodes(const QList<NodeItem *> &nodes)
+{
+    this->m_pendingNodes.append(nodes);
+    this->m_totalItems += nodes.size();
+    this->scheduleChunk();
+}
+void LaneletVisualisation::visualizeWays(const QList<WayItem *> &ways)
+{
+    this->m_pendingWays.append(ways);
+    this->m_totalItems += ways.size();
+    this->scheduleChunk();
+}
+void LaneletVisualisation::visualizeLanelets(const QList<LaneletItem *> &lanelets)
+{
+    this->m_pendingLanelets.append(lanelets);
+    this->m_totalItems += lanelets.size();
+    this->scheduleChunk();
+}
+void LaneletVisualisation::finishPopulation()
+{
+    this->m_loadingFinished = true;
+    this->scheduleChunk();
+}
+void LaneletVisualisation::scheduleChunk()
+{
+    if (this->m_chunkScheduled) return;
+    this->m_chunkScheduled = true;
+    QTimer::singleShot(0, this, &LaneletVisualisation::populateChunk);
+}
+void LaneletVisualisation::populateChunk()
+{
+    this->m_chunkScheduled = false;
+
+    // Nodes before ways before lanelets, so elements are never shown without their children
+    int budget = ChunkSize;
+    while (budget > 0 && !this->m_pendingNodes.isEmpty()) {
+        auto node = this->m_pendingNodes.takeFirst();
+        budget--;
+        if (!this->m_registry->contains(node)) continue; // Removed while pending
+        this->addNodeToScene(node);
+    }
+    while (budget > 0 && this->m_pendingNodes.isEmpty() && !this->m_pendingWays.isEmpty()) {
+        auto way = this->m_pendingWays.takeFirst();
+        budget--;
+        if (!this->m_registry->contains(way)) continue; // Removed while pending
+        this->addWayToScene(way);
+    }
+    while (budget > 0 && this->m_pendingWays.isEmpty() && !this->m_pendingLanelets.isEmpty()) {
+        auto lanelet = this->m_pendingLanelets.takeFirst();
+        budget--;
+        if (!this->m_registry->contains(lanelet)) continue; // Removed while pending
+        this->m_scene->addItem(lanelet);
+        lanelet->updateElement();
+    }
+    this->m_populatedItems += ChunkSize - budget;
+    emit populationProgress(this->m_populatedItems, this->m_totalItems);
+
+    if (!this->m_pendingNodes.isEmpty() || !this->m_pendingWays.isEmpty() || !this->m_pendingLanelets.isEmpty()) {
+        this->scheduleChunk();
+        return;
+    }
+    if (!this->m_loadingFinished) return;
+
+    qDebug() << "[LaneletVisualisation]" << this->m_populatedItems << "items visualized!";
+    this->m_populatedItems = 0;
+    this->m_totalItems = 0;
+    this->m_loadingFinished = false;
+    emit populated();
+}
 void LaneletVisualisation::selectItem(QGraphicsItem *item)
 {
     item->setSelected(true);
@@ -48,48 +152,153 @@ void LaneletVisualisation::addWayToLanelet(LaneletItem *lanelet, WayItem *item)
 
 void LaneletVisualisation::removeNode(NodeItem *node)
 {
-    this->m_scene->removeItem(node);
-    this->m_nodes.removeOne(node);
-    for (auto parent : node->ways()) {
-        parent->removeNode(node);
-        emit nodeRemovedFromWay(parent, node);
-        qDebug() << "[LaneletVisualisation] Node removed from way!";
-    }
-    emit nodeRemovedFromVisualisation(node);
-    qDebug() << "[LaneletVisualisation] Node removed from visualization!";
+    this->removeElements({node}, {}, {});
 }
 void LaneletVisualisation::removeWay(WayItem *way)
 {
-    this->m_scene->removeItem(way);
-    this->m_ways.removeOne(way);
-    for (auto child : way->nodes()) {
-        child->removeParent(way);
-        qDebug() << "[LaneletVisualisation] Way removed from node!";
-    }
-    emit wayRemovedFromVisualisation(way);
-    qDebug() << "[LaneletVisualisation] Way removed from visualization!";
+    this->removeElements({}, {way}, {});
 }
 void LaneletVisualisation::removeLanelet(LaneletItem *lanelet)
 {
-    this->m_scene->removeItem(lanelet);
-    this->m_lanelets.removeOne(lanelet);
-    auto rightWay = lanelet->rightWayItem();
-    auto leftWay = lanelet->leftWayItem();
-    if (rightWay) rightWay->removeFromLanelet(lanelet);
-    if (leftWay) leftWay->removeFromLanelet(lanelet);
-    qDebug() << "[LaneletVisualisation] Ways removed from lanelet!";
+    this->removeElements({}, {}, {lanelet});
+}
+void LaneletVisualisation::removeElements(const QList<NodeItem *> &nodes,
+                                          const QList<WayItem *> &ways,
+                                          const QList<LaneletItem *> &lanelets)
+{
+    // Collect everything that goes, lanelets can not exist without their ways
+    QSet<NodeItem *> removedNodes;
+    QSet<WayItem *> removedWays;
+    QSet<LaneletItem *> removedLanelets;
+    for (auto node : nodes) {
+        if (this->m_registry->contains(node)) removedNodes.insert(node);
+    }
+    for (auto way : ways) {
+        if (!this->m_registry->contains(way)) continue;
+        removedWays.insert(way);
+        for (auto lanelet : way->lanelets()) {
+            removedLanelets.insert(lanelet);
+        }
+    }
+    for (auto lanelet : lanelets) {
+        if (this->m_registry->contains(lanelet)) removedLanelets.insert(lanelet);
+    }
+
+    // Deselect once up front, otherwise every removed item triggers its own selection update
+    this->m_scene->clearSelection();
+
+    for (auto lanelet : removedLanelets) {
+        auto rightWay = lanelet->rightWayItem();
+        auto leftWay = lanelet->leftWayItem();
+        if (rightWay) rightWay->removeFromLanelet(lanelet);
+        if (leftWay) leftWay->removeFromLanelet(lanelet);
+        if (lanelet->scene() == this->m_scene) this->m_scene->removeItem(lanelet);
+    }
+    for (auto way : removedWays) {
+        for (auto child : way->nodes()) {
+            child->removeParent(way);
+        }
+        way->setSpatialIndex(nullptr);
+        this->m_spatialIndex.removeWay(way);
+        if (way->scene() == this->m_scene) this->m_scene->removeItem(way);
+    }
+
+    // Every remaining way is rebuilt once, no matter how many of its nodes are removed
+    QSet<WayItem *> affectedWays;
+    for (auto node : removedNodes) {
+        for (auto parent : node->ways()) {
+            affectedWays.insert(parent);
+        }
+    }
+    for (auto way : affectedWays) {
+        QList<NodeItem *> remainingNodes;
+        remainingNodes.reserve(way->nodes().size());
+        for (auto node : way->nodes()) {
+            if (!removedNodes.contains(node)) {
+                remainingNodes.push_back(node);
+                continue;
+            }
+            emit nodeRemovedFromWay(way, node);
+        }
+        way->setNodes(remainingNodes);
+    }
+    for (auto node : removedNodes) {
+        node->setSpatialIndex(nullptr);
+        this->m_spatialIndex.removeNode(node);
+        if (node->scene() == this->m_scene) this->m_scene->removeItem(node);
+    }
+
+    emit elementsRemovedFromVisualisation(removedNodes.values(), removedWays.values(), removedLanelets.values());
+    qDebug() << "[LaneletVisualisation]" << removedNodes.size() << "nodes," << removedWays.size() << "ways and"
+             << removedLanelets.size() << "lanelets removed from visualization!";
+}
+void LaneletVisualisation::removeSelection()
+{
+    QList<NodeItem *> nodes;
+    QList<WayItem *> ways;
+    QList<LaneletItem *> lanelets;
+    for (auto item : this->m_scene->selectedItems()) {
+        if (auto node = qgraphicsitem_cast<NodeItem *>(item)) nodes.push_back(node);
+        else if (auto way = qgraphicsitem_cast<WayItem *>(item)) ways.push_back(way);
+        else if (auto lanelet = qgraphicsitem_cast<LaneletItem *>(item)) lanelets.push_back(lanelet);
+    }
+    this->removeElements(nodes, ways, lanelets);
+}
 
-    emit laneletRemovedFromVisualisation(lanelet);
-    qDebug() << "[LaneletVisualisation] Lanelet removed from visualization!";
+void LaneletVisualisation::setIssues(const QVector<LaneletIssue> &issues)
+{
+    for (auto item : this->m_issueItems) {
+        this->m_scene->removeItem(item);
+    }
+    qDeleteAll(this->m_issueItems);
+    this->m_issueItems.clear();
+
+    this->m_issueItems.reserve(issues.size());
+    for (const auto &issue : issues) {
+        auto item = new IssueItem(issue.message(), issue.isRepairable());
+        item->setPos(issue.position);
+        this->m_scene->addItem(item);
+        this->m_issueItems.push_back(item);
+    }
+}
+
+void LaneletVisualisation::repairIssues(const QVector<LaneletIssue> &issues)
+{
+    QList<NodeItem *> nodes;
+    QList<WayItem *> ways;
+    QList<LaneletItem *> lanelets;
+    for (const auto &issue : issues) {
+        switch (issue.type) {
+            case LaneletIssue::Type::DanglingNode:
+                if (auto node = this->m_registry->node(issue.elementId)) nodes.push_back(node);
+                break;
+            case LaneletIssue::Type::ShortWay:
+                if (auto way = this->m_registry->way(issue.elementId)) ways.push_back(way);
+                break;
+            case LaneletIssue::Type::MissingBound:
+                if (auto lanelet = this->m_registry->lanelet(issue.elementId)) lanelets.push_back(lanelet);
+                break;
+            default:
+                break;
+        }
+    }
+    this->removeElements(nodes, ways, lanelets);
+    qDebug() << "[LaneletVisualisation] Repaired" << nodes.size() + ways.size() + lanelets.size() << "elements!";
 }
 
 void LaneletVisualisation::clearVisualisation()
 {
-    for (auto node : this->m_nodes) {
-        this->m_scene->removeItem(node);
+    this->m_spatialIndex.clear();
+    for (auto node : this->m_registry->nodes()) {
+        node->setSpatialIndex(nullptr);
+        if (node->scene() == this->m_scene) this->m_scene->removeItem(node);
+    }
+    for (auto way : this->m_registry->ways()) {
+        way->setSpatialIndex(nullptr);
+        if (way->scene() == this->m_scene) this->m_scene->removeItem(way);
     }
-    for (auto way : this->m_ways) {
-        this->m_scene->removeItem(way);
+    for (auto lanelet : this->m_registry->lanelets()) {
+        if (lanelet->scene() == this->m_scene) this->m_scene->removeItem(lanelet);
     }
     qDebug() << "[LaneletVisualisation] Visualization cleared!";
 }
@@ -100,14 +309,14 @@ void LaneletVisualisation::splineSelection(qreal splineFactor)
     // Get nodes under cursor
     WayItem *selectedWay = nullptr;
     for (auto item : itemsSelected) {
-        auto *wayItem = dynamic_cast<WayItem *>(item);
+        auto *wayItem = qgraphicsitem_cast<WayItem *>(item);
         if (!wayItem) continue;
         selectedWay = wayItem;
         break;
     }
     QList<NodeItem *> nodeItemsUnderCursor;
     for (auto item : itemsSelected) {
-        auto *nodeItem = dynamic_cast<NodeItem *>(item);
+        auto *nodeItem = qgraphicsitem_cast<NodeItem *>(item);
         if (!nodeItem) continue;
         nodeItemsUnderCursor.push_back(nodeItem);
     }
@@ -136,11 +345,11 @@ void LaneletVisualisation::splineSelection(qreal splineFactor)
     }
     positions.push_back(nodesSelected.last()->pos());
 
+    EditTransaction transaction;
     for (int i = 1; i < nodesSelected.size() - 1; i++) {
         auto current = nodesSelected.at(i);
         auto newPosition = positions.at(i);
         current->setPos(newPosition);
-        current->itemChange(QGraphicsItem::ItemPositionChange, newPosition);
     }
 
 }
@@ -5,9 +5,10 @@
 #include <QGraphicsItem>
 #include <QGraphicsView>
 
-#include "visualisation/graphics_items/NodeItem.h"
-#include "visualisation/graphics_items/WayItem.h"
-#include "visualisation/graphics_items/LaneletItem.h"
+#include "worker/LaneletElementRegistry.h"
+#include "worker/LaneletValidator.h"
+#include "visualisation/LaneletSpatialIndex.h"
+#include "visualisation/graphics_items/IssueItem.h"
 
 /**
  * Handler for all lanelet related visualisation tasks.
@@ -20,18 +21,54 @@ private:
     QGraphicsView *const m_canvas = nullptr; ///< Canvas to render on
     QGraphicsScene *const m_scene = nullptr; ///< Scene where all object live in
 
-    // Dynamic scene elements all elements in this list are visualised
-    QList<NodeItem *> m_nodes; ///< All rendered nodes
-    QList<WayItem *> m_ways; ///< All rendered ways
-    QList<LaneletItem *> m_lanelets; ///< All rendered lanelets
+    // Dynamic scene elements, all registered elements are visualised
+    const LaneletElementRegistryPtr m_registry; ///< Registry of all lanelet elements, shared with the handler
+    LaneletSpatialIndex m_spatialIndex; ///< Index of all visualised nodes and ways for hit tests and snapping
+    static constexpr qreal SnapRadius = 6.0; ///< Distance in scene units in which dragged nodes snap to other nodes
+    bool m_nodesVisible = true; ///< False if the view is zoomed out too far to show unselected nodes
+    QList<IssueItem *> m_issueItems; ///< Markers of the current validation issues
+
+    // Bulk population
+    static constexpr int ChunkSize = 2000; ///< Number of items added to the scene per event loop iteration
+    QList<NodeItem *> m_pendingNodes; ///< Nodes waiting to be added to the scene
+    QList<WayItem *> m_pendingWays; ///< Ways waiting to be added to the scene
+    QList<LaneletItem *> m_pendingLanelets; ///< Lanelets waiting to be added to the scene
+    int m_populatedItems = 0; ///< Number of items added during the current population
+    int m_totalItems = 0; ///< Number of items received during the current population
+    bool m_chunkScheduled = false; ///< Whether the next chunk is already scheduled
+    bool m_loadingFinished = false; ///< Whether the loader delivered all items
+
+    /**
+     * Schedules the next chunk for the next event loop iteration.
+     */
+    void scheduleChunk();
+
+    /**
+     * Adds a node to the scene and the spatial index.
+     * @param node Node to add.
+     */
+    void addNodeToScene(NodeItem *node);
+
+    /**
+     * Adds a way to the scene and the spatial index.
+     * @param way Way to add.
+     */
+    void addWayToScene(WayItem *way);
+
+private slots:
+    /**
+     * Adds the next chunk of pending items to the scene and reports the progress.
+     */
+    void populateChunk();
 
 public:
     /**
      * Initialises the service by setting up scene and canvas.
      * @param canvas Canvas to draw on.
+     * @param registry Registry of all lanelet elements, shared with the handler.
      * @param parent Possible parent or qt pointer destruction.
      */
-    explicit LaneletVisualisation(QGraphicsView *canvas, QObject *parent = nullptr);
+    LaneletVisualisation(QGraphicsView *canvas, LaneletElementRegistryPtr registry, QObject *parent = nullptr);
 
     /**
      * Getter for the canvas.
@@ -39,6 +76,12 @@ public:
      */
     [[nodiscard]] QGraphicsView *canvas() const;
 
+    /**
+     * Getter for the spatial index of all visualised nodes and ways.
+     * @return Spatial index.
+     */
+    [[nodiscard]] const LaneletSpatialIndex *spatialIndex() const;
+
 public slots:
 
     /**
@@ -57,6 +100,27 @@ public slots:
      */
     void visualizeLanelet(LaneletItem *lanelet);
 
+    /**
+     * Interface to request a batch of loaded nodes to the render service. The nodes are added in chunks.
+     * @param nodes Nodes to add.
+     */
+    void visualizeNodes(const QList<NodeItem *> &nodes);
+    /**
+     * Interface to request a batch of loaded ways to the render service. The ways are added in chunks.
+     * @param ways Ways to add.
+     */
+    void visualizeWays(const QList<WayItem *> &ways);
+    /**
+     * Interface to request a batch of loaded lanelets to the render service. The lanelets are added in chunks.
+     * @param lanelets Lanelets to add.
+     */
+    void visualizeLanelets(const QList<LaneletItem *> &lanelets);
+
+    /**
+     * Marks that the loader delivered all batches. Emits populated once all pending items are added.
+     */
+    void finishPopulation();
+
     /**
      * Request the service to link a node to a way.
      * @param way Way to add node to.
@@ -88,6 +152,34 @@ public slots:
      */
     void removeLanelet(LaneletItem *lanelet);
 
+    /**
+     * Request the service to remove a selection of elements from the canvas in one transaction. Lanelets of removed
+     * ways are removed as well, ways losing nodes are rebuilt once.
+     * @param nodes Nodes to remove.
+     * @param ways Ways to remove.
+     * @param lanelets Lanelets to remove.
+     */
+    void removeElements(const QList<NodeItem *> &nodes,
+                        const QList<WayItem *> &ways,
+                        const QList<LaneletItem *> &lanelets);
+
+    /**
+     * Request the service to remove all selected elements from the canvas.
+     */
+    void removeSelection();
+
+    /**
+     * Replaces the validation markers.
+     * @param issues Current validation issues.
+     */
+    void setIssues(const QVector<LaneletIssue> &issues);
+
+    /**
+     * Removes all elements of repairable issues, i.e. short ways, lanelets without bound and dangling nodes.
+     * @param issues Validation issues to repair.
+     */
+    void repairIssues(const QVector<LaneletIssue> &issues);
+
     /**
      * Select an item. Implemented to make sure that item are added before they are selected. The Qt event queue makes
      * sure of that.
@@ -101,28 +193,44 @@ public slots:
      */
     void splineSelection(qreal splineFactor);
 
+    /**
+     * Enables or disables snapping of dragged nodes to close nodes.
+     * @param enabled True to snap.
+     */
+    void setSnapToNodes(bool enabled);
+
+    /**
+     * Hides unselected nodes while the view is zoomed out too far to tell them apart. Hidden nodes are neither painted
+     * nor considered by hit tests. Only touches the nodes if the threshold is crossed.
+     * @param levelOfDetail Device pixels per scene unit of the canvas.
+     */
+    void setLevelOfDetail(qreal levelOfDetail);
+
     /**
      * Removed all lanelet elements from the visualisation.
      */
     void clearVisualisation();
 
 signals:
-
     /**
-     * Signal acknowledging the request to remove a node.
-     * @param node Node that was removed.
+     * Progress of adding loaded items to the scene.
+     * @param current Number of added items.
+     * @param max Number of received items.
      */
-    void nodeRemovedFromVisualisation(NodeItem *node);
+    void populationProgress(int current, int max);
+
     /**
-     * Signal acknowledging the request to remove a way.
-     * @param way Way that was removed.
+     * All loaded items are added to the scene.
      */
-    void wayRemovedFromVisualisation(WayItem *way);
+    void populated();
+
     /**
-     * Signal acknowledging the request to remove a lanelet.
-     * @param lanelet Lanelet that was removed.
+     * Signal acknowledging the request to remove elements. The elements are unlinked and no longer part of the scene.
+     * @param nodes Nodes that were removed.
+     * @param ways Ways that were removed.
+     * @param lanelets Lanelets that were removed.
      */
-    void laneletRemovedFromVisualisation(LaneletItem *lanelet);
+    void elementsRemovedFromVisualisation(QList<NodeItem *> nodes, QList<WayItem *> ways, QList<LaneletItem *> lanelets);
     /**
      * Signal acknowledging the request to remove a node from a way.
      * @param way Way that the node was removed from.
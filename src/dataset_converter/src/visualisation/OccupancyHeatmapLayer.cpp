@@ -0,0 +1,156 @@
+#include "OccupancyHeatmapLayer.h"
+
+#include <cmath>
+
+#include <QImage>
+#include <QtConcurrent/QtConcurrent>
+
+using dataset_converter_common::OccupancyHistogram;
+
+OccupancyHeatmapLayer::OccupancyHeatmapLayer(QGraphicsItem *parentItem, qreal scaleFactor, QObject *parent)
+    : QObject(parent), m_item(new QGraphicsPixmapItem(parentItem)), m_scaleFactor(scaleFactor)
+{
+    // Heatmap is drawn below all objects and trails, cells should stay sharp when zooming in
+    this->m_item->setZValue(-2);
+    this->m_item->setTransformationMode(Qt::FastTransformation);
+    this->m_item->setVisible(false);
+}
+
+OccupancyHeatmapLayer::~OccupancyHeatmapLayer()
+{
+    this->abortJob();
+    for (auto &job : this->m_jobs) {
+        job.waitForFinished();
+    }
+}
+
+void OccupancyHeatmapLayer::setScenario(cpm_scenario::ScenarioPtr scenario)
+{
+    this->abortJob();
+    this->m_histogram.reset();
+    this->m_scenario = std::move(scenario);
+    this->update();
+}
+
+void OccupancyHeatmapLayer::setVisible(bool visible)
+{
+    this->m_visible = visible;
+    this->update();
+}
+
+void OccupancyHeatmapLayer::setTypeMask(uint32_t typeMask)
+{
+    this->m_typeMask = typeMask;
+    this->renderHistogram();
+}
+
+void OccupancyHeatmapLayer::abortJob()
+{
+    if (this->m_abort) *this->m_abort = true;
+    this->m_abort.reset();
+    this->m_jobRunning = false;
+    this->m_generation++;
+}
+
+void OccupancyHeatmapLayer::update()
+{
+    if (!this->m_visible || !this->m_scenario) {
+        this->m_item->setVisible(false);
+        return;
+    }
+
+    // Use cached histogram if it belongs to this very scenario
+    auto key = reinterpret_cast<quintptr>(this->m_scenario.get());
+    auto cached = this->m_cache.object(key);
+    if (cached && cached->scenario.lock() == this->m_scenario) {
+        this->m_histogram = cached->histogram;
+        this->renderHistogram();
+        return;
+    }
+    this->renderHistogram();
+    if (this->m_jobRunning) return;
+
+    // Build histogram in the background, every pass hands a snapshot to the gui thread
+    this->m_jobRunning = true;
+    this->m_abort = std::make_shared<std::atomic_bool>(false);
+    quint64 generation = this->m_generation;
+    auto abort = this->m_abort;
+    auto scenario = this->m_scenario;
+    for (auto job = this->m_jobs.begin(); job != this->m_jobs.end();) {
+        job = job->isFinished() ? this->m_jobs.erase(job) : job + 1;
+    }
+    this->m_jobs.append(QtConcurrent::run([this, generation, abort, scenario]()
+    {
+        auto histogram = OccupancyHistogram::ForScenario(scenario, CellSize);
+        histogram.Build(scenario, Passes, [this, generation, abort](const OccupancyHistogram &current)
+        {
+            if (*abort) return false;
+            auto snapshot = std::make_shared<const OccupancyHistogram>(current);
+            QMetaObject::invokeMethod(this, [this, generation, snapshot]()
+            {
+                this->onHistogramUpdated(generation, snapshot);
+            }, Qt::QueuedConnection);
+            return true;
+        });
+    }));
+}
+
+void OccupancyHeatmapLayer::onHistogramUpdated(quint64 generation, const HistogramPtr &histogram)
+{
+    if (generation != this->m_generation) return;
+    this->m_histogram = histogram;
+
+    // Cache finished histogram
+    if (histogram->GetCompleteness() >= 1.0) {
+        this->m_jobRunning = false;
+        this->m_abort.reset();
+        auto cached = new CachedHistogram{this->m_scenario, histogram};
+        auto cost = histogram->GetWidth() * histogram->GetHeight() * OccupancyHistogram::kNumberOfTypes * 4 / 1024;
+        this->m_cache.insert(reinterpret_cast<quintptr>(this->m_scenario.get()), cached,
+                             qMax(1, static_cast<int>(cost)));
+    }
+    this->renderHistogram();
+}
+
+void OccupancyHeatmapLayer::renderHistogram()
+{
+    if (!this->m_visible || !this->m_histogram || this->m_histogram->GetWidth() == 0) {
+        this->m_item->setVisible(false);
+        return;
+    }
+    const auto &histogram = *this->m_histogram;
+    int width = static_cast<int>(histogram.GetWidth());
+    int height = static_cast<int>(histogram.GetHeight());
+
+    QVector<uint32_t> counts(width * height);
+    uint32_t maximum = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint32_t count = histogram.GetCount(x, y, this->m_typeMask);
+            counts[y * width + x] = count;
+            maximum = qMax(maximum, count);
+        }
+    }
+
+    // Logarithmic scale from blue over yellow to red, empty cells stay transparent
+    QImage image(width, height, QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+    double logMaximum = std::log1p(static_cast<double>(maximum));
+    for (int y = 0; y < height; y++) {
+        auto line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < width; x++) {
+            uint32_t count = counts[y * width + x];
+            if (count == 0) continue;
+            double value = std::log1p(static_cast<double>(count)) / logMaximum;
+            QColor color = QColor::fromHsvF((1.0 - value) * 240.0 / 360.0, 1.0, 1.0, 0.4 + 0.4 * value);
+            line[x] = color.rgba();
+        }
+    }
+
+    qreal cellSize = histogram.GetCellSize() * this->m_scaleFactor;
+    this->m_item->setPixmap(QPixmap::fromImage(image));
+    this->m_item->setPos(histogram.GetOrigin().x() * this->m_scaleFactor,
+                         histogram.GetOrigin().y() * this->m_scaleFactor);
+    this->m_item->setScale(cellSize);
+    this->m_item->setVisible(true);
+}
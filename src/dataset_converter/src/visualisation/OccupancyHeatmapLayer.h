@@ -0,0 +1,108 @@
+#ifndef OCCUPANCYHEATMAPLAYER_H
+#define OCCUPANCYHEATMAPLAYER_H
+
+#include <atomic>
+#include <memory>
+
+#include <QObject>
+#include <QCache>
+#include <QFuture>
+#include <QList>
+#include <QGraphicsPixmapItem>
+#include <cpm_scenario/Scenario.h>
+#include <dataset_converter_common/analysis/OccupancyHistogram.h>
+
+/**
+ * Overlay showing how often each part of the scenario is occupied by objects. The occupancy histogram is computed in
+ * the background in several passes, so a coarse heatmap is shown first and refines while the computation continues.
+ * Finished histograms are cached per scenario, only the colouring is repeated when the type filter changes.
+ */
+class OccupancyHeatmapLayer: public QObject
+{
+Q_OBJECT
+private:
+    typedef std::shared_ptr<const dataset_converter_common::OccupancyHistogram> HistogramPtr;
+
+    /**
+     * Finished histogram of one scenario.
+     */
+    struct CachedHistogram
+    {
+        std::weak_ptr<cpm_scenario::Scenario> scenario; ///< Scenario the histogram belongs to, detects reused addresses
+        HistogramPtr histogram; ///< Finished histogram
+    };
+
+    static constexpr double CellSize = 0.5; ///< Preferred edge length of a histogram cell in meters
+    static constexpr int Passes = 8; ///< Number of refinement passes
+
+    QGraphicsPixmapItem *const m_item = nullptr; ///< Item displaying the heatmap
+    const qreal m_scaleFactor = 1.0; ///< Scale factor from scenario to pixel values
+
+    cpm_scenario::ScenarioPtr m_scenario; ///< Scenario that should be displayed
+    bool m_visible = false; ///< Whether the heatmap should be displayed
+    uint32_t m_typeMask = dataset_converter_common::OccupancyHistogram::kAllTypes; ///< Object types to include
+
+    QCache<quintptr, CachedHistogram> m_cache{256 * 1024}; ///< Finished histograms per scenario, cost in kilobytes
+    HistogramPtr m_histogram; ///< Histogram that is currently displayed, may still be refined
+    quint64 m_generation = 0; ///< Identifies the running job, results of older jobs are discarded
+    bool m_jobRunning = false; ///< Whether a job for the current scenario is running
+    std::shared_ptr<std::atomic_bool> m_abort; ///< Abort flag of the running job
+    QList<QFuture<void>> m_jobs; ///< Jobs that may still be running, aborted jobs finish their current pass
+
+    /**
+     * Displays the heatmap of the current scenario, starting a job if no histogram is cached.
+     */
+    void update();
+
+    /**
+     * Aborts the running job.
+     */
+    void abortJob();
+
+    /**
+     * Colours the current histogram with the current type filter and displays it.
+     */
+    void renderHistogram();
+
+    /**
+     * Receives the result of a pass in the gui thread.
+     * @param generation Job the result belongs to.
+     * @param histogram Histogram after the pass.
+     */
+    void onHistogramUpdated(quint64 generation, const HistogramPtr &histogram);
+
+public:
+    /**
+     * Creates the layer as child of the scenario layer.
+     * @param parentItem Scenario layer the heatmap is aligned to.
+     * @param scaleFactor Scale factor from scenario to pixel values.
+     * @param parent Possible parent or qt pointer destruction.
+     */
+    OccupancyHeatmapLayer(QGraphicsItem *parentItem, qreal scaleFactor, QObject *parent = nullptr);
+
+    /**
+     * Aborts and waits for all running jobs.
+     */
+    ~OccupancyHeatmapLayer() override;
+
+public slots:
+    /**
+     * Setter for the scenario whose heatmap is displayed.
+     * @param scenario New scenario, may be nullptr.
+     */
+    void setScenario(cpm_scenario::ScenarioPtr scenario);
+
+    /**
+     * Shows or hides the heatmap. Histograms are only computed while visible.
+     * @param visible True to show the heatmap.
+     */
+    void setVisible(bool visible);
+
+    /**
+     * Setter for the object types that are included in the heatmap.
+     * @param typeMask Bit mask of type indices, see OccupancyHistogram::TypeIndex.
+     */
+    void setTypeMask(uint32_t typeMask);
+};
+
+#endif // OCCUPANCYHEATMAPLAYER_H
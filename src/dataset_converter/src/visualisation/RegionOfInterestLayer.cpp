@@ -0,0 +1,88 @@
+#include "RegionOfInterestLayer.h"
+
+#include <QPen>
+#include <QBrush>
+
+#include "graphics_items/ColorDefinition.h"
+
+RegionOfInterestLayer::RegionOfInterestLayer(QGraphicsScene *scene, QObject *parent)
+    : QObject(parent), m_item(new QGraphicsPathItem)
+{
+    // The region is drawn above the scenario and the lanelets but does not take clicks
+    QColor fill = ColorDefinitions::ORANGE;
+    fill.setAlpha(40);
+    QPen pen(ColorDefinitions::ORANGE, 0.5, Qt::DashLine);
+    pen.setCosmetic(false);
+    this->m_item->setPen(pen);
+    this->m_item->setBrush(fill);
+    this->m_item->setZValue(20);
+    this->m_item->setAcceptedMouseButtons(Qt::NoButton);
+    scene->addItem(this->m_item);
+}
+
+QList<QPolygonF> RegionOfInterestLayer::polygons() const
+{
+    QList<QPolygonF> polygons;
+    for (const auto &polygon : this->m_polygons) {
+        if (polygon.size() >= 3) polygons.push_back(polygon);
+    }
+    return polygons;
+}
+
+void RegionOfInterestLayer::addVertex(QPointF scenePosition)
+{
+    // Polygons taken from the lanelets or finished before are never extended
+    if (!this->m_drawing) {
+        this->m_polygons.push_back(QPolygonF());
+        this->m_drawing = true;
+    }
+    this->m_polygons.last().push_back(scenePosition);
+    this->update();
+}
+
+void RegionOfInterestLayer::newPolygon()
+{
+    if (!this->m_drawing) return;
+    if (this->m_polygons.last().size() < 3) this->m_polygons.removeLast();
+    this->m_drawing = false;
+    this->update();
+}
+
+void RegionOfInterestLayer::removeLastVertex()
+{
+    if (!this->m_drawing) return;
+    this->m_polygons.last().removeLast();
+    if (this->m_polygons.last().isEmpty()) {
+        this->m_polygons.removeLast();
+        this->m_drawing = false;
+    }
+    this->update();
+}
+
+void RegionOfInterestLayer::setPolygons(const QList<QPolygonF> &polygons)
+{
+    this->m_polygons = polygons;
+    this->m_drawing = false;
+    this->update();
+}
+
+void RegionOfInterestLayer::clear()
+{
+    this->m_polygons.clear();
+    this->m_drawing = false;
+    this->update();
+}
+
+void RegionOfInterestLayer::update()
+{
+    // Polygons are closed as they are tested, so the drawn one is shown closed as well
+    QPainterPath path;
+    path.setFillRule(Qt::WindingFill);
+    for (const auto &polygon : this->m_polygons) {
+        if (polygon.isEmpty()) continue;
+        path.addPolygon(polygon);
+        path.closeSubpath();
+    }
+    this->m_item->setPath(path);
+    emit regionChanged(!this->polygons().isEmpty());
+}
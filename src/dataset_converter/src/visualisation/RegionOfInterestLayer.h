@@ -0,0 +1,77 @@
+#ifndef REGIONOFINTERESTLAYER_H
+#define REGIONOFINTERESTLAYER_H
+
+#include <QObject>
+#include <QList>
+#include <QPolygonF>
+#include <QGraphicsPathItem>
+#include <QGraphicsScene>
+
+/**
+ * Overlay showing the region of interest an export is restricted to. The region is a union of polygons in scene
+ * coordinates, either drawn vertex by vertex with the region tool or taken from the lanelet outlines.
+ */
+class RegionOfInterestLayer: public QObject
+{
+Q_OBJECT
+private:
+    QGraphicsPathItem *const m_item = nullptr; ///< Item displaying the region
+    QList<QPolygonF> m_polygons; ///< Polygons of the region in scene coordinates
+    bool m_drawing = false; ///< Whether the last polygon is being drawn and takes the next vertex
+
+    /**
+     * Displays the current polygons.
+     */
+    void update();
+
+public:
+    /**
+     * Creates the layer on top of all other items.
+     * @param scene Scene to display the region in.
+     * @param parent Possible parent or qt pointer destruction.
+     */
+    explicit RegionOfInterestLayer(QGraphicsScene *scene, QObject *parent = nullptr);
+
+    /**
+     * Getter for the region.
+     * @return Polygons in scene coordinates, polygons with less than three vertices are skipped.
+     */
+    [[nodiscard]] QList<QPolygonF> polygons() const;
+
+public slots:
+    /**
+     * Adds a vertex to the drawn polygon, starts a new polygon if none is being drawn.
+     * @param scenePosition Position of the vertex.
+     */
+    void addVertex(QPointF scenePosition);
+
+    /**
+     * Finishes the drawn polygon, the next vertex starts a new one. A polygon with less than three vertices is dropped.
+     */
+    void newPolygon();
+
+    /**
+     * Removes the last vertex of the drawn polygon.
+     */
+    void removeLastVertex();
+
+    /**
+     * Replaces the region, the next vertex starts a new polygon.
+     * @param polygons Polygons in scene coordinates.
+     */
+    void setPolygons(const QList<QPolygonF> &polygons);
+
+    /**
+     * Removes the region, exports are only restricted to the lab area again.
+     */
+    void clear();
+
+signals:
+    /**
+     * Emitted if the region changed.
+     * @param defined Whether the region contains at least one polygon.
+     */
+    void regionChanged(bool defined);
+};
+
+#endif // REGIONOFINTERESTLAYER_H
@@ -1,6 +1,8 @@
 #include "ScenarioVisualization.h"
 
 #include <QApplication>
+#include <QImageReader>
+#include <QSet>
 
 ScenarioVisualization::ScenarioVisualization(QGraphicsView *canvas, QObject *parent)
     : QObject(parent), m_canvas(canvas), m_scene(new QGraphicsScene(this))
@@ -57,6 +59,20 @@ ScenarioVisualization::ScenarioVisualization(QGraphicsView *canvas, QObject *par
     this->m_scenarioBackgroundItem->setParentItem(this->m_borderItem);
     this->m_scenarioBackgroundItem->setZValue(2);
 
+    // Add placeholder that marks the background area while the image is loading
+    QPen penPlaceholder(this->m_canvas->palette().color(QPalette::Highlight), 2, Qt::DashLine);
+    penPlaceholder.setCosmetic(true);
+    this->m_scenarioBackgroundPlaceholderItem = new QGraphicsRectItem(this->m_scenarioBackgroundItem);
+    this->m_scenarioBackgroundPlaceholderItem->setPen(penPlaceholder);
+    this->m_scenarioBackgroundPlaceholderItem->setBrush(brushHighlightColorPattern);
+    this->m_scenarioBackgroundPlaceholderItem->setVisible(false);
+
+    // Add tiled background that replaces the single image once its pyramid is available
+    this->m_scenarioBackgroundTilesItem = new TiledImageItem(this->m_scenarioBackgroundItem);
+    this->m_scenarioBackgroundTilesItem->setVisible(false);
+    connect(this->m_scenarioBackgroundTilesItem, &TiledImageItem::ready, this,
+            &ScenarioVisualization::onBackgroundTilesReady);
+
     // Draw line around bound rectangle
     this->m_scene->addRect(0, 0, m_labWidth, m_labHeight, penHighlightColor, Qt::NoBrush);
 
@@ -73,6 +89,11 @@ ScenarioVisualization::ScenarioVisualization(QGraphicsView *canvas, QObject *par
     this->m_scenarioForegroundItem->setZValue(9);
     this->m_scenarioForegroundItem->setParentItem(scenarioClippingElement);
 
+    // Add trails overlay that moves with the scenario layer
+    this->m_trajectoryTrailLayer = new TrajectoryTrailLayer(this->m_scenarioForegroundItem, this->m_scaleFactor, this);
+    this->m_occupancyHeatmapLayer =
+        new OccupancyHeatmapLayer(this->m_scenarioForegroundItem, this->m_scaleFactor, this);
+
     // Add indicator of current shift position
     this->m_shiftIndicatorItem = this->m_scene->addEllipse(
         this->m_scenarioShiftX - 5, this->m_scenarioShiftY - 5, 10, 10, Qt::NoPen,
@@ -92,6 +113,17 @@ ScenarioVisualization::ScenarioVisualization(QGraphicsView *canvas, QObject *par
     this->m_frameItem->setBrush(QBrush(Qt::white));
     this->m_frameItem->setZValue(-75);
 
+    // Setup background loading
+    this->m_backgroundImageLoader = new BackgroundImageLoader(this);
+    connect(this->m_backgroundImageLoader, &BackgroundImageLoader::imageReady, this,
+            &ScenarioVisualization::onBackgroundImageReady);
+
+    // Setup prefetching of the object poses
+    this->m_framePrefetcher = new FramePrefetcher();
+    this->m_framePrefetcher->moveToThread(&this->m_prefetchThread);
+    connect(&this->m_prefetchThread, &QThread::finished, this->m_framePrefetcher, &QObject::deleteLater);
+    this->m_prefetchThread.start();
+
     // Make slider update frame
     connect(this, &ScenarioVisualization::frameChanged, this,
             &ScenarioVisualization::updateDynamicObjects);
@@ -111,23 +143,74 @@ ScenarioVisualization::ScenarioVisualization(QGraphicsView *canvas, QObject *par
             &ScenarioVisualization::updateScenarioMetaData);
 }
 
+ScenarioVisualization::~ScenarioVisualization()
+{
+    // Make sure that prefetch thread is stopped
+    this->m_prefetchThread.quit();
+    this->m_prefetchThread.wait();
+}
+
 void ScenarioVisualization::updateScenarioBackgroundImage(cpm_scenario::ScenarioPtr scenario)
 {
     if (!scenario) {
+        this->m_backgroundImagePath.clear();
+        this->m_scenarioBackgroundPlaceholderItem->setVisible(false);
+        this->m_scenarioBackgroundTilesItem->setSource(QString());
+        this->m_scenarioBackgroundTilesItem->setVisible(false);
         this->m_scenarioBackgroundItem->setPixmap(QPixmap(":resources/no-scenario-loaded.png"));
         return;
     }
-    // Scale image
-    QPixmap pixmap(scenario->GetBackgroundImageSourcePath().c_str());
+    QString path = QString::fromStdString(scenario->GetBackgroundImageSourcePath());
     qreal scenarioScaleFactor = scenario->GetBackgroundImageScaleFactor();
     qreal combinedScaleFactor = this->m_scaleFactor * 1.0 / scenarioScaleFactor;
-    int width = std::floor(static_cast<qreal>(pixmap.width()) * combinedScaleFactor);
-    int height = std::floor(static_cast<qreal>(pixmap.height()) * combinedScaleFactor);
+    this->m_backgroundImagePath = path;
+    this->m_backgroundImageScaleFactor = combinedScaleFactor;
 
-    // Display image
-    this->m_scenarioBackgroundItem->setPixmap(
-        pixmap.scaled(width, height, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    // Display tiles directly if the pyramid is already cached on disk, otherwise it is generated in the background
+    this->m_scenarioBackgroundTilesItem->setScale(combinedScaleFactor);
+    if (this->m_scenarioBackgroundTilesItem->setSource(path)) {
+        this->m_scenarioBackgroundPlaceholderItem->setVisible(false);
+        this->m_scenarioBackgroundItem->setPixmap(QPixmap());
+        this->m_scenarioBackgroundTilesItem->setVisible(true);
+        return;
+    }
+    this->m_scenarioBackgroundTilesItem->setVisible(false);
 
+    // Display cached image directly
+    QPixmap pixmap;
+    if (this->m_backgroundImageLoader->cachedPixmap(path, combinedScaleFactor, pixmap)) {
+        this->m_scenarioBackgroundPlaceholderItem->setVisible(false);
+        this->m_scenarioBackgroundItem->setPixmap(pixmap);
+        return;
+    }
+
+    // Show placeholder with the final size, reading the size only parses the image header
+    QSize size = QImageReader(path).size();
+    this->m_scenarioBackgroundItem->setPixmap(QPixmap());
+    this->m_scenarioBackgroundPlaceholderItem->setRect(
+        0, 0, std::floor(static_cast<qreal>(size.width()) * combinedScaleFactor),
+        std::floor(static_cast<qreal>(size.height()) * combinedScaleFactor));
+    this->m_scenarioBackgroundPlaceholderItem->setVisible(size.isValid());
+
+    this->m_backgroundImageLoader->request(path, combinedScaleFactor);
+}
+void ScenarioVisualization::onBackgroundImageReady(const QString &path, qreal scaleFactor, const QPixmap &pixmap)
+{
+    // Scenario was changed while the image was loading
+    if (path != this->m_backgroundImagePath || !qFuzzyCompare(scaleFactor, this->m_backgroundImageScaleFactor)) {
+        return;
+    }
+    this->m_scenarioBackgroundPlaceholderItem->setVisible(false);
+    // Tiles were faster than the single image
+    if (this->m_scenarioBackgroundTilesItem->isVisible()) return;
+    this->m_scenarioBackgroundItem->setPixmap(pixmap);
+}
+void ScenarioVisualization::onBackgroundTilesReady(const QString &path)
+{
+    if (path != this->m_backgroundImagePath) return;
+    this->m_scenarioBackgroundPlaceholderItem->setVisible(false);
+    this->m_scenarioBackgroundItem->setPixmap(QPixmap());
+    this->m_scenarioBackgroundTilesItem->setVisible(true);
 }
 void ScenarioVisualization::updateScenarioMetaData(cpm_scenario::ScenarioPtr scenario)
 {
@@ -140,6 +223,17 @@ void ScenarioVisualization::updateScenarioMetaData(cpm_scenario::ScenarioPtr sce
 void ScenarioVisualization::updateDynamicObjects(qint64 frame)
 {
     this->m_frameItem->setText("Frame: " + QString::number(frame));
+    if (!this->m_scenario) return;
+
+    // Use the prefetched poses if they are ready
+    FramePoses framePoses;
+    if (this->m_framePrefetcher->takeFrame(frame, framePoses)) {
+        this->applyFramePoses(framePoses);
+        this->applyShiftToDynamicObjects();
+        return;
+    }
+
+    // Fallback after jumps, compute the frame directly
     for (const auto &object : this->m_scenario->GetObjects()) {
         // Object is not in the scene but was created -> clean up graphic element
         if (!object->IsInScene(frame)
@@ -168,6 +262,33 @@ void ScenarioVisualization::updateDynamicObjects(qint64 frame)
 
     this->applyShiftToDynamicObjects();
 }
+void ScenarioVisualization::applyFramePoses(const FramePoses &framePoses)
+{
+    QSet<qint64> activeIds;
+    for (const auto &pose : framePoses.poses) {
+        auto id = pose.object->GetId();
+        activeIds.insert(id);
+
+        // Object is in scene but no object was created
+        auto item = this->m_idToDynamicElementMap.value(id, nullptr);
+        if (!item) {
+            item = new ExtendedObjectItem(this->m_scenarioForegroundItem, pose.object, this->m_scaleFactor);
+            this->m_idToDynamicElementMap[id] = item;
+        }
+        item->ApplyPose(framePoses.frame, pose);
+    }
+
+    // Object is not in the scene but was created -> clean up graphic element
+    for (auto element = this->m_idToDynamicElementMap.begin(); element != this->m_idToDynamicElementMap.end();) {
+        if (activeIds.contains(element.key())) {
+            element++;
+            continue;
+        }
+        this->m_scene->removeItem(element.value());
+        delete element.value();
+        element = this->m_idToDynamicElementMap.erase(element);
+    }
+}
 void ScenarioVisualization::clearDynamicObjects()
 {
     for (auto child : this->m_idToDynamicElementMap) {
@@ -195,6 +316,9 @@ cpm_scenario::ScenarioPtr ScenarioVisualization::scenario() const
 void ScenarioVisualization::setScenario(cpm_scenario::ScenarioPtr scenario)
 {
     this->m_scenario = scenario;
+    this->m_framePrefetcher->setScenario(scenario, this->m_scaleFactor);
+    this->m_trajectoryTrailLayer->setScenario(scenario);
+    this->m_occupancyHeatmapLayer->setScenario(scenario);
     emit this->scenarioChanged(scenario);
 }
 qint64 ScenarioVisualization::frame() const
@@ -240,6 +364,18 @@ void ScenarioVisualization::setScenarioRotation(qreal rotation)
     this->m_scenarioRotation = rotation;
     emit this->scenarioRotationChanged(m_scenarioRotation);
 }
+void ScenarioVisualization::setTrajectoryTrailsVisible(bool visible)
+{
+    this->m_trajectoryTrailLayer->setVisible(visible);
+}
+void ScenarioVisualization::setOccupancyHeatmapVisible(bool visible)
+{
+    this->m_occupancyHeatmapLayer->setVisible(visible);
+}
+void ScenarioVisualization::setOccupancyHeatmapTypeMask(uint32_t typeMask)
+{
+    this->m_occupancyHeatmapLayer->setTypeMask(typeMask);
+}
 qreal ScenarioVisualization::scenarioRotation() const
 {
     return this->m_scenarioRotation;
@@ -259,4 +395,13 @@ qreal ScenarioVisualization::scaleFactor() const
 {
     return this->m_scaleFactor;
 }
+QPolygonF ScenarioVisualization::mapToScenario(const QPolygonF &scenePolygon) const
+{
+    // Objects are placed in the foreground item at their position times the scale factor
+    QPolygonF polygon = this->m_scenarioForegroundItem->mapFromScene(scenePolygon);
+    for (auto &point : polygon) {
+        point /= this->m_scaleFactor;
+    }
+    return polygon;
+}
 
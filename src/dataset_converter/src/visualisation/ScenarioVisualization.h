@@ -13,8 +13,14 @@
 
 #include <QGraphicsPixmapItem>
 #include <QPixmap>
+#include <QThread>
 
 #include "graphics_items/ExtendedObjectItem.h"
+#include "graphics_items/TiledImageItem.h"
+#include "visualisation/BackgroundImageLoader.h"
+#include "visualisation/TrajectoryTrailLayer.h"
+#include "visualisation/OccupancyHeatmapLayer.h"
+#include "worker/FramePrefetcher.h"
 
 /**
  * Visualisation service for the scenario elements.
@@ -57,6 +63,8 @@ private:
     QGraphicsEllipseItem *m_shiftIndicatorItem = nullptr; ///< Bubble indication the transformation origin.
 
     QGraphicsPixmapItem *m_scenarioBackgroundItem = nullptr; ///< Scenario background image
+    QGraphicsRectItem *m_scenarioBackgroundPlaceholderItem = nullptr; ///< Shown while the background is loading
+    TiledImageItem *m_scenarioBackgroundTilesItem = nullptr; ///< Tiled scenario background for deep zoom
     QGraphicsRectItem *m_scenarioForegroundItem = nullptr; ///< Scenario dynamic element
 
     QGraphicsRectItem *m_borderItem = nullptr; ///< Lan border line
@@ -70,12 +78,43 @@ private:
     qreal m_labWidth = 0.0; ///< Lab background width in pixels
     qreal m_labHeight = 0.0; ///< Lab background height in pixels
 
+    // Background
+    BackgroundImageLoader *m_backgroundImageLoader = nullptr; ///< Decodes and scales background images
+    QString m_backgroundImagePath; ///< Path of the background image that should be displayed
+    qreal m_backgroundImageScaleFactor = 0.0; ///< Scale factor of the background image that should be displayed
+
+    // Overlays
+    TrajectoryTrailLayer *m_trajectoryTrailLayer = nullptr; ///< Trajectories of all objects at once
+    OccupancyHeatmapLayer *m_occupancyHeatmapLayer = nullptr; ///< Occupancy of the scenario area
+
+    // Playback
+    FramePrefetcher *m_framePrefetcher = nullptr; ///< Computes the object poses ahead of the playhead
+    QThread m_prefetchThread; ///< Thread the frame prefetcher lives in
+
+    /**
+     * Updates all dynamic elements from poses that were computed ahead of time.
+     * @param framePoses Poses of all objects active in the frame.
+     */
+    void applyFramePoses(const FramePoses &framePoses);
+
 private slots:
     /**
      * Updates background if new scenario is loaded.
      * @param scenario New scenario.
      */
     void updateScenarioBackgroundImage(cpm_scenario::ScenarioPtr scenario);
+    /**
+     * Displays a background image once it is decoded. Results of scenarios that are no longer selected are ignored.
+     * @param path Image path.
+     * @param scaleFactor Scale factor that was applied.
+     * @param pixmap Scaled image.
+     */
+    void onBackgroundImageReady(const QString &path, qreal scaleFactor, const QPixmap &pixmap);
+    /**
+     * Replaces the single background image with the tiled one once its pyramid is generated.
+     * @param path Image path.
+     */
+    void onBackgroundTilesReady(const QString &path);
     /**
      * Updates metadata such as the title if a new scenario is loaded.
      * @param scenario New scenario.
@@ -105,6 +144,11 @@ public:
      */
     explicit ScenarioVisualization(QGraphicsView *canvas, QObject *parent = nullptr);
 
+    /**
+     * Stops the prefetch thread.
+     */
+    ~ScenarioVisualization() override;
+
     /**
      * Getter for the currently displayed scenario.
      * @return Currently displayed scenario.
@@ -151,6 +195,13 @@ public:
      */
     [[nodiscard]] qreal scaleFactor() const;
 
+    /**
+     * Maps a polygon from the scene into the scenario with the current shift and rotation.
+     * @param scenePolygon Polygon in scene coordinates.
+     * @return Polygon in scenario meters.
+     */
+    [[nodiscard]] QPolygonF mapToScenario(const QPolygonF &scenePolygon) const;
+
 public slots:
     /**
      * Setter for the current scenario. Will clear all objects and load a new background.
@@ -193,6 +244,24 @@ public slots:
      */
     void setScenarioRotation(qreal rotation);
 
+    /**
+     * Shows or hides the trajectories of all objects of the scenario.
+     * @param visible True to show the trajectories.
+     */
+    void setTrajectoryTrailsVisible(bool visible);
+
+    /**
+     * Shows or hides the occupancy heatmap of the scenario.
+     * @param visible True to show the heatmap.
+     */
+    void setOccupancyHeatmapVisible(bool visible);
+
+    /**
+     * Setter for the object types included in the occupancy heatmap.
+     * @param typeMask Bit mask of type indices, see OccupancyHistogram::TypeIndex.
+     */
+    void setOccupancyHeatmapTypeMask(uint32_t typeMask);
+
 signals:
     /**
      * Emitted if the displayed scenario changed.
@@ -0,0 +1,181 @@
+#include "SceneExporter.h"
+
+#include <atomic>
+#include <cmath>
+#include <functional>
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QImage>
+#include <QMutex>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QSvgGenerator>
+#include <QtConcurrent/QtConcurrent>
+
+SceneExporter::SceneExporter(QGraphicsScene *scene, QObject *parent)
+    : QObject(parent), m_scene(scene)
+{
+    this->m_watcher = new QFutureWatcher<QString>(this);
+    connect(this->m_watcher, &QFutureWatcher<QString>::finished, this, &SceneExporter::onExportFinished);
+}
+
+SceneExporter::~SceneExporter()
+{
+    this->m_watcher->waitForFinished();
+}
+
+SceneExporter::Format SceneExporter::formatOf(const QString &fileName)
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "png") return Format::Png;
+    if (suffix == "pdf") return Format::Pdf;
+    return Format::Svg;
+}
+
+bool SceneExporter::isRunning() const
+{
+    return this->m_watcher->isRunning();
+}
+
+QPicture SceneExporter::record(const QRectF &source, qreal scale) const
+{
+    // Scaling before rendering lets the items choose the level of detail of the export resolution
+    QPicture picture;
+    QPainter painter(&picture);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.scale(scale, scale);
+    this->m_scene->render(&painter, QRectF(QPointF(0, 0), source.size()), source, Qt::IgnoreAspectRatio);
+    painter.end();
+    return picture;
+}
+
+bool SceneExporter::exportScene(const QString &fileName, qreal dpi)
+{
+    if (this->isRunning()) return false;
+    this->m_fileName = fileName;
+
+    QRectF source = this->m_scene->sceneRect();
+    Format format = formatOf(fileName);
+    if (format != Format::Png) {
+        QPicture picture = this->record(source, 1.0);
+        this->m_watcher->setFuture(QtConcurrent::run(&SceneExporter::writeVector, picture, source.size(), dpi, format,
+                                                     fileName));
+        return true;
+    }
+
+    qreal scale = dpi / ScreenDpi;
+    QSize size(qMax(1, qCeil(source.width() * scale)), qMax(1, qCeil(source.height() * scale)));
+    QVector<Tile> tiles;
+    for (int y = 0; y < size.height(); y += TileSize) {
+        for (int x = 0; x < size.width(); x += TileSize) {
+            QRect target(x, y, qMin(TileSize, size.width() - x), qMin(TileSize, size.height() - y));
+            QRectF tileSource(source.x() + target.x() / scale, source.y() + target.y() / scale,
+                              target.width() / scale, target.height() / scale);
+            tiles.push_back({target, this->record(tileSource, scale)});
+        }
+    }
+    qDebug() << "[SceneExporter] Recorded" << tiles.size() << "tiles for a" << size << "image";
+
+    this->m_watcher->setFuture(QtConcurrent::run(&SceneExporter::writeRaster, tiles, size, fileName));
+    return true;
+}
+
+QString SceneExporter::writeRaster(const QVector<Tile> &tiles, const QSize &size, const QString &fileName)
+{
+    QVector<Tile> work = tiles;
+    bool writeTiles = qint64(size.width()) * size.height() > MaxImagePixels;
+
+    if (writeTiles) {
+        // Every tile is a file of its own, only the tiles being rasterized are held in memory
+        QFileInfo file(fileName);
+        QString baseName = file.absolutePath() + "/" + file.completeBaseName();
+        std::atomic_bool failed{false};
+        QMutex errorMutex;
+        QString errorMessage;
+        std::function<void(Tile &)> writeTile = [&](Tile &tile)
+        {
+            if (failed) return;
+            QImage image(tile.target.size(), QImage::Format_ARGB32_Premultiplied);
+            image.fill(Qt::transparent);
+            QPainter painter(&image);
+            painter.setRenderHint(QPainter::Antialiasing);
+            tile.picture.play(&painter);
+            painter.end();
+
+            QString tileFileName = QString("%1_%2_%3.png").arg(baseName).arg(tile.target.y() / TileSize)
+                .arg(tile.target.x() / TileSize);
+            if (!image.save(tileFileName, "PNG") && !failed.exchange(true)) {
+                QMutexLocker locker(&errorMutex);
+                errorMessage = QString("Could not write %1").arg(tileFileName);
+            }
+        };
+        QtConcurrent::blockingMap(work, writeTile);
+        return errorMessage;
+    }
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull()) return QString("Not enough memory for a %1x%2 image").arg(size.width()).arg(size.height());
+    image.fill(Qt::transparent);
+
+    // Tiles paint into disjoint parts of the same image through images sharing its memory
+    uchar *bits = image.bits();
+    int bytesPerLine = image.bytesPerLine();
+    std::function<void(Tile &)> rasterizeTile = [bits, bytesPerLine](Tile &tile)
+    {
+        uchar *first = bits + qint64(tile.target.y()) * bytesPerLine + qint64(tile.target.x()) * 4;
+        QImage view(first, tile.target.width(), tile.target.height(), bytesPerLine,
+                    QImage::Format_ARGB32_Premultiplied);
+        QPainter painter(&view);
+        painter.setRenderHint(QPainter::Antialiasing);
+        tile.picture.play(&painter);
+    };
+    QtConcurrent::blockingMap(work, rasterizeTile);
+    work.clear();
+
+    if (!image.save(fileName, "PNG")) return QString("Could not write %1").arg(fileName);
+    return {};
+}
+
+QString SceneExporter::writeVector(const QPicture &picture, const QSizeF &size, qreal dpi, Format format,
+                                   const QString &fileName)
+{
+    QPainter painter;
+    if (format == Format::Pdf) {
+        QPdfWriter writer(fileName);
+        writer.setResolution(qRound(dpi));
+        writer.setPageSize(QPageSize(size / ScreenDpi, QPageSize::Inch));
+        writer.setPageMargins(QMarginsF());
+        if (!painter.begin(&writer)) return QString("Could not write %1").arg(fileName);
+        painter.scale(dpi / ScreenDpi, dpi / ScreenDpi);
+        picture.play(&painter);
+        painter.end();
+        return {};
+    }
+
+    // The view box keeps scene units, the resolution only sets the physical size
+    QSvgGenerator generator;
+    generator.setFileName(fileName);
+    generator.setResolution(qRound(dpi));
+    generator.setSize(QSize(qCeil(size.width() * dpi / ScreenDpi), qCeil(size.height() * dpi / ScreenDpi)));
+    generator.setViewBox(QRectF(QPointF(0, 0), size));
+    generator.setTitle(QFileInfo(fileName).completeBaseName());
+    generator.setDescription(tr("Lanelet map exported by the dataset converter."));
+    if (!painter.begin(&generator)) return QString("Could not write %1").arg(fileName);
+    picture.play(&painter);
+    painter.end();
+    return {};
+}
+
+void SceneExporter::onExportFinished()
+{
+    QString errorMessage = this->m_watcher->result();
+    if (errorMessage.isEmpty()) {
+        qDebug() << "[SceneExporter] Exported to" << this->m_fileName;
+        emit exported(this->m_fileName);
+    }
+    else {
+        qWarning("Export failed: %s", qUtf8Printable(errorMessage));
+        emit error(errorMessage);
+    }
+}
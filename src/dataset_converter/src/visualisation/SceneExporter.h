@@ -0,0 +1,135 @@
+#ifndef SCENEEXPORTER_H
+#define SCENEEXPORTER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QGraphicsScene>
+#include <QPicture>
+#include <QRect>
+#include <QVector>
+
+/**
+ * Exports the scene to svg, pdf or png. The scene is recorded into pictures in the gui thread, which only collects
+ * the paint commands of the items and is cheap compared to rasterization. Everything else runs in the background, so
+ * the scene can be edited while the export is written and the export still shows the state at the time it was started.
+ *
+ * Raster exports are recorded as tiles that are rasterized in parallel. Images larger than MaxImagePixels are not
+ * assembled in memory but written as one png file per tile, so memory use stays bounded for any resolution.
+ * Only to be used in the gui thread.
+ */
+class SceneExporter: public QObject
+{
+Q_OBJECT
+public:
+    /**
+     * Output format, derived from the file suffix.
+     */
+    enum class Format
+    {
+        Svg, ///< Vector graphic
+        Pdf, ///< Single page document
+        Png ///< Raster image
+    };
+
+private:
+    static constexpr qreal ScreenDpi = 96.0; ///< Resolution at which one scene unit is one pixel
+    static constexpr int TileSize = 1024; ///< Edge length of a raster tile in pixels
+    static constexpr qint64 MaxImagePixels = 8192LL * 8192LL; ///< Larger raster exports are written as tile files
+
+    /**
+     * Recorded part of a raster export.
+     */
+    struct Tile
+    {
+        QRect target; ///< Pixel rect in the exported image
+        QPicture picture; ///< Paint commands, already scaled to the export resolution
+    };
+
+    QGraphicsScene *const m_scene; ///< Scene to export
+    QFutureWatcher<QString> *m_watcher; ///< Watches the running export
+    QString m_fileName; ///< File of the running export
+
+    /**
+     * Rasterizes recorded tiles. Runs on a worker thread.
+     * @param tiles Recorded tiles covering the image.
+     * @param size Size of the image in pixels.
+     * @param fileName Png file, the suffix is replaced by the tile position if the image is written as tiles.
+     * @return Error message, empty on success.
+     */
+    static QString writeRaster(const QVector<Tile> &tiles, const QSize &size, const QString &fileName);
+
+    /**
+     * Replays a recording into a vector format. Runs on a worker thread.
+     * @param picture Recorded scene at screen resolution.
+     * @param size Size of the recording in scene units.
+     * @param dpi Resolution of the document.
+     * @param format Svg or pdf.
+     * @param fileName Output file.
+     * @return Error message, empty on success.
+     */
+    static QString writeVector(const QPicture &picture, const QSizeF &size, qreal dpi, Format format,
+                               const QString &fileName);
+
+    /**
+     * Records a part of the scene.
+     * @param source Rect in scene coordinates.
+     * @param scale Scale from scene units to output units.
+     * @return Recorded paint commands, source is mapped to the origin.
+     */
+    QPicture record(const QRectF &source, qreal scale) const;
+
+private slots:
+    /**
+     * Reports the result of the export.
+     */
+    void onExportFinished();
+
+public:
+    /**
+     * Creates an idle exporter.
+     * @param scene Scene to export.
+     * @param parent Possible parent or qt pointer destruction.
+     */
+    explicit SceneExporter(QGraphicsScene *scene, QObject *parent = nullptr);
+
+    /**
+     * Waits for a running export.
+     */
+    ~SceneExporter() override;
+
+    /**
+     * Determines the format of a file.
+     * @param fileName Output file.
+     * @return Format matching the suffix, svg for unknown suffixes.
+     */
+    static Format formatOf(const QString &fileName);
+
+    /**
+     * Checks if an export is running.
+     * @return True while an export is written.
+     */
+    [[nodiscard]] bool isRunning() const;
+
+    /**
+     * Records the scene and writes it in the background.
+     * @param fileName Output file, the format is derived from the suffix.
+     * @param dpi Output resolution, 96 writes one pixel per scene unit.
+     * @return False if an export is still running.
+     */
+    bool exportScene(const QString &fileName, qreal dpi);
+
+signals:
+    /**
+     * Emitted after the export was written.
+     * @param fileName Output file.
+     */
+    void exported(QString fileName);
+
+    /**
+     * Emitted if the export could not be written.
+     * @param message Error description.
+     */
+    void error(QString message);
+};
+
+#endif // SCENEEXPORTER_H
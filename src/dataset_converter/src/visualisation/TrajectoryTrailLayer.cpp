@@ -0,0 +1,151 @@
+#include "TrajectoryTrailLayer.h"
+
+#include <cmath>
+
+#include <QPainter>
+#include <QThread>
+#include <QtMath>
+#include <QtConcurrent/QtConcurrent>
+
+#include "graphics_items/ColorDefinition.h"
+
+TrajectoryTrailLayer::TrajectoryTrailLayer(QGraphicsItem *parentItem, qreal scaleFactor, QObject *parent)
+    : QObject(parent), m_item(new QGraphicsPixmapItem(parentItem)), m_scaleFactor(scaleFactor)
+{
+    // Trails are drawn below all objects
+    this->m_item->setZValue(-1);
+    this->m_item->setTransformationMode(Qt::SmoothTransformation);
+    this->m_item->setVisible(false);
+}
+
+TrajectoryTrailLayer::~TrajectoryTrailLayer()
+{
+    if (this->m_watcher) this->m_watcher->waitForFinished();
+}
+
+void TrajectoryTrailLayer::setScenario(cpm_scenario::ScenarioPtr scenario)
+{
+    this->m_scenario = std::move(scenario);
+    this->update();
+}
+
+void TrajectoryTrailLayer::setVisible(bool visible)
+{
+    this->m_visible = visible;
+    this->update();
+}
+
+void TrajectoryTrailLayer::update()
+{
+    this->m_item->setVisible(false);
+    if (!this->m_visible || !this->m_scenario) return;
+
+    // Use cached trails if they belong to this very scenario
+    auto key = reinterpret_cast<quintptr>(this->m_scenario.get());
+    auto trails = this->m_cache.object(key);
+    if (trails && trails->scenario.lock() == this->m_scenario) {
+        qreal resolution = trails->pixmap.width() / trails->bounds.width();
+        this->m_item->setPixmap(trails->pixmap);
+        this->m_item->setPos(trails->bounds.topLeft());
+        this->m_item->setScale(1.0 / resolution);
+        this->m_item->setVisible(true);
+        return;
+    }
+
+    // Only one job at a time, the result of a finished job triggers the next one
+    if (this->m_watcher) return;
+    this->m_renderingScenario = this->m_scenario;
+    this->m_watcher = new QFutureWatcher<Trails>(this);
+    connect(this->m_watcher, &QFutureWatcher<Trails>::finished, this, &TrajectoryTrailLayer::onRenderFinished);
+    this->m_watcher->setFuture(QtConcurrent::run(&TrajectoryTrailLayer::render, this->m_renderingScenario,
+                                                 this->m_scaleFactor));
+}
+
+void TrajectoryTrailLayer::onRenderFinished()
+{
+    Trails trails = this->m_watcher->result();
+    this->m_watcher->deleteLater();
+    this->m_watcher = nullptr;
+
+    auto key = reinterpret_cast<quintptr>(this->m_renderingScenario.get());
+    this->m_renderingScenario.reset();
+    if (!trails.image.isNull()) {
+        // Pixmaps may only be created in the gui thread
+        int cost = qMax(1, static_cast<int>(trails.image.sizeInBytes() / 1024));
+        trails.pixmap = QPixmap::fromImage(trails.image);
+        trails.image = QImage();
+        this->m_cache.insert(key, new Trails(std::move(trails)), cost);
+    }
+    this->update();
+}
+
+TrajectoryTrailLayer::Trails TrajectoryTrailLayer::render(const cpm_scenario::ScenarioPtr &scenario,
+                                                          qreal scaleFactor)
+{
+    Trails trails;
+    trails.scenario = scenario;
+
+    // Collect polylines in scenario layer coordinates
+    struct Trail
+    {
+        QPolygonF points;
+        QRectF bounds;
+        QColor color;
+    };
+    QVector<Trail> trailList;
+    QRectF bounds;
+    for (const auto &object : scenario->GetObjects()) {
+        Trail trail;
+        for (const auto &state : object->GetStates()) {
+            trail.points << QPointF(state.second->GetPosition().x() * scaleFactor,
+                                    state.second->GetPosition().y() * scaleFactor);
+        }
+        if (trail.points.size() < 2) continue;
+        trail.bounds = trail.points.boundingRect();
+        trail.color = object->GetType() == cpm_scenario::ExtendedObjectType::CAR
+                      ? ColorDefinitions::GREEN : ColorDefinitions::VIOLET;
+        trail.color.setAlpha(40);
+        bounds |= trail.bounds;
+        trailList.push_back(std::move(trail));
+    }
+    if (trailList.isEmpty()) return trails;
+
+    // Limit the image size, the margin keeps pens at the border visible
+    bounds.adjust(-2, -2, 2, 2);
+    qreal resolution = qMin(1.0, MaxImageSize / qMax(bounds.width(), bounds.height()));
+    QImage image(qCeil(bounds.width() * resolution), qCeil(bounds.height() * resolution),
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    // Every band paints into its own part of the image memory, so no synchronisation is needed
+    int bandCount = qMax(1, QThread::idealThreadCount());
+    int bandHeight = (image.height() + bandCount - 1) / bandCount;
+    uchar *bits = image.bits();
+    QVector<int> bands;
+    for (int top = 0; top < image.height(); top += bandHeight) {
+        bands.push_back(top);
+    }
+    QtConcurrent::blockingMap(bands, [&](int top)
+    {
+        int height = qMin(bandHeight, image.height() - top);
+        QImage band(bits + static_cast<qptrdiff>(top) * image.bytesPerLine(), image.width(), height,
+                    image.bytesPerLine(), image.format());
+        QRectF bandBounds(bounds.left(), bounds.top() + top / resolution, bounds.width(), height / resolution);
+
+        QPainter painter(&band);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.scale(resolution, resolution);
+        painter.translate(-bandBounds.topLeft());
+        for (const auto &trail : trailList) {
+            if (!trail.bounds.adjusted(-2, -2, 2, 2).intersects(bandBounds)) continue;
+            QPen pen(trail.color, 1.5);
+            pen.setCosmetic(true);
+            painter.setPen(pen);
+            painter.drawPolyline(trail.points);
+        }
+    });
+
+    trails.image = image;
+    trails.bounds = QRectF(bounds.topLeft(), QSizeF(image.width() / resolution, image.height() / resolution));
+    return trails;
+}
@@ -0,0 +1,91 @@
+#ifndef TRAJECTORYTRAILLAYER_H
+#define TRAJECTORYTRAILLAYER_H
+
+#include <memory>
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QGraphicsPixmapItem>
+#include <QFutureWatcher>
+#include <cpm_scenario/Scenario.h>
+
+/**
+ * Overlay showing the trajectories of all objects of a scenario at once. The trajectories are rasterised once per
+ * scenario on worker threads and displayed as a single image in the coordinates of the scenario layer, so shifting
+ * and rotating the scenario does not require rendering again.
+ */
+class TrajectoryTrailLayer: public QObject
+{
+Q_OBJECT
+private:
+    /**
+     * Rasterised trajectories of one scenario.
+     */
+    struct Trails
+    {
+        std::weak_ptr<cpm_scenario::Scenario> scenario; ///< Scenario the trails belong to, detects reused addresses
+        QImage image; ///< Rasterised trajectories as rendered by the worker
+        QPixmap pixmap; ///< Rasterised trajectories ready for display
+        QRectF bounds; ///< Area the image covers in scenario layer coordinates
+    };
+
+    static constexpr int MaxImageSize = 4096; ///< Maximum edge length of the rasterised image in pixels
+
+    QGraphicsPixmapItem *const m_item = nullptr; ///< Item displaying the trails
+    const qreal m_scaleFactor = 1.0; ///< Scale factor from scenario to pixel values
+
+    cpm_scenario::ScenarioPtr m_scenario; ///< Scenario that should be displayed
+    bool m_visible = false; ///< Whether the trails should be displayed
+    QCache<quintptr, Trails> m_cache{256 * 1024}; ///< Rendered trails per scenario, cost in kilobytes
+    QFutureWatcher<Trails> *m_watcher = nullptr; ///< Watches the running render job
+    cpm_scenario::ScenarioPtr m_renderingScenario; ///< Scenario of the running render job
+
+    /**
+     * Renders the trajectories of all objects. Runs on a worker thread and splits the image into bands that are
+     * rasterised in parallel.
+     * @param scenario Scenario to render.
+     * @param scaleFactor Scale factor from scenario to pixel values.
+     * @return Rendered trails.
+     */
+    static Trails render(const cpm_scenario::ScenarioPtr &scenario, qreal scaleFactor);
+
+    /**
+     * Displays the trails of the current scenario, starting a render job if they are not cached.
+     */
+    void update();
+
+    /**
+     * Stores and displays the result of a render job.
+     */
+    void onRenderFinished();
+
+public:
+    /**
+     * Creates the layer as child of the scenario layer.
+     * @param parentItem Scenario layer the trails are aligned to.
+     * @param scaleFactor Scale factor from scenario to pixel values.
+     * @param parent Possible parent or qt pointer destruction.
+     */
+    TrajectoryTrailLayer(QGraphicsItem *parentItem, qreal scaleFactor, QObject *parent = nullptr);
+
+    /**
+     * Waits for a running render job.
+     */
+    ~TrajectoryTrailLayer() override;
+
+public slots:
+    /**
+     * Setter for the scenario whose trails are displayed.
+     * @param scenario New scenario, may be nullptr.
+     */
+    void setScenario(cpm_scenario::ScenarioPtr scenario);
+
+    /**
+     * Shows or hides the trails. Trails are only rendered while visible.
+     * @param visible True to show the trails.
+     */
+    void setVisible(bool visible);
+};
+
+#endif // TRAJECTORYTRAILLAYER_H
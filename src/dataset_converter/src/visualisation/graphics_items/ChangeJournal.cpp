@@ -0,0 +1,50 @@
+#include "ChangeJournal.h"
+
+#include <atomic>
+#include <utility>
+
+#include <QMutex>
+#include <QMutexLocker>
+
+static QMutex s_mutex; ///< Guards the recorded changes
+static ChangeJournal::Changes s_changes; ///< Changes since the last take
+static std::atomic<bool> s_enabled{false}; ///< Whether changes are recorded, checked without locking
+
+bool ChangeJournal::Changes::isEmpty() const
+{
+    return nodes.isEmpty() && ways.isEmpty() && lanelets.isEmpty();
+}
+
+void ChangeJournal::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&s_mutex);
+    s_enabled = enabled;
+    if (!enabled) s_changes = Changes();
+}
+
+void ChangeJournal::recordNode(const NodeItem *node)
+{
+    if (!s_enabled) return;
+    QMutexLocker locker(&s_mutex);
+    s_changes.nodes.insert(node);
+}
+
+void ChangeJournal::recordWay(const WayItem *way)
+{
+    if (!s_enabled) return;
+    QMutexLocker locker(&s_mutex);
+    s_changes.ways.insert(way);
+}
+
+void ChangeJournal::recordLanelet(const LaneletItem *lanelet)
+{
+    if (!s_enabled) return;
+    QMutexLocker locker(&s_mutex);
+    s_changes.lanelets.insert(lanelet);
+}
+
+ChangeJournal::Changes ChangeJournal::take()
+{
+    QMutexLocker locker(&s_mutex);
+    return std::exchange(s_changes, Changes());
+}
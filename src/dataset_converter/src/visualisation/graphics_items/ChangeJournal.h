@@ -0,0 +1,68 @@
+#ifndef CHANGEJOURNAL_H
+#define CHANGEJOURNAL_H
+
+#include <QSet>
+
+class NodeItem;
+class WayItem;
+class LaneletItem;
+
+/**
+ * Records which lanelet elements were added, modified or removed since the changes were last taken. Elements report
+ * their own modifications, the element registry reports additions and removals. Recorded pointers are never
+ * dereferenced by the journal, so elements may be deleted after they were recorded. Nothing is recorded until the
+ * journal is enabled. All functions are thread safe.
+ */
+class ChangeJournal
+{
+public:
+    /**
+     * Elements recorded since the last take.
+     */
+    struct Changes
+    {
+        QSet<const NodeItem *> nodes; ///< Changed nodes
+        QSet<const WayItem *> ways; ///< Changed ways
+        QSet<const LaneletItem *> lanelets; ///< Changed lanelets
+
+        /**
+         * Checks if anything changed.
+         * @return True if no element was recorded.
+         */
+        [[nodiscard]] bool isEmpty() const;
+    };
+
+    ChangeJournal() = delete;
+
+    /**
+     * Starts or stops recording. Stopping drops all recorded changes.
+     * @param enabled True to record.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * Records a changed node.
+     * @param node Added, modified or removed node.
+     */
+    static void recordNode(const NodeItem *node);
+
+    /**
+     * Records a changed way.
+     * @param way Added, modified or removed way.
+     */
+    static void recordWay(const WayItem *way);
+
+    /**
+     * Records a changed lanelet.
+     * @param lanelet Added, modified or removed lanelet.
+     */
+    static void recordLanelet(const LaneletItem *lanelet);
+
+    /**
+     * Takes all recorded changes and starts a new recording.
+     * @return Changes since the last take.
+     */
+    static Changes take();
+};
+
+#endif // CHANGEJOURNAL_H
@@ -0,0 +1,87 @@
+#include "EditTransaction.h"
+#include "NodeItem.h"
+#include "WayItem.h"
+#include "LaneletItem.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QVector>
+#include <algorithm>
+#include <utility>
+
+EditTransaction *EditTransaction::s_current = nullptr;
+
+EditTransaction::EditTransaction()
+{
+    if (!s_current) s_current = this;
+}
+
+EditTransaction::~EditTransaction()
+{
+    if (s_current != this) return;
+    s_current = nullptr;
+    this->commit();
+}
+
+bool EditTransaction::isActive()
+{
+    return s_current;
+}
+
+void EditTransaction::recordNodeMove(const NodeItem *node)
+{
+    if (!s_current) return;
+    for (auto way : node->ways()) {
+        s_current->m_dirtyWays.insert(way);
+    }
+}
+
+void EditTransaction::commit()
+{
+    if (this->m_dirtyWays.isEmpty()) return;
+
+    struct WayJob
+    {
+        WayItem *way;
+        WayItem::Geometry geometry;
+    };
+    struct LaneletJob
+    {
+        LaneletItem *lanelet;
+        LaneletItem::Outline outline;
+    };
+
+    QVector<WayJob> wayJobs;
+    QVector<LaneletJob> laneletJobs;
+    QSet<LaneletItem *> dirtyLanelets;
+    wayJobs.reserve(this->m_dirtyWays.size());
+    for (auto way : this->m_dirtyWays) {
+        wayJobs.push_back({way, {}});
+        for (auto lanelet : way->lanelets()) {
+            if (dirtyLanelets.contains(lanelet)) continue;
+            dirtyLanelets.insert(lanelet);
+            laneletJobs.push_back({lanelet, {}});
+        }
+    }
+
+    // Calculation only reads node positions, nothing is modified until all results are there
+    auto computeWay = [](WayJob &job)
+    { job.geometry = job.way->computeGeometry(); };
+    auto computeLanelet = [](LaneletJob &job)
+    { job.outline = job.lanelet->computeOutline(); };
+    if (wayJobs.size() + laneletJobs.size() >= ParallelThreshold) {
+        QtConcurrent::blockingMap(wayJobs, computeWay);
+        QtConcurrent::blockingMap(laneletJobs, computeLanelet);
+    }
+    else {
+        std::for_each(wayJobs.begin(), wayJobs.end(), computeWay);
+        std::for_each(laneletJobs.begin(), laneletJobs.end(), computeLanelet);
+    }
+
+    // Scene updates have to happen in the gui thread
+    for (auto &job : wayJobs) {
+        job.way->applyGeometry(std::move(job.geometry));
+    }
+    for (auto &job : laneletJobs) {
+        job.lanelet->applyOutline(std::move(job.outline));
+    }
+}
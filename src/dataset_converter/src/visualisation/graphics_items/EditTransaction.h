@@ -0,0 +1,55 @@
+#ifndef EDITTRANSACTION_H
+#define EDITTRANSACTION_H
+
+#include <QSet>
+
+class NodeItem;
+class WayItem;
+
+/**
+ * Groups node moves of one user action. While a transaction exists, moved nodes only mark their ways as dirty. When
+ * the outermost transaction is destroyed, every dirty way and every lanelet using one of them is recomputed exactly
+ * once. The geometry is calculated in parallel for larger edits and applied in the gui thread afterwards. Transactions
+ * may be nested, inner transactions are merged into the outermost one. Only to be used in the gui thread.
+ */
+class EditTransaction
+{
+private:
+    static constexpr int ParallelThreshold = 64; ///< Minimum number of dirty elements to calculate in parallel
+    static EditTransaction *s_current; ///< Outermost transaction or nullptr
+
+    QSet<WayItem *> m_dirtyWays; ///< Ways whose nodes moved during the transaction
+
+    /**
+     * Recomputes all dirty ways and their lanelets.
+     */
+    void commit();
+
+public:
+    /**
+     * Starts a transaction or joins the running one.
+     */
+    EditTransaction();
+
+    /**
+     * Commits the transaction if it is the outermost one.
+     */
+    ~EditTransaction();
+
+    EditTransaction(const EditTransaction &) = delete;
+    EditTransaction &operator=(const EditTransaction &) = delete;
+
+    /**
+     * Checks if a transaction is running.
+     * @return True if node moves are recorded.
+     */
+    static bool isActive();
+
+    /**
+     * Records a node move in the running transaction.
+     * @param node Node that moved.
+     */
+    static void recordNodeMove(const NodeItem *node);
+};
+
+#endif // EDITTRANSACTION_H
@@ -20,7 +20,32 @@ ExtendedObjectItem::ExtendedObjectItem(QGraphicsItem *parent,
                                        cpm_scenario::ExtendedObjectPtr extendedObject,
                                        double scaleFactor)
     : QGraphicsRectItem(parent), extended_object_(std::move(extendedObject)), scale_factor_(scaleFactor)
-{}
+{
+    setAcceptHoverEvents(true);
+}
+
+void ExtendedObjectItem::ApplyPose(long currentFrame, const ObjectPose &pose)
+{
+    current_frame_ = currentFrame;
+    current_state_ = pose.state;
+    if (!extended_object_ || scale_factor_ == 0.0) return;
+
+    // Type and dimensions never change for an object
+    if (!static_properties_set_) {
+        UpdatePenAndBrush();
+        UpdateDimensions(extended_object_->GetDimension().x() * this->scale_factor_,
+                         extended_object_->GetDimension().y() * this->scale_factor_);
+        static_properties_set_ = true;
+    }
+    UpdatePositionAndOrientation(pose.position.x(), pose.position.y(), pose.rotation);
+    this->velocity_arrow_ = pose.velocityArrow.translated(-pose.position).toLine();
+    if (current_state_ && isUnderMouse()) UpdateToolTipText(current_state_);
+}
+void ExtendedObjectItem::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
+{
+    if (current_state_) UpdateToolTipText(current_state_);
+    QGraphicsRectItem::hoverEnterEvent(event);
+}
 
 void ExtendedObjectItem::UpdateObject()
 {
@@ -40,10 +65,11 @@ void ExtendedObjectItem::UpdateObject()
             frame = extended_object_->GetLastFrame();
         }
     }
-    if (!extended_object_->ContainsState(current_frame_)) return;
+    if (!extended_object_->ContainsState(frame)) return;
 
     // Get meta data from current state
     auto state = this->extended_object_->GetStates().at(frame);
+    current_state_ = state;
     qreal x = state->GetPosition().x() * this->scale_factor_;
     qreal y = state->GetPosition().y() * this->scale_factor_;
     qreal vx = state->GetVelocity().x() * this->scale_factor_;
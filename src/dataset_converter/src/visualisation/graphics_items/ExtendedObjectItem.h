@@ -4,6 +4,8 @@
 #include <QGraphicsItem>
 #include <cpm_scenario/ExtendedObject.h>
 
+#include "visualisation/graphics_items/ObjectPose.h"
+
 /**
  * QGraphicsItem that is representing the individual dynamic objects in a scenario.
  */
@@ -19,6 +21,8 @@ private:
 
     // Dynamic data
     long current_frame_ = -1; ///< Frame number of the linked item that should be rendered.
+    std::shared_ptr<cpm_scenario::ObjectState> current_state_; ///< State that is currently rendered.
+    bool static_properties_set_ = false; ///< Flag indicating that pen, brush and dimensions are already set.
 
     /**
      * Main update function that will update all graphical elements.
@@ -58,6 +62,13 @@ private:
      */
     void UpdatePositionAndOrientation(qreal x, qreal y, qreal orientation);
 
+protected:
+    /**
+     * Updates the tool tip only when the mouse enters the object instead of on every frame.
+     * @param event Information about the mouse movement.
+     */
+    void hoverEnterEvent(QGraphicsSceneHoverEvent *event) override;
+
 public:
     /**
      * Creates an visualisation element linked to the provided object using the scale factor.
@@ -83,6 +94,13 @@ public:
      * @param currentFrame Frame to show on next render call.
      */
     void SetCurrentFrame(long currentFrame);
+
+    /**
+     * Applies a pose that was computed ahead of time by the frame prefetcher. Static properties are only set once.
+     * @param currentFrame Frame the pose belongs to.
+     * @param pose Precomputed pose of the linked object.
+     */
+    void ApplyPose(long currentFrame, const ObjectPose &pose);
 };
 
 #endif //EXTENDEDOBJECTITEM_H
@@ -0,0 +1,36 @@
+#include "IssueItem.h"
+#include "ColorDefinition.h"
+
+#include <QPainter>
+
+IssueItem::IssueItem(const QString &message, bool repairable, QGraphicsItem *parent)
+    : QGraphicsItem(parent), m_repairable(repairable)
+{
+    setFlag(ItemIsSelectable, true);
+    setFlag(ItemIgnoresTransformations, true);
+    setToolTip(message);
+    setZValue(8);
+}
+
+int IssueItem::type() const
+{
+    return Type;
+}
+
+QRectF IssueItem::boundingRect() const
+{
+    return {-8, -8, 16, 16};
+}
+
+void IssueItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    QColor color = this->m_repairable ? ColorDefinitions::RED : ColorDefinitions::ORANGE;
+    painter->setPen(QPen(this->isSelected() ? ColorDefinitions::GREEN : Qt::white, 1.5));
+    painter->setBrush(color);
+    painter->drawEllipse(QRectF(-6, -6, 12, 12));
+
+    // Exclamation mark
+    painter->setPen(QPen(Qt::white, 2, Qt::SolidLine, Qt::RoundCap));
+    painter->drawLine(QPointF(0, -3), QPointF(0, 1));
+    painter->drawPoint(QPointF(0, 3.5));
+}
@@ -0,0 +1,46 @@
+#ifndef ISSUEITEM_H
+#define ISSUEITEM_H
+
+#include <QGraphicsItem>
+
+/**
+ * Marker of a problem found by the lanelet map validation. Keeps its size on screen regardless of the zoom.
+ */
+class IssueItem: public QGraphicsItem
+{
+private:
+    bool m_repairable = false; ///< Whether the problem is fixed by the map repair
+
+public:
+    enum { Type = UserType + 4 }; ///< Item type used by qgraphicsitem_cast
+
+    /**
+     * Creates a selectable marker above all lanelet elements.
+     * @param message Description shown as tool tip.
+     * @param repairable Whether the problem is fixed by the map repair, drawn as error instead of warning.
+     * @param parent Possible parent item.
+     */
+    explicit IssueItem(const QString &message, bool repairable, QGraphicsItem *parent = nullptr);
+
+    /**
+     * Item type for qgraphicsitem_cast.
+     * @return Type of issue items.
+     */
+    [[nodiscard]] int type() const override;
+
+    /**
+     * Bounding rect in device pixels.
+     * @return Rect around the marker.
+     */
+    [[nodiscard]] QRectF boundingRect() const override;
+
+    /**
+     * Will render this object.
+     * @param painter QPainter to render with.
+     * @param option Options to follow.
+     * @param widget QWidget to paint on.
+     */
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+};
+
+#endif // ISSUEITEM_H
@@ -1,7 +1,9 @@
 #include "WayItem.h"
 #include "NodeItem.h"
 #include "LaneletItem.h"
+#include "ChangeJournal.h"
 #include "ColorDefinition.h"
+#include "LevelOfDetail.h"
 
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
@@ -13,36 +15,137 @@ LaneletItem::LaneletItem(QGraphicsItem *parent)
     setFlag(ItemIsSelectable, true);
     setZValue(5);
 }
-void LaneletItem::updateElement()
+bool LaneletItem::hasValidWays() const
+{
+    if (!left_way_item_) return false;
+    if (!right_way_item_) return false;
+    if (right_way_item_->nodes().size() < 2) return false;
+    if (left_way_item_->nodes().size() < 2) return false;
+    return true;
+}
+bool LaneletItem::isRightWayInverted() const
 {
-    // Reject update if lanelet is invalid
-    if (!left_way_item_) return;
-    if (!right_way_item_) return;
-    if (right_way_item_->nodes().size() < 2) return;
-    if (left_way_item_->nodes().size() < 2) return;
-
     QLineF first(left_way_item_->nodes().front()->pos(), right_way_item_->nodes().front()->pos());
     QLineF second(left_way_item_->nodes().back()->pos(), right_way_item_->nodes().back()->pos());
     QPointF intersectionPoint;
-    bool rightInverted = first.intersects(second, &intersectionPoint) != QLineF::BoundedIntersection;
+    return first.intersects(second, &intersectionPoint) != QLineF::BoundedIntersection;
+}
+LaneletItem::Outline LaneletItem::computeOutline() const
+{
+    // Reject update if lanelet is invalid
+    if (!hasValidWays()) return {};
 
-    // Transfer both ways into polygons
-    QPolygonF polygon;
+    QPolygonF left;
+    QPolygonF right;
+    left.reserve(left_way_item_->nodes().size());
+    right.reserve(right_way_item_->nodes().size());
     for (auto node : left_way_item_->nodes()) {
-        polygon << node->pos();
+        left << node->pos();
+    }
+    for (auto node : right_way_item_->nodes()) {
+        right << node->pos();
     }
-    if (rightInverted) {
-        for (auto elementPtr = right_way_item_->nodes().rbegin(); elementPtr != right_way_item_->nodes().rend();
-             elementPtr++) {
-            polygon << (*elementPtr)->pos();
+    return outlineOf(left, right);
+}
+LaneletItem::Outline LaneletItem::outlineOf(const QPolygonF &left, const QPolygonF &right)
+{
+    Outline outline;
+    if (left.size() < 2 || right.size() < 2) return outline;
+    outline.valid = true;
+    QLineF first(left.front(), right.front());
+    QLineF second(left.back(), right.back());
+    QPointF intersectionPoint;
+    outline.rightInverted = first.intersects(second, &intersectionPoint) != QLineF::BoundedIntersection;
+
+    // Transfer both ways into polygons
+    outline.polygon.reserve(left.size() + right.size());
+    outline.polygon << left;
+    if (outline.rightInverted) {
+        for (auto point = right.rbegin(); point != right.rend(); point++) {
+            outline.polygon << *point;
         }
     }
     else {
-        for (auto node : right_way_item_->nodes()) {
-            polygon << node->pos();
-        }
+        outline.polygon << right;
     }
-    this->setPolygon(polygon);
+    return outline;
+}
+void LaneletItem::applyOutline(Outline outline)
+{
+    if (!outline.valid) return;
+    right_inverted_ = outline.rightInverted;
+    polygon_ = std::move(outline.polygon);
+    fitBoundingRect();
+}
+void LaneletItem::updateElement()
+{
+    applyOutline(computeOutline());
+}
+void LaneletItem::wayNodeUpdated(WayItem *way, int index)
+{
+    if (!hasValidWays()) return;
+    int leftSize = left_way_item_->nodes().size();
+    int rightSize = right_way_item_->nodes().size();
+    if (polygon_.size() != leftSize + rightSize) {
+        updateElement();
+        return;
+    }
+
+    // Moving an end of a way may flip the direction of the right way
+    if ((index == 0 || index == way->nodes().size() - 1) && isRightWayInverted() != right_inverted_) {
+        updateElement();
+        return;
+    }
+
+    int vertex;
+    if (way == left_way_item_) {
+        vertex = index;
+    }
+    else if (way == right_way_item_) {
+        vertex = leftSize + (right_inverted_ ? rightSize - 1 - index : index);
+    }
+    else {
+        return;
+    }
+    QPointF point = way->nodes().at(index)->pos();
+    polygon_[vertex] = point;
+
+    // Grow the bounding rect only, it is fitted again once the edit is finished
+    if (!bounding_rect_.contains(point)) {
+        QRectF boundingRect = bounding_rect_;
+        boundingRect.setLeft(qMin(boundingRect.left(), point.x()));
+        boundingRect.setRight(qMax(boundingRect.right(), point.x()));
+        boundingRect.setTop(qMin(boundingRect.top(), point.y()));
+        boundingRect.setBottom(qMax(boundingRect.bottom(), point.y()));
+        prepareGeometryChange();
+        bounding_rect_ = boundingRect;
+    }
+    update();
+}
+void LaneletItem::fitBoundingRect()
+{
+    // Leave room for the outline pen
+    QRectF boundingRect = polygon_.boundingRect().adjusted(-1, -1, 1, 1);
+    if (boundingRect != bounding_rect_) {
+        prepareGeometryChange();
+        bounding_rect_ = boundingRect;
+    }
+    update();
+}
+int LaneletItem::type() const
+{
+    return Type;
+}
+QRectF LaneletItem::boundingRect() const
+{
+    return bounding_rect_;
+}
+QPainterPath LaneletItem::shape() const
+{
+    QPainterPath path;
+    path.addPolygon(polygon_);
+    path.closeSubpath();
+    return path;
 }
 //QVariant LaneletItem::itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value)
 //{
@@ -60,8 +163,10 @@ void LaneletItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
     painter->setBrush(this->brush());
 
     // Draw polygon
-    painter->drawPolygon(this->polygon());
-    drawArrows(painter);
+    painter->drawPolygon(polygon_);
+    if (option->levelOfDetailFromTransform(painter->worldTransform()) >= LevelOfDetail::LANELET_ARROWS) {
+        drawArrows(painter);
+    }
     if (this->isSelected()) drawSelectionIndicator(painter, option);
 }
 void LaneletItem::updatePenAndBrush()
@@ -118,23 +223,17 @@ void LaneletItem::drawSelectionIndicator(QPainter *painter, const QStyleOptionGr
 
     painter->setPen(QPen(backgroundColor, penWidth, Qt::SolidLine));
     painter->setBrush(Qt::NoBrush);
-    painter->drawPolygon(polygon());
+    painter->drawPolygon(polygon_);
 
     painter->setPen(QPen(option->palette.windowText(), 0, Qt::DashLine));
     painter->setBrush(Qt::NoBrush);
-    painter->drawPolygon(polygon());
+    painter->drawPolygon(polygon_);
 }
 
 void LaneletItem::drawArrows(QPainter *painter) const
 {
-    if (!this->left_way_item_) return;
-    if (!this->right_way_item_) return;
-    if (right_way_item_->nodes().size() < 2) return;
-    if (left_way_item_->nodes().size() < 2) return;
-    QLineF first(left_way_item_->nodes().front()->pos(), right_way_item_->nodes().front()->pos());
-    QLineF second(left_way_item_->nodes().back()->pos(), right_way_item_->nodes().back()->pos());
-    QPointF intersectionPoint;
-    bool rightInverted = first.intersects(second, &intersectionPoint) != QLineF::BoundedIntersection;
+    if (!hasValidWays()) return;
+    bool rightInverted = right_inverted_;
 
     QLineF
         line(rightInverted ? this->left_way_item_->nodes().last()->pos() : this->left_way_item_->nodes().first()
@@ -173,6 +272,7 @@ QString LaneletItem::laneletType() const
 void LaneletItem::setLaneletType(QString type)
 {
     this->type_ = std::move(type);
+    ChangeJournal::recordLanelet(this);
     this->update();
 }
 WayItem *LaneletItem::leftWayItem() const
@@ -183,6 +283,7 @@ void LaneletItem::setLeftWayItem(WayItem *leftWayItem)
 {
     if (leftWayItem == right_way_item_) return;
     left_way_item_ = leftWayItem;
+    ChangeJournal::recordLanelet(this);
     this->updateElement();
     if (leftWayItem) {
         leftWayItem->addToLanelet(this);
@@ -196,6 +297,7 @@ void LaneletItem::setRightWayItem(WayItem *rightWayItem)
 {
     if (rightWayItem == left_way_item_) return;
     right_way_item_ = rightWayItem;
+    ChangeJournal::recordLanelet(this);
     this->updateElement();
     if (rightWayItem) {
         rightWayItem->addToLanelet(this);
@@ -208,5 +310,6 @@ void LaneletItem::flipDirection()
     auto store = this->left_way_item_;
     this->left_way_item_ = this->right_way_item_;
     this->right_way_item_ = store;
+    ChangeJournal::recordLanelet(this);
     this->updateElement();
 }
@@ -16,6 +16,21 @@ private:
     WayItem *left_way_item_ = nullptr; ///< Left way visual item that is a child of this lanelet
     WayItem *right_way_item_ = nullptr; ///< Left way visual item that is a child of this lanelet
     QString type_ = "unknown"; ///< Internal lanelet type of this lanelet
+    QPolygonF polygon_; ///< Outline made of the left way followed by the right way
+    QRectF bounding_rect_; ///< Bounding rect of the outline, may be too large while nodes are moved
+    bool right_inverted_ = false; ///< Whether the right way is added to the outline in reverse order
+
+    /**
+     * Checks whether both ways are set and have at least two nodes.
+     * @return True if the outline can be built.
+     */
+    [[nodiscard]] bool hasValidWays() const;
+
+    /**
+     * Checks whether the right way points in the opposite direction of the left way.
+     * @return True if the right way has to be reversed to close the outline.
+     */
+    [[nodiscard]] bool isRightWayInverted() const;
 
     /**
      * Draws the dashed line around the element if it it selected.
@@ -36,6 +51,19 @@ private:
     void updatePenAndBrush();
 
 public:
+    enum { Type = UserType + 3 }; ///< Item type used by qgraphicsitem_cast
+
+    /**
+     * Outline derived from the node positions of both ways. Calculated apart from the item, so it can be done off the
+     * gui thread.
+     */
+    struct Outline
+    {
+        QPolygonF polygon; ///< Left way followed by the right way
+        bool rightInverted = false; ///< Whether the right way is reversed
+        bool valid = false; ///< Whether both ways are usable, invalid outlines are not applied
+    };
+
     /**
      * Creates a lanelet item, make it selectable and moves it in the correct z index.
      * @param parent Possible parent item.
@@ -50,6 +78,24 @@ public:
      */
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
 
+    /**
+     * Item type for qgraphicsitem_cast.
+     * @return Type of lanelet items.
+     */
+    [[nodiscard]] int type() const override;
+
+    /**
+     * Overrides this function to use the outline that is updated in place.
+     * @return Bounding rect of the outline.
+     */
+    [[nodiscard]] QRectF boundingRect() const override;
+
+    /**
+     * Overrides this function to use the outline that is updated in place.
+     * @return Outline as shape.
+     */
+    [[nodiscard]] QPainterPath shape() const override;
+
 //    /**
 //     * Will update child elements if this element is moved.
 //     * @param change Type of change.
@@ -100,6 +146,40 @@ public slots:
      */
     void updateElement();
 
+    /**
+     * A node of one of the ways moved. Only the matching vertex of the outline is updated, unless an end of a way moved
+     * and the right way changed its direction relative to the left way.
+     * @param way Way the node belongs to.
+     * @param index Index of the node in the way.
+     */
+    void wayNodeUpdated(WayItem *way, int index);
+
+    /**
+     * Fits the bounding rect to the outline after nodes were moved.
+     */
+    void fitBoundingRect();
+
+    /**
+     * Calculates the outline from the current node positions without modifying the item. Safe to call from worker
+     * threads as long as ways and nodes are not modified meanwhile.
+     * @return New outline.
+     */
+    [[nodiscard]] Outline computeOutline() const;
+
+    /**
+     * Calculates the outline of two ways. Independent of any item, so it can be used with copies of the model.
+     * @param left Node positions of the left way.
+     * @param right Node positions of the right way.
+     * @return Outline, invalid if a way has less than two nodes.
+     */
+    static Outline outlineOf(const QPolygonF &left, const QPolygonF &right);
+
+    /**
+     * Replaces the outline. Has to be called in the gui thread.
+     * @param outline Outline calculated by computeOutline.
+     */
+    void applyOutline(Outline outline);
+
     /**
      * Flips the direction by switching right and left way.
      */
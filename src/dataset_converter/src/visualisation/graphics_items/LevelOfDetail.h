@@ -0,0 +1,16 @@
+#ifndef DATASET_CONVERTER_LEVEL_OF_DETAIL_H_
+#define DATASET_CONVERTER_LEVEL_OF_DETAIL_H_
+
+#include <QtGlobal>
+/**
+ * Zoom thresholds for the lanelet elements. Values are device pixels per scene unit as returned by
+ * QStyleOptionGraphicsItem::levelOfDetailFromTransform, details are not drawn below their threshold.
+ */
+namespace LevelOfDetail
+{
+constexpr static const qreal NODES = 0.75; // Nodes are 4 units wide, hidden once smaller than 3 pixels
+constexpr static const qreal WAY_ARROWS = 1.0; // Way arrows are 3 units long
+constexpr static const qreal LANELET_ARROWS = 0.25; // Lanelet arrows are 20 units long
+constexpr static const qreal LABEL_PIXEL_SIZE = 7.0; // Smallest legible label height in pixels
+}
+#endif //DATASET_CONVERTER_LEVEL_OF_DETAIL_H_
@@ -1,10 +1,16 @@
 #include "NodeItem.h"
 #include "WayItem.h"
+#include "EditTransaction.h"
+#include "ChangeJournal.h"
+#include "visualisation/LaneletSpatialIndex.h"
 #include "ColorDefinition.h"
+#include "LevelOfDetail.h"
 
 #include <QApplication>
 #include <QPainter>
 #include <QPalette>
+#include <QStyleOptionGraphicsItem>
+#include <QGraphicsScene>
 
 NodeItem::NodeItem(QGraphicsItem *parent)
     : QGraphicsItem(parent)
@@ -15,6 +21,10 @@ NodeItem::NodeItem(QGraphicsItem *parent)
     setZValue(7);
 }
 
+int NodeItem::type() const
+{
+    return Type;
+}
 QRectF NodeItem::boundingRect() const
 {
     if (!this->isSelected()) {
@@ -26,6 +36,11 @@ QRectF NodeItem::boundingRect() const
 }
 void NodeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+    const qreal levelOfDetail = option->levelOfDetailFromTransform(painter->worldTransform());
+
+    // Unselected nodes are only noise when zoomed out, the ways still show their shape
+    if (!this->isSelected() && levelOfDetail < LevelOfDetail::NODES) return;
+
     QRectF rect = boundingRect();
 
     QPen pen;
@@ -43,68 +58,83 @@ void NodeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
     painter->setBrush(brush);
     painter->drawEllipse(rect);
 
-    auto font = QApplication::font();
-    font.setPointSizeF(2);
+    if (!this->isSelected()) return;
+
+    // Font and metrics are the same for all nodes
+    static const QFont font = []()
+    {
+        auto font = QApplication::font();
+        font.setPointSizeF(2);
+        return font;
+    }();
+    static const QFontMetrics fm(font);
+    int height = fm.height();
+    if (height * levelOfDetail < LevelOfDetail::LABEL_PIXEL_SIZE) return;
+
     QString text = QString("%1, %2").arg(this->pos().x()).arg(this->pos().y());
-    QFontMetrics fm(font);
     int width = fm.horizontalAdvance(text);
-    int height = fm.height();
 
     painter->setFont(font);
     painter->setPen(Qt::white);
-
-    if (this->isSelected()) {
-        painter->drawText(-static_cast<int>(width / 2.0), static_cast<int>(height / 2.0), text);
-    }
+    painter->drawText(-static_cast<int>(width / 2.0), static_cast<int>(height / 2.0), text);
 }
 QVariant NodeItem::itemChange(GraphicsItemChange change, const QVariant &value)
 {
+    // Snap to the closest node while this node is dragged, nodes moved along with their way never snap
+    if (change == ItemPositionChange && scene() && m_spatial_index && m_spatial_index->snapRadius() > 0
+        && scene()->mouseGrabberItem() == this && !EditTransaction::isActive()) {
+        auto target = m_spatial_index->nearestNode(value.toPointF(), m_spatial_index->snapRadius(), this);
+        if (target) return target->pos();
+    }
 
-    // Do custom update and afterwards the normal update
-    if (change == ItemPositionChange && scene()) {
-        for (auto parent : this->m_parents) {
-            parent->nodeUpdated(this);
+    // Do custom update once the new position is set, so the ways read the current position
+    if (change == ItemPositionHasChanged && scene()) {
+        if (m_spatial_index) m_spatial_index->updateNode(this);
+        ChangeJournal::recordNode(this);
+        if (EditTransaction::isActive()) {
+            EditTransaction::recordNodeMove(this);
+        }
+        else {
+            for (auto parent : this->m_parents) {
+                parent->nodeUpdated(this);
+            }
         }
     }
 
-    // Snap to grid.
-    // TODO Add this feature to the editor
-//  if (change == ItemPositionChange && scene()) {
-//    QPointF gridPosition = value.toPointF();
-//    int gridSize = 10;
-//    gridPosition.setX(round(gridPosition.x() / gridSize) * gridSize);
-//    gridPosition.setY(round(gridPosition.y() / gridSize) * gridSize);
-//    return gridPosition;
-//  }
-
     // Normal update
     return QGraphicsItem::itemChange(change, value);
 }
 
+void NodeItem::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
+{
+    // Ways only grow their bounds while the node is dragged
+    for (auto parent : this->m_parents) {
+        parent->fitGeometry();
+    }
+    QGraphicsItem::mouseReleaseEvent(event);
+}
+
 void NodeItem::parentPositionShifted(QPointF shift)
 {
     this->moveBy(shift.x(), shift.y());
 }
 
-const QList<WayItem *> &NodeItem::ways() const
+const QSet<WayItem *> &NodeItem::ways() const
 {
     return m_parents;
 }
 //void NodeItem::setParents(const QList<WayItem *> &parents) {
 //    m_parents = parents;
 //}
+void NodeItem::setSpatialIndex(LaneletSpatialIndex *spatialIndex)
+{
+    m_spatial_index = spatialIndex;
+}
 void NodeItem::addParent(WayItem *parent)
 {
-    this->m_parents.push_back(parent);
+    this->m_parents.insert(parent);
 }
 void NodeItem::removeParent(WayItem *parent)
 {
-    int index = -1;
-    int counter = -1;
-    for (auto element : this->m_parents) {
-        counter++;
-        if (element != parent) continue;
-        index = counter;
-    }
-    this->m_parents.removeAt(index);
+    this->m_parents.remove(parent);
 }
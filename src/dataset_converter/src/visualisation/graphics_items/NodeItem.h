@@ -2,8 +2,10 @@
 #define NODEITEM_H
 
 #include <QGraphicsItem>
+#include <QSet>
 
 class WayItem;
+class LaneletSpatialIndex;
 
 /**
  * Graphical representation of the nodes making up a way.
@@ -11,16 +13,25 @@ class WayItem;
 class NodeItem: public QGraphicsItem
 {
 private:
-    QList<WayItem *> m_parents; ///< All ways that this item is a child of
+    QSet<WayItem *> m_parents; ///< All ways that this item is a child of
     QPointF m_system_position; ///< Buffer to calculate relative motion
+    LaneletSpatialIndex *m_spatial_index = nullptr; ///< Index to keep up to date with the position, may be nullptr
 
 public:
+    enum { Type = UserType + 1 }; ///< Item type used by qgraphicsitem_cast
+
     /**
      * Creates a node item, make it selectable, movable and moves it in the correct z index.
      * @param parent Possible parent item.
      */
     explicit NodeItem(QGraphicsItem *parent = nullptr);
 
+    /**
+     * Item type for qgraphicsitem_cast.
+     * @return Type of node items.
+     */
+    [[nodiscard]] int type() const override;
+
     /**
      * Overrides this function to make the selection bounding box show up correctly.
      * @return New updated bounding box rectangle.
@@ -36,18 +47,30 @@ public:
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
 
     /**
-     * Will update parent elements if this element is moved.
+     * Will update parent elements if this element is moved. A node dragged by the mouse snaps to close nodes.
      * @param change Type of change.
      * @param value Value of change.
      * @return QGraphicsItem response after filtering desired change.
      */
     QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
 
+    /**
+     * Fits the bounds of the parent ways after the node was dragged.
+     * @param event Information about the mouse movement.
+     */
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
+
     /**
      * Getter for all parent nodes.
      * @return Parent nodes.
      */
-    [[nodiscard]] const QList<WayItem *> &ways() const;
+    [[nodiscard]] const QSet<WayItem *> &ways() const;
+
+    /**
+     * Setter for the spatial index that is informed about position changes and used for snapping.
+     * @param spatialIndex Index or nullptr.
+     */
+    void setSpatialIndex(LaneletSpatialIndex *spatialIndex);
 
 public slots:
     /**
@@ -0,0 +1,34 @@
+#ifndef OBJECTPOSE_H
+#define OBJECTPOSE_H
+
+#include <memory>
+
+#include <QVector>
+#include <QPointF>
+#include <QLineF>
+
+#include <cpm_scenario/ExtendedObject.h>
+
+/**
+ * Pose of a single dynamic object in one frame. All values are given in the coordinates of the scenario layer, so
+ * they can be applied to the graphics item without any further computation.
+ */
+struct ObjectPose
+{
+    cpm_scenario::ExtendedObjectPtr object; ///< Object this pose belongs to
+    std::shared_ptr<cpm_scenario::ObjectState> state; ///< State the pose was computed from
+    QPointF position; ///< Position of the object
+    qreal rotation = 0.0; ///< Rotation of the object in degrees
+    QLineF velocityArrow; ///< Velocity arrow from the object position to the arrow tip
+};
+
+/**
+ * Poses of all objects that are active in a single frame.
+ */
+struct FramePoses
+{
+    qint64 frame = -1; ///< Frame the poses belong to
+    QVector<ObjectPose> poses; ///< Poses of all active objects
+};
+
+#endif // OBJECTPOSE_H
@@ -0,0 +1,249 @@
+#include "TiledImageItem.h"
+
+#include <cmath>
+#include <atomic>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QDateTime>
+#include <QTextStream>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
+
+TiledImageItem::TiledImageItem(QGraphicsItem *parent)
+    : QGraphicsObject(parent)
+{
+    // Exposed rect is needed to only draw the visible tiles
+    this->setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    this->m_loadPool.setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
+}
+
+QString TiledImageItem::pyramidDirectory(const QString &sourcePath)
+{
+    // Size and modification date are part of the key, so modified images get a new pyramid
+    QFileInfo info(sourcePath);
+    QString identifier = QString("%1|%2|%3").arg(info.absoluteFilePath())
+        .arg(info.size())
+        .arg(info.lastModified().toMSecsSinceEpoch());
+    QByteArray hash = QCryptographicHash::hash(identifier.toUtf8(), QCryptographicHash::Md5).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/background_tiles/" + QString::fromLatin1(hash);
+}
+
+QString TiledImageItem::tilePath(const QString &directory, int level, int x, int y)
+{
+    return QString("%1/%2/%3_%4.png").arg(directory).arg(level).arg(x).arg(y);
+}
+
+QString TiledImageItem::tileKey(int level, int x, int y)
+{
+    return QString("%1/%2_%3").arg(level).arg(x).arg(y);
+}
+
+bool TiledImageItem::readIndex(const QString &directory, QSize &imageSize, int &levels)
+{
+    QFile file(directory + "/index");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+    QTextStream stream(&file);
+    int width = 0, height = 0, tileSize = 0;
+    stream >> width >> height >> tileSize >> levels;
+    imageSize = QSize(width, height);
+    return stream.status() == QTextStream::Ok && !imageSize.isEmpty() && tileSize == TileSize && levels > 0;
+}
+
+bool TiledImageItem::buildPyramid(const QString &sourcePath, const QString &directory)
+{
+    QImage image(sourcePath);
+    if (image.isNull()) return false;
+    QSize imageSize = image.size();
+
+    int level = 0;
+    while (true) {
+        if (!QDir().mkpath(QString("%1/%2").arg(directory).arg(level))) return false;
+
+        // Store all tiles of this level in parallel
+        QVector<QPoint> tiles;
+        for (int y = 0; y * TileSize < image.height(); y++) {
+            for (int x = 0; x * TileSize < image.width(); x++) {
+                tiles.push_back(QPoint(x, y));
+            }
+        }
+        std::atomic_bool success{true};
+        QtConcurrent::blockingMap(tiles, [&](const QPoint &tile)
+        {
+            QRect area(tile.x() * TileSize, tile.y() * TileSize, TileSize, TileSize);
+            QImage tileImage = image.copy(area.intersected(image.rect()));
+            if (!tileImage.save(tilePath(directory, level, tile.x(), tile.y()))) success = false;
+        });
+        if (!success) return false;
+
+        if (image.width() <= TileSize && image.height() <= TileSize) break;
+        image = image.scaled((image.width() + 1) / 2, (image.height() + 1) / 2, Qt::IgnoreAspectRatio,
+                             Qt::SmoothTransformation);
+        level++;
+    }
+
+    // Index is written last and renamed into place, so an existing index marks a complete pyramid
+    QFile index(directory + "/index.tmp");
+    if (!index.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) return false;
+    QTextStream stream(&index);
+    stream << imageSize.width() << " " << imageSize.height() << " " << TileSize << " " << level + 1 << "\n";
+    stream.flush();
+    index.close();
+    QFile::remove(directory + "/index");
+    return QFile::rename(directory + "/index.tmp", directory + "/index");
+}
+
+bool TiledImageItem::setSource(const QString &sourcePath)
+{
+    if (sourcePath == this->m_sourcePath && this->isReady()) return true;
+    this->prepareGeometryChange();
+    this->m_sourcePath = sourcePath;
+    this->m_directory.clear();
+    this->m_imageSize = QSize();
+    this->m_levels = 0;
+    this->m_generation++;
+    this->m_tiles.clear();
+    this->m_pendingTiles.clear();
+    if (sourcePath.isEmpty() || !QFileInfo::exists(sourcePath)) return false;
+
+    QString directory = pyramidDirectory(sourcePath);
+    this->m_directory = directory;
+    if (readIndex(directory, this->m_imageSize, this->m_levels)) {
+        this->onPyramidAvailable();
+        return true;
+    }
+
+    // Generate pyramid in the background, a pyramid that is already generated is only waited for
+    if (this->m_buildingDirectories.contains(directory)) return false;
+    this->m_buildingDirectories.insert(directory);
+    auto watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, directory]()
+    {
+        watcher->deleteLater();
+        this->m_buildingDirectories.remove(directory);
+        if (directory != this->m_directory || !watcher->result()) return;
+        this->prepareGeometryChange();
+        if (!readIndex(this->m_directory, this->m_imageSize, this->m_levels)) return;
+        this->onPyramidAvailable();
+        emit ready(this->m_sourcePath);
+    });
+    watcher->setFuture(QtConcurrent::run(&TiledImageItem::buildPyramid, sourcePath, directory));
+    return false;
+}
+
+void TiledImageItem::onPyramidAvailable()
+{
+    // Coarsest level is the fallback for every other tile
+    int coarsest = this->m_levels - 1;
+    int span = TileSize << coarsest;
+    for (int y = 0; y * span < this->m_imageSize.height(); y++) {
+        for (int x = 0; x * span < this->m_imageSize.width(); x++) {
+            this->requestTile(coarsest, x, y);
+        }
+    }
+    this->update();
+}
+
+QString TiledImageItem::source() const
+{
+    return this->m_sourcePath;
+}
+
+bool TiledImageItem::isReady() const
+{
+    return this->m_levels > 0;
+}
+
+QRectF TiledImageItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), this->m_imageSize);
+}
+
+QRectF TiledImageItem::tileRect(int level, int x, int y) const
+{
+    int span = TileSize << level;
+    return QRectF(x * span, y * span, span, span).intersected(this->boundingRect());
+}
+
+void TiledImageItem::requestTile(int level, int x, int y)
+{
+    QString key = tileKey(level, x, y);
+    if (this->m_tiles.contains(key) || this->m_pendingTiles.contains(key)) return;
+    this->m_pendingTiles.insert(key);
+
+    QString path = tilePath(this->m_directory, level, x, y);
+    quint64 generation = this->m_generation;
+    auto watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, generation, key, level, x, y]()
+    {
+        watcher->deleteLater();
+        if (generation != this->m_generation) return;
+        this->m_pendingTiles.remove(key);
+        QImage image = watcher->result();
+        if (image.isNull()) return;
+        this->m_tiles.insert(key, new QPixmap(QPixmap::fromImage(image)),
+                             qMax(1, static_cast<int>(image.sizeInBytes() / 1024)));
+        this->update(this->tileRect(level, x, y));
+    });
+    watcher->setFuture(QtConcurrent::run(&this->m_loadPool, [path]()
+    {
+        return QImage(path);
+    }));
+}
+
+void TiledImageItem::drawTile(QPainter *painter, int level, int x, int y)
+{
+    QRectF target = this->tileRect(level, x, y);
+    if (auto tile = this->m_tiles.object(tileKey(level, x, y))) {
+        painter->drawPixmap(target, *tile, QRectF(QPointF(0, 0), target.size() / (1 << level)));
+        return;
+    }
+    this->requestTile(level, x, y);
+
+    // Draw the matching part of the closest coarser tile that is loaded
+    for (int coarser = level + 1; coarser < this->m_levels; coarser++) {
+        int shift = coarser - level;
+        auto parent = this->m_tiles.object(tileKey(coarser, x >> shift, y >> shift));
+        if (!parent) continue;
+        QRectF parentRect = this->tileRect(coarser, x >> shift, y >> shift);
+        qreal factor = 1 << coarser;
+        QRectF source((target.left() - parentRect.left()) / factor, (target.top() - parentRect.top()) / factor,
+                      target.width() / factor, target.height() / factor);
+        painter->drawPixmap(target, *parent, source);
+        return;
+    }
+}
+
+void TiledImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget)
+    if (!this->isReady()) return;
+
+    // Choose the level that has about one tile pixel per screen pixel
+    qreal levelOfDetail = option->levelOfDetailFromTransform(painter->worldTransform());
+    int level = 0;
+    if (levelOfDetail > 0 && levelOfDetail < 1) {
+        level = qBound(0, static_cast<int>(std::floor(std::log2(1.0 / levelOfDetail))), this->m_levels - 1);
+    }
+
+    QRectF exposed = option->exposedRect.intersected(this->boundingRect());
+    if (exposed.isEmpty()) return;
+    int span = TileSize << level;
+    int firstX = static_cast<int>(std::floor(exposed.left() / span));
+    int lastX = static_cast<int>(std::ceil(exposed.right() / span)) - 1;
+    int firstY = static_cast<int>(std::floor(exposed.top() / span));
+    int lastY = static_cast<int>(std::ceil(exposed.bottom() / span)) - 1;
+
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    for (int y = firstY; y <= lastY; y++) {
+        for (int x = firstX; x <= lastX; x++) {
+            this->drawTile(painter, level, x, y);
+        }
+    }
+}
@@ -0,0 +1,157 @@
+#ifndef TILEDIMAGEITEM_H
+#define TILEDIMAGEITEM_H
+
+#include <QGraphicsObject>
+#include <QCache>
+#include <QSet>
+#include <QPixmap>
+#include <QThreadPool>
+
+/**
+ * Graphical representation of a large image as a pyramid of tiles. The pyramid is generated once per image and cached
+ * on disk. Only the visible tiles with the resolution matching the current zoom are loaded, asynchronously. Until a
+ * tile is loaded, the matching part of a coarser level is drawn instead. The item is sized in pixels of the original
+ * image.
+ */
+class TiledImageItem: public QGraphicsObject
+{
+Q_OBJECT
+public:
+    static constexpr int TileSize = 512; ///< Edge length of a tile in pixels
+
+private:
+    QString m_sourcePath; ///< Image the pyramid is generated from
+    QString m_directory; ///< Directory the pyramid is cached in
+    QSize m_imageSize; ///< Size of the original image, empty as long as the pyramid is not ready
+    int m_levels = 0; ///< Number of pyramid levels, level 0 has the full resolution
+    quint64 m_generation = 0; ///< Increased on every source change so that results in flight are discarded
+
+    QCache<QString, QPixmap> m_tiles{64 * 1024}; ///< Loaded tiles, cost in kilobytes
+    QSet<QString> m_pendingTiles; ///< Tiles that are currently loaded
+    QSet<QString> m_buildingDirectories; ///< Pyramids that are currently generated
+    QThreadPool m_loadPool; ///< Threads loading tiles, separate so that tile loads do not starve other tasks
+
+    /**
+     * Generates the cache directory of an image. It changes if the image file is modified.
+     * @param sourcePath Image path.
+     * @return Cache directory of the pyramid.
+     */
+    static QString pyramidDirectory(const QString &sourcePath);
+
+    /**
+     * Generates the path of a single tile.
+     * @param directory Cache directory of the pyramid.
+     * @param level Pyramid level.
+     * @param x Tile column.
+     * @param y Tile row.
+     * @return Path of the tile.
+     */
+    static QString tilePath(const QString &directory, int level, int x, int y);
+
+    /**
+     * Reads the index of a pyramid. The index is written last, so a pyramid with an index is complete.
+     * @param directory Cache directory of the pyramid.
+     * @param imageSize Output for the original image size.
+     * @param levels Output for the number of levels.
+     * @return True if the pyramid is complete, false otherwise.
+     */
+    static bool readIndex(const QString &directory, QSize &imageSize, int &levels);
+
+    /**
+     * Generates the pyramid of an image. Runs on a worker thread.
+     * @param sourcePath Image path.
+     * @param directory Cache directory of the pyramid.
+     * @return True if the pyramid was generated, false otherwise.
+     */
+    static bool buildPyramid(const QString &sourcePath, const QString &directory);
+
+    /**
+     * Generates the cache key of a tile.
+     * @param level Pyramid level.
+     * @param x Tile column.
+     * @param y Tile row.
+     * @return Cache key.
+     */
+    static QString tileKey(int level, int x, int y);
+
+    /**
+     * Area a tile covers in item coordinates.
+     * @param level Pyramid level.
+     * @param x Tile column.
+     * @param y Tile row.
+     * @return Area of the tile.
+     */
+    [[nodiscard]] QRectF tileRect(int level, int x, int y) const;
+
+    /**
+     * Loads the pyramid index and the coarsest level after the pyramid is available.
+     */
+    void onPyramidAvailable();
+
+    /**
+     * Starts loading a tile if it is not loaded or loading yet.
+     * @param level Pyramid level.
+     * @param x Tile column.
+     * @param y Tile row.
+     */
+    void requestTile(int level, int x, int y);
+
+    /**
+     * Draws a tile or, if it is not loaded yet, the matching part of the closest coarser level.
+     * @param painter QPainter to paint with.
+     * @param level Pyramid level.
+     * @param x Tile column.
+     * @param y Tile row.
+     */
+    void drawTile(QPainter *painter, int level, int x, int y);
+
+public:
+    /**
+     * Creates an empty item.
+     * @param parent Possible parent element this is relative to.
+     */
+    explicit TiledImageItem(QGraphicsItem *parent = nullptr);
+
+    /**
+     * Sets the image to display. If the pyramid is not cached yet, it is generated in the background and ready is
+     * emitted once it is available.
+     * @param sourcePath Image path, an empty path clears the item.
+     * @return True if the pyramid was already cached and is ready, false otherwise.
+     */
+    bool setSource(const QString &sourcePath);
+
+    /**
+     * Getter for the current image path.
+     * @return Current image path.
+     */
+    [[nodiscard]] QString source() const;
+
+    /**
+     * Returns whether the pyramid of the current image is available.
+     * @return True if the tiles can be displayed, false otherwise.
+     */
+    [[nodiscard]] bool isReady() const;
+
+    /**
+     * Bounding rectangle of the original image.
+     * @return Bounding rectangle.
+     */
+    [[nodiscard]] QRectF boundingRect() const override;
+
+    /**
+     * Draws the visible tiles of the level matching the current zoom.
+     * @param painter QPainter to paint with.
+     * @param option Option to respect while painting.
+     * @param widget Widget that is painted on.
+     */
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+signals:
+    /**
+     * Emitted if the pyramid of the current image became available.
+     * @param sourcePath Image path.
+     */
+    void ready(QString sourcePath);
+};
+
+#endif // TILEDIMAGEITEM_H
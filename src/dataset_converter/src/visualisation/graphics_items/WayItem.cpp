@@ -1,11 +1,16 @@
 #include "WayItem.h"
 #include "NodeItem.h"
 #include "LaneletItem.h"
+#include "EditTransaction.h"
+#include "ChangeJournal.h"
+#include "visualisation/LaneletSpatialIndex.h"
 #include "ColorDefinition.h"
+#include "LevelOfDetail.h"
 
 #include <QStyleOptionGraphicsItem>
 #include <QPainter>
 #include <QDebug>
+#include <QSet>
 #include <utility>
 
 WayItem::WayItem(QGraphicsItem *parent)
@@ -16,6 +21,10 @@ WayItem::WayItem(QGraphicsItem *parent)
     setFlag(ItemSendsGeometryChanges, true);
     setZValue(6);
 }
+int WayItem::type() const
+{
+    return Type;
+}
 QPainterPath WayItem::shape() const
 {
     QPainterPath ret;
@@ -24,101 +33,176 @@ QPainterPath WayItem::shape() const
 }
 QRectF WayItem::boundingRect() const
 {
-    return m_selection_polygon.boundingRect();
+    return m_bounding_rect;
 }
 void WayItem::UpdateBoundingBoxPolygon()
 {
-    if (m_nodes.size() < 2) return;
-    double selectionOffset = 2;
-    QPolygonF leftLine;
-    QPolygonF rightLine;
-    for (int i = 0; i < m_nodes.size() - 1; i++) {
-        QLineF line(m_nodes.at(i)->pos(), m_nodes.at(i + 1)->pos());
-        qreal radAngle = line.angle() * M_PI / 180;
-        qreal dx = selectionOffset * sin(radAngle);
-        qreal dy = selectionOffset * cos(radAngle);
-        QPointF offset1 = QPointF(dx, dy);
-        QPointF offset2 = QPointF(-dx, -dy);
-        leftLine << line.p1() + offset1
-                 << line.p2() + offset1;
-        rightLine << line.p1() + offset2
-                  << line.p2() + offset2;
+    if (m_nodes.size() < 2) {
+        m_selection_polygon.clear();
+        fitBoundingRect();
+        return;
     }
-    QPolygonF nPolygon;
-    nPolygon << leftLine;
-    for (auto elementPtr = rightLine.rbegin(); elementPtr != rightLine.rend(); elementPtr++) {
-        nPolygon << (*elementPtr);
+    // Two points per segment on each side, the right side is appended in reverse order
+    m_selection_polygon.resize(4 * (m_nodes.size() - 1));
+    for (int i = 0; i < m_nodes.size() - 1; i++) {
+        updateSelectionSegment(i);
     }
+    fitBoundingRect();
+}
+void WayItem::setSelectionSegment(QPolygonF &selectionPolygon, const QPolygonF &polyline, int segment)
+{
+    double selectionOffset = 2;
+    QLineF line(polyline.at(segment), polyline.at(segment + 1));
+    qreal radAngle = line.angle() * M_PI / 180;
+    qreal dx = selectionOffset * sin(radAngle);
+    qreal dy = selectionOffset * cos(radAngle);
+    QPointF offset1 = QPointF(dx, dy);
+    QPointF offset2 = QPointF(-dx, -dy);
 
-    m_selection_polygon = nPolygon;
+    int sideLength = selectionPolygon.size() / 2;
+    selectionPolygon[2 * segment] = line.p1() + offset1;
+    selectionPolygon[2 * segment + 1] = line.p2() + offset1;
+    selectionPolygon[2 * sideLength - 1 - 2 * segment] = line.p1() + offset2;
+    selectionPolygon[2 * sideLength - 2 - 2 * segment] = line.p2() + offset2;
+}
+void WayItem::updateSelectionSegment(int segment)
+{
+    if (segment < 0 || segment >= m_polyline.size() - 1) return;
+    setSelectionSegment(m_selection_polygon, m_polyline, segment);
+}
+WayItem::Geometry WayItem::computeGeometry() const
+{
+    Geometry geometry;
+    geometry.polyline.reserve(m_nodes.size());
+    for (auto node : m_nodes) {
+        geometry.polyline << node->pos();
+    }
+    if (m_nodes.size() >= 2) {
+        geometry.selectionPolygon.resize(4 * (m_nodes.size() - 1));
+        for (int i = 0; i < m_nodes.size() - 1; i++) {
+            setSelectionSegment(geometry.selectionPolygon, geometry.polyline, i);
+        }
+    }
+    return geometry;
+}
+void WayItem::applyGeometry(Geometry geometry)
+{
+    m_polyline = std::move(geometry.polyline);
+    m_selection_polygon = std::move(geometry.selectionPolygon);
+    m_arrow_path_valid = false;
+    fitBoundingRect();
+    if (m_spatial_index) m_spatial_index->updateWay(this);
+}
+void WayItem::fitBoundingRect()
+{
+    QRectF boundingRect = m_selection_polygon.boundingRect();
+    if (boundingRect != m_bounding_rect) {
+        prepareGeometryChange();
+        m_bounding_rect = boundingRect;
+    }
     update();
 }
+void WayItem::rebuildGeometry()
+{
+    m_polyline.clear();
+    m_polyline.reserve(m_nodes.size());
+    m_node_index.clear();
+    m_node_index.reserve(m_nodes.size());
+    for (int i = 0; i < m_nodes.size(); i++) {
+        m_polyline << m_nodes.at(i)->pos();
+        m_node_index.insert(m_nodes.at(i), i);
+    }
+    m_arrow_path_valid = false;
+    UpdateBoundingBoxPolygon();
+    if (m_spatial_index) m_spatial_index->updateWay(this);
+    updateLanelets();
+}
 void WayItem::addNode(NodeItem *item)
 {
-    if (m_nodes.contains(item)) return;
+    if (m_node_index.contains(item)) return;
 
-    QPainterPath path = this->path();
-    // Prevent line from 0, 0
-    if (this->m_nodes.isEmpty()) {
-        path.moveTo(item->pos());
-    }
-    path.lineTo(item->pos());
-    setPath(path);
+    m_node_index.insert(item, m_nodes.size());
     this->m_nodes.push_back(item);
+    this->m_polyline << item->pos();
+    ChangeJournal::recordWay(this);
+    m_arrow_path_valid = false;
     item->addParent(this);
     UpdateBoundingBoxPolygon();
+    if (m_spatial_index) m_spatial_index->updateWay(this);
     updateLanelets();
 }
-void WayItem::removeNode(NodeItem *item)
+void WayItem::setNodes(const QList<NodeItem *> &items)
 {
-    if (!m_nodes.contains(item)) return;
-    if (m_nodes.empty()) return;
-
-    // Copy path and skip item that is to be removed
-    QPainterPath newPath;
-    QPainterPath path = this->path();
-
-    newPath.moveTo(path.elementAt(0));
+    for (auto node : this->m_nodes) {
+        node->removeParent(this);
+    }
+    this->m_nodes.clear();
 
-    int counter = -1;
-    int index = -1;
-    for (auto element : this->m_nodes) {
-        counter++;
-        if (item == element) {
-            index = counter;
-            continue;
-        }
-        newPath.lineTo(element->pos());
+    QSet<NodeItem *> added;
+    for (auto item : items) {
+        if (!item || added.contains(item)) continue;
+        added.insert(item);
+        this->m_nodes.push_back(item);
+        item->addParent(this);
     }
-    this->setPath(newPath);
+    ChangeJournal::recordWay(this);
+    rebuildGeometry();
+}
+void WayItem::removeNode(NodeItem *item)
+{
+    int index = m_node_index.value(item, -1);
+    if (index < 0) return;
 
     // Remove item
     this->m_nodes.removeAt(index);
-    UpdateBoundingBoxPolygon();
-    updateLanelets();
+    ChangeJournal::recordWay(this);
+    rebuildGeometry();
 }
 
 void WayItem::nodeUpdated(NodeItem *item)
 {
-    if (!m_nodes.contains(item)) return;
+    int index = m_node_index.value(item, -1);
+    if (index < 0) return;
 
-    QPainterPath path = this->path();
-    // Prevent line from 0, 0
-    int counter = -1;
-    for (auto element : this->m_nodes) {
-        counter++;
-        if (item != element) continue;
-        path.setElementPositionAt(counter, item->x(), item->y());
-        break;
+    // Only the segments before and after the node change
+    m_polyline[index] = item->pos();
+    m_arrow_path_valid = false;
+    if (m_nodes.size() >= 2) {
+        updateSelectionSegment(index - 1);
+        updateSelectionSegment(index);
+    }
+
+    // Grow the bounding rect only, it is fitted again once the edit is finished
+    QRectF boundingRect = m_bounding_rect;
+    int sideLength = m_selection_polygon.size() / 2;
+    for (int segment = qMax(0, index - 1); segment <= qMin(index, m_polyline.size() - 2); segment++) {
+        int corners[] = {2 * segment, 2 * segment + 1,
+                         2 * sideLength - 1 - 2 * segment, 2 * sideLength - 2 - 2 * segment};
+        for (auto corner : corners) {
+            const QPointF &point = m_selection_polygon.at(corner);
+            boundingRect.setLeft(qMin(boundingRect.left(), point.x()));
+            boundingRect.setRight(qMax(boundingRect.right(), point.x()));
+            boundingRect.setTop(qMin(boundingRect.top(), point.y()));
+            boundingRect.setBottom(qMax(boundingRect.bottom(), point.y()));
+        }
+    }
+    if (boundingRect != m_bounding_rect) {
+        prepareGeometryChange();
+        m_bounding_rect = boundingRect;
+    }
+    update();
+    if (m_spatial_index) m_spatial_index->updateWayNode(this, index);
+
+    for (auto parent : m_lanelets) {
+        parent->wayNodeUpdated(this, index);
     }
-    this->setPath(path);
-    UpdateBoundingBoxPolygon();
-    updateLanelets();
 }
 QVariant WayItem::itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value)
 {
     if (change == ItemPositionChange && scene()) {
         auto shift = value.toPointF() - this->m_system_position;
+        // Recompute this way and all ways sharing the nodes once instead of once per node
+        EditTransaction transaction;
         for (auto child : this->m_nodes) {
             child->parentPositionShifted(shift);
         }
@@ -135,26 +219,31 @@ void WayItem::updateLanelets()
 }
 void WayItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+    const qreal levelOfDetail = option->levelOfDetailFromTransform(painter->worldTransform());
+
     // Update main pen and brush
     updatePenAndBrush();
     painter->setPen(this->pen());
     painter->setBrush(this->brush());
 
     // Draw line
-    painter->drawPath(this->path());
+    painter->drawPolyline(m_polyline);
 
-    drawArrows(painter);
+    // Arrows would only be a few pixels wide
+    if (levelOfDetail >= LevelOfDetail::WAY_ARROWS) drawArrows(painter);
 
     if (this->isSelected()) drawSelectionIndicator(painter, option);
 }
-void WayItem::drawArrows(QPainter *painter) const
-{// Draw arrows
-    for (auto i = 1; i < m_nodes.size(); i++) {
-        auto last = m_nodes.at(i);
-        auto preLast = m_nodes.at(i - 1);
-
-        QLineF line;
-        line.setLine(preLast->x(), preLast->y(), last->x(), last->y());
+void WayItem::drawArrows(QPainter *painter)
+{
+    if (!m_arrow_path_valid) updateArrowPath();
+    painter->drawPath(m_arrow_path);
+}
+void WayItem::updateArrowPath()
+{
+    m_arrow_path = QPainterPath();
+    for (auto i = 1; i < m_polyline.size(); i++) {
+        QLineF line(m_polyline.at(i - 1), m_polyline.at(i));
         line.setLength(0.5 * line.length());
 
         double angle = atan2(line.dy(), -line.dx());
@@ -167,11 +256,10 @@ void WayItem::drawArrows(QPainter *painter) const
         QPolygonF arrowHead;
         arrowHead << line.p2() << arrowP1 << line.p2() << arrowP2 << line.p2();
 
-        QPainterPath path;
-        path.moveTo(line.p2());
-        path.addPolygon(arrowHead);
-        painter->drawPath(path);
+        m_arrow_path.moveTo(line.p2());
+        m_arrow_path.addPolygon(arrowHead);
     }
+    m_arrow_path_valid = true;
 }
 void WayItem::drawSelectionIndicator(QPainter *painter, const QStyleOptionGraphicsItem *option) const
 {
@@ -219,6 +307,14 @@ const QList<NodeItem *> &WayItem::nodes() const
 {
     return m_nodes;
 }
+const QPolygonF &WayItem::polyline() const
+{
+    return m_polyline;
+}
+void WayItem::setSpatialIndex(LaneletSpatialIndex *spatialIndex)
+{
+    m_spatial_index = spatialIndex;
+}
 QString WayItem::wayType() const
 {
     return m_type;
@@ -226,31 +322,33 @@ QString WayItem::wayType() const
 void WayItem::setWayType(QString type)
 {
     this->m_type = std::move(type);
+    ChangeJournal::recordWay(this);
     this->update();
 }
 
-const QList<LaneletItem *> &WayItem::lanelets() const
+const QSet<LaneletItem *> &WayItem::lanelets() const
 {
     return m_lanelets;
 }
 void WayItem::addToLanelet(LaneletItem *parent)
 {
-    this->m_lanelets.push_back(parent);
+    this->m_lanelets.insert(parent);
 }
 void WayItem::removeFromLanelet(LaneletItem *parent)
 {
-    int index = -1;
-    int counter = -1;
-    for (auto element : this->m_lanelets) {
-        counter++;
-        if (element != parent) continue;
-        index = counter;
-    }
-    this->m_lanelets.removeAt(index);
+    this->m_lanelets.remove(parent);
 }
 void WayItem::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
 {
     // Reset before the next shift
     this->m_system_position = {0, 0};
+    fitGeometry();
     QGraphicsItem::mouseReleaseEvent(event);
 }
+void WayItem::fitGeometry()
+{
+    fitBoundingRect();
+    for (auto parent : m_lanelets) {
+        parent->fitBoundingRect();
+    }
+}
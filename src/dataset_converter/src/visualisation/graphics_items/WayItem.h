@@ -2,10 +2,14 @@
 #define WAYITEM_H
 
 #include <QGraphicsItem>
+#include <QHash>
+#include <QPainterPath>
+#include <QSet>
 #include <cpm_scenario/Scenario.h>
 
 class NodeItem;
 class LaneletItem;
+class LaneletSpatialIndex;
 
 /**
  * Graphical representation of the ways making up a lanelets left and right border.
@@ -14,10 +18,16 @@ class WayItem: public QGraphicsPathItem
 {
 private:
     QList<NodeItem *> m_nodes; ///< Child nodes
-    QList<LaneletItem *> m_lanelets; ///< Parent lanelets
+    QSet<LaneletItem *> m_lanelets; ///< Parent lanelets
     QString m_type = "unknown"; ///< Internal way type
     QPointF m_system_position; ///< Buffer to calculate relative motion
     QPolygonF m_selection_polygon; ///< Polygon to calculate the selection box of a complex shape
+    QPolygonF m_polyline; ///< Positions of the nodes, drawn as line
+    QHash<NodeItem *, int> m_node_index; ///< Index of each node in the way
+    QRectF m_bounding_rect; ///< Bounding rect of the selection polygon, may be too large while nodes are moved
+    LaneletSpatialIndex *m_spatial_index = nullptr; ///< Index to keep up to date with the segments, may be nullptr
+    QPainterPath m_arrow_path; ///< Arrowheads of all segments, built on the next paint after the geometry changed
+    bool m_arrow_path_valid = false; ///< True if the arrow path matches the current polyline
 
 
     /**
@@ -36,7 +46,12 @@ private:
      * Draws direction arrow that shows the direction of the lanelet.
      * @param painter QPainter to paint with.
      */
-    void drawArrows(QPainter *painter) const;
+    void drawArrows(QPainter *painter);
+
+    /**
+     * Builds the arrowheads in the middle of every segment.
+     */
+    void updateArrowPath();
 
     /**
      * Updates the lanelets if this item is modified or moved.
@@ -48,14 +63,55 @@ private:
      */
     void UpdateBoundingBoxPolygon();
 
+    /**
+     * Calculates the four corners of a selection polygon belonging to one segment.
+     * @param selectionPolygon Selection polygon with four corners per segment.
+     * @param polyline Node positions of the way.
+     * @param segment Index of the segment, segment i connects node i and i + 1.
+     */
+    static void setSelectionSegment(QPolygonF &selectionPolygon, const QPolygonF &polyline, int segment);
+
+    /**
+     * Updates the four corners of the selection polygon belonging to one segment.
+     * @param segment Index of the segment, segment i connects node i and i + 1.
+     */
+    void updateSelectionSegment(int segment);
+
+    /**
+     * Fits the bounding rect to the selection polygon.
+     */
+    void fitBoundingRect();
+
+    /**
+     * Rebuilds line, node index, selection polygon and lanelets after the node list changed.
+     */
+    void rebuildGeometry();
+
 
 public:
+    enum { Type = UserType + 2 }; ///< Item type used by qgraphicsitem_cast
+
+    /**
+     * Geometry derived from the node positions. Calculated apart from the item, so it can be done off the gui thread.
+     */
+    struct Geometry
+    {
+        QPolygonF polyline; ///< Node positions
+        QPolygonF selectionPolygon; ///< Selection polygon
+    };
+
     /**
      * Creates a way item, make it selectable, movable and moves it in the correct z index.
      * @param parent Possible parent item.
      */
     explicit WayItem(QGraphicsItem *parent = nullptr);
 
+    /**
+     * Item type for qgraphicsitem_cast.
+     * @return Type of way items.
+     */
+    [[nodiscard]] int type() const override;
+
     /**
      * Overrides this function to make the selection bounding box show up correctly.
      * @return New shape that is the bounding box.
@@ -90,6 +146,24 @@ public:
      */
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
 
+    /**
+     * Fits the bounding rects of this way and its lanelets after nodes were moved.
+     */
+    void fitGeometry();
+
+    /**
+     * Calculates the geometry from the current node positions without modifying the item. Safe to call from worker
+     * threads as long as the nodes are not modified meanwhile.
+     * @return New geometry.
+     */
+    [[nodiscard]] Geometry computeGeometry() const;
+
+    /**
+     * Replaces the geometry of the way. Has to be called in the gui thread, lanelets are not updated.
+     * @param geometry Geometry calculated by computeGeometry.
+     */
+    void applyGeometry(Geometry geometry);
+
     /**
      * Getter for the type of way.
      * @return Type of way.
@@ -102,11 +176,23 @@ public:
      */
     [[nodiscard]] const QList<NodeItem *> &nodes() const;
 
+    /**
+     * Getter for the node positions as they are drawn.
+     * @return Node positions in order.
+     */
+    [[nodiscard]] const QPolygonF &polyline() const;
+
+    /**
+     * Setter for the spatial index that is informed about changed segments.
+     * @param spatialIndex Index or nullptr.
+     */
+    void setSpatialIndex(LaneletSpatialIndex *spatialIndex);
+
     /**
      * Getter for the lanelets this is part of.
      * @return Lanelets using this way.
      */
-    [[nodiscard]] const QList<LaneletItem *> &lanelets() const;
+    [[nodiscard]] const QSet<LaneletItem *> &lanelets() const;
 
 public slots:
     /**
@@ -121,6 +207,13 @@ public slots:
      */
     void addNode(NodeItem *item);
 
+    /**
+     * Replaces all nodes at once. Path and selection polygon are only built once, which makes this the preferred way
+     * to create large ways.
+     * @param items New nodes in order, duplicates are skipped.
+     */
+    void setNodes(const QList<NodeItem *> &items);
+
     /**
      * Removes a node from this way.
      * @param item Node to be removed.
@@ -128,7 +221,7 @@ public slots:
     void removeNode(NodeItem *item);
 
     /**
-     * A node was updates so update this way as well.
+     * A node was updates so update this way as well. Only the segments next to the node are updated.
      * @param item Node that was updated.
      */
     void nodeUpdated(NodeItem *item);
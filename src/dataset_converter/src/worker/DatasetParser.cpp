@@ -12,10 +12,16 @@ cpm_scenario::ScenarioPtrs DatasetParser::loadedScenarios()
 {
     return this->m_scenarios;
 }
-void DatasetParser::loadScenariosFromDataset(QString datasetName, QString datasetRootDirectory)
+dataset_converter_common::DatasetScenarioPtrs DatasetParser::loadedDatasetScenarios()
+{
+    if (!this->m_datasetParser || this->m_scenarios.empty()) return {};
+    return this->m_datasetParser->GetScenarios();
+}
+void DatasetParser::loadScenariosFromDataset(QString datasetName, QString datasetRootDirectory, qreal smoothingWindow)
 {
     this->m_datasetName = std::move(datasetName);
     this->m_datasetRootDirectory = std::move(datasetRootDirectory);
+    this->m_smoothingWindow = smoothingWindow;
 
     initialise();
 }
@@ -40,6 +46,12 @@ void DatasetParser::initialise()
         this->m_datasetParser = new dataset_converter_common::RounDParser;
     }
 
+    // Trajectories are smoothed by the parser right after each scenario is read
+    if (this->m_datasetParser && this->m_smoothingWindow > 0.0) {
+        this->m_datasetParser->SetSmoother(
+            std::make_shared<const dataset_converter_common::TrajectorySmoother>(this->m_smoothingWindow));
+    }
+
     QDir datasetRootDirectory(this->m_datasetRootDirectory);
     if (!datasetRootDirectory.exists()) {
         emit error("Dataset root directory does not exists.");
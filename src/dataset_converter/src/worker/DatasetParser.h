@@ -18,6 +18,7 @@ private:
     cpm_scenario::ScenarioPtrs m_scenarios; ///< Loaded scenarios
     QString m_datasetName; ///< Name of data set
     QString m_datasetRootDirectory; ///< Root directory to search in
+    qreal m_smoothingWindow = 0.0; ///< Duration of the smoothing window in seconds, 0 to keep the trajectories
 
     /**
      * Initialises the parser and directly afterwards executes the parsing afterwards.
@@ -42,6 +43,12 @@ public:
      */
     cpm_scenario::ScenarioPtrs loadedScenarios();
 
+    /**
+     * Getter for the parsed scenarios with their dataset specific information like the frame rate.
+     * @return Parsed scenarios.
+     */
+    dataset_converter_common::DatasetScenarioPtrs loadedDatasetScenarios();
+
     /**
      * Getter for the parsed data set name.
      * @return Parsed data set name.
@@ -54,8 +61,9 @@ public slots:
      * Start the parsing process.
      * @param datasetName Data set to parse.
      * @param datasetRootDirectory Directory to look in.
+     * @param smoothingWindow Duration of the smoothing window in seconds, 0 to keep the recorded trajectories.
      */
-    void loadScenariosFromDataset(QString datasetName, QString datasetRootDirectory);
+    void loadScenariosFromDataset(QString datasetName, QString datasetRootDirectory, qreal smoothingWindow);
 
 signals:
 
@@ -0,0 +1,165 @@
+#ifndef ELEMENTREGISTRY_H
+#define ELEMENTREGISTRY_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+/**
+ * Bidirectional mapping between ids and items with stable slots. Items are stored in a slot vector, removed slots are
+ * recycled by later insertions, so no item is moved by insertions or removals of other items. Insertion, removal and
+ * lookup in both directions are constant in time, iteration follows the slot order. The registry itself is not
+ * synchronised.
+ * @tparam T Type of the registered items.
+ */
+template<typename T>
+class ElementRegistry
+{
+private:
+    /**
+     * Storage of a single item.
+     */
+    struct Slot
+    {
+        qint64 id = 0; ///< Id of the item, 0 if the slot is free
+        T *item = nullptr; ///< Registered item, nullptr if the slot is free
+    };
+
+    QVector<Slot> m_slots; ///< All slots, free slots included
+    QVector<int> m_freeSlots; ///< Indices of free slots
+    QHash<const T *, int> m_slotOfItem; ///< Slot index per item
+    QHash<qint64, int> m_slotOfId; ///< Slot index per id
+
+public:
+    /**
+     * Registers an item under an id.
+     * @param item Item to register.
+     * @param id Id of the item, has to be positive.
+     * @return False if the item or the id is already registered.
+     */
+    bool insert(T *item, qint64 id)
+    {
+        if (!item || id <= 0) return false;
+        if (this->m_slotOfItem.contains(item) || this->m_slotOfId.contains(id)) return false;
+        int slot;
+        if (!this->m_freeSlots.isEmpty()) {
+            slot = this->m_freeSlots.takeLast();
+            this->m_slots[slot] = {id, item};
+        }
+        else {
+            slot = this->m_slots.size();
+            this->m_slots.push_back({id, item});
+        }
+        this->m_slotOfItem.insert(item, slot);
+        this->m_slotOfId.insert(id, slot);
+        return true;
+    }
+
+    /**
+     * Unregisters an item and frees its slot.
+     * @param item Item to unregister.
+     * @return False if the item was not registered.
+     */
+    bool remove(const T *item)
+    {
+        auto slotOfItem = this->m_slotOfItem.find(item);
+        if (slotOfItem == this->m_slotOfItem.end()) return false;
+        int slot = slotOfItem.value();
+        this->m_slotOfItem.erase(slotOfItem);
+        this->m_slotOfId.remove(this->m_slots[slot].id);
+        this->m_slots[slot] = Slot();
+        this->m_freeSlots.push_back(slot);
+        return true;
+    }
+
+    /**
+     * Checks if an item is registered.
+     * @param item Item to check.
+     * @return True if the item is registered.
+     */
+    [[nodiscard]] bool contains(const T *item) const
+    {
+        return this->m_slotOfItem.contains(item);
+    }
+
+    /**
+     * Checks if an id is in use.
+     * @param id Id to check.
+     * @return True if an item is registered under the id.
+     */
+    [[nodiscard]] bool containsId(qint64 id) const
+    {
+        return this->m_slotOfId.contains(id);
+    }
+
+    /**
+     * Lookup of an item by id.
+     * @param id Id of the item.
+     * @return Registered item or nullptr.
+     */
+    [[nodiscard]] T *item(qint64 id) const
+    {
+        auto slotOfId = this->m_slotOfId.constFind(id);
+        if (slotOfId == this->m_slotOfId.constEnd()) return nullptr;
+        return this->m_slots[slotOfId.value()].item;
+    }
+
+    /**
+     * Lookup of an id by item.
+     * @param item Registered item.
+     * @return Id of the item or 0 if not registered.
+     */
+    [[nodiscard]] qint64 id(const T *item) const
+    {
+        auto slotOfItem = this->m_slotOfItem.constFind(item);
+        if (slotOfItem == this->m_slotOfItem.constEnd()) return 0;
+        return this->m_slots[slotOfItem.value()].id;
+    }
+
+    /**
+     * Getter for the number of registered items.
+     * @return Number of items.
+     */
+    [[nodiscard]] int size() const
+    {
+        return this->m_slotOfItem.size();
+    }
+
+    /**
+     * Snapshot of all registered items in slot order.
+     * @return Registered items.
+     */
+    [[nodiscard]] QList<T *> items() const
+    {
+        QList<T *> items;
+        items.reserve(this->size());
+        for (const auto &slot : this->m_slots) {
+            if (slot.item) items.push_back(slot.item);
+        }
+        return items;
+    }
+
+    /**
+     * Prepares the registry for a number of items to avoid rehashing during bulk insertions.
+     * @param size Expected number of items.
+     */
+    void reserve(int size)
+    {
+        this->m_slots.reserve(size);
+        this->m_slotOfItem.reserve(size);
+        this->m_slotOfId.reserve(size);
+    }
+
+    /**
+     * Unregisters all items.
+     */
+    void clear()
+    {
+        this->m_slots.clear();
+        this->m_freeSlots.clear();
+        this->m_slotOfItem.clear();
+        this->m_slotOfId.clear();
+    }
+};
+
+#endif // ELEMENTREGISTRY_H
@@ -0,0 +1,115 @@
+#include "FramePrefetcher.h"
+
+#include <QtMath>
+
+FramePrefetcher::FramePrefetcher(int depth, QObject *parent)
+    : QObject(parent), m_ring(qMax(depth, 1))
+{
+    // Fill requests are always executed in the thread this object lives in
+    connect(this, &FramePrefetcher::fillRequested, this, &FramePrefetcher::fill, Qt::QueuedConnection);
+}
+
+void FramePrefetcher::setScenario(const cpm_scenario::ScenarioPtr &scenario, qreal scaleFactor)
+{
+    QMutexLocker locker(&this->m_mutex);
+    this->m_objects.clear();
+    this->m_numberOfFrames = 0;
+    if (scenario) {
+        for (const auto &object : scenario->GetObjects()) {
+            this->m_objects.push_back(object);
+        }
+        this->m_numberOfFrames = scenario->GetNumberOfFrames();
+    }
+    this->m_scaleFactor = scaleFactor;
+    this->m_firstFrame = 0;
+    this->m_filledFrames = 0;
+    this->m_generation++;
+}
+
+bool FramePrefetcher::takeFrame(qint64 frame, FramePoses &framePoses)
+{
+    bool ready = false;
+    {
+        QMutexLocker locker(&this->m_mutex);
+        if (frame >= this->m_firstFrame && frame < this->m_firstFrame + this->m_filledFrames) {
+            // Frame is ready, release all frames before it
+            framePoses = this->m_ring.at(static_cast<int>(frame % this->m_ring.size()));
+            this->m_filledFrames -= frame - this->m_firstFrame;
+            this->m_firstFrame = frame;
+            ready = true;
+        }
+        else if (this->m_filledFrames > 0 || this->m_firstFrame != frame + 1) {
+            // Jump, reverse scrub or the worker fell behind. The gui thread computes this frame itself, so the buffer
+            // restarts directly behind it. Restarting is a constant time operation.
+            this->m_firstFrame = frame + 1;
+            this->m_filledFrames = 0;
+            this->m_generation++;
+        }
+    }
+    this->scheduleFill();
+    return ready;
+}
+
+void FramePrefetcher::scheduleFill()
+{
+    if (this->m_fillScheduled.exchange(true)) return;
+    emit fillRequested();
+}
+
+void FramePrefetcher::fill()
+{
+    this->m_fillScheduled = false;
+
+    QMutexLocker locker(&this->m_mutex);
+    while (this->m_filledFrames < this->m_ring.size()) {
+        qint64 frame = this->m_firstFrame + this->m_filledFrames;
+        if (this->m_objects.isEmpty() || frame > this->m_numberOfFrames) return;
+
+        // Copy everything needed so the gui thread is not blocked during the computation
+        auto objects = this->m_objects;
+        qreal scaleFactor = this->m_scaleFactor;
+        quint64 generation = this->m_generation;
+        locker.unlock();
+
+        FramePoses framePoses = computeFrame(objects, scaleFactor, frame);
+
+        locker.relock();
+        // Buffer was invalidated or moved in the meantime, restart with the new state
+        if (generation != this->m_generation || frame != this->m_firstFrame + this->m_filledFrames) continue;
+        this->m_ring[static_cast<int>(frame % this->m_ring.size())] = std::move(framePoses);
+        this->m_filledFrames++;
+    }
+}
+
+FramePoses FramePrefetcher::computeFrame(const QVector<cpm_scenario::ExtendedObjectPtr> &objects,
+                                         qreal scaleFactor,
+                                         qint64 frame)
+{
+    FramePoses framePoses;
+    framePoses.frame = frame;
+    for (const auto &object : objects) {
+        if (!object->IsInScene(frame)) continue;
+
+        // Scenario with planning problem was loaded, keep the object visible for more than a single frame
+        long stateFrame = frame;
+        if (object->GetStates().size() == 2) {
+            stateFrame = object->GetFirstFrame();
+            if (qAbs(frame - object->GetFirstFrame()) > qAbs(frame - object->GetLastFrame())) {
+                stateFrame = object->GetLastFrame();
+            }
+        }
+        if (!object->ContainsState(stateFrame)) continue;
+
+        auto state = object->GetStates().at(stateFrame);
+        ObjectPose pose;
+        pose.object = object;
+        pose.state = state;
+        pose.position = QPointF(state->GetPosition().x() * scaleFactor, state->GetPosition().y() * scaleFactor);
+        pose.rotation = qRadiansToDegrees(state->GetOrientation());
+        pose.velocityArrow = QLineF(pose.position,
+                                    pose.position + QPointF(state->GetVelocity().x() * scaleFactor,
+                                                            state->GetVelocity().y() * scaleFactor));
+        framePoses.poses.push_back(pose);
+    }
+    return framePoses;
+}
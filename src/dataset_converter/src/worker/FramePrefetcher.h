@@ -0,0 +1,90 @@
+#ifndef FRAMEPREFETCHER_H
+#define FRAMEPREFETCHER_H
+
+#include <atomic>
+
+#include <QObject>
+#include <QMutex>
+#include <QVector>
+
+#include <cpm_scenario/Scenario.h>
+#include <cpm_scenario/ExtendedObject.h>
+
+#include "visualisation/graphics_items/ObjectPose.h"
+
+/**
+ * Worker that stays a fixed number of frames ahead of the playhead and computes the poses of all active objects into a
+ * ring buffer. The gui thread only takes the ready results. All public functions are thread safe.
+ */
+class FramePrefetcher: public QObject
+{
+Q_OBJECT
+private:
+    mutable QMutex m_mutex; ///< Guards all members shared between the gui and the worker thread
+
+    QVector<cpm_scenario::ExtendedObjectPtr> m_objects; ///< Objects of the current scenario
+    qint64 m_numberOfFrames = 0; ///< Last frame of the current scenario
+    qreal m_scaleFactor = 1.0; ///< Scale factor from scenario to pixel values
+
+    QVector<FramePoses> m_ring; ///< Ring buffer of computed frames, a frame is stored at frame % size
+    qint64 m_firstFrame = 0; ///< Oldest frame that is kept in the ring buffer
+    qint64 m_filledFrames = 0; ///< Number of consecutive frames from the oldest frame on that are ready
+    quint64 m_generation = 0; ///< Increased on every invalidation so that results in flight are discarded
+
+    std::atomic_bool m_fillScheduled{false}; ///< Prevents flooding the worker event queue with fill requests
+
+    /**
+     * Computes the poses of all active objects for a frame. Only reads from the scenario.
+     * @param objects Objects to compute the poses for.
+     * @param scaleFactor Scale factor from scenario to pixel values.
+     * @param frame Frame to compute.
+     * @return Poses of all objects active in the frame.
+     */
+    static FramePoses computeFrame(const QVector<cpm_scenario::ExtendedObjectPtr> &objects,
+                                   qreal scaleFactor,
+                                   qint64 frame);
+
+    /**
+     * Requests the worker thread to fill the ring buffer if no request is pending yet.
+     */
+    void scheduleFill();
+
+private slots:
+    /**
+     * Computes frames until the ring buffer is full or the scenario ends. Runs in the worker thread.
+     */
+    void fill();
+
+public:
+    /**
+     * Creates the prefetcher.
+     * @param depth Number of frames that are computed ahead of the playhead.
+     * @param parent Possible parent or qt pointer destruction.
+     */
+    explicit FramePrefetcher(int depth = 100, QObject *parent = nullptr);
+
+    /**
+     * Replaces the scenario and drops all computed frames.
+     * @param scenario New scenario, may be nullptr.
+     * @param scaleFactor Scale factor from scenario to pixel values.
+     */
+    void setScenario(const cpm_scenario::ScenarioPtr &scenario, qreal scaleFactor);
+
+    /**
+     * Takes the poses of a frame if they are ready. Frames before the requested one are released and the buffer is
+     * refilled from there. If the frame is not buffered, e.g. after a jump or while scrubbing backwards, the buffer is
+     * restarted directly behind the requested frame.
+     * @param frame Frame that should be displayed.
+     * @param framePoses Output for the poses, only written if the frame was ready.
+     * @return True if the frame was ready, false otherwise.
+     */
+    bool takeFrame(qint64 frame, FramePoses &framePoses);
+
+signals:
+    /**
+     * Internal signal to hand fill requests to the worker thread.
+     */
+    void fillRequested();
+};
+
+#endif // FRAMEPREFETCHER_H
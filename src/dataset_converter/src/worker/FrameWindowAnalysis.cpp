@@ -0,0 +1,98 @@
+#include "FrameWindowAnalysis.h"
+
+#include <QDebug>
+#include <QtConcurrent/QtConcurrent>
+
+FrameWindowAnalysis::FrameWindowAnalysis(QObject *parent)
+    : QObject(parent)
+{
+    this->m_watcher = new QFutureWatcher<Result>(this);
+    connect(this->m_watcher, &QFutureWatcher<Result>::finished, this, &FrameWindowAnalysis::onUpdateFinished);
+}
+
+FrameWindowAnalysis::~FrameWindowAnalysis()
+{
+    this->m_watcher->waitForFinished();
+}
+
+const dataset_converter_common::FrameCountsPtr &FrameWindowAnalysis::counts() const
+{
+    return this->m_counts;
+}
+
+void FrameWindowAnalysis::setScenario(const cpm_scenario::ScenarioPtr &scenario)
+{
+    if (scenario == this->m_scenario) return;
+    this->m_scenario = scenario;
+    this->m_counts = nullptr;
+    this->schedule();
+}
+
+void FrameWindowAnalysis::setTransformation(double shiftX, double shiftY, double rotation)
+{
+    this->m_shiftX = shiftX;
+    this->m_shiftY = shiftY;
+    this->m_rotation = rotation;
+    this->schedule();
+}
+
+void FrameWindowAnalysis::setFrameRange(long fromFrame, long toFrame)
+{
+    if (fromFrame == this->m_fromFrame && toFrame == this->m_toFrame) return;
+    this->m_fromFrame = fromFrame;
+    this->m_toFrame = toFrame;
+    this->schedule();
+}
+
+void FrameWindowAnalysis::schedule()
+{
+    if (this->m_watcher->isRunning()) {
+        this->m_updatePending = true;
+        return;
+    }
+    if (!this->m_scenario) return;
+
+    // Statistics of another scenario are dropped, the update builds new ones
+    if (this->m_statisticsScenario != this->m_scenario) {
+        this->m_statistics = nullptr;
+        this->m_statisticsScenario = nullptr;
+    }
+    this->m_updatedScenario = this->m_scenario;
+    this->m_watcher->setFuture(QtConcurrent::run(&FrameWindowAnalysis::update, this->m_statistics,
+                                                 this->m_scenario, this->m_shiftX, this->m_shiftY,
+                                                 this->m_rotation, this->m_fromFrame, this->m_toFrame));
+}
+
+FrameWindowAnalysis::Result FrameWindowAnalysis::update(
+    std::shared_ptr<dataset_converter_common::FrameStatistics> statistics,
+    const cpm_scenario::ScenarioPtr &scenario,
+    double shiftX,
+    double shiftY,
+    double rotation,
+    long fromFrame,
+    long toFrame)
+{
+    if (!statistics) statistics = std::make_shared<dataset_converter_common::FrameStatistics>(scenario);
+    statistics->SetFrameRange(fromFrame, toFrame);
+    size_t tested = statistics->SetTransformation(shiftX, shiftY, rotation);
+    qDebug() << "[FrameWindowAnalysis] Tested" << tested << "of" << statistics->GetNumberOfStates() << "states";
+    return {statistics, statistics->GetCounts(), statistics->GetRetention()};
+}
+
+void FrameWindowAnalysis::onUpdateFinished()
+{
+    Result result = this->m_watcher->result();
+    this->m_statistics = result.statistics;
+    this->m_statisticsScenario = this->m_updatedScenario;
+
+    if (this->m_updatedScenario == this->m_scenario) {
+        this->m_counts = result.counts;
+        emit countsChanged(this->m_counts);
+        emit retentionChanged(result.retention);
+    }
+
+    if (this->m_updatePending) {
+        this->m_updatePending = false;
+        this->schedule();
+    }
+}
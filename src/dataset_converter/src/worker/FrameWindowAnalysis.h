@@ -0,0 +1,131 @@
+#ifndef FRAMEWINDOWANALYSIS_H
+#define FRAMEWINDOWANALYSIS_H
+
+#include <memory>
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <cpm_scenario/Scenario.h>
+#include <dataset_converter_common/analysis/FrameStatistics.h>
+
+/**
+ * Keeps the number of objects inside the lab area per frame and object type up to date for the current scenario and
+ * transformation, together with the objects and states of the export frame range that would be kept. The statistics
+ * are built once per scenario and updated incrementally in the background whenever shift or rotation change. Changes
+ * during an update are merged into a single follow-up update.
+ * Only to be used in the gui thread.
+ */
+class FrameWindowAnalysis: public QObject
+{
+Q_OBJECT
+private:
+    /**
+     * Result of a background update.
+     */
+    struct Result
+    {
+        std::shared_ptr<dataset_converter_common::FrameStatistics> statistics; ///< Updated statistics
+        dataset_converter_common::FrameCountsPtr counts; ///< Prefix sums of the updated statistics
+        dataset_converter_common::Retention retention; ///< Kept objects and states of the frame range
+    };
+
+    cpm_scenario::ScenarioPtr m_scenario; ///< Current scenario
+    double m_shiftX = 0.0; ///< Current shift in x direction in meters
+    double m_shiftY = 0.0; ///< Current shift in y direction in meters
+    double m_rotation = 0.0; ///< Current rotation in degrees
+    long m_fromFrame = 0; ///< First frame of the export
+    long m_toFrame = 0; ///< Last frame of the export, 0 for all frames
+
+    std::shared_ptr<dataset_converter_common::FrameStatistics> m_statistics; ///< Statistics, only touched by updates
+    cpm_scenario::ScenarioPtr m_statisticsScenario; ///< Scenario the statistics belong to
+    cpm_scenario::ScenarioPtr m_updatedScenario; ///< Scenario of the running update
+    dataset_converter_common::FrameCountsPtr m_counts; ///< Counts of the last finished update
+
+    QFutureWatcher<Result> *m_watcher = nullptr; ///< Watches the running update
+    bool m_updatePending = false; ///< Whether scenario or transformation changed during the running update
+
+    /**
+     * Starts an update unless one is running.
+     */
+    void schedule();
+
+    /**
+     * Updates the statistics for a transformation. Runs on a worker thread.
+     * @param statistics Statistics of the scenario, nullptr to build them.
+     * @param scenario Scenario to count.
+     * @param shiftX Shift in x direction in meters.
+     * @param shiftY Shift in y direction in meters.
+     * @param rotation Rotation in degrees.
+     * @param fromFrame First frame of the export.
+     * @param toFrame Last frame of the export, 0 for all frames.
+     * @return Updated statistics, counts and retention.
+     */
+    static Result update(std::shared_ptr<dataset_converter_common::FrameStatistics> statistics,
+                         const cpm_scenario::ScenarioPtr &scenario,
+                         double shiftX,
+                         double shiftY,
+                         double rotation,
+                         long fromFrame,
+                         long toFrame);
+
+private slots:
+    /**
+     * Publishes the counts and starts a pending update.
+     */
+    void onUpdateFinished();
+
+public:
+    /**
+     * Creates the analysis without scenario.
+     * @param parent Possible parent or qt pointer destruction.
+     */
+    explicit FrameWindowAnalysis(QObject *parent = nullptr);
+
+    /**
+     * Waits for a running update.
+     */
+    ~FrameWindowAnalysis() override;
+
+    /**
+     * Getter for the counts.
+     * @return Counts of the last finished update, nullptr before the first one.
+     */
+    [[nodiscard]] const dataset_converter_common::FrameCountsPtr &counts() const;
+
+public slots:
+    /**
+     * Builds the statistics of a new scenario.
+     * @param scenario Scenario to analyse.
+     */
+    void setScenario(const cpm_scenario::ScenarioPtr &scenario);
+
+    /**
+     * Updates the statistics for a new transformation.
+     * @param shiftX Shift in x direction in meters.
+     * @param shiftY Shift in y direction in meters.
+     * @param rotation Rotation in degrees.
+     */
+    void setTransformation(double shiftX, double shiftY, double rotation);
+
+    /**
+     * Sets the frames whose objects are reported as retained.
+     * @param fromFrame First frame of the export.
+     * @param toFrame Last frame of the export, 0 for all frames.
+     */
+    void setFrameRange(long fromFrame, long toFrame);
+
+signals:
+    /**
+     * Emitted after an update finished.
+     * @param counts Counts of the current scenario and transformation.
+     */
+    void countsChanged(dataset_converter_common::FrameCountsPtr counts);
+
+    /**
+     * Emitted after an update finished.
+     * @param retention Objects and states of the frame range inside the lab area.
+     */
+    void retentionChanged(dataset_converter_common::Retention retention);
+};
+
+#endif // FRAMEWINDOWANALYSIS_H
@@ -0,0 +1,95 @@
+#include "LaneletAutosave.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+#include <QtConcurrent/QtConcurrent>
+
+LaneletAutosave::LaneletAutosave(LaneletSnapshotTracker *tracker, QObject *parent)
+    : QObject(parent), m_tracker(tracker)
+{
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(directory);
+    this->m_fileName = directory + "/autosave.osm";
+
+    this->m_writeWatcher = new QFutureWatcher<QString>(this);
+    connect(this->m_writeWatcher, &QFutureWatcher<QString>::finished, this, &LaneletAutosave::onWriteFinished);
+
+    this->m_timer = new QTimer(this);
+    connect(this->m_timer, &QTimer::timeout, this, &LaneletAutosave::save);
+    this->m_timer->start(DefaultInterval);
+}
+
+LaneletAutosave::~LaneletAutosave()
+{
+    this->m_writeWatcher->waitForFinished();
+}
+
+QString LaneletAutosave::writeSnapshot(const LaneletSnapshot &snapshot, const QString &fileName, qreal scaleFactor)
+{
+    QString errorMessage;
+    if (snapshot.write(fileName, scaleFactor, &errorMessage)) return {};
+    return errorMessage.isEmpty() ? QString("Could not write %1").arg(fileName) : errorMessage;
+}
+
+void LaneletAutosave::save()
+{
+    if (this->m_writeWatcher->isRunning()) {
+        this->m_savePending = true;
+        return;
+    }
+    const LaneletSnapshot &snapshot = this->m_tracker->snapshot();
+    if (this->m_tracker->revision() == this->m_savedRevision) return;
+    this->m_savedRevision = this->m_tracker->revision();
+
+    // The copy shares all chunks with the snapshot, edits during the write only detach what they change
+    this->m_writeWatcher->setFuture(QtConcurrent::run(&LaneletAutosave::writeSnapshot, snapshot, this->m_fileName,
+                                                      this->m_scaleFactor));
+}
+
+void LaneletAutosave::onWriteFinished()
+{
+    QString errorMessage = this->m_writeWatcher->result();
+    if (errorMessage.isEmpty()) {
+        qDebug() << "[LaneletAutosave] Saved to" << this->m_fileName;
+        emit saved(this->m_fileName);
+    }
+    else {
+        // Try again with the next autosave
+        this->m_savedRevision = 0;
+        qWarning("Autosave failed: %s", qUtf8Printable(errorMessage));
+        emit saveFailed(errorMessage);
+    }
+
+    if (this->m_savePending) {
+        this->m_savePending = false;
+        this->save();
+    }
+}
+
+QString LaneletAutosave::fileName() const
+{
+    return this->m_fileName;
+}
+
+void LaneletAutosave::setFileName(const QString &fileName)
+{
+    if (fileName == this->m_fileName) return;
+    this->m_fileName = fileName;
+    // The new file does not contain anything yet
+    this->m_savedRevision = 0;
+}
+
+void LaneletAutosave::setScaleFactor(qreal scaleFactor)
+{
+    this->m_scaleFactor = scaleFactor;
+}
+
+void LaneletAutosave::setInterval(int interval)
+{
+    if (interval <= 0) {
+        this->m_timer->stop();
+        return;
+    }
+    this->m_timer->start(interval);
+}
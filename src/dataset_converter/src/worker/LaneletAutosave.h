@@ -0,0 +1,102 @@
+#ifndef LANELETAUTOSAVE_H
+#define LANELETAUTOSAVE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFutureWatcher>
+
+#include "worker/LaneletSnapshotTracker.h"
+
+/**
+ * Periodically saves the lanelet editor state. Snapshots of the editor model are taken from the tracker, which only
+ * touches changed elements, and written on a worker thread. The autosave file is replaced atomically. Elements keep
+ * their registry ids, so consecutive autosaves only differ in the changed elements. Only to be used in the gui thread.
+ */
+class LaneletAutosave: public QObject
+{
+Q_OBJECT
+private:
+    static constexpr int DefaultInterval = 60 * 1000; ///< Time between autosaves in milliseconds
+
+    LaneletSnapshotTracker *const m_tracker; ///< Source of the snapshots
+    quint64 m_savedRevision = 0; ///< Snapshot revision of the last autosave
+
+    QTimer *m_timer = nullptr; ///< Triggers the autosaves
+    QFutureWatcher<QString> *m_writeWatcher = nullptr; ///< Watches the running write
+    QString m_fileName; ///< Autosave file
+    qreal m_scaleFactor = 1; ///< Scale factor matching meter to pixels
+    bool m_savePending = false; ///< Whether an autosave was requested while writing
+
+    /**
+     * Writes a snapshot. Runs on a worker thread.
+     * @param snapshot Snapshot to write.
+     * @param fileName Target file.
+     * @param scaleFactor Scale factor matching meter to pixels.
+     * @return Error message, empty on success.
+     */
+    static QString writeSnapshot(const LaneletSnapshot &snapshot, const QString &fileName, qreal scaleFactor);
+
+private slots:
+    /**
+     * Reports the result of a write and starts a pending autosave.
+     */
+    void onWriteFinished();
+
+public:
+    /**
+     * Creates the service.
+     * @param tracker Source of the snapshots.
+     * @param parent Possible parent or qt pointer destruction.
+     */
+    explicit LaneletAutosave(LaneletSnapshotTracker *tracker, QObject *parent = nullptr);
+
+    /**
+     * Waits for a running write.
+     */
+    ~LaneletAutosave() override;
+
+    /**
+     * Getter for the autosave file.
+     * @return Autosave file.
+     */
+    [[nodiscard]] QString fileName() const;
+
+    /**
+     * Setter for the autosave file.
+     * @param fileName Autosave file.
+     */
+    void setFileName(const QString &fileName);
+
+    /**
+     * Setter for the scale factor used when writing.
+     * @param scaleFactor Scale factor matching meter to pixels.
+     */
+    void setScaleFactor(qreal scaleFactor);
+
+    /**
+     * Setter for the autosave interval.
+     * @param interval Time between autosaves in milliseconds, 0 to disable.
+     */
+    void setInterval(int interval);
+
+public slots:
+    /**
+     * Writes the editor model in the background if it changed since the last autosave.
+     */
+    void save();
+
+signals:
+    /**
+     * Emitted after an autosave was written.
+     * @param fileName Autosave file.
+     */
+    void saved(QString fileName);
+
+    /**
+     * Emitted if an autosave could not be written.
+     * @param message Error message.
+     */
+    void saveFailed(QString message);
+};
+
+#endif // LANELETAUTOSAVE_H
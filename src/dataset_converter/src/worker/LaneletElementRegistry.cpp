@@ -0,0 +1,124 @@
+#include "LaneletElementRegistry.h"
+#include "visualisation/graphics_items/ChangeJournal.h"
+
+#include <algorithm>
+
+#include <QMutexLocker>
+
+template<typename T>
+qint64 LaneletElementRegistry::insert(ElementRegistry<T> &registry, T *item, qint64 id)
+{
+    if (registry.contains(item)) return 0;
+    if (id <= 0 || registry.containsId(id)) id = this->m_nextId;
+    registry.insert(item, id);
+    this->m_nextId = qMax(this->m_nextId, id + 1);
+    return id;
+}
+
+qint64 LaneletElementRegistry::addNode(NodeItem *node, qint64 id)
+{
+    QMutexLocker locker(&this->m_mutex);
+    id = this->insert(this->m_nodes, node, id);
+    if (id) ChangeJournal::recordNode(node);
+    return id;
+}
+qint64 LaneletElementRegistry::addWay(WayItem *way, qint64 id)
+{
+    QMutexLocker locker(&this->m_mutex);
+    id = this->insert(this->m_ways, way, id);
+    if (id) ChangeJournal::recordWay(way);
+    return id;
+}
+qint64 LaneletElementRegistry::addLanelet(LaneletItem *lanelet, qint64 id)
+{
+    QMutexLocker locker(&this->m_mutex);
+    id = this->insert(this->m_lanelets, lanelet, id);
+    if (id) ChangeJournal::recordLanelet(lanelet);
+    return id;
+}
+
+void LaneletElementRegistry::removeElements(QList<NodeItem *> &nodes,
+                                            QList<WayItem *> &ways,
+                                            QList<LaneletItem *> &lanelets)
+{
+    QMutexLocker locker(&this->m_mutex);
+    nodes.erase(std::remove_if(nodes.begin(), nodes.end(), [this](NodeItem *node)
+    { return !this->m_nodes.remove(node); }), nodes.end());
+    ways.erase(std::remove_if(ways.begin(), ways.end(), [this](WayItem *way)
+    { return !this->m_ways.remove(way); }), ways.end());
+    lanelets.erase(std::remove_if(lanelets.begin(), lanelets.end(), [this](LaneletItem *lanelet)
+    { return !this->m_lanelets.remove(lanelet); }), lanelets.end());
+
+    for (auto node : nodes) ChangeJournal::recordNode(node);
+    for (auto way : ways) ChangeJournal::recordWay(way);
+    for (auto lanelet : lanelets) ChangeJournal::recordLanelet(lanelet);
+}
+
+bool LaneletElementRegistry::contains(const NodeItem *node) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_nodes.contains(node);
+}
+bool LaneletElementRegistry::contains(const WayItem *way) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_ways.contains(way);
+}
+bool LaneletElementRegistry::contains(const LaneletItem *lanelet) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_lanelets.contains(lanelet);
+}
+
+NodeItem *LaneletElementRegistry::node(qint64 id) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_nodes.item(id);
+}
+WayItem *LaneletElementRegistry::way(qint64 id) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_ways.item(id);
+}
+LaneletItem *LaneletElementRegistry::lanelet(qint64 id) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_lanelets.item(id);
+}
+
+qint64 LaneletElementRegistry::id(const NodeItem *node) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_nodes.id(node);
+}
+qint64 LaneletElementRegistry::id(const WayItem *way) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_ways.id(way);
+}
+qint64 LaneletElementRegistry::id(const LaneletItem *lanelet) const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_lanelets.id(lanelet);
+}
+
+QList<NodeItem *> LaneletElementRegistry::nodes() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_nodes.items();
+}
+QList<WayItem *> LaneletElementRegistry::ways() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_ways.items();
+}
+QList<LaneletItem *> LaneletElementRegistry::lanelets() const
+{
+    QMutexLocker locker(&this->m_mutex);
+    return this->m_lanelets.items();
+}
+
+QMutex *LaneletElementRegistry::mutex() const
+{
+    return &this->m_mutex;
+}
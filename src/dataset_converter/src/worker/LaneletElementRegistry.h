@@ -0,0 +1,156 @@
+#ifndef LANELETELEMENTREGISTRY_H
+#define LANELETELEMENTREGISTRY_H
+
+#include <memory>
+
+#include <QMutex>
+
+#include "worker/ElementRegistry.h"
+#include "visualisation/graphics_items/NodeItem.h"
+#include "visualisation/graphics_items/WayItem.h"
+#include "visualisation/graphics_items/LaneletItem.h"
+
+/**
+ * Registry of all lanelet map elements that exist in the editor. It is shared between the lanelet handler, which
+ * creates, stores and deletes the elements, and the lanelet visualisation, which renders them. Ids are taken from the
+ * loaded map or handed out from a counter shared by all element types and are used when the map is stored. All
+ * functions are thread safe.
+ */
+class LaneletElementRegistry
+{
+private:
+    mutable QMutex m_mutex{QMutex::Recursive}; ///< Guards all registries and the id counter
+    qint64 m_nextId = 1; ///< Next id handed out to new elements
+
+    ElementRegistry<NodeItem> m_nodes; ///< All registered nodes
+    ElementRegistry<WayItem> m_ways; ///< All registered ways
+    ElementRegistry<LaneletItem> m_lanelets; ///< All registered lanelets
+
+    /**
+     * Registers an element, the mutex has to be locked.
+     * @param registry Registry of the element type.
+     * @param item Element to register.
+     * @param id Preferred id, a new id is used if it is not positive or already in use.
+     * @return Id of the element or 0 if the element was already registered.
+     */
+    template<typename T>
+    qint64 insert(ElementRegistry<T> &registry, T *item, qint64 id);
+
+public:
+    /**
+     * Registers a node.
+     * @param node Node to register.
+     * @param id Preferred id, a new id is used if it is not positive or already in use.
+     * @return Id of the node or 0 if the node was already registered.
+     */
+    qint64 addNode(NodeItem *node, qint64 id = 0);
+
+    /**
+     * Registers a way.
+     * @param way Way to register.
+     * @param id Preferred id, a new id is used if it is not positive or already in use.
+     * @return Id of the way or 0 if the way was already registered.
+     */
+    qint64 addWay(WayItem *way, qint64 id = 0);
+
+    /**
+     * Registers a lanelet.
+     * @param lanelet Lanelet to register.
+     * @param id Preferred id, a new id is used if it is not positive or already in use.
+     * @return Id of the lanelet or 0 if the lanelet was already registered.
+     */
+    qint64 addLanelet(LaneletItem *lanelet, qint64 id = 0);
+
+    /**
+     * Unregisters a selection of elements in one step. Elements that are not registered are removed from the lists, so
+     * afterwards the lists hold exactly the elements that were unregistered by this call.
+     * @param nodes Nodes to unregister.
+     * @param ways Ways to unregister.
+     * @param lanelets Lanelets to unregister.
+     */
+    void removeElements(QList<NodeItem *> &nodes, QList<WayItem *> &ways, QList<LaneletItem *> &lanelets);
+
+    /**
+     * Checks if a node is registered.
+     * @param node Node to check.
+     * @return True if registered.
+     */
+    [[nodiscard]] bool contains(const NodeItem *node) const;
+    /**
+     * Checks if a way is registered.
+     * @param way Way to check.
+     * @return True if registered.
+     */
+    [[nodiscard]] bool contains(const WayItem *way) const;
+    /**
+     * Checks if a lanelet is registered.
+     * @param lanelet Lanelet to check.
+     * @return True if registered.
+     */
+    [[nodiscard]] bool contains(const LaneletItem *lanelet) const;
+
+    /**
+     * Lookup of a node by id.
+     * @param id Id of the node.
+     * @return Node or nullptr.
+     */
+    [[nodiscard]] NodeItem *node(qint64 id) const;
+    /**
+     * Lookup of a way by id.
+     * @param id Id of the way.
+     * @return Way or nullptr.
+     */
+    [[nodiscard]] WayItem *way(qint64 id) const;
+    /**
+     * Lookup of a lanelet by id.
+     * @param id Id of the lanelet.
+     * @return Lanelet or nullptr.
+     */
+    [[nodiscard]] LaneletItem *lanelet(qint64 id) const;
+
+    /**
+     * Lookup of the id of a node.
+     * @param node Registered node.
+     * @return Id or 0 if not registered.
+     */
+    [[nodiscard]] qint64 id(const NodeItem *node) const;
+    /**
+     * Lookup of the id of a way.
+     * @param way Registered way.
+     * @return Id or 0 if not registered.
+     */
+    [[nodiscard]] qint64 id(const WayItem *way) const;
+    /**
+     * Lookup of the id of a lanelet.
+     * @param lanelet Registered lanelet.
+     * @return Id or 0 if not registered.
+     */
+    [[nodiscard]] qint64 id(const LaneletItem *lanelet) const;
+
+    /**
+     * Snapshot of all registered nodes.
+     * @return Registered nodes.
+     */
+    [[nodiscard]] QList<NodeItem *> nodes() const;
+    /**
+     * Snapshot of all registered ways.
+     * @return Registered ways.
+     */
+    [[nodiscard]] QList<WayItem *> ways() const;
+    /**
+     * Snapshot of all registered lanelets.
+     * @return Registered lanelets.
+     */
+    [[nodiscard]] QList<LaneletItem *> lanelets() const;
+
+    /**
+     * Getter for the recursive mutex guarding the registry. Elements are only freed after they were removed, so all
+     * registered elements stay alive while it is locked.
+     * @return Mutex of the registry.
+     */
+    [[nodiscard]] QMutex *mutex() const;
+};
+
+typedef std::shared_ptr<LaneletElementRegistry> LaneletElementRegistryPtr;
+
+#endif // LANELETELEMENTREGISTRY_H
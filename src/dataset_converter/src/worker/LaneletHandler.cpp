@@ -1,18 +1,39 @@
 #include "LaneletHandler.h"
+#include "LaneletMapCache.h"
 
 #include <QFileInfo>
 #include <QDebug>
-#include <QtSvg/QSvgGenerator>
-#include <QPainter>
-#include <QGraphicsScene>
 
 #include <lanelet2_projection/CPM.h>
 #include <lanelet2_io/Io.h>
 
-LaneletHandler::LaneletHandler(QObject *parent)
-    : QObject(parent)
+LaneletHandler::LaneletHandler(LaneletElementRegistryPtr registry, QObject *parent)
+    : QObject(parent), m_registry(std::move(registry))
 {}
 
+QString LaneletHandler::internalWayType(const lanelet::ConstLineString3d &way)
+{
+    QString internalType = "unknown";
+    if (way.hasAttribute("type")) {
+        std::string laneletType = way.attribute("type").value();
+        if (laneletType == "virtual") {
+            internalType = "virtual";
+        }
+        else if (laneletType == "line_thin" || "line_thick") {
+            if (way.hasAttribute("subtype")) {
+                std::string laneletSubtype = way.attribute("subtype").value();
+                if (laneletSubtype == "dashed") {
+                    internalType = "dashed";
+                }
+                else if (laneletSubtype == "solid") {
+                    internalType = "solid";
+                }
+            }
+        }
+    }
+    return internalType;
+}
+
 void LaneletHandler::parseLanelet(QString laneletFileName, qreal scaleFactor)
 {
     this->lanelet_file_name_ = std::move(laneletFileName);
@@ -20,6 +41,20 @@ void LaneletHandler::parseLanelet(QString laneletFileName, qreal scaleFactor)
 
     emit progress(0, 5);
 
+    // Skip the xml parser if the snapshot was created from the same file content
+    QString cacheFileName = LaneletMapCache::cacheFileName(this->lanelet_file_name_);
+    QByteArray sourceHash = LaneletMapCache::hashFile(this->lanelet_file_name_);
+    if (!sourceHash.isEmpty()) {
+        LaneletMapCache cache(cacheFileName);
+        if (cache.open(sourceHash)) {
+            qInfo("Load lanelet cache: %s", qUtf8Printable(cacheFileName));
+            this->m_map = nullptr;
+            this->loadFromCache(cache, scaleFactor);
+            emit loaded();
+            return;
+        }
+    }
+
     try {
         lanelet::projection::CpmProjector projector(lanelet::Origin({0.0, 0.0}));
         this->m_map = lanelet::load(lanelet_file_name_.toStdString(), projector);
@@ -30,225 +65,258 @@ void LaneletHandler::parseLanelet(QString laneletFileName, qreal scaleFactor)
     }
     emit progress(1, 5);
 
-    std::map<long, NodeItem *> nodeIdMap;
-    std::map<long, WayItem *> wayIdMap;
+    // Ids from the file are kept unless they are already in use by a previously loaded map
+    QHash<lanelet::Id, NodeItem *> nodeIdMap;
+    QHash<lanelet::Id, WayItem *> wayIdMap;
+    nodeIdMap.reserve(static_cast<int>(this->m_map->pointLayer.size()));
+    wayIdMap.reserve(static_cast<int>(this->m_map->lineStringLayer.size()));
 
-    // Parse nodes and push to visualisation
-    long id = 0;
+    // Parse nodes and push to visualisation in batches
+    QList<NodeItem *> nodeBatch;
     for (const auto &node : this->m_map->pointLayer) {
         auto item = new NodeItem();
         item->setPos({node.x() * scaleFactor * 18, (4 - node.y()) * scaleFactor * 18});
-        item->setPos(item->pos());
-        this->nodes_.push_back(item);
-        nodeIdMap[node.id()] = item;
-        emit nodeAdded(item);
-        id++;
+        this->m_registry->addNode(item, node.id());
+        nodeIdMap.insert(node.id(), item);
+        nodeBatch.push_back(item);
+        if (nodeBatch.size() >= BatchSize) {
+            emit nodesAdded(nodeBatch);
+            nodeBatch.clear();
+        }
     }
+    if (!nodeBatch.isEmpty()) emit nodesAdded(nodeBatch);
     emit progress(3, 5);
 
     // Parse ways
+    QList<WayItem *> wayBatch;
     for (const auto &way : this->m_map->lineStringLayer) {
         auto item = new WayItem();
-        QString internalType = "unknown";
-        if (way.hasAttribute("type")) {
-            std::string laneletType = way.attribute("type").value();
-            if (laneletType == "virtual") {
-                internalType = "virtual";
-            }
-            else if (laneletType == "line_thin" || "line_thick") {
-                if (way.hasAttribute("subtype")) {
-                    std::string laneletSubtype = way.attribute("subtype").value();
-                    if (laneletSubtype == "dashed") {
-                        internalType = "dashed";
-                    }
-                    else if (laneletSubtype == "solid") {
-                        internalType = "solid";
-                    }
-                }
-            }
-        }
-        item->setWayType(internalType);
-        this->ways_.push_back(item);
-        wayIdMap[way.id()] = item;
-        emit wayAdded(item);
+        item->setWayType(internalWayType(way));
 
+        // Build the geometry once for all nodes instead of once per node
+        QList<NodeItem *> wayNodes;
+        wayNodes.reserve(static_cast<int>(way.size()));
         for (const auto &node : way) {
-            item->addNode(nodeIdMap[node.id()]);
+            wayNodes.push_back(nodeIdMap.value(node.id()));
+        }
+        item->setNodes(wayNodes);
+
+        this->m_registry->addWay(item, way.id());
+        wayIdMap.insert(way.id(), item);
+        wayBatch.push_back(item);
+        if (wayBatch.size() >= BatchSize) {
+            emit waysAdded(wayBatch);
+            wayBatch.clear();
         }
-        id++;
     }
+    if (!wayBatch.isEmpty()) emit waysAdded(wayBatch);
     emit progress(4, 5);
 
     // Parse lanelets
+    QList<LaneletItem *> laneletBatch;
     for (const auto &lanelet : this->m_map->laneletLayer) {
         auto item = new LaneletItem();
         item->setLaneletType(lanelet.attribute("cpm_type").value().c_str());
-        item->setRightWayItem(wayIdMap[lanelet.rightBound().id()]);
-        item->setLeftWayItem(wayIdMap[lanelet.leftBound().id()]);
-        this->lanelets_.push_back(item);
-        emit laneletAdded(item);
-        id++;
+        item->setRightWayItem(wayIdMap.value(lanelet.rightBound().id()));
+        item->setLeftWayItem(wayIdMap.value(lanelet.leftBound().id()));
+        this->m_registry->addLanelet(item, lanelet.id());
+        laneletBatch.push_back(item);
+        if (laneletBatch.size() >= BatchSize) {
+            emit laneletsAdded(laneletBatch);
+            laneletBatch.clear();
+        }
     }
+    if (!laneletBatch.isEmpty()) emit laneletsAdded(laneletBatch);
 
     emit progress(5, 5);
 
     emit loaded();
+
+    // Loading is done, the next load of the unchanged file uses the snapshot
+    if (!sourceHash.isEmpty() && !LaneletMapCache::write(cacheFileName, sourceHash, *this->m_map)) {
+        qWarning("Could not write lanelet cache: %s", qUtf8Printable(cacheFileName));
+    }
 }
 
-void LaneletHandler::writeLanelet(QString laneletFileName, qreal scaleFactor)
+void LaneletHandler::loadFromCache(const LaneletMapCache &cache, qreal scaleFactor)
 {
-    this->lanelet_file_name_ = std::move(laneletFileName);
-    qInfo("Write lanelet File: %s", qUtf8Printable(this->lanelet_file_name_));
+    emit progress(1, 5);
 
-    std::map<NodeItem *, lanelet::Point3d> nodeIdMap;
-    std::map<WayItem *, lanelet::LineString3d> wayIdMap;
-    this->m_map = std::make_shared<lanelet::LaneletMap>();
-    emit progress(0, 3);
-    long id = 1;
-    for (auto node : nodes_) {
-
-        auto backendNode =
-            lanelet::Point3d(id,
-                             node->pos().x() / (scaleFactor * 18.0),
-                             4 - (node->pos().y() / (scaleFactor * 18.0)),
-                             0);
-        this->m_map->add(backendNode);
-        nodeIdMap[node] = backendNode;
-
-        id++;
-    }
-    emit progress(1, 4);
-    for (auto way : ways_) {
-        if (way->nodes().size() < 2) continue;
-        auto backendWay = lanelet::LineString3d(id);
-        QString internalWay = way->wayType();
-        // Equivalent for both unknown and virtual
-        if (internalWay == "solid") {
-            backendWay.setAttribute("type", "line_thin");
-            backendWay.setAttribute("subtype", "solid");
+    // Records reference each other by index, so items are looked up by position
+    QVector<NodeItem *> nodeItems(static_cast<int>(cache.nodeCount()));
+    QVector<WayItem *> wayItems(static_cast<int>(cache.wayCount()));
+
+    QList<NodeItem *> nodeBatch;
+    for (quint32 i = 0; i < cache.nodeCount(); i++) {
+        const auto &node = cache.nodes()[i];
+        auto item = new NodeItem();
+        item->setPos({node.x * scaleFactor * 18, (4 - node.y) * scaleFactor * 18});
+        this->m_registry->addNode(item, node.id);
+        nodeItems[static_cast<int>(i)] = item;
+        nodeBatch.push_back(item);
+        if (nodeBatch.size() >= BatchSize) {
+            emit nodesAdded(nodeBatch);
+            nodeBatch.clear();
         }
-        else if (internalWay == "dashed") {
-            backendWay.setAttribute("type", "line_thin");
-            backendWay.setAttribute("subtype", "dashed");
+    }
+    if (!nodeBatch.isEmpty()) emit nodesAdded(nodeBatch);
+    emit progress(3, 5);
+
+    QList<WayItem *> wayBatch;
+    for (quint32 i = 0; i < cache.wayCount(); i++) {
+        const auto &way = cache.ways()[i];
+        auto item = new WayItem();
+        item->setWayType(cache.string(way.type));
+
+        QList<NodeItem *> wayNodes;
+        wayNodes.reserve(static_cast<int>(way.nodeCount));
+        for (quint32 j = 0; j < way.nodeCount; j++) {
+            wayNodes.push_back(nodeItems.at(static_cast<int>(cache.wayNodes()[way.firstNode + j])));
         }
-        else if (internalWay == "virtual") {
-            backendWay.setAttribute("type", "virtual");
+        item->setNodes(wayNodes);
+
+        this->m_registry->addWay(item, way.id);
+        wayItems[static_cast<int>(i)] = item;
+        wayBatch.push_back(item);
+        if (wayBatch.size() >= BatchSize) {
+            emit waysAdded(wayBatch);
+            wayBatch.clear();
         }
+    }
+    if (!wayBatch.isEmpty()) emit waysAdded(wayBatch);
+    emit progress(4, 5);
 
-        for (auto node : way->nodes()) {
-            backendWay.push_back(nodeIdMap[node]);
+    QList<LaneletItem *> laneletBatch;
+    for (quint32 i = 0; i < cache.laneletCount(); i++) {
+        const auto &lanelet = cache.lanelets()[i];
+        auto item = new LaneletItem();
+        item->setLaneletType(cache.string(lanelet.type));
+        if (lanelet.rightWay != LaneletMapCache::NoIndex) {
+            item->setRightWayItem(wayItems.at(static_cast<int>(lanelet.rightWay)));
+        }
+        if (lanelet.leftWay != LaneletMapCache::NoIndex) {
+            item->setLeftWayItem(wayItems.at(static_cast<int>(lanelet.leftWay)));
+        }
+        this->m_registry->addLanelet(item, lanelet.id);
+        laneletBatch.push_back(item);
+        if (laneletBatch.size() >= BatchSize) {
+            emit laneletsAdded(laneletBatch);
+            laneletBatch.clear();
         }
-        this->m_map->add(backendWay);
-        wayIdMap[way] = backendWay;
-        id++;
     }
-    emit progress(2, 4);
-    for (auto lanelet : lanelets_) {
-        if (!lanelet->leftWayItem() || !lanelet->rightWayItem()) continue;
-        auto backendLanelet = lanelet::Lanelet(id);
-        backendLanelet.setAttribute("cpm_type", lanelet->laneletType().toStdString());
-        backendLanelet.setAttribute("location", "urban");
-        backendLanelet.setAttribute("name", "CPM-Lab");
-        backendLanelet.setAttribute("one_way", "yes");
-        backendLanelet.setAttribute("region", "de");
-        backendLanelet.setAttribute("subtype", "road");
-        backendLanelet.setAttribute(lanelet::AttributeName::Subtype, lanelet::AttributeValueString::Road);
-        backendLanelet.setLeftBound(wayIdMap[lanelet->leftWayItem()]);
-        backendLanelet.setRightBound(wayIdMap[lanelet->rightWayItem()]);
-        this->m_map->add(backendLanelet);
-        id++;
+    if (!laneletBatch.isEmpty()) emit laneletsAdded(laneletBatch);
+
+    emit progress(5, 5);
+}
+
+void LaneletHandler::writeLanelet(QString laneletFileName, LaneletSnapshot snapshot, qreal scaleFactor)
+{
+    this->lanelet_file_name_ = std::move(laneletFileName);
+    qInfo("Write lanelet File: %s", qUtf8Printable(this->lanelet_file_name_));
+
+    emit progress(0, 1);
+    // Snapshot ids are the registry ids, so loaded maps keep their ids
+    QString errorMessage;
+    if (!snapshot.write(this->lanelet_file_name_, scaleFactor, &errorMessage)) {
+        emit error(errorMessage);
+        return;
     }
-    emit progress(3, 4);
-    lanelet::projection::CpmProjector projector(lanelet::Origin({0.0, 0.0}));
-    lanelet::write(lanelet_file_name_.toStdString(), *this->m_map, projector);
-    emit progress(4, 4);
+    emit progress(1, 1);
     emit stored();
 }
+void LaneletHandler::addLaneletCandidates(QList<QPolygonF> leftBounds, QList<QPolygonF> rightBounds)
+{
+    emit progress(0, 1);
+    QList<NodeItem *> nodes;
+    QList<WayItem *> ways;
+    QList<LaneletItem *> lanelets;
+    auto addWay = [&](const QPolygonF &bound)
+    {
+        QList<NodeItem *> wayNodes;
+        for (const auto &point : bound) {
+            auto node = new NodeItem();
+            node->setPos(point);
+            this->m_registry->addNode(node);
+            nodes.push_back(node);
+            wayNodes.push_back(node);
+        }
+        auto way = new WayItem();
+        way->setNodes(wayNodes);
+        this->m_registry->addWay(way);
+        ways.push_back(way);
+        return way;
+    };
+    for (int i = 0; i < leftBounds.size() && i < rightBounds.size(); i++) {
+        auto lanelet = new LaneletItem();
+        lanelet->setRightWayItem(addWay(rightBounds.at(i)));
+        lanelet->setLeftWayItem(addWay(leftBounds.at(i)));
+        this->m_registry->addLanelet(lanelet);
+        lanelets.push_back(lanelet);
+    }
+    qDebug() << "[LaneletParser]" << lanelets.size() << "lanelet candidates added!";
+
+    emit nodesAdded(nodes);
+    emit waysAdded(ways);
+    emit laneletsAdded(lanelets);
+    emit progress(1, 1);
+    emit loaded();
+}
 void LaneletHandler::addNode(QPointF position)
 {
     auto item = new NodeItem();
     item->setPos(position);
-    this->nodes_.push_back(item);
+    this->m_registry->addNode(item);
     emit nodeAdded(item);
     qDebug() << "[LaneletParser] Node added!";
 }
 void LaneletHandler::removeNode(NodeItem *node)
 {
-    int index = -1;
-    int counter = -1;
-    for (auto element : this->nodes_) {
-        counter++;
-        if (element != node) continue;
-        index = counter;
-    }
-    this->nodes_.removeAt(index);
-    // Free Memory
-    delete node;
-    qDebug() << "[LaneletParser] Node removed!";
+    this->removeElements({node}, {}, {});
 }
 void LaneletHandler::addWayWithNode(NodeItem *node)
 {
     auto path = new WayItem();
     path->addNode(node);
-    this->ways_.push_back(path);
+    this->m_registry->addWay(path);
     emit wayAdded(path);
     qDebug() << "[LaneletParser] Path added!";
 }
 void LaneletHandler::removeWay(WayItem *way)
 {
-    if (!way->lanelets().empty()) {
-        for (auto lanelet : way->lanelets()) {
-            auto laneletWay = lanelet->leftWayItem();
-            if (laneletWay) laneletWay->removeFromLanelet(lanelet);
-            laneletWay = lanelet->rightWayItem();
-            if (laneletWay) laneletWay->removeFromLanelet(lanelet);
-            this->removeLanelet(lanelet);
-        }
+    // Lanelets can not exist without their ways
+    QList<LaneletItem *> lanelets;
+    for (auto lanelet : way->lanelets()) {
+        lanelets.push_back(lanelet);
     }
-    int index = -1;
-    int counter = -1;
-    for (auto element : this->ways_) {
-        counter++;
-        if (element != way) continue;
-        index = counter;
+    for (auto lanelet : lanelets) {
+        auto laneletWay = lanelet->leftWayItem();
+        if (laneletWay) laneletWay->removeFromLanelet(lanelet);
+        laneletWay = lanelet->rightWayItem();
+        if (laneletWay) laneletWay->removeFromLanelet(lanelet);
     }
-    this->ways_.removeAt(index);
-    // Free Memory
-    delete way;
-    qDebug() << "[LaneletParser] Path removed!";
+    this->removeElements({}, {way}, lanelets);
 }
 void LaneletHandler::addLaneletWithPath(WayItem *way)
 {
     auto lanelet = new LaneletItem();
     lanelet->setLeftWayItem(way);
-    this->lanelets_.push_back(lanelet);
+    this->m_registry->addLanelet(lanelet);
     emit laneletAdded(lanelet);
     qDebug() << "[LaneletParser] Lanelet added!";
 }
 void LaneletHandler::removeLanelet(LaneletItem *lanelet)
 {
-    int index = -1;
-    int counter = -1;
-    for (auto element : this->lanelets_) {
-        counter++;
-        if (element != lanelet) continue;
-        index = counter;
-    }
-    this->lanelets_.removeAt(index);
-    // Free Memory
-    delete lanelet;
-    qDebug() << "[LaneletParser] Lanelet removed!";
+    this->removeElements({}, {}, {lanelet});
 }
-void LaneletHandler::writeLaneletImage(const QString &svgFile, QGraphicsScene *scene)
+void LaneletHandler::removeElements(QList<NodeItem *> nodes, QList<WayItem *> ways, QList<LaneletItem *> lanelets)
 {
-    QSvgGenerator svgGen;
-
-    svgGen.setFileName(svgFile);
-    svgGen.setSize(QSize(1190, 1057));
-    svgGen.setViewBox(QRect(0, 0, 1190, 1057));
-    svgGen.setTitle(tr("SVG Generator Example Drawing"));
-    svgGen.setDescription(tr("An SVG drawing created by the SVG Generator Example provided with Qt."));
+    // Only free what was still registered, so elements are never freed twice
+    this->m_registry->removeElements(nodes, ways, lanelets);
 
-    QPainter painter(&svgGen);
-    scene->render(&painter);
+    // Free Memory, parents before children
+    qDeleteAll(lanelets);
+    qDeleteAll(ways);
+    qDeleteAll(nodes);
+    qDebug() << "[LaneletParser]" << nodes.size() << "nodes," << ways.size() << "paths and" << lanelets.size()
+             << "lanelets removed!";
 }
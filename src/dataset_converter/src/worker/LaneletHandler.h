@@ -4,12 +4,14 @@
 #include <memory>
 
 #include <QObject>
+#include <QPolygonF>
 
 #include <lanelet2_core/LaneletMap.h>
 
-#include "visualisation/graphics_items/NodeItem.h"
-#include "visualisation/graphics_items/WayItem.h"
-#include "visualisation/graphics_items/LaneletItem.h"
+#include "worker/LaneletElementRegistry.h"
+#include "worker/LaneletSnapshot.h"
+
+class LaneletMapCache;
 
 /**
  * Worker class that loads or stores lanelet 2 maps. All updates in the interface are always mirrored here.
@@ -18,41 +20,51 @@ class LaneletHandler: public QObject
 {
 Q_OBJECT
 private:
+    static constexpr int BatchSize = 10000; ///< Number of elements delivered to the visualisation at once
+
     QString lanelet_file_name_; ///< Lanelet map that should be loaded or stored
     lanelet::LaneletMapPtr m_map = nullptr; ///< Lanelet map instance that is ever stored to or loaded from
 
-    QList<NodeItem *> nodes_; ///< All nodes that appeared or should appear in the map
-    QList<WayItem *> ways_; ///< All ways that appeared or should appear in the map
-    QList<LaneletItem *> lanelets_; ///< All lanelets that appeared or should appear in the map
+    const LaneletElementRegistryPtr m_registry; ///< All elements that appeared or should appear in the map
+
+    /**
+     * Creates the items of a map from its binary snapshot and pushes them to the visualisation in batches.
+     * @param cache Opened snapshot.
+     * @param scaleFactor Scale factor matching meter to pixels
+     */
+    void loadFromCache(const LaneletMapCache &cache, qreal scaleFactor);
 
 public:
     /**
      * Creates the handler..
+     * @param registry Registry of all lanelet elements, shared with the visualisation.
      * @param parent Possible parent or qt pointer destruction.
      */
-    explicit LaneletHandler(QObject *parent = nullptr);
+    explicit LaneletHandler(LaneletElementRegistryPtr registry, QObject *parent = nullptr);
+
+    /**
+     * Maps the type and subtype of a lanelet line string to the way type used in the editor.
+     * @param way Line string of the map.
+     * @return Internal way type.
+     */
+    static QString internalWayType(const lanelet::ConstLineString3d &way);
 
 public slots:
     /**
-     * Starts the parsing of a lanelet map.
+     * Starts the parsing of a lanelet map. A binary snapshot next to the map is used instead of the map if it was
+     * created from the same file content, otherwise it is written after parsing.
      * @param laneletFileName File to parse from.
      * @param scaleFactor Scale factor matching meter to pixels
      */
     void parseLanelet(QString laneletFileName, qreal scaleFactor);
 
     /**
-     * Starts the storing of a lanelet map.
+     * Starts the storing of a lanelet map. The snapshot is taken in the gui thread, so no graphics item is read here.
      * @param laneletFileName File to wrote to.
+     * @param snapshot Editor model to store.
      * @param scaleFactor Scale factor matching meter to pixels
      */
-    void writeLanelet(QString laneletFileName, qreal scaleFactor);
-
-    /**
-     * Starts the export process to store the current lanelet map into a svg file.
-     * @param svgFile SVG file path to store into.
-     * @param scene Scene to grab the data from.
-     */
-    void writeLaneletImage(const QString &svgFile, QGraphicsScene *scene);
+    void writeLanelet(QString laneletFileName, LaneletSnapshot snapshot, qreal scaleFactor);
 
     /**
      * Add a node for later storing.
@@ -90,6 +102,23 @@ public slots:
      */
     void removeLanelet(LaneletItem *lanelet);
 
+    /**
+     * Remove a selection of elements from buffer in one transaction and free them. The elements have to be unlinked
+     * from each other and removed from the scene already.
+     * @param nodes Nodes to remove.
+     * @param ways Ways to remove.
+     * @param lanelets Lanelets to remove.
+     */
+    void removeElements(QList<NodeItem *> nodes, QList<WayItem *> ways, QList<LaneletItem *> lanelets);
+
+    /**
+     * Adds lanelets with new nodes for every vertex of their bounds, for example lanes found in trajectories. The
+     * elements are delivered like a loaded map.
+     * @param leftBounds Left bound of every lanelet in scene coordinates.
+     * @param rightBounds Right bound of every lanelet in scene coordinates.
+     */
+    void addLaneletCandidates(QList<QPolygonF> leftBounds, QList<QPolygonF> rightBounds);
+
 signals:
     /**
      * Indicator for the current progress. Send periodically from the worker to the main thread.
@@ -128,6 +157,22 @@ signals:
      * @param lanelet New lanelet.
      */
     void laneletAdded(LaneletItem *lanelet);
+
+    /**
+     * Batch of nodes added while loading a map.
+     * @param nodes New nodes.
+     */
+    void nodesAdded(QList<NodeItem *> nodes);
+    /**
+     * Batch of ways added while loading a map.
+     * @param ways New ways.
+     */
+    void waysAdded(QList<WayItem *> ways);
+    /**
+     * Batch of lanelets added while loading a map.
+     * @param lanelets New lanelets.
+     */
+    void laneletsAdded(QList<LaneletItem *> lanelets);
 };
 
 #endif // LANELETHANDLER_H
@@ -0,0 +1,268 @@
+#include "LaneletMapCache.h"
+#include "LaneletHandler.h"
+
+#include <QCryptographicHash>
+#include <QHash>
+#include <QSaveFile>
+#include <cstring>
+
+static_assert(sizeof(LaneletMapCache::NodeRecord) == 24, "Node records have to be packed");
+static_assert(sizeof(LaneletMapCache::WayRecord) == 24, "Way records have to be packed");
+static_assert(sizeof(LaneletMapCache::LaneletRecord) == 24, "Lanelet records have to be packed");
+
+// Rounds a byte offset up to the next multiple of 8
+static qint64 Align(qint64 offset)
+{
+    return (offset + 7) & ~qint64(7);
+}
+
+LaneletMapCache::LaneletMapCache(const QString &cacheFileName)
+    : m_file(cacheFileName)
+{
+    static_assert(sizeof(Header) % 8 == 0, "Records following the header have to be aligned");
+}
+
+LaneletMapCache::~LaneletMapCache()
+{
+    this->close();
+}
+
+QString LaneletMapCache::cacheFileName(const QString &mapFileName)
+{
+    return mapFileName + ".dcache";
+}
+
+QByteArray LaneletMapCache::hashFile(const QString &mapFileName)
+{
+    QFile file(mapFileName);
+    if (!file.open(QIODevice::ReadOnly)) return {};
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) return {};
+    return hash.result();
+}
+
+qint64 LaneletMapCache::stringTableOffset(const Header &header)
+{
+    qint64 offset = sizeof(Header);
+    offset += qint64(header.nodeCount) * sizeof(NodeRecord);
+    offset += qint64(header.wayCount) * sizeof(WayRecord);
+    offset += qint64(header.laneletCount) * sizeof(LaneletRecord);
+    offset += qint64(header.wayNodeCount) * sizeof(quint32);
+    return Align(offset);
+}
+
+bool LaneletMapCache::write(const QString &cacheFileName, const QByteArray &sourceHash, const lanelet::LaneletMap &map)
+{
+    if (sourceHash.size() != sizeof(Header::sourceHash)) return false;
+
+    QStringList strings;
+    QHash<QString, quint32> stringIndex;
+    auto internString = [&strings, &stringIndex](const QString &string)
+    {
+        auto index = stringIndex.constFind(string);
+        if (index != stringIndex.constEnd()) return *index;
+        strings.push_back(string);
+        return *stringIndex.insert(string, static_cast<quint32>(strings.size() - 1));
+    };
+
+    // Records reference each other by index, so loading needs no id lookup
+    QVector<NodeRecord> nodes;
+    QHash<lanelet::Id, quint32> nodeIndex;
+    nodes.reserve(static_cast<int>(map.pointLayer.size()));
+    for (const auto &node : map.pointLayer) {
+        nodeIndex.insert(node.id(), static_cast<quint32>(nodes.size()));
+        nodes.push_back({node.id(), node.x(), node.y()});
+    }
+
+    QVector<WayRecord> ways;
+    QVector<quint32> wayNodes;
+    QHash<lanelet::Id, quint32> wayIndex;
+    ways.reserve(static_cast<int>(map.lineStringLayer.size()));
+    for (const auto &way : map.lineStringLayer) {
+        WayRecord record{way.id(), static_cast<quint32>(wayNodes.size()), static_cast<quint32>(way.size()),
+                         internString(LaneletHandler::internalWayType(way)), 0};
+        for (const auto &node : way) {
+            auto index = nodeIndex.constFind(node.id());
+            if (index == nodeIndex.constEnd()) return false;
+            wayNodes.push_back(*index);
+        }
+        wayIndex.insert(way.id(), static_cast<quint32>(ways.size()));
+        ways.push_back(record);
+    }
+
+    QVector<LaneletRecord> lanelets;
+    lanelets.reserve(static_cast<int>(map.laneletLayer.size()));
+    for (const auto &lanelet : map.laneletLayer) {
+        QString type = lanelet.hasAttribute("cpm_type") ? lanelet.attribute("cpm_type").value().c_str() : "";
+        lanelets.push_back({lanelet.id(), wayIndex.value(lanelet.leftBound().id(), NoIndex),
+                            wayIndex.value(lanelet.rightBound().id(), NoIndex), internString(type), 0});
+    }
+
+    Header header{};
+    header.magic = Magic;
+    header.version = Version;
+    std::memcpy(header.sourceHash, sourceHash.constData(), sizeof(header.sourceHash));
+    header.nodeCount = static_cast<quint32>(nodes.size());
+    header.wayCount = static_cast<quint32>(ways.size());
+    header.laneletCount = static_cast<quint32>(lanelets.size());
+    header.wayNodeCount = static_cast<quint32>(wayNodes.size());
+    header.stringCount = static_cast<quint32>(strings.size());
+
+    QByteArray data;
+    data.reserve(static_cast<int>(stringTableOffset(header)));
+    data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    data.append(reinterpret_cast<const char *>(nodes.constData()), nodes.size() * int(sizeof(NodeRecord)));
+    data.append(reinterpret_cast<const char *>(ways.constData()), ways.size() * int(sizeof(WayRecord)));
+    data.append(reinterpret_cast<const char *>(lanelets.constData()), lanelets.size() * int(sizeof(LaneletRecord)));
+    data.append(reinterpret_cast<const char *>(wayNodes.constData()), wayNodes.size() * int(sizeof(quint32)));
+    data.append(static_cast<int>(stringTableOffset(header) - data.size()), '\0');
+    for (const auto &string : strings) {
+        QByteArray utf8 = string.toUtf8();
+        auto length = static_cast<quint32>(utf8.size());
+        data.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        data.append(utf8);
+    }
+
+    QSaveFile file(cacheFileName);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    if (file.write(data) != data.size()) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool LaneletMapCache::open(const QByteArray &sourceHash)
+{
+    this->close();
+    if (sourceHash.size() != sizeof(Header::sourceHash)) return false;
+    if (!this->m_file.open(QIODevice::ReadOnly)) return false;
+
+    qint64 size = this->m_file.size();
+    if (size < qint64(sizeof(Header))) {
+        this->close();
+        return false;
+    }
+    this->m_data = this->m_file.map(0, size);
+    if (!this->m_data) {
+        this->close();
+        return false;
+    }
+
+    this->m_header = reinterpret_cast<const Header *>(this->m_data);
+    const Header &header = *this->m_header;
+    if (header.magic != Magic || header.version != Version
+        || std::memcmp(header.sourceHash, sourceHash.constData(), sizeof(header.sourceHash)) != 0
+        || stringTableOffset(header) > size) {
+        this->close();
+        return false;
+    }
+
+    const uchar *position = this->m_data + sizeof(Header);
+    this->m_nodes = reinterpret_cast<const NodeRecord *>(position);
+    position += qint64(header.nodeCount) * sizeof(NodeRecord);
+    this->m_ways = reinterpret_cast<const WayRecord *>(position);
+    position += qint64(header.wayCount) * sizeof(WayRecord);
+    this->m_lanelets = reinterpret_cast<const LaneletRecord *>(position);
+    position += qint64(header.laneletCount) * sizeof(LaneletRecord);
+    this->m_wayNodes = reinterpret_cast<const quint32 *>(position);
+
+    // Strings are small and few, decode them once
+    qint64 offset = stringTableOffset(header);
+    this->m_strings.reserve(static_cast<int>(header.stringCount));
+    for (quint32 i = 0; i < header.stringCount; i++) {
+        quint32 length;
+        if (offset + qint64(sizeof(length)) > size) {
+            this->close();
+            return false;
+        }
+        std::memcpy(&length, this->m_data + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > size) {
+            this->close();
+            return false;
+        }
+        this->m_strings.push_back(QString::fromUtf8(reinterpret_cast<const char *>(this->m_data + offset),
+                                                    static_cast<int>(length)));
+        offset += length;
+    }
+
+    if (!this->validateRecords()) {
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+bool LaneletMapCache::validateRecords() const
+{
+    const Header &header = *this->m_header;
+    for (quint32 i = 0; i < header.wayNodeCount; i++) {
+        if (this->m_wayNodes[i] >= header.nodeCount) return false;
+    }
+    for (quint32 i = 0; i < header.wayCount; i++) {
+        const WayRecord &way = this->m_ways[i];
+        if (qint64(way.firstNode) + way.nodeCount > header.wayNodeCount) return false;
+        if (way.type >= header.stringCount) return false;
+    }
+    for (quint32 i = 0; i < header.laneletCount; i++) {
+        const LaneletRecord &lanelet = this->m_lanelets[i];
+        if (lanelet.leftWay != NoIndex && lanelet.leftWay >= header.wayCount) return false;
+        if (lanelet.rightWay != NoIndex && lanelet.rightWay >= header.wayCount) return false;
+        if (lanelet.type >= header.stringCount) return false;
+    }
+    return true;
+}
+
+void LaneletMapCache::close()
+{
+    if (this->m_data) this->m_file.unmap(const_cast<uchar *>(this->m_data));
+    if (this->m_file.isOpen()) this->m_file.close();
+    this->m_data = nullptr;
+    this->m_header = nullptr;
+    this->m_nodes = nullptr;
+    this->m_ways = nullptr;
+    this->m_lanelets = nullptr;
+    this->m_wayNodes = nullptr;
+    this->m_strings.clear();
+}
+
+quint32 LaneletMapCache::nodeCount() const
+{
+    return this->m_header ? this->m_header->nodeCount : 0;
+}
+
+const LaneletMapCache::NodeRecord *LaneletMapCache::nodes() const
+{
+    return this->m_nodes;
+}
+
+quint32 LaneletMapCache::wayCount() const
+{
+    return this->m_header ? this->m_header->wayCount : 0;
+}
+
+const LaneletMapCache::WayRecord *LaneletMapCache::ways() const
+{
+    return this->m_ways;
+}
+
+quint32 LaneletMapCache::laneletCount() const
+{
+    return this->m_header ? this->m_header->laneletCount : 0;
+}
+
+const LaneletMapCache::LaneletRecord *LaneletMapCache::lanelets() const
+{
+    return this->m_lanelets;
+}
+
+const quint32 *LaneletMapCache::wayNodes() const
+{
+    return this->m_wayNodes;
+}
+
+QString LaneletMapCache::string(quint32 index) const
+{
+    return index < quint32(this->m_strings.size()) ? this->m_strings.at(static_cast<int>(index)) : QString();
+}
@@ -0,0 +1,200 @@
+#ifndef LANELETMAPCACHE_H
+#define LANELETMAPCACHE_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+#include <lanelet2_core/LaneletMap.h>
+
+/**
+ * Binary snapshot of the editor model of a lanelet map, stored next to the map file. It holds node positions in map
+ * coordinates, the node list and type of every way and the bounds and cpm type of every lanelet. The snapshot is only
+ * valid as long as the hash of the map file matches the hash stored in it. Opening memory maps the file, the records
+ * are read in place and reference each other by index, so no xml parsing or id lookup is needed to build the items.
+ *
+ * Layout: header, node records, way records, lanelet records, way node indices, string table. All records are 8 byte
+ * aligned and stored in native byte order, snapshots written on a machine with different byte order are rejected.
+ */
+class LaneletMapCache
+{
+public:
+    static constexpr quint32 NoIndex = 0xffffffff; ///< Index of a missing lanelet bound
+
+    /**
+     * Node in map coordinates.
+     */
+    struct NodeRecord
+    {
+        qint64 id; ///< Id in the map file
+        double x; ///< X in meter
+        double y; ///< Y in meter
+    };
+
+    /**
+     * Way referencing a range of the way node indices.
+     */
+    struct WayRecord
+    {
+        qint64 id; ///< Id in the map file
+        quint32 firstNode; ///< Position of the first node index in the way node indices
+        quint32 nodeCount; ///< Number of nodes
+        quint32 type; ///< Index of the internal way type in the string table
+        quint32 reserved; ///< Padding
+    };
+
+    /**
+     * Lanelet referencing its bounds by way index.
+     */
+    struct LaneletRecord
+    {
+        qint64 id; ///< Id in the map file
+        quint32 leftWay; ///< Index of the left bound or NoIndex
+        quint32 rightWay; ///< Index of the right bound or NoIndex
+        quint32 type; ///< Index of the cpm type in the string table
+        quint32 reserved; ///< Padding
+    };
+
+private:
+    static constexpr quint32 Magic = 0x4443434c; ///< "DCCL", also detects a different byte order
+    static constexpr quint32 Version = 2; ///< Increased whenever the layout changes
+
+    /**
+     * Header at the start of the file.
+     */
+    struct Header
+    {
+        quint32 magic; ///< Always Magic
+        quint32 version; ///< Layout version
+        char sourceHash[20]; ///< Sha1 of the map file the snapshot was created from
+        quint32 nodeCount; ///< Number of node records
+        quint32 wayCount; ///< Number of way records
+        quint32 laneletCount; ///< Number of lanelet records
+        quint32 wayNodeCount; ///< Number of way node indices
+        quint32 stringCount; ///< Number of strings in the string table
+        quint32 reserved[2]; ///< Padding to a multiple of 8 bytes
+    };
+
+    QFile m_file; ///< Snapshot file, kept open while mapped
+    const uchar *m_data = nullptr; ///< Mapped file content or nullptr if not open
+    const Header *m_header = nullptr; ///< Header inside the mapped content
+    const NodeRecord *m_nodes = nullptr; ///< Node records inside the mapped content
+    const WayRecord *m_ways = nullptr; ///< Way records inside the mapped content
+    const LaneletRecord *m_lanelets = nullptr; ///< Lanelet records inside the mapped content
+    const quint32 *m_wayNodes = nullptr; ///< Way node indices inside the mapped content
+    QStringList m_strings; ///< Decoded string table
+
+    /**
+     * Calculates the byte offset of the string table.
+     * @param header Header with the element counts.
+     * @return Offset from the start of the file.
+     */
+    static qint64 stringTableOffset(const Header &header);
+
+    /**
+     * Checks that all indices stay within the snapshot.
+     * @return True if the records are consistent.
+     */
+    [[nodiscard]] bool validateRecords() const;
+
+    /**
+     * Unmaps and closes the file.
+     */
+    void close();
+
+public:
+    /**
+     * Creates a closed snapshot.
+     * @param cacheFileName Snapshot file.
+     */
+    explicit LaneletMapCache(const QString &cacheFileName);
+
+    /**
+     * Unmaps the snapshot.
+     */
+    ~LaneletMapCache();
+
+    LaneletMapCache(const LaneletMapCache &) = delete;
+    LaneletMapCache &operator=(const LaneletMapCache &) = delete;
+
+    /**
+     * Generates the snapshot file name of a map.
+     * @param mapFileName Lanelet map file.
+     * @return File name next to the map.
+     */
+    static QString cacheFileName(const QString &mapFileName);
+
+    /**
+     * Hashes the content of a map file.
+     * @param mapFileName Lanelet map file.
+     * @return Sha1 of the file, empty if the file could not be read.
+     */
+    static QByteArray hashFile(const QString &mapFileName);
+
+    /**
+     * Writes a snapshot of a parsed map. The file is replaced atomically, so readers never see a partial snapshot.
+     * @param cacheFileName Snapshot file.
+     * @param sourceHash Hash of the map file.
+     * @param map Parsed lanelet map.
+     * @return True on success.
+     */
+    static bool write(const QString &cacheFileName, const QByteArray &sourceHash, const lanelet::LaneletMap &map);
+
+    /**
+     * Maps the snapshot if it exists, is consistent and was created from a map file with the given hash.
+     * @param sourceHash Hash of the current map file.
+     * @return True if the snapshot can be used.
+     */
+    bool open(const QByteArray &sourceHash);
+
+    /**
+     * Getter for the number of nodes.
+     * @return Number of node records.
+     */
+    [[nodiscard]] quint32 nodeCount() const;
+
+    /**
+     * Getter for the nodes.
+     * @return First node record.
+     */
+    [[nodiscard]] const NodeRecord *nodes() const;
+
+    /**
+     * Getter for the number of ways.
+     * @return Number of way records.
+     */
+    [[nodiscard]] quint32 wayCount() const;
+
+    /**
+     * Getter for the ways.
+     * @return First way record.
+     */
+    [[nodiscard]] const WayRecord *ways() const;
+
+    /**
+     * Getter for the number of lanelets.
+     * @return Number of lanelet records.
+     */
+    [[nodiscard]] quint32 laneletCount() const;
+
+    /**
+     * Getter for the lanelets.
+     * @return First lanelet record.
+     */
+    [[nodiscard]] const LaneletRecord *lanelets() const;
+
+    /**
+     * Getter for the node indices of the ways.
+     * @return First way node index.
+     */
+    [[nodiscard]] const quint32 *wayNodes() const;
+
+    /**
+     * Getter for a string of the string table.
+     * @param index Index of the string.
+     * @return String, empty if the index is invalid.
+     */
+    [[nodiscard]] QString string(quint32 index) const;
+};
+
+#endif // LANELETMAPCACHE_H
@@ -0,0 +1,91 @@
+#include "LaneletSnapshot.h"
+
+#include <QHash>
+#include <filesystem>
+#include <system_error>
+
+#include <lanelet2_projection/CPM.h>
+#include <lanelet2_io/Io.h>
+
+lanelet::LaneletMapPtr LaneletSnapshot::toMap(qreal scaleFactor) const
+{
+    auto map = std::make_shared<lanelet::LaneletMap>();
+
+    QHash<qint64, lanelet::Point3d> backendNodes;
+    backendNodes.reserve(this->nodes.size());
+    this->nodes.forEach([&](qint64 id, const QPointF &position)
+    {
+        lanelet::Point3d backendNode(id, position.x() / (scaleFactor * 18.0), 4 - (position.y() / (scaleFactor * 18.0)),
+                                     0);
+        map->add(backendNode);
+        backendNodes.insert(id, backendNode);
+    });
+
+    QHash<qint64, lanelet::LineString3d> backendWays;
+    backendWays.reserve(this->ways.size());
+    this->ways.forEach([&](qint64 id, const Way &way)
+    {
+        lanelet::LineString3d backendWay(id);
+        // Equivalent for both unknown and virtual
+        if (way.type == "solid") {
+            backendWay.setAttribute("type", "line_thin");
+            backendWay.setAttribute("subtype", "solid");
+        }
+        else if (way.type == "dashed") {
+            backendWay.setAttribute("type", "line_thin");
+            backendWay.setAttribute("subtype", "dashed");
+        }
+        else if (way.type == "virtual") {
+            backendWay.setAttribute("type", "virtual");
+        }
+        for (auto node : way.nodes) {
+            auto backendNode = backendNodes.constFind(node);
+            if (backendNode != backendNodes.constEnd()) backendWay.push_back(*backendNode);
+        }
+        if (backendWay.size() < 2) return;
+        map->add(backendWay);
+        backendWays.insert(id, backendWay);
+    });
+
+    this->lanelets.forEach([&](qint64 id, const Lanelet &lanelet)
+    {
+        auto leftWay = backendWays.constFind(lanelet.leftWay);
+        auto rightWay = backendWays.constFind(lanelet.rightWay);
+        if (leftWay == backendWays.constEnd() || rightWay == backendWays.constEnd()) return;
+        lanelet::Lanelet backendLanelet(id);
+        backendLanelet.setAttribute("cpm_type", lanelet.type.toStdString());
+        backendLanelet.setAttribute("location", "urban");
+        backendLanelet.setAttribute("name", "CPM-Lab");
+        backendLanelet.setAttribute("one_way", "yes");
+        backendLanelet.setAttribute("region", "de");
+        backendLanelet.setAttribute("subtype", "road");
+        backendLanelet.setAttribute(lanelet::AttributeName::Subtype, lanelet::AttributeValueString::Road);
+        backendLanelet.setLeftBound(*leftWay);
+        backendLanelet.setRightBound(*rightWay);
+        map->add(backendLanelet);
+    });
+    return map;
+}
+
+bool LaneletSnapshot::write(const QString &fileName, qreal scaleFactor, QString *errorMessage) const
+{
+    // The writer is chosen by extension, so the temporary file keeps it
+    QString temporaryFileName = fileName + ".part.osm";
+    try {
+        lanelet::projection::CpmProjector projector(lanelet::Origin({0.0, 0.0}));
+        lanelet::write(temporaryFileName.toStdString(), *this->toMap(scaleFactor), projector);
+    }
+    catch (const std::exception &e) {
+        if (errorMessage) *errorMessage = e.what();
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryFileName.toStdString(), fileName.toStdString(), error);
+    if (error) {
+        if (errorMessage) *errorMessage = QString::fromStdString(error.message());
+        std::filesystem::remove(temporaryFileName.toStdString(), error);
+        return false;
+    }
+    return true;
+}
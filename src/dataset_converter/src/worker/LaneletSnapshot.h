@@ -0,0 +1,170 @@
+#ifndef LANELETSNAPSHOT_H
+#define LANELETSNAPSHOT_H
+
+#include <QMap>
+#include <QMetaType>
+#include <QPointF>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include <lanelet2_core/LaneletMap.h>
+
+/**
+ * Table of elements ordered by id. Elements are grouped into chunks of consecutive ids that are implicitly shared
+ * on their own, so copying a table is constant and changing an element after a copy only detaches its chunk.
+ * @tparam T Element data.
+ */
+template<typename T>
+class SnapshotTable
+{
+private:
+    static constexpr int ChunkBits = 8; ///< Each chunk holds up to 256 consecutive ids
+
+    QMap<qint64, QMap<qint64, T>> m_chunks; ///< Chunks by id >> ChunkBits
+    int m_size = 0; ///< Number of elements
+
+public:
+    /**
+     * Inserts or replaces an element.
+     * @param id Element id, has to be positive.
+     * @param value Element data.
+     */
+    void insert(qint64 id, const T &value)
+    {
+        auto &chunk = this->m_chunks[id >> ChunkBits];
+        int previousSize = chunk.size();
+        chunk.insert(id, value);
+        this->m_size += chunk.size() - previousSize;
+    }
+
+    /**
+     * Removes an element if it exists.
+     * @param id Element id.
+     */
+    void remove(qint64 id)
+    {
+        auto chunk = this->m_chunks.find(id >> ChunkBits);
+        if (chunk == this->m_chunks.end()) return;
+        this->m_size -= chunk->remove(id);
+        if (chunk->isEmpty()) this->m_chunks.erase(chunk);
+    }
+
+    /**
+     * Looks up an element.
+     * @param id Element id.
+     * @return Element data or nullptr if it does not exist.
+     */
+    [[nodiscard]] const T *find(qint64 id) const
+    {
+        auto chunk = this->m_chunks.constFind(id >> ChunkBits);
+        if (chunk == this->m_chunks.constEnd()) return nullptr;
+        auto element = chunk->constFind(id);
+        return element == chunk->constEnd() ? nullptr : &element.value();
+    }
+
+    /**
+     * Getter for the number of elements.
+     * @return Number of elements.
+     */
+    [[nodiscard]] int size() const
+    {
+        return this->m_size;
+    }
+
+    /**
+     * Visits all elements in ascending id order.
+     * @param function Called with id and data of each element.
+     */
+    template<typename Function>
+    void forEach(Function function) const
+    {
+        for (const auto &chunk : this->m_chunks) {
+            for (auto element = chunk.constBegin(); element != chunk.constEnd(); ++element) {
+                function(element.key(), element.value());
+            }
+        }
+    }
+};
+
+/**
+ * Copy of the editor model that is independent of the graphics items, so it can be serialised on any thread. Elements
+ * are stored by their registry id and reference each other by id.
+ */
+class LaneletSnapshot
+{
+public:
+    /**
+     * Way with its node ids.
+     */
+    struct Way
+    {
+        QString type; ///< Internal way type
+        QVector<qint64> nodes; ///< Node ids in order
+    };
+
+    /**
+     * Lanelet with the ids of its bounds.
+     */
+    struct Lanelet
+    {
+        QString type; ///< Cpm type
+        qint64 leftWay = 0; ///< Id of the left bound, 0 if not set
+        qint64 rightWay = 0; ///< Id of the right bound, 0 if not set
+    };
+
+    /**
+     * Ids of the elements that were added, modified or removed between two snapshots.
+     */
+    struct Changes
+    {
+        QSet<qint64> nodes; ///< Changed node ids
+        QSet<qint64> ways; ///< Changed way ids
+        QSet<qint64> lanelets; ///< Changed lanelet ids
+
+        /**
+         * Checks if anything changed.
+         * @return True if no id is contained.
+         */
+        [[nodiscard]] bool isEmpty() const
+        {
+            return nodes.isEmpty() && ways.isEmpty() && lanelets.isEmpty();
+        }
+
+        /**
+         * Adds the ids of other changes.
+         * @param other Changes to merge.
+         */
+        void unite(const Changes &other)
+        {
+            nodes.unite(other.nodes);
+            ways.unite(other.ways);
+            lanelets.unite(other.lanelets);
+        }
+    };
+
+    SnapshotTable<QPointF> nodes; ///< Node positions in scene coordinates
+    SnapshotTable<Way> ways; ///< Ways
+    SnapshotTable<Lanelet> lanelets; ///< Lanelets
+
+    /**
+     * Builds a lanelet map. Ways with less than two nodes and lanelets without both bounds are left out.
+     * @param scaleFactor Scale factor matching meter to pixels.
+     * @return New lanelet map.
+     */
+    [[nodiscard]] lanelet::LaneletMapPtr toMap(qreal scaleFactor) const;
+
+    /**
+     * Writes the snapshot as lanelet map. The map is written to a temporary file next to the target first and then
+     * renamed, so the target always holds a complete map.
+     * @param fileName Target osm file.
+     * @param scaleFactor Scale factor matching meter to pixels.
+     * @param errorMessage Output for the reason of a failure, may be nullptr.
+     * @return True on success.
+     */
+    bool write(const QString &fileName, qreal scaleFactor, QString *errorMessage = nullptr) const;
+};
+
+Q_DECLARE_METATYPE(LaneletSnapshot)
+
+#endif // LANELETSNAPSHOT_H
@@ -0,0 +1,94 @@
+#include "LaneletSnapshotTracker.h"
+#include "visualisation/graphics_items/ChangeJournal.h"
+
+#include <QMutexLocker>
+#include <utility>
+
+LaneletSnapshotTracker::LaneletSnapshotTracker(LaneletElementRegistryPtr registry, QObject *parent)
+    : QObject(parent), m_registry(std::move(registry))
+{
+    // Elements registered before recording starts would be missing in the snapshot
+    ChangeJournal::setEnabled(true);
+    for (auto node : this->m_registry->nodes()) ChangeJournal::recordNode(node);
+    for (auto way : this->m_registry->ways()) ChangeJournal::recordWay(way);
+    for (auto lanelet : this->m_registry->lanelets()) ChangeJournal::recordLanelet(lanelet);
+
+    this->m_timer = new QTimer(this);
+    connect(this->m_timer, &QTimer::timeout, this, &LaneletSnapshotTracker::update);
+    this->m_timer->start(UpdateInterval);
+}
+
+LaneletSnapshotTracker::~LaneletSnapshotTracker()
+{
+    ChangeJournal::setEnabled(false);
+}
+
+template<typename Item, typename T>
+void LaneletSnapshotTracker::applyChange(QHash<const Item *, qint64> &ids, SnapshotTable<T> &table,
+                                         QSet<qint64> &changedIds, const Item *item, qint64 id, const T &value)
+{
+    // Freed elements are not registered anymore, their memory may already be reused by a new element
+    qint64 previousId = ids.value(item, 0);
+    if (previousId && previousId != id) {
+        table.remove(previousId);
+        ids.remove(item);
+        changedIds.insert(previousId);
+    }
+    if (!id) return;
+    table.insert(id, value);
+    ids.insert(item, id);
+    changedIds.insert(id);
+}
+
+void LaneletSnapshotTracker::update()
+{
+    LaneletSnapshot::Changes changes;
+    {
+        // Registered elements can not be freed while the registry is locked
+        QMutexLocker locker(this->m_registry->mutex());
+        auto journal = ChangeJournal::take();
+        if (journal.isEmpty()) return;
+
+        for (auto node : journal.nodes) {
+            qint64 id = this->m_registry->id(node);
+            applyChange(this->m_nodeIds, this->m_snapshot.nodes, changes.nodes, node, id,
+                        id ? node->pos() : QPointF());
+        }
+        for (auto way : journal.ways) {
+            qint64 id = this->m_registry->id(way);
+            LaneletSnapshot::Way data;
+            if (id) {
+                data.type = way->wayType();
+                data.nodes.reserve(way->nodes().size());
+                for (auto node : way->nodes()) {
+                    data.nodes.push_back(this->m_registry->id(node));
+                }
+            }
+            applyChange(this->m_wayIds, this->m_snapshot.ways, changes.ways, way, id, data);
+        }
+        for (auto lanelet : journal.lanelets) {
+            qint64 id = this->m_registry->id(lanelet);
+            LaneletSnapshot::Lanelet data;
+            if (id) {
+                data.type = lanelet->laneletType();
+                data.leftWay = lanelet->leftWayItem() ? this->m_registry->id(lanelet->leftWayItem()) : 0;
+                data.rightWay = lanelet->rightWayItem() ? this->m_registry->id(lanelet->rightWayItem()) : 0;
+            }
+            applyChange(this->m_laneletIds, this->m_snapshot.lanelets, changes.lanelets, lanelet, id, data);
+        }
+    }
+    if (changes.isEmpty()) return;
+    this->m_revision++;
+    emit changed(changes);
+}
+
+const LaneletSnapshot &LaneletSnapshotTracker::snapshot()
+{
+    this->update();
+    return this->m_snapshot;
+}
+
+quint64 LaneletSnapshotTracker::revision() const
+{
+    return this->m_revision;
+}
@@ -0,0 +1,83 @@
+#ifndef LANELETSNAPSHOTTRACKER_H
+#define LANELETSNAPSHOTTRACKER_H
+
+#include <QObject>
+#include <QHash>
+#include <QTimer>
+
+#include "worker/LaneletElementRegistry.h"
+#include "worker/LaneletSnapshot.h"
+
+/**
+ * Keeps a snapshot of the lanelet editor model up to date. The elements recorded by the change journal are applied
+ * periodically, so an update only touches changed elements. Services that work on the model, like the autosave or the
+ * validation, read the snapshot instead of the graphics items and can therefore run on worker threads. Only to be used
+ * in the gui thread.
+ */
+class LaneletSnapshotTracker: public QObject
+{
+Q_OBJECT
+private:
+    static constexpr int UpdateInterval = 250; ///< Time between journal polls in milliseconds
+
+    const LaneletElementRegistryPtr m_registry; ///< Registry of all lanelet elements
+    LaneletSnapshot m_snapshot; ///< Editor model as of the last update
+    QHash<const NodeItem *, qint64> m_nodeIds; ///< Ids of the nodes in the snapshot
+    QHash<const WayItem *, qint64> m_wayIds; ///< Ids of the ways in the snapshot
+    QHash<const LaneletItem *, qint64> m_laneletIds; ///< Ids of the lanelets in the snapshot
+    quint64 m_revision = 0; ///< Increased with every update that changed the snapshot
+    QTimer *m_timer = nullptr; ///< Triggers the updates
+
+    /**
+     * Updates the snapshot entry of an element.
+     * @param ids Ids of the elements in the snapshot.
+     * @param table Snapshot table of the element type.
+     * @param changedIds Output for the ids whose entry changed.
+     * @param item Changed element.
+     * @param id Current registry id, 0 if the element was removed.
+     * @param value Current element data.
+     */
+    template<typename Item, typename T>
+    static void applyChange(QHash<const Item *, qint64> &ids, SnapshotTable<T> &table, QSet<qint64> &changedIds,
+                            const Item *item, qint64 id, const T &value);
+
+public:
+    /**
+     * Creates the tracker and starts recording changes.
+     * @param registry Registry of all lanelet elements.
+     * @param parent Possible parent or qt pointer destruction.
+     */
+    explicit LaneletSnapshotTracker(LaneletElementRegistryPtr registry, QObject *parent = nullptr);
+
+    /**
+     * Stops recording.
+     */
+    ~LaneletSnapshotTracker() override;
+
+    /**
+     * Applies pending changes and returns the snapshot. Copies share all data with the tracker.
+     * @return Snapshot of all registered elements.
+     */
+    const LaneletSnapshot &snapshot();
+
+    /**
+     * Getter for the revision.
+     * @return Number that changes whenever the snapshot changes.
+     */
+    [[nodiscard]] quint64 revision() const;
+
+public slots:
+    /**
+     * Applies all recorded changes to the snapshot. Emits changed if anything changed.
+     */
+    void update();
+
+signals:
+    /**
+     * Emitted after the snapshot changed.
+     * @param changes Ids of the changed elements.
+     */
+    void changed(const LaneletSnapshot::Changes &changes);
+};
+
+#endif // LANELETSNAPSHOTTRACKER_H
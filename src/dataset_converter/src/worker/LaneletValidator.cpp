@@ -0,0 +1,346 @@
+#include "LaneletValidator.h"
+#include "visualisation/graphics_items/LaneletItem.h"
+
+#include <QDebug>
+#include <QtConcurrent/QtConcurrent>
+#include <QtMath>
+
+bool LaneletIssue::isRepairable() const
+{
+    return type == Type::ShortWay || type == Type::MissingBound || type == Type::DanglingNode;
+}
+
+QString LaneletIssue::message() const
+{
+    switch (type) {
+        case Type::ShortWay:
+            return QString("Way %1 has less than two nodes").arg(elementId);
+        case Type::MissingBound:
+            return QString("Lanelet %1 is missing a bound").arg(elementId);
+        case Type::DanglingNode:
+            return QString("Node %1 is not part of any way").arg(elementId);
+        case Type::SelfIntersection:
+            return QString("Outline of lanelet %1 intersects itself").arg(elementId);
+        case Type::Overlap:
+            return QString("Lanelets %1 and %2 overlap").arg(elementId).arg(otherElementId);
+    }
+    return {};
+}
+
+LaneletValidator::LaneletValidator(LaneletSnapshotTracker *tracker, QObject *parent)
+    : QObject(parent), m_tracker(tracker)
+{
+    this->m_watcher = new QFutureWatcher<QVector<LaneletIssue>>(this);
+    connect(this->m_watcher, &QFutureWatcher<QVector<LaneletIssue>>::finished, this,
+            &LaneletValidator::onValidationFinished);
+    connect(this->m_tracker, &LaneletSnapshotTracker::changed, this, &LaneletValidator::onSnapshotChanged);
+}
+
+LaneletValidator::~LaneletValidator()
+{
+    this->m_watcher->waitForFinished();
+}
+
+const QVector<LaneletIssue> &LaneletValidator::issues() const
+{
+    return this->m_issues;
+}
+
+void LaneletValidator::setEnabled(bool enabled)
+{
+    if (enabled == this->m_enabled) return;
+    this->m_enabled = enabled;
+    this->m_generation++;
+    this->m_pendingChanges = {};
+
+    if (!enabled) {
+        this->m_state.reset();
+        this->m_issues.clear();
+        emit issuesChanged(this->m_issues);
+        return;
+    }
+
+    // Start from scratch, every element counts as changed
+    this->m_state = std::make_shared<State>();
+    const LaneletSnapshot &snapshot = this->m_tracker->snapshot();
+    snapshot.nodes.forEach([this](qint64 id, const QPointF &)
+    { this->m_pendingChanges.nodes.insert(id); });
+    snapshot.ways.forEach([this](qint64 id, const LaneletSnapshot::Way &)
+    { this->m_pendingChanges.ways.insert(id); });
+    snapshot.lanelets.forEach([this](qint64 id, const LaneletSnapshot::Lanelet &)
+    { this->m_pendingChanges.lanelets.insert(id); });
+    this->schedule();
+}
+
+void LaneletValidator::onSnapshotChanged(const LaneletSnapshot::Changes &changes)
+{
+    if (!this->m_enabled) return;
+    this->m_pendingChanges.unite(changes);
+    this->schedule();
+}
+
+void LaneletValidator::schedule()
+{
+    // Changes arriving meanwhile are validated once the running validation is done
+    if (this->m_watcher->isRunning() || this->m_pendingChanges.isEmpty()) return;
+
+    this->m_runningGeneration = this->m_generation;
+    this->m_watcher->setFuture(QtConcurrent::run(&LaneletValidator::validate, this->m_state,
+                                                 this->m_tracker->snapshot(), this->m_pendingChanges));
+    this->m_pendingChanges = {};
+}
+
+void LaneletValidator::onValidationFinished()
+{
+    if (this->m_enabled && this->m_runningGeneration == this->m_generation) {
+        this->m_issues = this->m_watcher->result();
+        qDebug() << "[LaneletValidator]" << this->m_issues.size() << "issues found";
+        emit issuesChanged(this->m_issues);
+    }
+    this->schedule();
+}
+
+bool LaneletValidator::isSelfIntersecting(const QPolygonF &outline, QPointF &intersection)
+{
+    int size = outline.size();
+    if (size < 4) return false;
+    auto isVertex = [](const QPointF &point, const QLineF &line)
+    {
+        return QLineF(point, line.p1()).length() < 1e-6 || QLineF(point, line.p2()).length() < 1e-6;
+    };
+    for (int i = 0; i < size; i++) {
+        QLineF first(outline.at(i), outline.at((i + 1) % size));
+        for (int j = i + 2; j < size; j++) {
+            // The last edge is adjacent to the first one
+            if (i == 0 && j == size - 1) continue;
+            QLineF second(outline.at(j), outline.at((j + 1) % size));
+            if (first.intersects(second, &intersection) != QLineF::BoundedIntersection) continue;
+            if (isVertex(intersection, first) && isVertex(intersection, second)) continue;
+            return true;
+        }
+    }
+    return false;
+}
+
+qreal LaneletValidator::area(const QPolygonF &polygon)
+{
+    qreal area = 0;
+    for (int i = 0; i < polygon.size(); i++) {
+        const QPointF &current = polygon.at(i);
+        const QPointF &next = polygon.at((i + 1) % polygon.size());
+        area += current.x() * next.y() - next.x() * current.y();
+    }
+    return qAbs(area) / 2;
+}
+
+QVector<LaneletIssue> LaneletValidator::validate(const std::shared_ptr<State> &state, const LaneletSnapshot &snapshot,
+                                                 const LaneletSnapshot::Changes &changes)
+{
+    State &s = *state;
+    QSet<qint64> affectedNodes = changes.nodes;
+    QSet<qint64> affectedLanelets = changes.lanelets;
+
+    // Keep the reverse references up to date, both the old and the new members are affected
+    for (auto wayId : changes.ways) {
+        if (auto oldWay = s.snapshot.ways.find(wayId)) {
+            for (auto nodeId : oldWay->nodes) {
+                auto ways = s.waysOfNode.find(nodeId);
+                if (ways == s.waysOfNode.end()) continue;
+                ways->remove(wayId);
+                if (ways->isEmpty()) s.waysOfNode.erase(ways);
+                affectedNodes.insert(nodeId);
+            }
+        }
+        if (auto newWay = snapshot.ways.find(wayId)) {
+            for (auto nodeId : newWay->nodes) {
+                s.waysOfNode[nodeId].insert(wayId);
+                affectedNodes.insert(nodeId);
+            }
+        }
+        affectedLanelets.unite(s.laneletsOfWay.value(wayId));
+    }
+    for (auto laneletId : changes.lanelets) {
+        if (auto oldLanelet = s.snapshot.lanelets.find(laneletId)) {
+            for (auto wayId : {oldLanelet->leftWay, oldLanelet->rightWay}) {
+                auto lanelets = s.laneletsOfWay.find(wayId);
+                if (lanelets == s.laneletsOfWay.end()) continue;
+                lanelets->remove(laneletId);
+                if (lanelets->isEmpty()) s.laneletsOfWay.erase(lanelets);
+            }
+        }
+        if (auto newLanelet = snapshot.lanelets.find(laneletId)) {
+            for (auto wayId : {newLanelet->leftWay, newLanelet->rightWay}) {
+                if (wayId) s.laneletsOfWay[wayId].insert(laneletId);
+            }
+        }
+    }
+    for (auto nodeId : changes.nodes) {
+        for (auto wayId : s.waysOfNode.value(nodeId)) {
+            affectedLanelets.unite(s.laneletsOfWay.value(wayId));
+        }
+    }
+
+    // Topology of nodes and ways
+    for (auto nodeId : affectedNodes) {
+        auto node = snapshot.nodes.find(nodeId);
+        if (node && !s.waysOfNode.contains(nodeId)) {
+            s.nodeIssues.insert(nodeId, {LaneletIssue::Type::DanglingNode, nodeId, 0, *node});
+        }
+        else {
+            s.nodeIssues.remove(nodeId);
+        }
+    }
+    for (auto wayId : changes.ways) {
+        auto way = snapshot.ways.find(wayId);
+        if (way && way->nodes.size() < 2) {
+            const QPointF *node = way->nodes.isEmpty() ? nullptr : snapshot.nodes.find(way->nodes.first());
+            s.wayIssues.insert(wayId, {LaneletIssue::Type::ShortWay, wayId, 0, node ? *node : QPointF()});
+        }
+        else {
+            s.wayIssues.remove(wayId);
+        }
+    }
+
+    // Outlines of the affected lanelets, calculated in parallel
+    struct OutlineResult
+    {
+        qint64 id = 0;
+        bool exists = false;
+        QPolygonF outline;
+        LaneletIssue issue;
+        bool hasIssue = false;
+    };
+    auto wayPolyline = [&snapshot](qint64 wayId)
+    {
+        QPolygonF polyline;
+        auto way = snapshot.ways.find(wayId);
+        if (!way) return polyline;
+        polyline.reserve(way->nodes.size());
+        for (auto nodeId : way->nodes) {
+            if (auto node = snapshot.nodes.find(nodeId)) polyline << *node;
+        }
+        return polyline;
+    };
+    QVector<qint64> laneletIds = affectedLanelets.values().toVector();
+    auto outlines = QtConcurrent::blockingMapped<QVector<OutlineResult>>(laneletIds,
+        std::function<OutlineResult(qint64)>(
+        [&snapshot, &wayPolyline](qint64 laneletId)
+        {
+            OutlineResult result;
+            result.id = laneletId;
+            auto lanelet = snapshot.lanelets.find(laneletId);
+            if (!lanelet) return result;
+            result.exists = true;
+
+            QPolygonF left = wayPolyline(lanelet->leftWay);
+            QPolygonF right = wayPolyline(lanelet->rightWay);
+            if (!snapshot.ways.find(lanelet->leftWay) || !snapshot.ways.find(lanelet->rightWay)) {
+                QPointF position = !left.isEmpty() ? left.first() : !right.isEmpty() ? right.first() : QPointF();
+                result.issue = {LaneletIssue::Type::MissingBound, laneletId, 0, position};
+                result.hasIssue = true;
+                return result;
+            }
+            auto outline = LaneletItem::outlineOf(left, right);
+            if (!outline.valid) return result;
+            result.outline = outline.polygon;
+            QPointF intersection;
+            if (isSelfIntersecting(result.outline, intersection)) {
+                result.issue = {LaneletIssue::Type::SelfIntersection, laneletId, 0, intersection};
+                result.hasIssue = true;
+            }
+            return result;
+        }));
+
+    // Grid cells covered by a rect
+    auto cellRange = [](const QRectF &rect)
+    {
+        return QRect(QPoint(qFloor(rect.left() / CellSize), qFloor(rect.top() / CellSize)),
+                     QPoint(qFloor(rect.right() / CellSize), qFloor(rect.bottom() / CellSize)));
+    };
+    for (const auto &result : outlines) {
+        auto oldRange = s.cellRanges.find(result.id);
+        if (oldRange != s.cellRanges.end()) {
+            for (int x = oldRange->left(); x <= oldRange->right(); x++) {
+                for (int y = oldRange->top(); y <= oldRange->bottom(); y++) {
+                    auto cell = s.cells.find({x, y});
+                    if (cell == s.cells.end()) continue;
+                    cell->remove(result.id);
+                    if (cell->isEmpty()) s.cells.erase(cell);
+                }
+            }
+            s.cellRanges.erase(oldRange);
+        }
+        s.outlines.remove(result.id);
+        if (result.hasIssue) s.laneletIssues.insert(result.id, result.issue);
+        else s.laneletIssues.remove(result.id);
+
+        if (result.outline.size() < 3) continue;
+        QRect range = cellRange(result.outline.boundingRect());
+        for (int x = range.left(); x <= range.right(); x++) {
+            for (int y = range.top(); y <= range.bottom(); y++) {
+                s.cells[{x, y}].insert(result.id);
+            }
+        }
+        s.cellRanges.insert(result.id, range);
+        s.outlines.insert(result.id, result.outline);
+    }
+
+    // Overlaps of the affected lanelets with all lanelets in the same cells, tested in parallel
+    for (auto overlap = s.overlapIssues.begin(); overlap != s.overlapIssues.end();) {
+        if (affectedLanelets.contains(overlap.key().first) || affectedLanelets.contains(overlap.key().second)) {
+            overlap = s.overlapIssues.erase(overlap);
+        }
+        else {
+            overlap++;
+        }
+    }
+    const State &constState = s;
+    auto overlaps = QtConcurrent::blockingMapped<QVector<QVector<LaneletIssue>>>(laneletIds,
+        std::function<QVector<LaneletIssue>(qint64)>([&constState, &snapshot](qint64 laneletId)
+        {
+            QVector<LaneletIssue> issues;
+            auto outline = constState.outlines.constFind(laneletId);
+            if (outline == constState.outlines.constEnd()) return issues;
+            auto lanelet = snapshot.lanelets.find(laneletId);
+            QRectF bounds = outline->boundingRect();
+            QRect range = constState.cellRanges.value(laneletId);
+
+            QSet<qint64> candidates;
+            for (int x = range.left(); x <= range.right(); x++) {
+                for (int y = range.top(); y <= range.bottom(); y++) {
+                    candidates.unite(constState.cells.value({x, y}));
+                }
+            }
+            candidates.remove(laneletId);
+            for (auto otherId : candidates) {
+                const QPolygonF &otherOutline = *constState.outlines.constFind(otherId);
+                if (!bounds.intersects(otherOutline.boundingRect())) continue;
+                // Neighbours share a bound, they only touch
+                auto other = snapshot.lanelets.find(otherId);
+                if (lanelet && other && (lanelet->leftWay == other->leftWay || lanelet->leftWay == other->rightWay
+                    || lanelet->rightWay == other->leftWay || lanelet->rightWay == other->rightWay)) {
+                    continue;
+                }
+                QPolygonF intersection = outline->intersected(otherOutline);
+                if (area(intersection) <= OverlapTolerance) continue;
+                issues.push_back({LaneletIssue::Type::Overlap, qMin(laneletId, otherId), qMax(laneletId, otherId),
+                                  intersection.boundingRect().center()});
+            }
+            return issues;
+        }));
+    for (const auto &issues : overlaps) {
+        for (const auto &issue : issues) {
+            s.overlapIssues.insert({issue.elementId, issue.otherElementId}, issue);
+        }
+    }
+
+    s.snapshot = snapshot;
+
+    QVector<LaneletIssue> issues;
+    issues.reserve(s.nodeIssues.size() + s.wayIssues.size() + s.laneletIssues.size() + s.overlapIssues.size());
+    for (const auto &issue : s.nodeIssues) issues.push_back(issue);
+    for (const auto &issue : s.wayIssues) issues.push_back(issue);
+    for (const auto &issue : s.laneletIssues) issues.push_back(issue);
+    for (const auto &issue : s.overlapIssues) issues.push_back(issue);
+    return issues;
+}
@@ -0,0 +1,166 @@
+#ifndef LANELETVALIDATOR_H
+#define LANELETVALIDATOR_H
+
+#include <memory>
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QPair>
+#include <QPolygonF>
+#include <QRect>
+#include <QVector>
+
+#include "worker/LaneletSnapshotTracker.h"
+
+/**
+ * Problem found in the lanelet editor model.
+ */
+struct LaneletIssue
+{
+    /**
+     * Kind of problem.
+     */
+    enum class Type
+    {
+        ShortWay, ///< Way with less than two nodes
+        MissingBound, ///< Lanelet without left or right way
+        DanglingNode, ///< Node that is not part of any way
+        SelfIntersection, ///< Lanelet outline that crosses itself
+        Overlap ///< Two lanelets covering the same area
+    };
+
+    Type type = Type::ShortWay; ///< Kind of problem
+    qint64 elementId = 0; ///< Id of the node, way or lanelet
+    qint64 otherElementId = 0; ///< Id of the second lanelet of an overlap, 0 otherwise
+    QPointF position; ///< Location of the problem in scene coordinates
+
+    /**
+     * Checks if the map can be repaired by removing the element.
+     * @return True for short ways, lanelets without bound and dangling nodes.
+     */
+    [[nodiscard]] bool isRepairable() const;
+
+    /**
+     * Describes the problem.
+     * @return Human readable message.
+     */
+    [[nodiscard]] QString message() const;
+};
+
+/**
+ * Validates the lanelet editor model in the background. The first run checks all elements, later runs only the
+ * elements affected by the changes reported by the snapshot tracker. Topology checks and the outline checks of the
+ * affected lanelets are done in parallel, overlaps are only tested between lanelets sharing a cell of a uniform grid.
+ * Only to be used in the gui thread.
+ */
+class LaneletValidator: public QObject
+{
+Q_OBJECT
+private:
+    static constexpr qreal CellSize = 64.0; ///< Edge length of a grid cell in scene units
+    static constexpr qreal OverlapTolerance = 4.0; ///< Overlapping area in square scene units that is ignored
+
+    /**
+     * Results of the previous runs. Only touched by the running validation.
+     */
+    struct State
+    {
+        LaneletSnapshot snapshot; ///< Model of the previous run
+        QHash<qint64, QSet<qint64>> waysOfNode; ///< Ways using each node
+        QHash<qint64, QSet<qint64>> laneletsOfWay; ///< Lanelets bound by each way
+        QHash<qint64, QPolygonF> outlines; ///< Outlines of all lanelets with both bounds
+        QHash<QPoint, QSet<qint64>> cells; ///< Lanelets whose outline bounds touch each cell
+        QHash<qint64, QRect> cellRanges; ///< Cells each lanelet is stored in
+        QHash<qint64, LaneletIssue> nodeIssues; ///< Issues by node id
+        QHash<qint64, LaneletIssue> wayIssues; ///< Issues by way id
+        QHash<qint64, LaneletIssue> laneletIssues; ///< Issues by lanelet id
+        QHash<QPair<qint64, qint64>, LaneletIssue> overlapIssues; ///< Overlaps by ordered pair of lanelet ids
+    };
+
+    LaneletSnapshotTracker *const m_tracker; ///< Source of the model
+    std::shared_ptr<State> m_state; ///< State of the current validation generation
+    QFutureWatcher<QVector<LaneletIssue>> *m_watcher = nullptr; ///< Watches the running validation
+    LaneletSnapshot::Changes m_pendingChanges; ///< Changes that were not validated yet
+    QVector<LaneletIssue> m_issues; ///< Issues of the last finished validation
+    int m_generation = 0; ///< Increased when validation is restarted, results of older runs are dropped
+    int m_runningGeneration = 0; ///< Generation of the running validation
+    bool m_enabled = false; ///< Whether changes are validated
+
+    /**
+     * Starts a validation of the pending changes unless one is running.
+     */
+    void schedule();
+
+    /**
+     * Validates the elements affected by changes and updates the state. Runs on a worker thread.
+     * @param state Results of the previous runs.
+     * @param snapshot Current model.
+     * @param changes Elements changed since the previous run.
+     * @return All issues of the model.
+     */
+    static QVector<LaneletIssue> validate(const std::shared_ptr<State> &state, const LaneletSnapshot &snapshot,
+                                          const LaneletSnapshot::Changes &changes);
+
+    /**
+     * Checks if an outline crosses itself. Touching vertices, e.g. of ways sharing an end node, do not count.
+     * @param outline Closed outline.
+     * @param intersection Output for the first crossing.
+     * @return True if two non adjacent edges cross.
+     */
+    static bool isSelfIntersecting(const QPolygonF &outline, QPointF &intersection);
+
+    /**
+     * Calculates the area of a polygon.
+     * @param polygon Polygon.
+     * @return Absolute area.
+     */
+    static qreal area(const QPolygonF &polygon);
+
+private slots:
+    /**
+     * Publishes the issues and starts the next validation if changes are pending.
+     */
+    void onValidationFinished();
+
+public:
+    /**
+     * Creates a disabled validator.
+     * @param tracker Source of the model.
+     * @param parent Possible parent or qt pointer destruction.
+     */
+    explicit LaneletValidator(LaneletSnapshotTracker *tracker, QObject *parent = nullptr);
+
+    /**
+     * Waits for a running validation.
+     */
+    ~LaneletValidator() override;
+
+    /**
+     * Getter for the issues.
+     * @return Issues of the last finished validation.
+     */
+    [[nodiscard]] const QVector<LaneletIssue> &issues() const;
+
+public slots:
+    /**
+     * Starts or stops continuous validation. Enabling validates the whole model.
+     * @param enabled True to validate.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Queues changed elements for validation.
+     * @param changes Ids of the changed elements.
+     */
+    void onSnapshotChanged(const LaneletSnapshot::Changes &changes);
+
+signals:
+    /**
+     * Emitted after a validation finished or the validation was disabled.
+     * @param issues All current issues.
+     */
+    void issuesChanged(QVector<LaneletIssue> issues);
+};
+
+#endif // LANELETVALIDATOR_H
@@ -1,4 +1,5 @@
 #include "ScenarioHandler.h"
+#include <QDebug>
 #include <QDir>
 #include <utility>
 #include <QtMath>
@@ -11,15 +12,25 @@ void ScenarioHandler::writeScenario(QString name,
                                     QString rootDirectoryPath,
                                     size_t fromFrame,
                                     size_t toFrame,
-                                    bool exportFullTrajectories)
+                                    bool exportFullTrajectories,
+                                    double framesPerSecond,
+                                    bool abortOnCollision,
+                                    QList<QPolygonF> region,
+                                    dataset_converter_common::MapMatcherPtr mapMatcher,
+                                    QList<qint64> lanelets)
 {
-    emit progress(0, 3);
+    emit progress(0, 5);
     this->m_exportRootDirectory = std::move(rootDirectoryPath);
     this->m_exportFullTrajectories = exportFullTrajectories;
     this->m_scenarioName = std::move(name);
     this->m_fromFrame = fromFrame;
     this->m_toFrame = toFrame;
-    emit progress(1, 3);
+    this->m_framesPerSecond = framesPerSecond;
+    this->m_abortOnCollision = abortOnCollision;
+    this->m_region = std::move(region);
+    this->m_mapMatcher = std::move(mapMatcher);
+    this->m_lanelets = std::move(lanelets);
+    emit progress(1, 5);
 
     QDir datasetRootDirectory(this->m_exportRootDirectory);
     if (!datasetRootDirectory.exists()) {
@@ -27,11 +38,41 @@ void ScenarioHandler::writeScenario(QString name,
         return;
     }
 
+    // Keep only the states inside the region of interest, the lab area is applied by the writer
+    cpm_scenario::ScenarioPtr scenario = this->m_visualization->scenario();
+    if (!this->m_region.isEmpty()) {
+        std::vector<std::vector<Eigen::Vector2d>> polygons;
+        for (const auto &polygon : this->m_region) {
+            std::vector<Eigen::Vector2d> vertices;
+            for (const auto &point : polygon) {
+                vertices.emplace_back(point.x(), point.y());
+            }
+            polygons.push_back(std::move(vertices));
+        }
+        scenario = dataset_converter_common::PolygonRegion(polygons).Restrict(scenario);
+    }
+
+    // Lanelet of every state, objects that never use one of the requested lanelets are left out
+    if (this->m_mapMatcher && !this->m_mapMatcher->IsEmpty()) {
+        auto matches = this->m_mapMatcher->Match(scenario);
+        if (!this->m_lanelets.isEmpty()) {
+            std::vector<long> lanelets(this->m_lanelets.begin(), this->m_lanelets.end());
+            scenario = dataset_converter_common::MapMatcher::Restrict(scenario, matches, lanelets);
+            qDebug() << "[ScenarioHandler]" << scenario->GetObjects().size() << "objects use the selected lanelets";
+        }
+        QString matchingFileName = "MapMatching_" + this->m_scenarioName + ".csv";
+        if (!dataset_converter_common::MapMatcher::WriteCsv(
+            datasetRootDirectory.absoluteFilePath(matchingFileName).toStdString(), matches)) {
+            emit error("Map matching side file could not be written.");
+            return;
+        }
+    }
+
     // Delete old scenario and make a copy
-    this->m_scenarioWriter = std::make_shared<cpm_scenario::ScenarioWriter>(this->m_visualization->scenario());
+    this->m_scenarioWriter = std::make_shared<cpm_scenario::ScenarioWriter>(scenario);
     this->m_scenarioWriter->SetName(m_scenarioName.toStdString());
 
-    emit progress(2, 3);
+    emit progress(2, 5);
     double scaleFactor = this->m_visualization->scaleFactor();
     double shiftXInMeter = this->m_visualization->scenarioShiftX() / scaleFactor;
     double shiftXYnMeter = this->m_visualization->scenarioShiftY() / scaleFactor;
@@ -52,10 +93,58 @@ void ScenarioHandler::writeScenario(QString name,
     if (!this->m_exportFullTrajectories) this->m_scenarioWriter->RestrictTrajectories();
     // Perform temporal shift
     this->m_scenarioWriter->RestrictToFrames(this->m_fromFrame, this->m_toFrame);
+    emit progress(3, 5);
+
+    // Model cars of overlapping objects collide in the lab, verify the kept states before the file is written
+    dataset_converter_common::CollisionVerifier verifier(scenario,
+                                                         shiftXInMeter,
+                                                         shiftXYnMeter,
+                                                         this->m_visualization->scenarioRotation(),
+                                                         static_cast<long>(this->m_fromFrame),
+                                                         static_cast<long>(this->m_toFrame));
+    const auto &conflicts = verifier.GetConflicts();
+    if (!conflicts.empty()) {
+        QString conflictFileName = "Conflicts_" + this->m_scenarioName + ".csv";
+        verifier.WriteCsv(datasetRootDirectory.absoluteFilePath(conflictFileName).toStdString());
+        QString message = QString("%1 conflicts in %2 frames, first in frame %3 with object %4. See %5.")
+            .arg(conflicts.size())
+            .arg(verifier.GetNumberOfConflictFrames())
+            .arg(conflicts.front().frame)
+            .arg(conflicts.front().first_id)
+            .arg(conflictFileName);
+        qWarning() << "[ScenarioHandler]" << message;
+        if (this->m_abortOnCollision) {
+            emit error(message);
+            return;
+        }
+        emit warning(message);
+    }
+
     // Write file
     this->m_scenarioWriter->Write(scenarioFilePath);
+    emit progress(4, 5);
+
+    // Criticality of the exported frames, measured on the source scenario in meters
+    if (this->m_framesPerSecond <= 0.0) {
+        QString message = "Frame rate of the scenario is unknown, no criticality side files written.";
+        qWarning() << "[ScenarioHandler]" << message;
+        emit warning(message);
+        emit progress(5, 5);
+        emit stored();
+        return;
+    }
+    dataset_converter_common::CriticalityMetrics metrics(scenario,
+                                                         this->m_framesPerSecond,
+                                                         static_cast<long>(this->m_fromFrame),
+                                                         static_cast<long>(this->m_toFrame));
+    std::string criticalityFilePath =
+        datasetRootDirectory.absolutePath().toStdString() + "/Criticality_" + this->m_scenarioName.toStdString();
+    if (!metrics.WriteCsv(criticalityFilePath + "_frames.csv", criticalityFilePath + "_pairs.csv")) {
+        emit error("Criticality side files could not be written.");
+        return;
+    }
 
-    emit progress(3, 3);
+    emit progress(5, 5);
     emit stored();
 }
 const cpm_scenario::ScenarioPtr &ScenarioHandler::loadedScenario() const
@@ -4,10 +4,16 @@
 #include <memory>
 
 #include <QObject>
+#include <QList>
+#include <QPolygonF>
 
 #include <cpm_scenario/Scenario.h>
 #include <cpm_scenario/ScenarioWriter.h>
 #include <cpm_scenario/ScenarioParser.h>
+#include <dataset_converter_common/analysis/CollisionVerifier.h>
+#include <dataset_converter_common/analysis/CriticalityMetrics.h>
+#include <dataset_converter_common/analysis/MapMatcher.h>
+#include <dataset_converter_common/analysis/PolygonRegion.h>
 
 #include "visualisation/ScenarioVisualization.h"
 
@@ -21,6 +27,11 @@ private:
     size_t m_fromFrame = 0; ///< First frame for the temporal transformation
     size_t m_toFrame = 0; ///< Last frame for the temporal transformation
     bool m_exportFullTrajectories = false; ///< Flag indication if a trajectory purge should be performed
+    double m_framesPerSecond = 0.0; ///< Frame rate of the exported scenario, 0 if unknown
+    bool m_abortOnCollision = false; ///< Flag indicating if objects colliding in the lab abort the export
+    QList<QPolygonF> m_region; ///< Region of interest in scenario meters, empty exports the whole lab area
+    dataset_converter_common::MapMatcherPtr m_mapMatcher; ///< Lanelet map in scenario meters, may be nullptr
+    QList<qint64> m_lanelets; ///< Lanelets the exported objects have to use, empty exports all objects
 
     ScenarioVisualization *const m_visualization = nullptr; ///< Source of all non dialog information
 
@@ -40,18 +51,30 @@ public:
 
 public slots:
     /**
-     * Transforms and writes scenario to the disk.
+     * Transforms and writes scenario to the disk. The criticality metrics of the exported frames are written next to
+     * it as csv side files. Objects that collide in the lab are written to a conflict file before the scenario. If a
+     * lanelet map is given, the lanelet of every state is written to a csv side file as well.
      * @param name Name of the scenario
      * @param rootDirectoryPath Root directory.
      * @param fromFrame Starting frame for temporal shift.
      * @param toFrame End frame for temporal shift.
      * @param exportFullTrajectories Flag to indicate a trajectory purge.
+     * @param framesPerSecond Frame rate of the scenario, 0 if unknown skips the criticality side files.
+     * @param abortOnCollision Flag to abort the export if objects collide in the lab.
+     * @param region Polygons in scenario meters the export is restricted to, empty exports the whole lab area.
+     * @param mapMatcher Lanelet map the trajectories are matched to, may be nullptr.
+     * @param lanelets Lanelets the exported objects have to use at least once, empty exports all objects.
      */
     void writeScenario(QString name,
                        QString rootDirectoryPath,
                        size_t fromFrame,
                        size_t toFrame,
-                       bool exportFullTrajectories);
+                       bool exportFullTrajectories,
+                       double framesPerSecond,
+                       bool abortOnCollision,
+                       QList<QPolygonF> region,
+                       dataset_converter_common::MapMatcherPtr mapMatcher,
+                       QList<qint64> lanelets);
 
     /**
      * Loads a scenario from the disk.
@@ -73,6 +96,11 @@ signals:
      * @param message Error message.
      */
     void error(QString message);
+    /**
+     * Indicates a problem of the stored scenario that did not abort the process.
+     * @param message Warning message.
+     */
+    void warning(QString message);
     /**
      * Loading is finished and no errors occurred.
      */
@@ -83,4 +111,6 @@ signals:
     void stored();
 };
 
+Q_DECLARE_METATYPE(dataset_converter_common::MapMatcherPtr)
+
 #endif // SCENARIOHANDLER_H
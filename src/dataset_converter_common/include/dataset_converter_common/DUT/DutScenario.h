@@ -36,6 +36,8 @@ class DutScenario : public DatasetScenario {
 
   void Parse(const std::string &dataset_root_directory) override;
 
+  [[nodiscard]] double GetFramesPerSecond() const override;
+
   [[nodiscard]] const std::string &GetPedestrianTrajectoryFilePath() const;
   void SetPedestrianTrajectoryFilePath(const std::string &pedestrian_trajectory_file_path);
   [[nodiscard]] const std::string &GetVehicleTrajectoryFilePath() const;
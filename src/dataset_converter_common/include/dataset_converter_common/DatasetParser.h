@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "dataset_converter_common/DatasetScenario.h"
+#include "dataset_converter_common/analysis/TrajectorySmoother.h"
 
 namespace dataset_converter_common {
 
@@ -18,6 +19,7 @@ class DatasetParser {
  protected:
   DatasetScenarioPtrs scenarios_; ///< Collection of recordings/scenarios parsed from the dataset
   long scenario_counter_ = 0; ///< Counter to keep track which scenario was parsed already
+  TrajectorySmootherPtr smoother_; ///< Smoother applied to every parsed scenario, trajectories are kept if null
 
  public:
   /**
@@ -43,6 +45,12 @@ class DatasetParser {
    */
   void AddScenario(const DatasetScenarioPtr &scenario);
 
+  /**
+   * Set the smoother applied to every scenario right after it is parsed.
+   * @param smoother Smoother, null to keep the recorded trajectories.
+   */
+  void SetSmoother(const TrajectorySmootherPtr &smoother);
+
   /**
    * Get list of scenarios.
    * @return List of scenarios.
@@ -26,6 +26,12 @@ public:
      * @param dataset_root_directory Directory to parse from.
      */
     virtual void Parse(const std::string &dataset_root_directory) = 0;
+
+    /**
+     * Frame rate of the recording.
+     * @return Frames per second.
+     */
+    [[nodiscard]] virtual double GetFramesPerSecond() const = 0;
 };
 
 typedef std::shared_ptr<DatasetScenario> DatasetScenarioPtr;
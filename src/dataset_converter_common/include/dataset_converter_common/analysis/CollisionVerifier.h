@@ -0,0 +1,112 @@
+/**
+ * @file CollisionVerifier.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_COLLISION_VERIFIER_H_
+#define DATASET_CONVERTER_LIB_COLLISION_VERIFIER_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <cpm_scenario/Scenario.h>
+
+#include "dataset_converter_common/analysis/FrameStatistics.h"
+
+namespace dataset_converter_common {
+
+/**
+ * Conflict of the exported scenario that would make model cars collide in the lab.
+ */
+struct LabConflict {
+  /**
+   * Kind of the conflict.
+   */
+  enum class Kind {
+    kOverlap, ///< Two objects overlap
+    kBorder, ///< An object reaches beyond the lab border
+  };
+
+  Kind kind = Kind::kOverlap; ///< Kind of the conflict
+  long frame = 0; ///< Frame
+  long first_id = 0; ///< Id of the first object
+  long second_id = 0; ///< Id of the second object, unused for the border
+  double distance = 0.0; ///< Gap between the boxes in lab meters, for the border how far the box reaches beyond it
+};
+
+/**
+ * Tests the states that are kept when a scenario is converted into the lab for overlapping objects and objects beyond
+ * the lab border, see PlacementOptimizer for the transformation. Only objects of the types driven by model cars are
+ * tested. Objects are oriented boxes with the dimension of the object and the pose of its state. Every frame sorts
+ * the boxes into a uniform grid with the largest box as cell size, so only boxes of neighbouring cells are tested.
+ * Frames are tested in parallel, the cost grows linearly with the number of states.
+ */
+class CollisionVerifier {
+ private:
+  /**
+   * Box of a kept state in scenario meters.
+   */
+  struct Box {
+    uint32_t object; ///< Index of the object
+    Eigen::Vector2d center; ///< Center
+    std::array<Eigen::Vector2d, 4> corners; ///< Corners in counter clockwise order
+  };
+
+  double clearance_; ///< Smallest allowed gap between two boxes in scenario meters
+  double cell_size_ = 1.0; ///< Edge length of a grid cell in scenario meters
+  uint64_t states_ = 0; ///< Number of tested states
+  std::vector<long> ids_; ///< Id of every object
+  std::vector<LabConflict> conflicts_; ///< Conflicts, first frame first
+
+  /**
+   * Tests all boxes of a frame.
+   * @param frame Frame.
+   * @param boxes Boxes of the frame.
+   * @param count Number of boxes.
+   * @param conflicts Found conflicts.
+   */
+  void ProcessFrame(long frame, const Box *boxes, size_t count, std::vector<LabConflict> &conflicts) const;
+
+ public:
+  /**
+   * Tests the kept states of a frame range.
+   * @param scenario Scenario to export.
+   * @param shift_x Shift in x direction in meters.
+   * @param shift_y Shift in y direction in meters.
+   * @param rotation Rotation in degrees.
+   * @param from_frame First frame.
+   * @param to_frame Last frame, 0 includes all frames from from_frame on.
+   * @param clearance Smallest allowed gap between two boxes in lab meters.
+   * @param types Bit mask of the object types that are tested.
+   */
+  CollisionVerifier(const cpm_scenario::ScenarioPtr &scenario,
+                    double shift_x,
+                    double shift_y,
+                    double rotation,
+                    long from_frame = 0,
+                    long to_frame = 0,
+                    double clearance = 0.0,
+                    uint32_t types = FrameCounts::kVehicleTypes);
+
+  /**
+   * Writes the conflicts as csv.
+   * @param file_path File to write.
+   * @return Whether the file was written.
+   */
+  bool WriteCsv(const std::string &file_path) const;
+
+  /**
+   * Number of frames with at least one conflict.
+   * @return Number of frames.
+   */
+  [[nodiscard]] size_t GetNumberOfConflictFrames() const;
+
+  [[nodiscard]] const std::vector<LabConflict> &GetConflicts() const;
+  [[nodiscard]] uint64_t GetNumberOfStates() const;
+};
+
+}
+#endif //DATASET_CONVERTER_LIB_COLLISION_VERIFIER_H_
@@ -0,0 +1,176 @@
+/**
+ * @file CriticalityMetrics.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_CRITICALITY_METRICS_H_
+#define DATASET_CONVERTER_LIB_CRITICALITY_METRICS_H_
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <cpm_scenario/Scenario.h>
+
+namespace dataset_converter_common {
+
+/**
+ * Smallest metrics of all pairs of objects of a frame. Metrics without any pair are infinite.
+ */
+struct FrameCriticality {
+  long frame = 0; ///< Frame
+  size_t objects = 0; ///< Objects with a state in the frame
+  size_t pairs = 0; ///< Pairs closer than the search radius
+  double min_distance = std::numeric_limits<double>::infinity(); ///< Smallest distance between two boxes in meters
+  double min_ttc = std::numeric_limits<double>::infinity(); ///< Smallest time to collision in seconds
+  double min_pet = std::numeric_limits<double>::infinity(); ///< Smallest post encroachment time in seconds
+};
+
+/**
+ * Metrics of two objects in a frame. Only close pairs and pairs on a collision course are kept.
+ */
+struct PairCriticality {
+  long frame = 0; ///< Frame
+  long first_id = 0; ///< Id of the first object
+  long second_id = 0; ///< Id of the second object
+  double distance = 0.0; ///< Distance between the boxes in meters
+  double ttc = std::numeric_limits<double>::infinity(); ///< Time to collision in seconds
+};
+
+/**
+ * Post encroachment time of two objects whose paths cross, reported at the frame the second object arrives.
+ */
+struct Encroachment {
+  long frame = 0; ///< Frame the second object reaches the conflict area
+  long first_id = 0; ///< Id of the object that passed first
+  long second_id = 0; ///< Id of the object that passed second
+  double pet = 0.0; ///< Time between the first object leaving and the second object reaching the conflict area
+};
+
+/**
+ * Range of frames with critical interactions.
+ */
+struct CriticalWindow {
+  long from_frame = 0; ///< First frame of the window
+  long to_frame = 0; ///< Last frame of the window
+  size_t critical_frames = 0; ///< Frames with a critical time to collision, post encroachment time or distance
+  double min_ttc = std::numeric_limits<double>::infinity(); ///< Smallest time to collision in seconds
+};
+
+/**
+ * Time to collision, post encroachment time and minimal distance of all objects of a scenario per frame.
+ * Objects are oriented boxes with the dimension of the object and the pose of its state. Every frame sorts the boxes
+ * into a uniform grid with the search radius as cell size, so only pairs of neighbouring cells are compared. The time
+ * to collision assumes constant velocities and is exact for boxes. The post encroachment time is measured on a fine
+ * grid of the paths of moving objects that cross at an angle. Frames are processed in parallel.
+ */
+class CriticalityMetrics {
+ public:
+  static constexpr double kCloseDistance = 2.0; ///< Pairs closer than this in meters are kept
+  static constexpr double kCriticalDistance = 0.5; ///< Distance in meters that makes a frame critical
+  static constexpr double kCriticalTtc = 1.5; ///< Time to collision in seconds that makes a frame critical
+  static constexpr double kCriticalPet = 1.5; ///< Post encroachment time in seconds that makes a frame critical
+  static constexpr double kMovingSpeed = 0.5; ///< Speed in m/s above which an object passes a conflict area
+  static constexpr double kConflictCellSize = 1.0; ///< Edge length of a conflict area in meters
+  static constexpr double kMinConflictAngle = 30.0; ///< Smallest angle in degrees between crossing paths
+  static constexpr double kMaxPet = 5.0; ///< Largest post encroachment time in seconds that is reported
+
+ private:
+  /**
+   * Box of an object in a frame.
+   */
+  struct Box {
+    uint32_t object; ///< Index of the object
+    Eigen::Vector2d center; ///< Center in meters
+    Eigen::Vector2d velocity; ///< Velocity in m/s
+    std::array<Eigen::Vector2d, 4> corners; ///< Corners in counter clockwise order
+  };
+
+  double frames_per_second_; ///< Frame rate to convert frames to seconds
+  double search_radius_; ///< Largest distance of compared centers in meters
+  double ttc_horizon_; ///< Largest time to collision in seconds
+  std::vector<long> ids_; ///< Id of every object
+  std::vector<FrameCriticality> frames_; ///< Metrics of every frame, first frame first
+  std::vector<PairCriticality> pairs_; ///< Kept pairs, first frame first
+  std::vector<Encroachment> encroachments_; ///< Closest encroachment of every pair of objects, first frame first
+
+  /**
+   * Compares all close pairs of a frame.
+   * @param boxes Boxes of the frame.
+   * @param count Number of boxes.
+   * @param frame Metrics of the frame.
+   * @param pairs Kept pairs.
+   */
+  void ProcessFrame(const Box *boxes, size_t count, FrameCriticality &frame,
+                    std::vector<PairCriticality> &pairs) const;
+
+  /**
+   * Measures the post encroachment times of all objects.
+   * @param scenario Scenario to measure.
+   * @param from_frame First frame.
+   * @param to_frame Last frame.
+   */
+  void FindEncroachments(const cpm_scenario::ScenarioPtr &scenario, long from_frame, long to_frame);
+
+ public:
+  /**
+   * Computes all metrics of a frame range.
+   * @param scenario Scenario to measure.
+   * @param frames_per_second Frame rate of the scenario.
+   * @param from_frame First frame.
+   * @param to_frame Last frame, 0 includes all frames from from_frame on.
+   * @param search_radius Largest distance of compared centers in meters.
+   * @param ttc_horizon Largest time to collision in seconds.
+   */
+  CriticalityMetrics(const cpm_scenario::ScenarioPtr &scenario,
+                     double frames_per_second,
+                     long from_frame = 0,
+                     long to_frame = 0,
+                     double search_radius = 30.0,
+                     double ttc_horizon = 5.0);
+
+  /**
+   * Distance between two convex polygons.
+   * @param a Corners of the first polygon in counter clockwise order.
+   * @param b Corners of the second polygon in counter clockwise order.
+   * @return Distance in meters, 0 if they overlap.
+   */
+  static double Distance(const std::array<Eigen::Vector2d, 4> &a, const std::array<Eigen::Vector2d, 4> &b);
+
+  /**
+   * Time until two convex polygons moving with constant velocities touch.
+   * @param a Corners of the first polygon in counter clockwise order.
+   * @param velocity_a Velocity of the first polygon.
+   * @param b Corners of the second polygon in counter clockwise order.
+   * @param velocity_b Velocity of the second polygon.
+   * @return Time in seconds, 0 if they overlap and infinite if they never touch.
+   */
+  static double TimeToCollision(const std::array<Eigen::Vector2d, 4> &a, const Eigen::Vector2d &velocity_a,
+                                const std::array<Eigen::Vector2d, 4> &b, const Eigen::Vector2d &velocity_b);
+
+  /**
+   * Searches the windows with the most critical frames. Windows do not overlap.
+   * @param length Number of frames of a window.
+   * @param count Maximal number of windows.
+   * @return Windows with at least one critical frame, most critical first.
+   */
+  [[nodiscard]] std::vector<CriticalWindow> FindWindows(size_t length, size_t count = 1) const;
+
+  /**
+   * Writes the metrics as csv side files.
+   * @param frames_file_path File for the metrics per frame.
+   * @param pairs_file_path File for the kept pairs and encroachments.
+   * @return Whether both files were written.
+   */
+  bool WriteCsv(const std::string &frames_file_path, const std::string &pairs_file_path) const;
+
+  [[nodiscard]] const std::vector<FrameCriticality> &GetFrames() const;
+  [[nodiscard]] const std::vector<PairCriticality> &GetPairs() const;
+  [[nodiscard]] const std::vector<Encroachment> &GetEncroachments() const;
+};
+
+}
+#endif //DATASET_CONVERTER_LIB_CRITICALITY_METRICS_H_
@@ -0,0 +1,96 @@
+/**
+ * @file FrameGrid.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_FRAME_GRID_H_
+#define DATASET_CONVERTER_LIB_FRAME_GRID_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <cpm_scenario/Scenario.h>
+
+namespace dataset_converter_common {
+
+/**
+ * Key of a cell of a uniform grid, neighbouring cells have neighbouring keys in y direction only.
+ * @param x Cell index in x direction.
+ * @param y Cell index in y direction.
+ * @return Key.
+ */
+inline int64_t CellKey(int64_t x, int64_t y) {
+  return static_cast<int64_t>((static_cast<uint64_t>(x) << 32) ^ (static_cast<uint64_t>(y) & 0xffffffffu));
+}
+
+/**
+ * Elements built from the states of a scenario, grouped by frame.
+ */
+template<typename Element>
+struct FrameBuckets {
+  long first_frame = 0; ///< Frame of the first bucket
+  std::vector<size_t> begin; ///< Index of the first element of every frame followed by the number of elements
+  std::vector<Element> elements; ///< Elements ordered by frame, within a frame by object
+
+  /**
+   * Number of frames from the first to the last frame with an element.
+   * @return Number of frames.
+   */
+  [[nodiscard]] size_t GetNumberOfFrames() const {
+    return begin.empty() ? 0 : begin.size() - 1;
+  }
+};
+
+/**
+ * Builds an element for every kept state and sorts the elements by frame with a counting sort, so every frame is a
+ * contiguous range that can be processed independently.
+ * @param scenario Scenario with the states.
+ * @param keep Called as keep(object_index, frame, state), whether the state gets an element.
+ * @param fill Called as fill(object_index, frame, state, element) for every kept state in object order.
+ * @return Elements grouped by frame, empty if no state is kept.
+ */
+template<typename Element, typename Keep, typename Fill>
+FrameBuckets<Element> BucketStatesByFrame(const cpm_scenario::ScenarioPtr &scenario, Keep &&keep, Fill &&fill) {
+  FrameBuckets<Element> buckets;
+  const auto &objects = scenario->GetObjects();
+  long first_frame = std::numeric_limits<long>::max();
+  long last_frame = std::numeric_limits<long>::min();
+  for (size_t i = 0; i < objects.size(); ++i) {
+    for (const auto &state : objects[i]->GetStates()) {
+      long frame = static_cast<long>(state.first);
+      if (!keep(i, frame, *state.second)) continue;
+      first_frame = std::min(first_frame, frame);
+      last_frame = std::max(last_frame, frame);
+    }
+  }
+  if (first_frame > last_frame) return buckets;
+  auto frames = static_cast<size_t>(last_frame - first_frame) + 1;
+
+  buckets.first_frame = first_frame;
+  buckets.begin.assign(frames + 1, 0);
+  for (size_t i = 0; i < objects.size(); ++i) {
+    for (const auto &state : objects[i]->GetStates()) {
+      long frame = static_cast<long>(state.first);
+      if (keep(i, frame, *state.second)) buckets.begin[frame - first_frame + 1]++;
+    }
+  }
+  for (size_t frame = 0; frame < frames; ++frame) {
+    buckets.begin[frame + 1] += buckets.begin[frame];
+  }
+  std::vector<size_t> next(buckets.begin.begin(), buckets.begin.end() - 1);
+  buckets.elements.resize(buckets.begin.back());
+  for (size_t i = 0; i < objects.size(); ++i) {
+    for (const auto &state : objects[i]->GetStates()) {
+      long frame = static_cast<long>(state.first);
+      if (!keep(i, frame, *state.second)) continue;
+      fill(i, frame, *state.second, buckets.elements[next[frame - first_frame]++]);
+    }
+  }
+  return buckets;
+}
+
+}
+#endif //DATASET_CONVERTER_LIB_FRAME_GRID_H_
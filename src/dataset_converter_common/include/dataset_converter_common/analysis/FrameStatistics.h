@@ -0,0 +1,201 @@
+/**
+ * @file FrameStatistics.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_FRAME_STATISTICS_H_
+#define DATASET_CONVERTER_LIB_FRAME_STATISTICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <cpm_scenario/Scenario.h>
+
+namespace dataset_converter_common {
+
+/**
+ * Range of frames suggested for an export.
+ */
+struct FrameWindow {
+  long from_frame = 0; ///< First frame of the window
+  long to_frame = 0; ///< Last frame of the window
+  uint64_t object_frames = 0; ///< Number of object states inside the lab area during the window
+};
+
+/**
+ * Minimal average number of objects of some types per frame of a window.
+ */
+struct WindowRequirement {
+  uint32_t type_mask = 0; ///< Bit mask of type indices, see OccupancyHistogram::TypeIndex
+  double min_count = 0.0; ///< Minimal average count per frame
+};
+
+/**
+ * Prefix sums of the number of objects inside the lab area per frame and object type. Immutable, so it can be read
+ * while the statistics are updated for the next transformation.
+ */
+class FrameCounts {
+ public:
+  static constexpr uint32_t kVehicleTypes = 0b0011101; ///< Cars, bicycles and motorcycles, trucks and buses, vans
+  static constexpr uint32_t kPedestrianTypes = 0b0000010; ///< Pedestrians
+
+ private:
+  long first_frame_ = 0; ///< Frame of the first entry
+  size_t frames_ = 0; ///< Number of frames
+  std::vector<uint64_t> prefix_; ///< Sums of all frames before a frame, stored as [frame][type]
+
+ public:
+  /**
+   * Creates counts without frames.
+   */
+  FrameCounts() = default;
+
+  /**
+   * Builds the prefix sums.
+   * @param first_frame Frame of the first entry.
+   * @param frames Number of frames.
+   * @param counts Objects per frame and type, stored as [frame][type].
+   */
+  FrameCounts(long first_frame, size_t frames, const std::vector<std::atomic<uint32_t>> &counts);
+
+  /**
+   * Number of object states of some types in a frame range.
+   * @param type_mask Bit mask of type indices.
+   * @param begin Offset of the first frame from the first frame of the counts.
+   * @param end Offset behind the last frame.
+   * @return Number of states.
+   */
+  [[nodiscard]] uint64_t Sum(uint32_t type_mask, size_t begin, size_t end) const;
+
+  /**
+   * Searches windows with the most objects inside the lab area that meet all requirements. Windows do not overlap,
+   * every window is found with one pass over the frames.
+   * @param length Number of frames of a window, limited to the number of frames.
+   * @param requirements Requirements a window has to meet.
+   * @param count Maximal number of windows.
+   * @return Windows, best first.
+   */
+  [[nodiscard]] std::vector<FrameWindow> FindWindows(size_t length,
+                                                     const std::vector<WindowRequirement> &requirements,
+                                                     size_t count = 1) const;
+
+  [[nodiscard]] long GetFirstFrame() const;
+  [[nodiscard]] size_t GetNumberOfFrames() const;
+};
+
+typedef std::shared_ptr<const FrameCounts> FrameCountsPtr;
+
+/**
+ * Share of a frame range that is kept when the scenario is restricted to the lab area.
+ */
+struct Retention {
+  size_t objects = 0; ///< Objects with at least one state inside the lab area
+  size_t total_objects = 0; ///< Objects with at least one state in the frame range
+  uint64_t states = 0; ///< States inside the lab area
+  uint64_t total_states = 0; ///< States in the frame range
+};
+
+/**
+ * Counts the objects inside the lab area per frame and object type for a shift and rotation of the scenario, see
+ * PlacementOptimizer for the transformation. The states are sorted into a grid once. When the transformation changes
+ * only the states of cells that are not entirely inside or outside the lab area under both transformations are tested
+ * again, so small changes of shift or rotation only touch the states near the border of the lab area. The number of
+ * states inside the lab area is tracked per object as well, to report how many objects of a frame range are kept.
+ */
+class FrameStatistics {
+ private:
+  /**
+   * State of an object.
+   */
+  struct Entry {
+    Eigen::Vector2d position; ///< Position in scenario meters
+    uint32_t frame; ///< Offset of the frame from the first frame
+    uint32_t type_index; ///< Index of the object type
+    uint32_t object; ///< Index of the object
+  };
+
+  /**
+   * Position of a grid cell relative to the lab area.
+   */
+  enum class CellState { kInside, kOutside, kPartial };
+
+  std::vector<Entry> entries_; ///< States sorted by grid cell
+  std::vector<size_t> cell_begin_; ///< Index of the first entry of each cell, one more than cells
+  std::vector<uint8_t> inside_; ///< Whether each entry is inside the lab area under the current transformation
+  std::vector<std::atomic<uint32_t>> counts_; ///< Objects inside per frame and type, stored as [frame][type]
+  std::vector<std::atomic<uint32_t>> object_counts_; ///< States inside per object within the frame range
+  size_t objects_ = 0; ///< Number of objects
+  size_t retained_objects_ = 0; ///< Objects with states inside within the frame range
+  size_t objects_in_range_ = 0; ///< Objects with states within the frame range
+  uint64_t states_in_range_ = 0; ///< States within the frame range
+  size_t range_begin_ = 0; ///< Offset of the first frame of the frame range
+  size_t range_end_ = 0; ///< Offset behind the last frame of the frame range
+  Eigen::Vector2d origin_ = Eigen::Vector2d::Zero(); ///< Lower corner of the grid in scenario meters
+  double cell_size_ = 2.0; ///< Edge length of a cell in meters
+  size_t width_ = 0; ///< Number of cells in x direction
+  size_t height_ = 0; ///< Number of cells in y direction
+  long first_frame_ = 0; ///< First frame with a state
+  size_t frames_ = 0; ///< Number of frames
+  Eigen::Rotation2Dd rotation_{0.0}; ///< Current rotation
+  Eigen::Vector2d shift_ = Eigen::Vector2d::Zero(); ///< Current shift in meters
+  bool has_transformation_ = false; ///< Whether the counts belong to a transformation
+
+  /**
+   * Classifies a cell.
+   * @param x Cell column.
+   * @param y Cell row.
+   * @param rotation Rotation of the scenario.
+   * @param shift Shift of the scenario.
+   * @return Position of the transformed cell relative to the lab area.
+   */
+  [[nodiscard]] CellState Classify(size_t x, size_t y, const Eigen::Rotation2Dd &rotation,
+                                   const Eigen::Vector2d &shift) const;
+
+ public:
+  /**
+   * Sorts the states of a scenario into the grid. No state is inside the lab area before a transformation is set.
+   * @param scenario Scenario to count.
+   * @param cell_size Preferred edge length of a cell in meters.
+   */
+  explicit FrameStatistics(const cpm_scenario::ScenarioPtr &scenario, double cell_size = 2.0);
+
+  /**
+   * Updates the counts for a new transformation.
+   * @param shift_x Shift in x direction in meters.
+   * @param shift_y Shift in y direction in meters.
+   * @param rotation Rotation in degrees.
+   * @return Number of states that had to be tested.
+   */
+  size_t SetTransformation(double shift_x, double shift_y, double rotation);
+
+  /**
+   * Restricts the retention to a frame range. Touches every state, but only if the range changed.
+   * @param from_frame First frame of the range.
+   * @param to_frame Last frame of the range, 0 includes all frames from from_frame on.
+   */
+  void SetFrameRange(long from_frame, long to_frame);
+
+  /**
+   * Objects and states of the frame range inside the lab area under the current transformation.
+   * @return Retained and total objects and states.
+   */
+  [[nodiscard]] Retention GetRetention() const;
+
+  /**
+   * Builds the prefix sums of the current counts.
+   * @return Immutable counts.
+   */
+  [[nodiscard]] FrameCountsPtr GetCounts() const;
+
+  /**
+   * Number of states of the scenario.
+   * @return Number of states.
+   */
+  [[nodiscard]] size_t GetNumberOfStates() const;
+};
+
+}
+#endif //DATASET_CONVERTER_LIB_FRAME_STATISTICS_H_
@@ -0,0 +1,151 @@
+/**
+ * @file LaneExtractor.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_LANE_EXTRACTOR_H_
+#define DATASET_CONVERTER_LIB_LANE_EXTRACTOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <cpm_scenario/Scenario.h>
+
+#include "dataset_converter_common/analysis/FrameStatistics.h"
+
+namespace dataset_converter_common {
+
+/**
+ * Lane found in the trajectories of a scenario.
+ */
+struct ExtractedLane {
+  std::vector<Eigen::Vector2d> center; ///< Center line in driving direction
+  std::vector<Eigen::Vector2d> left; ///< Left bound in driving direction
+  std::vector<Eigen::Vector2d> right; ///< Right bound in driving direction
+  double support = 0.0; ///< Number of trajectory samples assigned to the lane
+};
+
+/**
+ * Derives lane center lines from the trajectories of a scenario, see PlacementOptimizer for the transformation into
+ * the lab. Every trajectory is sampled once per meter driven, samples of the same small cell and heading are merged
+ * into weighted points. The points are clustered onto the lanes by a few mean shift iterations that only move them
+ * perpendicular to their heading, so the points of a lane collapse onto its center line. Lanes are traced from the
+ * densest points in both directions along the mean of the points ahead with a similar heading and stop where too few
+ * samples remain or where they run into a lane traced before. The center lines are simplified and widened into left
+ * and right bounds. Sampling, merging and the mean shift run in parallel.
+ */
+class LaneExtractor {
+ public:
+  static constexpr double kSampleSpacing = 1.0; ///< Distance driven between two samples in meters
+  static constexpr double kSearchRadius = 1.5; ///< Radius of the neighbourhood of a point in meters
+  static constexpr double kHeadingTolerance = 0.5; ///< Largest heading difference of neighbours in radians
+  static constexpr double kMinSupport = 6.0; ///< Smallest number of samples around a lane vertex
+  static constexpr double kMinLength = 10.0; ///< Shortest lane in meters that does not connect two other lanes
+  static constexpr double kLaneWidth = 3.5; ///< Default lane width in meters
+
+ private:
+  static constexpr size_t kIterations = 3; ///< Number of mean shift iterations
+
+  /**
+   * Merged samples of a cell and heading.
+   */
+  struct Point {
+    Eigen::Vector2d position; ///< Mean position
+    Eigen::Vector2d direction; ///< Mean driving direction, normalised
+    double weight; ///< Number of samples
+  };
+
+  /**
+   * Weighted mean of the neighbours of a position.
+   */
+  struct Neighbourhood {
+    Eigen::Vector2d position = Eigen::Vector2d::Zero(); ///< Mean position
+    Eigen::Vector2d direction = Eigen::Vector2d::Zero(); ///< Sum of the directions
+    double weight = 0.0; ///< Number of samples
+  };
+
+  double lane_width_; ///< Width of the lanes in meters
+  std::vector<Point> points_; ///< Merged samples
+  std::vector<std::pair<int64_t, uint32_t>> cells_; ///< Points sorted by their cell
+  std::vector<ExtractedLane> lanes_; ///< Found lanes, the most supported first
+
+  /**
+   * Sorts the points into the grid.
+   */
+  void BuildGrid();
+
+  /**
+   * Visits every point near a position with a heading close to a direction.
+   * @param position Center of the neighbourhood.
+   * @param direction Driving direction, normalised.
+   * @param function Called with the index of every point.
+   */
+  template<typename Function>
+  void ForEachNeighbour(const Eigen::Vector2d &position, const Eigen::Vector2d &direction, Function &&function) const;
+
+  /**
+   * Averages the points near a position with a heading close to a direction.
+   * @param position Center of the neighbourhood.
+   * @param direction Driving direction, normalised.
+   * @return Mean of the neighbours.
+   */
+  [[nodiscard]] Neighbourhood Average(const Eigen::Vector2d &position, const Eigen::Vector2d &direction) const;
+
+  /**
+   * Follows a lane from a point in one direction and claims the points along it.
+   * @param start Start of the lane.
+   * @param direction Driving direction at the start.
+   * @param sign 1 to follow the driving direction, -1 to go against it.
+   * @param lane Index of the traced lane.
+   * @param max_steps Largest number of steps.
+   * @param owner Lane of every point, -1 if unclaimed.
+   * @param mark Signed step in which the lane claimed a point.
+   * @param joined Set if the walk ended in a lane traced before.
+   * @return Vertices in walking order without the start.
+   */
+  std::vector<Eigen::Vector2d> Walk(const Eigen::Vector2d &start,
+                                    const Eigen::Vector2d &direction,
+                                    int sign,
+                                    int32_t lane,
+                                    size_t max_steps,
+                                    std::vector<int32_t> &owner,
+                                    std::vector<long> &mark,
+                                    bool &joined) const;
+
+  /**
+   * Simplifies a center line and builds both bounds.
+   * @param center Traced center line.
+   * @param support Number of samples of the lane.
+   * @return Lane.
+   */
+  [[nodiscard]] ExtractedLane Fit(const std::vector<Eigen::Vector2d> &center, double support) const;
+
+ public:
+  /**
+   * Extracts the lanes.
+   * @param scenario Scenario with the trajectories.
+   * @param shift_x Shift in x direction in meters.
+   * @param shift_y Shift in y direction in meters.
+   * @param rotation Rotation in degrees.
+   * @param area Area in transformed scenario meters samples are taken from.
+   * @param lane_width Width of the lanes in meters.
+   * @param types Bit mask of the object types whose trajectories are used.
+   */
+  LaneExtractor(const cpm_scenario::ScenarioPtr &scenario,
+                double shift_x,
+                double shift_y,
+                double rotation,
+                const Eigen::AlignedBox2d &area,
+                double lane_width = kLaneWidth,
+                uint32_t types = FrameCounts::kVehicleTypes);
+
+  /**
+   * Getter for the lanes.
+   * @return Lanes in transformed scenario meters with the y axis pointing down, the most supported first.
+   */
+  [[nodiscard]] const std::vector<ExtractedLane> &GetLanes() const;
+};
+
+}
+#endif //DATASET_CONVERTER_LIB_LANE_EXTRACTOR_H_
@@ -0,0 +1,180 @@
+/**
+ * @file MapMatcher.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_MAP_MATCHER_H_
+#define DATASET_CONVERTER_LIB_MAP_MATCHER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <cpm_scenario/Scenario.h>
+
+namespace dataset_converter_common {
+
+/**
+ * Lanelet of the map in scenario meters.
+ */
+struct MapLanelet {
+  long id = 0; ///< Id of the lanelet in the map
+  std::vector<Eigen::Vector2d> left; ///< Left bound in driving direction
+  std::vector<Eigen::Vector2d> right; ///< Right bound in driving direction
+};
+
+/**
+ * Lanelet a state is matched to.
+ */
+struct LaneletMatch {
+  long object_id = 0; ///< Id of the object
+  long frame = 0; ///< Frame of the state
+  long lanelet_id = 0; ///< Id of the lanelet, 0 if the state is off the map
+  double arc_length = 0.0; ///< Distance along the center line from its start in meters
+  double lateral = 0.0; ///< Distance from the center line in meters, positive towards the left bound
+};
+
+/**
+ * Matches the trajectories of a scenario to the lanelets of a map. The center line of every lanelet is the mean of
+ * both bounds after resampling them to the same number of vertices. The segments of the center lines together with
+ * the lanelet area next to them are bulk loaded into a packed R-tree, so the candidates of a state are found by
+ * visiting the few nodes around it. The lanelet sequence of an object is the most likely path of a hidden Markov
+ * model: a candidate is likely if it is close to the center line relative to the lane width and points in the
+ * direction of the object, a transition is likely if the distance driven along the map matches the distance between
+ * both states. Lane changes and states off the map have a fixed cost. Objects are matched in parallel.
+ */
+class MapMatcher {
+ public:
+  static constexpr double kSearchRadius = 3.0; ///< Largest distance of a candidate beyond the lane border in meters
+  static constexpr double kConnectionDistance = 0.5; ///< Largest gap between a center line and its successor in meters
+  static constexpr size_t kMaxCandidates = 8; ///< Largest number of candidates per state
+
+ private:
+  static constexpr size_t kNodeCapacity = 16; ///< Number of children of a node of the R-tree
+  static constexpr uint32_t kOffMap = UINT32_MAX; ///< Lane index of the candidate off the map
+
+  /**
+   * Lanelet prepared for matching.
+   */
+  struct Lane {
+    long id; ///< Id of the lanelet in the map
+    std::vector<Eigen::Vector2d> center; ///< Center line
+    std::vector<double> arc_length; ///< Distance along the center line of every vertex
+    std::vector<double> half_width; ///< Half of the lane width at every vertex
+    double left_sign; ///< Sign of the cross product of the direction and the left bound
+    std::vector<uint32_t> successors; ///< Indices of the lanes starting at the end of this lane
+  };
+
+  /**
+   * Segment of a center line, the leaves of the R-tree.
+   */
+  struct Segment {
+    Eigen::AlignedBox2d bounds; ///< Bounds of the segment and the lane area next to it
+    uint32_t lane; ///< Index of the lane
+    uint32_t index; ///< Segment i connects vertex i and i + 1
+  };
+
+  /**
+   * Node of the R-tree.
+   */
+  struct Node {
+    Eigen::AlignedBox2d bounds; ///< Bounds of all children
+    uint32_t begin; ///< Index of the first child
+    uint32_t end; ///< Index behind the last child
+    bool leaf; ///< Whether the children are segments instead of nodes
+  };
+
+  /**
+   * Lane a single state might be on.
+   */
+  struct Candidate {
+    uint32_t lane; ///< Index of the lane, kOffMap if the state is off the map
+    double arc_length; ///< Distance along the center line
+    double lateral; ///< Signed distance from the center line
+    double cost; ///< Negative log likelihood of the state on this lane
+  };
+
+  std::vector<Lane> lanes_; ///< Lanes of the map
+  std::vector<Segment> segments_; ///< Center line segments
+  std::vector<Node> nodes_; ///< Nodes of the R-tree, the root last
+  std::vector<uint32_t> children_; ///< Child indices of all nodes, segments for leaves
+
+  /**
+   * Visits every segment with bounds intersecting a box.
+   * @param box Box to query.
+   * @param function Called with the index of every segment.
+   */
+  template<typename Function>
+  void Query(const Eigen::AlignedBox2d &box, Function &&function) const;
+
+  /**
+   * Finds the lanes a state might be on, the lowest cost first.
+   * @param position Position of the state.
+   * @param orientation Orientation of the state in radians.
+   * @param candidates Candidates including the off map candidate.
+   */
+  void FindCandidates(const Eigen::Vector2d &position, double orientation, std::vector<Candidate> &candidates) const;
+
+  /**
+   * Negative log likelihood of moving from one candidate to another.
+   * @param from Candidate of the earlier state.
+   * @param to Candidate of the later state.
+   * @param distance Straight distance between both states.
+   * @return Cost.
+   */
+  [[nodiscard]] double TransitionCost(const Candidate &from, const Candidate &to, double distance) const;
+
+  /**
+   * Matches all states of an object.
+   * @param object Object to match.
+   * @param matches Matches of the states in frame order.
+   */
+  void MatchObject(const cpm_scenario::ExtendedObject &object, std::vector<LaneletMatch> &matches) const;
+
+ public:
+  /**
+   * Prepares the lanes and builds the R-tree. Lanelets with a bound of less than two vertices are ignored.
+   * @param lanelets Lanelets of the map.
+   */
+  explicit MapMatcher(const std::vector<MapLanelet> &lanelets);
+
+  /**
+   * Matches every state of a scenario.
+   * @param scenario Scenario to match.
+   * @return Matches ordered by object and frame.
+   */
+  [[nodiscard]] std::vector<LaneletMatch> Match(const cpm_scenario::ScenarioPtr &scenario) const;
+
+  /**
+   * Writes matches as csv.
+   * @param file_path File to write.
+   * @param matches Matches to write.
+   * @return Whether the file was written.
+   */
+  static bool WriteCsv(const std::string &file_path, const std::vector<LaneletMatch> &matches);
+
+  /**
+   * Copies a scenario with the objects that are matched to any of the given lanelets at least once. The objects are
+   * shared with the source scenario.
+   * @param scenario Scenario to restrict.
+   * @param matches Matches of the scenario, the matches of dropped objects are removed.
+   * @param lanelet_ids Ids of the lanelets.
+   * @return Restricted scenario.
+   */
+  static cpm_scenario::ScenarioPtr Restrict(const cpm_scenario::ScenarioPtr &scenario,
+                                            std::vector<LaneletMatch> &matches,
+                                            const std::vector<long> &lanelet_ids);
+
+  /**
+   * Whether the map contains no usable lanelet.
+   * @return True if no state can be matched.
+   */
+  [[nodiscard]] bool IsEmpty() const;
+};
+
+typedef std::shared_ptr<const MapMatcher> MapMatcherPtr;
+
+}
+#endif //DATASET_CONVERTER_LIB_MAP_MATCHER_H_
@@ -0,0 +1,126 @@
+/**
+ * @file OccupancyHistogram.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_OCCUPANCY_HISTOGRAM_H_
+#define DATASET_CONVERTER_LIB_OCCUPANCY_HISTOGRAM_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <cpm_scenario/Scenario.h>
+
+namespace dataset_converter_common {
+
+/**
+ * Two dimensional histogram counting the states of all objects per grid cell, split by object type. The histogram is
+ * built in several passes over interleaved subsets of the states, so a coarse but complete estimate is available
+ * after the first pass and refines with every further pass.
+ */
+class OccupancyHistogram {
+ public:
+  static constexpr size_t kNumberOfTypes = 7; ///< Number of distinguished object types
+  static constexpr uint32_t kAllTypes = (1u << kNumberOfTypes) - 1; ///< Type mask containing all types
+
+  /**
+   * Called after every pass with the current state of the histogram.
+   * Return false to abort the build.
+   */
+  typedef std::function<bool(const OccupancyHistogram &histogram)> ProgressCallback;
+
+ private:
+  Eigen::Vector2d origin_ = Eigen::Vector2d::Zero(); ///< Position of the lower corner of the first cell in meters
+  double cell_size_ = 1.0; ///< Edge length of a cell in meters
+  size_t width_ = 0; ///< Number of cells in x direction
+  size_t height_ = 0; ///< Number of cells in y direction
+  std::vector<uint32_t> bins_; ///< Counts stored as [type][y][x]
+  std::vector<uint32_t> maxima_; ///< Highest count per type
+  size_t passes_ = 1; ///< Number of passes of the build
+  size_t completed_passes_ = 0; ///< Number of passes that are already included
+
+ public:
+  /**
+   * Creates an empty histogram without cells.
+   */
+  OccupancyHistogram() = default;
+
+  /**
+   * Creates an empty histogram.
+   * @param origin Position of the lower corner of the first cell in meters.
+   * @param cell_size Edge length of a cell in meters.
+   * @param width Number of cells in x direction.
+   * @param height Number of cells in y direction.
+   */
+  OccupancyHistogram(Eigen::Vector2d origin, double cell_size, size_t width, size_t height);
+
+  /**
+   * Creates an empty histogram covering all states of a scenario. The cell size is increased if the grid would exceed
+   * the maximal number of cells per axis.
+   * @param scenario Scenario to cover.
+   * @param cell_size Preferred edge length of a cell in meters.
+   * @param max_cells_per_axis Maximal number of cells in each direction.
+   * @return Empty histogram.
+   */
+  static OccupancyHistogram ForScenario(const cpm_scenario::ScenarioPtr &scenario,
+                                        double cell_size,
+                                        size_t max_cells_per_axis = 1024);
+
+  /**
+   * Index of an object type inside the histogram.
+   * @param type Object type.
+   * @return Index smaller than kNumberOfTypes.
+   */
+  static size_t TypeIndex(cpm_scenario::ExtendedObjectType type);
+
+  /**
+   * Counts all states of the scenario. Every pass processes every passes-th state of each object, the objects are
+   * distributed over all workers.
+   * @param scenario Scenario to count.
+   * @param passes Number of passes, one computes the histogram at once.
+   * @param callback Optional callback after every pass.
+   * @return True if all passes were completed, false if the callback aborted the build.
+   */
+  bool Build(const cpm_scenario::ScenarioPtr &scenario, size_t passes = 4, const ProgressCallback &callback = nullptr);
+
+  /**
+   * Count of a single type in a cell.
+   * @param type_index Index of the type, see TypeIndex.
+   * @param x Cell column.
+   * @param y Cell row.
+   * @return Number of states.
+   */
+  [[nodiscard]] uint32_t GetCount(size_t type_index, size_t x, size_t y) const;
+
+  /**
+   * Summed count of several types in a cell.
+   * @param x Cell column.
+   * @param y Cell row.
+   * @param type_mask Bit mask of type indices to include.
+   * @return Number of states.
+   */
+  [[nodiscard]] uint32_t GetCount(size_t x, size_t y, uint32_t type_mask) const;
+
+  /**
+   * Highest count of a single type over all cells.
+   * @param type_index Index of the type, see TypeIndex.
+   * @return Highest count.
+   */
+  [[nodiscard]] uint32_t GetMaximum(size_t type_index) const;
+
+  /**
+   * Share of the states that is already counted.
+   * @return Value between 0 and 1.
+   */
+  [[nodiscard]] double GetCompleteness() const;
+
+  [[nodiscard]] const Eigen::Vector2d &GetOrigin() const;
+  [[nodiscard]] double GetCellSize() const;
+  [[nodiscard]] size_t GetWidth() const;
+  [[nodiscard]] size_t GetHeight() const;
+};
+
+}
+#endif //DATASET_CONVERTER_LIB_OCCUPANCY_HISTOGRAM_H_
@@ -0,0 +1,48 @@
+/**
+ * @file ParallelFor.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_PARALLEL_FOR_H_
+#define DATASET_CONVERTER_LIB_PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace dataset_converter_common {
+
+/**
+ * Number of workers used by ParallelFor.
+ * @return Number of hardware threads, at least one.
+ */
+inline size_t NumberOfWorkers() {
+  return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+/**
+ * Splits the index range [0, count) into one contiguous chunk per worker and processes the chunks in parallel. The
+ * calling thread processes the first chunk itself.
+ * @param count Number of elements.
+ * @param function Called as function(worker, begin, end) for every chunk, worker is smaller than NumberOfWorkers().
+ */
+template<typename RangeFunction>
+void ParallelFor(size_t count, RangeFunction &&function) {
+  size_t workers = std::min(NumberOfWorkers(), std::max<size_t>(1, count));
+  size_t chunk_size = (count + workers - 1) / std::max<size_t>(1, workers);
+  std::vector<std::thread> threads;
+  threads.reserve(workers);
+  for (size_t worker = 1; worker < workers; ++worker) {
+    size_t begin = std::min(count, worker * chunk_size);
+    size_t end = std::min(count, begin + chunk_size);
+    threads.emplace_back([&function, worker, begin, end]() { function(worker, begin, end); });
+  }
+  function(size_t(0), size_t(0), std::min(count, chunk_size));
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+}
+#endif //DATASET_CONVERTER_LIB_PARALLEL_FOR_H_
@@ -0,0 +1,130 @@
+/**
+ * @file PlacementOptimizer.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_PLACEMENT_OPTIMIZER_H_
+#define DATASET_CONVERTER_LIB_PLACEMENT_OPTIMIZER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <cpm_scenario/Scenario.h>
+
+namespace dataset_converter_common {
+
+/**
+ * Pose of a scenario inside the lab, in the units of the shift and rotation controls of the converter.
+ */
+struct Placement {
+  double shift_x = 0.0; ///< Shift in x direction in meters
+  double shift_y = 0.0; ///< Shift in y direction in meters
+  double rotation = 0.0; ///< Rotation in degrees between 0 and 360
+  uint64_t object_frames = 0; ///< Number of object states inside the lab area
+};
+
+/**
+ * Searches shift and rotation of a scenario that keep as many object states as possible inside the lab area that is
+ * kept on export. A state at position p ends up at R(rotation) * p + shift, the lab area is the export area of the
+ * scenario writer scaled by 1:18 back to scenario meters with the y axis of the visualisation.
+ *
+ * The states of the frame range are counted once into a fine histogram, the search only works on its occupied
+ * cells. For every candidate rotation the cells are rotated into a grid and the best shift is found with a summed
+ * area table in a single sweep. Rotations are searched coarse to fine, candidates of each level are evaluated in
+ * parallel, the final candidates are scored exactly on the histogram.
+ */
+class PlacementOptimizer {
+ public:
+  static constexpr double kLabScale = 18.0; ///< Scale of the lab, scenario meters per lab meter
+  static constexpr double kLabWidth = 4.5; ///< Width of the lab in lab meters
+  static constexpr double kLabHeight = 4.0; ///< Height of the lab in lab meters
+  static constexpr double kMaxShift = 100.0; ///< Largest shift in each direction in meters
+
+ private:
+  /**
+   * Occupied cell of the precomputed histogram.
+   */
+  struct WeightedPoint {
+    Eigen::Vector2d position; ///< Cell center in scenario meters
+    uint32_t count; ///< Number of states in the cell
+  };
+
+  /**
+   * Search level of the coarse to fine search.
+   */
+  struct Level {
+    double rotation_step; ///< Distance of the rotations in degrees
+    double rotation_range; ///< Rotations searched around each candidate in degrees, 360 searches all
+    double cell_size; ///< Edge length of the search grid in meters
+    size_t candidates; ///< Number of candidates passed to the next level
+  };
+
+  std::vector<WeightedPoint> points_; ///< Occupied cells of the histogram
+  uint64_t total_ = 0; ///< Number of states in the frame range
+  double cell_size_ = 0.25; ///< Edge length of a histogram cell in meters
+
+  /**
+   * Finds the best shift for a rotation.
+   * @param rotation Rotation in degrees.
+   * @param cell_size Edge length of the search grid in meters.
+   * @return Placement with the count estimated on the search grid.
+   */
+  [[nodiscard]] Placement SearchShift(double rotation, double cell_size) const;
+
+  /**
+   * Searches several rotations in parallel.
+   * @param rotations Rotations in degrees.
+   * @param cell_size Edge length of the search grid in meters.
+   * @return Best placement per rotation.
+   */
+  [[nodiscard]] std::vector<Placement> SearchShifts(const std::vector<double> &rotations, double cell_size) const;
+
+ public:
+  /**
+   * Counts the states of a frame range into the histogram.
+   * @param scenario Scenario to place.
+   * @param from_frame First frame to consider.
+   * @param to_frame Last frame to consider, 0 considers all frames from from_frame on.
+   * @param cell_size Preferred edge length of a histogram cell in meters.
+   */
+  PlacementOptimizer(const cpm_scenario::ScenarioPtr &scenario,
+                     size_t from_frame = 0,
+                     size_t to_frame = 0,
+                     double cell_size = 0.25);
+
+  /**
+   * Area that has to contain the states after the transformation.
+   * @return Box in scenario meters with the y axis pointing down.
+   */
+  static Eigen::AlignedBox2d LabArea();
+
+  /**
+   * Area of the lab walls.
+   * @return Box in scenario meters with the y axis pointing down.
+   */
+  static Eigen::AlignedBox2d LabBounds();
+
+  /**
+   * Counts the states inside the lab area on the histogram.
+   * @param placement Shift and rotation.
+   * @return Number of states, precise up to the histogram cell size.
+   */
+  [[nodiscard]] uint64_t Score(const Placement &placement) const;
+
+  /**
+   * Searches the best placements. Placements closer than a meter and a degree to a better one are skipped.
+   * @param k Number of placements.
+   * @return Up to k placements, best first.
+   */
+  [[nodiscard]] std::vector<Placement> FindBest(size_t k) const;
+
+  /**
+   * Number of states in the frame range.
+   * @return Number of states.
+   */
+  [[nodiscard]] uint64_t GetTotal() const;
+};
+
+}
+#endif //DATASET_CONVERTER_LIB_PLACEMENT_OPTIMIZER_H_
@@ -0,0 +1,93 @@
+/**
+ * @file PolygonRegion.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_POLYGON_REGION_H_
+#define DATASET_CONVERTER_LIB_POLYGON_REGION_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <cpm_scenario/Scenario.h>
+
+namespace dataset_converter_common {
+
+/**
+ * Union of polygons used to restrict an export to a region of interest, for example an intersection core or the
+ * lanelets of the lab. The edges are sorted into a uniform grid once. Every cell knows for each polygon with edges in
+ * the cell whether its center is inside, cells without edges are entirely inside or outside. A point is tested by
+ * counting the crossings of the line from the cell center to the point with the few edges of its cell, the edges of a
+ * cell are stored as separate coordinate arrays so the crossing tests of a cell are vectorised by the compiler.
+ */
+class PolygonRegion {
+ private:
+  /**
+   * Edges of one polygon in a cell.
+   */
+  struct Group {
+    uint32_t polygon; ///< Index of the polygon
+    bool center_inside; ///< Whether the cell center is inside the polygon
+    uint32_t edge_begin; ///< Index of the first edge
+    uint32_t edge_end; ///< Index behind the last edge
+  };
+
+  Eigen::Vector2d origin_ = Eigen::Vector2d::Zero(); ///< Lower corner of the grid
+  double cell_size_ = 1.0; ///< Edge length of a cell
+  size_t width_ = 0; ///< Number of cells in x direction
+  size_t height_ = 0; ///< Number of cells in y direction
+  std::vector<uint32_t> cell_begin_; ///< Index of the first group of each cell, one more than cells
+  std::vector<Group> groups_; ///< Groups sorted by cell and polygon
+  std::vector<uint8_t> covered_; ///< Whether a cell is inside a polygon without edges in the cell
+  std::vector<double> start_x_; ///< X coordinate of the first vertex of each edge, sorted by group
+  std::vector<double> start_y_; ///< Y coordinate of the first vertex of each edge, sorted by group
+  std::vector<double> end_x_; ///< X coordinate of the second vertex of each edge, sorted by group
+  std::vector<double> end_y_; ///< Y coordinate of the second vertex of each edge, sorted by group
+
+  /**
+   * Center of a cell.
+   * @param x Cell column.
+   * @param y Cell row.
+   * @return Center.
+   */
+  [[nodiscard]] Eigen::Vector2d CellCenter(size_t x, size_t y) const;
+
+ public:
+  /**
+   * Builds the edge grid. Polygons are closed implicitly, polygons with less than three vertices are ignored.
+   * @param polygons Vertices of every polygon.
+   */
+  explicit PolygonRegion(const std::vector<std::vector<Eigen::Vector2d>> &polygons);
+
+  /**
+   * Tests whether a point is inside any polygon.
+   * @param point Point to test.
+   * @return True if inside.
+   */
+  [[nodiscard]] bool Contains(const Eigen::Vector2d &point) const;
+
+  /**
+   * Tests a batch of points.
+   * @param points Points to test.
+   * @param inside Set to 1 for every point inside any polygon and to 0 otherwise, resized to the number of points.
+   */
+  void Contains(const std::vector<Eigen::Vector2d> &points, std::vector<uint8_t> &inside) const;
+
+  /**
+   * Copies a scenario with the states inside the region. Objects without such a state are dropped. The states are
+   * shared with the source scenario. Objects are tested in parallel.
+   * @param scenario Scenario to restrict.
+   * @return Restricted scenario.
+   */
+  [[nodiscard]] cpm_scenario::ScenarioPtr Restrict(const cpm_scenario::ScenarioPtr &scenario) const;
+
+  /**
+   * Whether the region contains no polygon.
+   * @return True if no point is inside.
+   */
+  [[nodiscard]] bool IsEmpty() const;
+};
+
+}
+#endif //DATASET_CONVERTER_LIB_POLYGON_REGION_H_
@@ -0,0 +1,153 @@
+/**
+ * @file ScenarioIndex.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_SCENARIO_INDEX_H_
+#define DATASET_CONVERTER_LIB_SCENARIO_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <cpm_scenario/Scenario.h>
+
+namespace dataset_converter_common {
+
+/**
+ * Condition a window of a scenario has to meet, for example at least three moving pedestrians.
+ */
+struct IndexCondition {
+  /**
+   * How the objects of a window are counted.
+   */
+  enum class Measure {
+    kDistinct, ///< Objects with a state in the window
+    kMoving, ///< Objects that move within the window
+    kMinimum, ///< Objects present in every frame of the window at the same time
+  };
+
+  uint32_t type_mask = 0; ///< Bit mask of type indices, see OccupancyHistogram::TypeIndex
+  Measure measure = Measure::kDistinct; ///< How the objects are counted
+  uint32_t min_count = 0; ///< Minimal number of objects
+};
+
+/**
+ * Window of a scenario that meets all conditions of a query.
+ */
+struct IndexMatch {
+  std::string dataset; ///< Name of the dataset
+  std::string scenario; ///< Name of the scenario
+  long from_frame = 0; ///< First frame of the window
+  long to_frame = 0; ///< Last frame of the window
+  double frames_per_second = 0.0; ///< Frame rate of the scenario
+};
+
+/**
+ * Feature summaries of parsed scenarios of several datasets, to find windows that meet some conditions without parsing
+ * the datasets again. The file stores the number of objects present per frame and type and the frames every object is
+ * present and moving. Windows are summarised with prefix sums that are built when scenarios are added or loaded, so a
+ * window is tested in constant time.
+ */
+class ScenarioIndex {
+ public:
+  static constexpr double kMovingSpeed = 0.5; ///< Speed in m/s above which an object counts as moving
+
+ private:
+  /**
+   * Frames an object is present and moving, as offsets from the first frame of the scenario.
+   */
+  struct ObjectSpan {
+    uint8_t type_index = 0; ///< Index of the object type
+    uint32_t first = 0; ///< First frame with a state
+    uint32_t last = 0; ///< Last frame with a state
+    uint32_t first_moving = 0; ///< First frame the object moves
+    uint32_t last_moving = 0; ///< Last frame the object moves
+    bool moving = false; ///< Whether the object moves at all
+  };
+
+  /**
+   * Summaries of a scenario.
+   */
+  struct Entry {
+    std::string dataset; ///< Name of the dataset
+    std::string scenario; ///< Name of the scenario
+    double frames_per_second = 25.0; ///< Frame rate
+    long first_frame = 0; ///< First frame with a state
+    uint32_t frames = 0; ///< Number of frames
+    std::vector<uint16_t> present; ///< Objects per frame and type, stored as [frame][type]
+    std::vector<ObjectSpan> objects; ///< Frames of every object
+
+    // Built from the stored summaries
+    std::vector<uint32_t> started; ///< Objects appeared up to a frame, stored as [frame + 1][type]
+    std::vector<uint32_t> ended; ///< Objects disappeared before a frame, stored as [frame][type]
+    std::vector<uint32_t> started_moving; ///< Moving objects started up to a frame, stored as [frame + 1][type]
+    std::vector<uint32_t> ended_moving; ///< Moving objects stopped before a frame, stored as [frame][type]
+  };
+
+  std::vector<Entry> entries_; ///< Indexed scenarios
+
+  /**
+   * Builds the prefix sums of an entry.
+   * @param entry Entry with stored summaries.
+   */
+  static void BuildSums(Entry &entry);
+
+  /**
+   * Searches the windows of one scenario.
+   * @param entry Scenario to search.
+   * @param window_seconds Length of a window in seconds.
+   * @param conditions Conditions every window has to meet.
+   * @return Non overlapping matching windows, first frame first.
+   */
+  static std::vector<IndexMatch> Search(const Entry &entry,
+                                        double window_seconds,
+                                        const std::vector<IndexCondition> &conditions);
+
+ public:
+  /**
+   * Summarises a parsed scenario. A scenario with the same dataset and name is replaced.
+   * @param dataset Name of the dataset.
+   * @param scenario Parsed scenario.
+   * @param frames_per_second Frame rate of the scenario.
+   */
+  void Add(const std::string &dataset, const cpm_scenario::ScenarioPtr &scenario, double frames_per_second);
+
+  /**
+   * Writes the index to a binary file.
+   * @param file_path File to write.
+   * @return Whether the file was written.
+   */
+  bool Save(const std::string &file_path) const;
+
+  /**
+   * Replaces the index with the content of a file written by Save.
+   * @param file_path File to read.
+   * @return Whether the file was read, the index is empty otherwise.
+   */
+  bool Load(const std::string &file_path);
+
+  /**
+   * Searches windows of all scenarios that meet all conditions. Scenarios are searched in parallel.
+   * @param window_seconds Length of a window in seconds.
+   * @param conditions Conditions every window has to meet.
+   * @return Non overlapping matching windows, in the order the scenarios were added.
+   */
+  [[nodiscard]] std::vector<IndexMatch> Query(double window_seconds,
+                                              const std::vector<IndexCondition> &conditions) const;
+
+  /**
+   * Parses a condition like "pedestrian:moving:3" or "car:minimum:5". Types are car, pedestrian, bicycle, truck_bus,
+   * van, trailer, unknown, vehicle and any, several types are joined with "+". Measures are distinct, moving and
+   * minimum.
+   * @param text Condition to parse.
+   * @param condition Parsed condition.
+   * @return Whether the text is a valid condition.
+   */
+  static bool ParseCondition(const std::string &text, IndexCondition &condition);
+
+  [[nodiscard]] size_t GetNumberOfScenarios() const;
+};
+
+}
+#endif //DATASET_CONVERTER_LIB_SCENARIO_INDEX_H_
@@ -0,0 +1,111 @@
+/**
+ * @file TrajectorySmoother.h
+ * @authors Simon Schaefer
+ * @date 19.10.2026
+ */
+#ifndef DATASET_CONVERTER_LIB_TRAJECTORY_SMOOTHER_H_
+#define DATASET_CONVERTER_LIB_TRAJECTORY_SMOOTHER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <cpm_scenario/Scenario.h>
+
+namespace dataset_converter_common {
+
+/**
+ * Savitzky-Golay smoothing of the recorded trajectories. A quadratic is fitted to the positions in a window around
+ * every state, its value replaces the position and its slope the velocity. Windows at the ends of a run of consecutive
+ * frames are shifted inwards instead of shrinking, so the first and last states are fitted with the same number of
+ * samples. Positions of an object are copied into contiguous arrays and the fits are evaluated as convolutions with
+ * coefficients precomputed once per window size, one pass over the array per coefficient. The heading follows the smoothed velocity of
+ * states with a centered window, the slope at the ends of a run is too noisy. It is held while the object is slower
+ * than kMinHeadingSpeed, so standing pedestrians do not spin. Vehicles keep driving backwards if their recorded
+ * orientation points against the velocity. Objects are smoothed in parallel.
+ */
+class TrajectorySmoother {
+ public:
+  static constexpr double kWindowDuration = 1.0; ///< Default duration of the smoothing window in seconds
+  static constexpr double kMinHeadingSpeed = 0.3; ///< Slowest speed in meters per second a heading is derived at
+
+ private:
+  static constexpr size_t kOrder = 2; ///< Degree of the fitted polynomial
+
+  /**
+   * Filter coefficients of one window size.
+   */
+  struct Kernel {
+    size_t size = 0; ///< Number of samples in the window
+    std::vector<double> value; ///< Coefficients of the value, size entries per position in the window
+    std::vector<double> slope; ///< Coefficients of the first derivative per frame, same layout
+  };
+
+  /**
+   * Working arrays of one object.
+   */
+  struct Buffers {
+    std::vector<double> x; ///< Recorded x positions
+    std::vector<double> y; ///< Recorded y positions
+    std::vector<double> smooth_x; ///< Smoothed x positions
+    std::vector<double> smooth_y; ///< Smoothed y positions
+    std::vector<double> velocity_x; ///< Velocity in x direction per frame
+    std::vector<double> velocity_y; ///< Velocity in y direction per frame
+    std::vector<uint8_t> centered; ///< Whether the window is centered on the state or the velocity was recorded
+  };
+
+  double window_duration_; ///< Duration of the smoothing window in seconds
+
+  /**
+   * Computes the coefficients of a window size.
+   * @param size Number of samples, at least kOrder + 1.
+   * @return Coefficients for every position in the window.
+   */
+  static Kernel MakeKernel(size_t size);
+
+  /**
+   * Applies a kernel to a run of samples.
+   * @param kernel Kernel not larger than the run.
+   * @param begin First sample of the run.
+   * @param end Sample behind the run.
+   * @param buffers Arrays to read the positions from and write the results to.
+   */
+  static void Filter(const Kernel &kernel, size_t begin, size_t end, Buffers &buffers);
+
+  /**
+   * Smooths all states of an object.
+   * @param object Object to smooth.
+   * @param kernels Kernels indexed by number of samples, the last one is the full window, made for every shorter run.
+   * @param frames_per_second Frame rate of the recording.
+   * @param buffers Working arrays reused between objects.
+   */
+  static void SmoothObject(const cpm_scenario::ExtendedObject &object,
+                           const std::vector<Kernel> &kernels,
+                           double frames_per_second,
+                           Buffers &buffers);
+
+ public:
+  /**
+   * Creates the smoother.
+   * @param window_duration Duration of the smoothing window in seconds.
+   */
+  explicit TrajectorySmoother(double window_duration = kWindowDuration);
+
+  /**
+   * Smooths position, velocity and orientation of every state in place.
+   * @param scenario Scenario to smooth.
+   * @param frames_per_second Frame rate of the recording.
+   */
+  void Smooth(const cpm_scenario::ScenarioPtr &scenario, double frames_per_second) const;
+
+  /**
+   * Getter for the window duration.
+   * @return Duration of the smoothing window in seconds.
+   */
+  [[nodiscard]] double GetWindowDuration() const;
+};
+
+typedef std::shared_ptr<const TrajectorySmoother> TrajectorySmootherPtr;
+
+}
+#endif //DATASET_CONVERTER_LIB_TRAJECTORY_SMOOTHER_H_
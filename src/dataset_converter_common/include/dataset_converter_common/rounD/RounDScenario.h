@@ -37,6 +37,8 @@ class RounDScenario : public DatasetScenario {
   explicit RounDScenario(const std::string &name);
 
   void Parse(const std::string &dataset_root_directory) override;
+
+  [[nodiscard]] double GetFramesPerSecond() const override;
 };
 
 }
@@ -156,4 +156,7 @@ const std::string &DutScenario::GetBackgroundFilePath() const {
 void DutScenario::SetBackgroundFilePath(const std::string &background_file_path) {
   background_file_path_ = background_file_path;
 }
+double DutScenario::GetFramesPerSecond() const {
+  return FRAMES_PER_SECOND;
+}
 }
\ No newline at end of file
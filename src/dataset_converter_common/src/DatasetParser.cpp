@@ -4,12 +4,15 @@ namespace dataset_converter_common {
 void DatasetParser::ParseAll(const std::string &dataset_root_directory) {
   for (const auto &dataset : this->scenarios_) {
     dataset->Parse(dataset_root_directory);
+    if (this->smoother_) this->smoother_->Smooth(dataset, dataset->GetFramesPerSecond());
   }
 }
 
 long DatasetParser::ParseNext(const std::string &dataset_root_directory) {
   if (this->scenario_counter_ >= this->scenarios_.size())return -1;
-  this->scenarios_.at(this->scenario_counter_)->Parse(dataset_root_directory);
+  const auto &scenario = this->scenarios_.at(this->scenario_counter_);
+  scenario->Parse(dataset_root_directory);
+  if (this->smoother_) this->smoother_->Smooth(scenario, scenario->GetFramesPerSecond());
   this->scenario_counter_++;
   return static_cast<long>(this->scenarios_.size()) - this->scenario_counter_;
 }
@@ -18,6 +21,10 @@ void DatasetParser::AddScenario(const DatasetScenarioPtr &scenario) {
   this->scenarios_.push_back(scenario);
 }
 
+void DatasetParser::SetSmoother(const TrajectorySmootherPtr &smoother) {
+  this->smoother_ = smoother;
+}
+
 const DatasetScenarioPtrs &DatasetParser::GetScenarios() const {
   return scenarios_;
 }
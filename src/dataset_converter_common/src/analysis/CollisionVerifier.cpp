@@ -0,0 +1,162 @@
+#include "dataset_converter_common/analysis/CollisionVerifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include "dataset_converter_common/analysis/CriticalityMetrics.h"
+#include "dataset_converter_common/analysis/FrameGrid.h"
+#include "dataset_converter_common/analysis/OccupancyHistogram.h"
+#include "dataset_converter_common/analysis/ParallelFor.h"
+#include "dataset_converter_common/analysis/PlacementOptimizer.h"
+
+namespace dataset_converter_common {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+}
+
+CollisionVerifier::CollisionVerifier(const cpm_scenario::ScenarioPtr &scenario,
+                                     double shift_x,
+                                     double shift_y,
+                                     double rotation,
+                                     long from_frame,
+                                     long to_frame,
+                                     double clearance,
+                                     uint32_t types)
+    : clearance_(clearance * PlacementOptimizer::kLabScale) {
+  Eigen::Rotation2Dd transform(rotation * kPi / 180.0);
+  Eigen::Vector2d shift(shift_x, shift_y);
+  Eigen::AlignedBox2d area = PlacementOptimizer::LabArea();
+  auto in_range = [from_frame, to_frame](long frame) {
+    return frame >= from_frame && (to_frame == 0 || frame <= to_frame);
+  };
+
+  const auto &objects = scenario->GetObjects();
+  std::vector<uint8_t> tested_objects(objects.size());
+  double largest = 0.0;
+  for (size_t i = 0; i < objects.size(); ++i) {
+    ids_.push_back(static_cast<long>(objects[i]->GetId()));
+    tested_objects[i] = (types & (1u << OccupancyHistogram::TypeIndex(objects[i]->GetType()))) != 0 ? 1 : 0;
+    if (tested_objects[i]) largest = std::max(largest, objects[i]->GetDimension().norm());
+  }
+
+  // States kept by the export sorted by frame, the writer keeps every state with its center inside the lab area
+  auto buckets = BucketStatesByFrame<Box>(
+      scenario,
+      [&](size_t object, long frame, const auto &state) {
+        return tested_objects[object] && in_range(frame) && area.contains(transform * state.GetPosition() + shift);
+      },
+      [&](size_t object, long, const auto &state, Box &box) {
+        Eigen::Vector2d half(objects[object]->GetDimension().x() / 2.0, objects[object]->GetDimension().y() / 2.0);
+        const Eigen::Vector2d local[] = {{half.x(), -half.y()}, {half.x(), half.y()},
+                                         {-half.x(), half.y()}, {-half.x(), -half.y()}};
+        Eigen::Rotation2Dd orientation(state.GetOrientation());
+        box.object = static_cast<uint32_t>(object);
+        box.center = transform * state.GetPosition() + shift;
+        for (size_t k = 0; k < 4; ++k) {
+          box.corners[k] = box.center + transform * (orientation * local[k]);
+        }
+      });
+  states_ = buckets.elements.size();
+  size_t frames = buckets.GetNumberOfFrames();
+  if (frames == 0) return;
+  long first_frame = buckets.first_frame;
+  const auto &frame_begin = buckets.begin;
+  const auto &boxes = buckets.elements;
+
+  // Boxes closer than the clearance have centers closer than the largest box plus the clearance
+  cell_size_ = std::max(largest + clearance_, 1e-3);
+  std::vector<std::vector<LabConflict>> worker_conflicts(NumberOfWorkers());
+  ParallelFor(frames, [&](size_t worker, size_t begin, size_t end) {
+    for (size_t frame = begin; frame < end; ++frame) {
+      ProcessFrame(first_frame + static_cast<long>(frame), boxes.data() + frame_begin[frame],
+                   frame_begin[frame + 1] - frame_begin[frame], worker_conflicts[worker]);
+    }
+  });
+  for (auto &conflicts : worker_conflicts) {
+    conflicts_.insert(conflicts_.end(), conflicts.begin(), conflicts.end());
+  }
+}
+
+void CollisionVerifier::ProcessFrame(long frame, const Box *boxes, size_t count,
+                                     std::vector<LabConflict> &conflicts) const {
+  Eigen::AlignedBox2d bounds = PlacementOptimizer::LabBounds();
+  auto cell_of = [this](const Eigen::Vector2d &position) {
+    return std::make_pair(static_cast<int64_t>(std::floor(position.x() / cell_size_)),
+                          static_cast<int64_t>(std::floor(position.y() / cell_size_)));
+  };
+  std::vector<std::pair<int64_t, uint32_t>> cells(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto cell = cell_of(boxes[i].center);
+    cells[i] = {CellKey(cell.first, cell.second), static_cast<uint32_t>(i)};
+  }
+  std::sort(cells.begin(), cells.end());
+
+  for (size_t i = 0; i < count; ++i) {
+    const Box &a = boxes[i];
+
+    // Lab walls
+    double beyond = 0.0;
+    for (const auto &corner : a.corners) {
+      beyond = std::max(beyond, bounds.exteriorDistance(corner));
+    }
+    if (beyond > 0.0) {
+      conflicts.push_back({LabConflict::Kind::kBorder, frame, ids_[a.object], 0,
+                           beyond / PlacementOptimizer::kLabScale});
+    }
+
+    // Other objects
+    auto cell = cell_of(a.center);
+    for (int64_t dx = -1; dx <= 1; ++dx) {
+      for (int64_t dy = -1; dy <= 1; ++dy) {
+        auto key = CellKey(cell.first + dx, cell.second + dy);
+        auto range = std::equal_range(cells.begin(), cells.end(), std::make_pair(key, uint32_t(0)),
+                                      [](const auto &l, const auto &r) { return l.first < r.first; });
+        for (auto it = range.first; it != range.second; ++it) {
+          if (it->second <= i) continue;
+          const Box &b = boxes[it->second];
+          if (a.object == b.object) continue;
+          double distance = CriticalityMetrics::Distance(a.corners, b.corners);
+          if (distance > clearance_) continue;
+
+          bool ordered = a.object < b.object;
+          conflicts.push_back({LabConflict::Kind::kOverlap, frame, ids_[ordered ? a.object : b.object],
+                               ids_[ordered ? b.object : a.object], distance / PlacementOptimizer::kLabScale});
+        }
+      }
+    }
+  }
+}
+
+bool CollisionVerifier::WriteCsv(const std::string &file_path) const {
+  std::ofstream stream(file_path);
+  stream << "frame,kind,first_id,second_id,distance\n";
+  for (const auto &conflict : conflicts_) {
+    bool overlap = conflict.kind == LabConflict::Kind::kOverlap;
+    stream << conflict.frame << "," << (overlap ? "overlap" : "border") << "," << conflict.first_id << ",";
+    if (overlap) stream << conflict.second_id;
+    stream << "," << conflict.distance << "\n";
+  }
+  return static_cast<bool>(stream.flush());
+}
+
+size_t CollisionVerifier::GetNumberOfConflictFrames() const {
+  size_t frames = 0;
+  for (size_t i = 0; i < conflicts_.size(); ++i) {
+    if (i == 0 || conflicts_[i].frame != conflicts_[i - 1].frame) frames++;
+  }
+  return frames;
+}
+
+const std::vector<LabConflict> &CollisionVerifier::GetConflicts() const {
+  return conflicts_;
+}
+
+uint64_t CollisionVerifier::GetNumberOfStates() const {
+  return states_;
+}
+
+}
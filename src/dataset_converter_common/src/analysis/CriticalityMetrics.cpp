@@ -0,0 +1,396 @@
+#include "dataset_converter_common/analysis/CriticalityMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include "dataset_converter_common/analysis/FrameGrid.h"
+#include "dataset_converter_common/analysis/ParallelFor.h"
+
+namespace dataset_converter_common {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+double Cross(const Eigen::Vector2d &a, const Eigen::Vector2d &b) {
+  return a.x() * b.y() - a.y() * b.x();
+}
+
+// Distance of a point to a segment
+double SegmentDistance(const Eigen::Vector2d &point, const Eigen::Vector2d &begin, const Eigen::Vector2d &end) {
+  Eigen::Vector2d segment = end - begin;
+  double length = segment.squaredNorm();
+  double t = length > 0.0 ? std::clamp((point - begin).dot(segment) / length, 0.0, 1.0) : 0.0;
+  return (begin + t * segment - point).norm();
+}
+
+// Whether two convex polygons overlap, by separating axes
+bool Overlap(const std::array<Eigen::Vector2d, 4> &a, const std::array<Eigen::Vector2d, 4> &b) {
+  for (const auto *polygon : {&a, &b}) {
+    for (size_t i = 0; i < 4; ++i) {
+      Eigen::Vector2d edge = (*polygon)[(i + 1) % 4] - (*polygon)[i];
+      Eigen::Vector2d axis(edge.y(), -edge.x());
+      double min_a = kInfinity, max_a = -kInfinity, min_b = kInfinity, max_b = -kInfinity;
+      for (size_t k = 0; k < 4; ++k) {
+        min_a = std::min(min_a, axis.dot(a[k]));
+        max_a = std::max(max_a, axis.dot(a[k]));
+        min_b = std::min(min_b, axis.dot(b[k]));
+        max_b = std::max(max_b, axis.dot(b[k]));
+      }
+      if (max_a < min_b || max_b < min_a) return false;
+    }
+  }
+  return true;
+}
+
+// Convex hull in counter clockwise order, by the monotone chain algorithm
+std::vector<Eigen::Vector2d> ConvexHull(std::vector<Eigen::Vector2d> points) {
+  std::sort(points.begin(), points.end(), [](const Eigen::Vector2d &a, const Eigen::Vector2d &b) {
+    return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+  });
+  std::vector<Eigen::Vector2d> hull(2 * points.size());
+  size_t k = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    while (k >= 2 && Cross(hull[k - 1] - hull[k - 2], points[i] - hull[k - 2]) <= 0) k--;
+    hull[k++] = points[i];
+  }
+  for (size_t i = points.size() - 1, lower = k + 1; i > 0; --i) {
+    while (k >= lower && Cross(hull[k - 1] - hull[k - 2], points[i - 1] - hull[k - 2]) <= 0) k--;
+    hull[k++] = points[i - 1];
+  }
+  hull.resize(k - 1);
+  return hull;
+}
+
+// Smallest angle between two headings as undirected lines
+double CrossingAngle(double a, double b) {
+  double angle = std::fmod(std::fabs(a - b), kPi);
+  return std::min(angle, kPi - angle) * 180.0 / kPi;
+}
+
+void WriteMetric(std::ostream &stream, double value) {
+  if (std::isfinite(value)) stream << value;
+}
+
+}
+
+CriticalityMetrics::CriticalityMetrics(const cpm_scenario::ScenarioPtr &scenario,
+                                       double frames_per_second,
+                                       long from_frame,
+                                       long to_frame,
+                                       double search_radius,
+                                       double ttc_horizon)
+    : frames_per_second_(frames_per_second), search_radius_(search_radius), ttc_horizon_(ttc_horizon) {
+  const auto &objects = scenario->GetObjects();
+  for (const auto &object : objects) {
+    ids_.push_back(static_cast<long>(object->GetId()));
+  }
+
+  // Boxes of the frame range sorted by frame
+  auto buckets = BucketStatesByFrame<Box>(
+      scenario,
+      [from_frame, to_frame](size_t, long frame, const auto &) {
+        return frame >= from_frame && (to_frame == 0 || frame <= to_frame);
+      },
+      [&objects](size_t object, long, const auto &state, Box &box) {
+        Eigen::Vector2d half(objects[object]->GetDimension().x() / 2.0, objects[object]->GetDimension().y() / 2.0);
+        const Eigen::Vector2d local[] = {{half.x(), -half.y()}, {half.x(), half.y()},
+                                         {-half.x(), half.y()}, {-half.x(), -half.y()}};
+        Eigen::Rotation2Dd rotation(state.GetOrientation());
+        box.object = static_cast<uint32_t>(object);
+        box.center = state.GetPosition();
+        box.velocity = state.GetVelocity();
+        for (size_t k = 0; k < 4; ++k) {
+          box.corners[k] = box.center + rotation * local[k];
+        }
+      });
+  size_t frames = buckets.GetNumberOfFrames();
+  if (frames == 0) return;
+  long first_frame = buckets.first_frame;
+  long last_frame = first_frame + static_cast<long>(frames) - 1;
+  const auto &frame_begin = buckets.begin;
+  const auto &boxes = buckets.elements;
+
+  // Frames are independent, every worker keeps the pairs of its contiguous chunk
+  frames_.resize(frames);
+  std::vector<std::vector<PairCriticality>> worker_pairs(NumberOfWorkers());
+  ParallelFor(frames, [&](size_t worker, size_t begin, size_t end) {
+    for (size_t frame = begin; frame < end; ++frame) {
+      frames_[frame].frame = first_frame + static_cast<long>(frame);
+      ProcessFrame(boxes.data() + frame_begin[frame], frame_begin[frame + 1] - frame_begin[frame], frames_[frame],
+                   worker_pairs[worker]);
+    }
+  });
+  for (auto &pairs : worker_pairs) {
+    pairs_.insert(pairs_.end(), pairs.begin(), pairs.end());
+  }
+
+  FindEncroachments(scenario, first_frame, last_frame);
+  for (const auto &encroachment : encroachments_) {
+    auto &frame = frames_[encroachment.frame - first_frame];
+    frame.min_pet = std::min(frame.min_pet, encroachment.pet);
+  }
+}
+
+void CriticalityMetrics::ProcessFrame(const Box *boxes, size_t count, FrameCriticality &frame,
+                                      std::vector<PairCriticality> &pairs) const {
+  frame.objects = count;
+
+  // Uniform grid with the search radius as cell size, so close pairs are in neighbouring cells
+  auto cell_of = [this](const Eigen::Vector2d &position) {
+    return std::make_pair(static_cast<int64_t>(std::floor(position.x() / search_radius_)),
+                          static_cast<int64_t>(std::floor(position.y() / search_radius_)));
+  };
+  std::vector<std::pair<int64_t, uint32_t>> cells(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto cell = cell_of(boxes[i].center);
+    cells[i] = {CellKey(cell.first, cell.second), static_cast<uint32_t>(i)};
+  }
+  std::sort(cells.begin(), cells.end());
+
+  for (size_t i = 0; i < count; ++i) {
+    const Box &a = boxes[i];
+    auto cell = cell_of(a.center);
+    for (int64_t dx = -1; dx <= 1; ++dx) {
+      for (int64_t dy = -1; dy <= 1; ++dy) {
+        auto key = CellKey(cell.first + dx, cell.second + dy);
+        auto range = std::equal_range(cells.begin(), cells.end(), std::make_pair(key, uint32_t(0)),
+                                      [](const auto &l, const auto &r) { return l.first < r.first; });
+        for (auto it = range.first; it != range.second; ++it) {
+          if (it->second <= i) continue;
+          const Box &b = boxes[it->second];
+          if ((a.center - b.center).norm() > search_radius_) continue;
+
+          frame.pairs++;
+          double distance = Distance(a.corners, b.corners);
+          double ttc = TimeToCollision(a.corners, a.velocity, b.corners, b.velocity);
+          if (ttc > ttc_horizon_) ttc = kInfinity;
+          frame.min_distance = std::min(frame.min_distance, distance);
+          frame.min_ttc = std::min(frame.min_ttc, ttc);
+          if (distance > kCloseDistance && !std::isfinite(ttc)) continue;
+
+          bool ordered = a.object < b.object;
+          pairs.push_back({frame.frame, ids_[ordered ? a.object : b.object], ids_[ordered ? b.object : a.object],
+                           distance, ttc});
+        }
+      }
+    }
+  }
+}
+
+void CriticalityMetrics::FindEncroachments(const cpm_scenario::ScenarioPtr &scenario, long from_frame,
+                                           long to_frame) {
+  /**
+   * Stay of a moving object in a conflict area.
+   */
+  struct Visit {
+    int64_t cell; ///< Key of the conflict area
+    uint32_t object; ///< Index of the object
+    long enter; ///< First frame inside
+    long exit; ///< Last frame inside
+    double heading; ///< Direction of motion when entering
+  };
+
+  std::vector<Visit> visits;
+  uint32_t index = 0;
+  for (const auto &object : scenario->GetObjects()) {
+    bool inside = false;
+    Visit visit{};
+    for (const auto &state : object->GetStates()) {
+      long frame = static_cast<long>(state.first);
+      if (frame < from_frame || frame > to_frame) continue;
+      const Eigen::Vector2d &velocity = state.second->GetVelocity();
+      const Eigen::Vector2d &position = state.second->GetPosition();
+      int64_t cell = CellKey(static_cast<int64_t>(std::floor(position.x() / kConflictCellSize)),
+                             static_cast<int64_t>(std::floor(position.y() / kConflictCellSize)));
+      bool moving = velocity.norm() > kMovingSpeed;
+      if (inside && moving && cell == visit.cell && frame == visit.exit + 1) {
+        visit.exit = frame;
+        continue;
+      }
+      if (inside) visits.push_back(visit);
+      inside = moving;
+      visit = {cell, index, frame, frame, std::atan2(velocity.y(), velocity.x())};
+    }
+    if (inside) visits.push_back(visit);
+    index++;
+  }
+  std::sort(visits.begin(), visits.end(), [](const Visit &a, const Visit &b) {
+    return a.cell < b.cell || (a.cell == b.cell && a.enter < b.enter);
+  });
+
+  // Pairs of visits of the same area by different objects on crossing paths
+  auto max_gap = static_cast<long>(std::ceil(kMaxPet * frames_per_second_));
+  std::vector<std::vector<Encroachment>> worker_encroachments(NumberOfWorkers());
+  ParallelFor(visits.size(), [&](size_t worker, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const Visit &first = visits[i];
+      for (size_t j = i + 1; j < visits.size() && visits[j].cell == first.cell; ++j) {
+        const Visit &second = visits[j];
+        if (second.enter - first.exit > max_gap) break;
+        if (second.object == first.object || CrossingAngle(first.heading, second.heading) < kMinConflictAngle) {
+          continue;
+        }
+        double pet = static_cast<double>(std::max(0L, second.enter - first.exit - 1)) / frames_per_second_;
+        worker_encroachments[worker].push_back({second.enter, ids_[first.object], ids_[second.object], pet});
+      }
+    }
+  });
+
+  // Keep the closest encroachment of every pair
+  for (auto &encroachments : worker_encroachments) {
+    encroachments_.insert(encroachments_.end(), encroachments.begin(), encroachments.end());
+  }
+  auto pair_of = [](const Encroachment &encroachment) {
+    return std::minmax(encroachment.first_id, encroachment.second_id);
+  };
+  std::sort(encroachments_.begin(), encroachments_.end(), [&](const Encroachment &a, const Encroachment &b) {
+    return pair_of(a) < pair_of(b) || (pair_of(a) == pair_of(b) && a.pet < b.pet);
+  });
+  encroachments_.erase(std::unique(encroachments_.begin(), encroachments_.end(),
+                                   [&](const Encroachment &a, const Encroachment &b) {
+                                     return pair_of(a) == pair_of(b);
+                                   }),
+                       encroachments_.end());
+  std::stable_sort(encroachments_.begin(), encroachments_.end(), [](const Encroachment &a, const Encroachment &b) {
+    return a.frame < b.frame;
+  });
+}
+
+double CriticalityMetrics::Distance(const std::array<Eigen::Vector2d, 4> &a, const std::array<Eigen::Vector2d, 4> &b) {
+  if (Overlap(a, b)) return 0.0;
+
+  // Separated convex polygons are closest between a corner and an edge
+  double distance = kInfinity;
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t k = 0; k < 4; ++k) {
+      distance = std::min(distance, SegmentDistance(a[i], b[k], b[(k + 1) % 4]));
+      distance = std::min(distance, SegmentDistance(b[i], a[k], a[(k + 1) % 4]));
+    }
+  }
+  return distance;
+}
+
+double CriticalityMetrics::TimeToCollision(const std::array<Eigen::Vector2d, 4> &a, const Eigen::Vector2d &velocity_a,
+                                           const std::array<Eigen::Vector2d, 4> &b,
+                                           const Eigen::Vector2d &velocity_b) {
+  if (Overlap(a, b)) return 0.0;
+
+  // The boxes touch once the relative motion carries the origin into the Minkowski difference of both boxes
+  std::vector<Eigen::Vector2d> points;
+  points.reserve(16);
+  for (const auto &corner_a : a) {
+    for (const auto &corner_b : b) {
+      points.emplace_back(corner_a - corner_b);
+    }
+  }
+  std::vector<Eigen::Vector2d> hull = ConvexHull(points);
+  Eigen::Vector2d direction = velocity_b - velocity_a;
+
+  // Clip the ray t * direction against every edge of the hull
+  double enter = 0.0;
+  double exit = kInfinity;
+  for (size_t i = 0; i < hull.size(); ++i) {
+    Eigen::Vector2d edge = hull[(i + 1) % hull.size()] - hull[i];
+    Eigen::Vector2d normal(edge.y(), -edge.x());
+    double distance = normal.dot(hull[i]);
+    double speed = normal.dot(direction);
+    if (speed == 0.0) {
+      if (distance < 0.0) return kInfinity;
+      continue;
+    }
+    double t = distance / speed;
+    if (speed < 0.0) enter = std::max(enter, t);
+    else exit = std::min(exit, t);
+    if (enter > exit) return kInfinity;
+  }
+  return enter;
+}
+
+std::vector<CriticalWindow> CriticalityMetrics::FindWindows(size_t length, size_t count) const {
+  std::vector<CriticalWindow> windows;
+  if (frames_.empty()) return windows;
+  length = std::clamp<size_t>(length, 1, frames_.size());
+
+  std::vector<size_t> critical(frames_.size() + 1, 0);
+  for (size_t frame = 0; frame < frames_.size(); ++frame) {
+    const auto &metrics = frames_[frame];
+    bool is_critical = metrics.min_ttc <= kCriticalTtc || metrics.min_pet <= kCriticalPet
+        || metrics.min_distance <= kCriticalDistance;
+    critical[frame + 1] = critical[frame] + (is_critical ? 1 : 0);
+  }
+
+  std::vector<uint8_t> taken(frames_.size(), 0);
+  while (windows.size() < count) {
+    size_t best_begin = 0;
+    size_t best = 0;
+    for (size_t begin = 0; begin + length <= frames_.size(); ++begin) {
+      size_t critical_frames = critical[begin + length] - critical[begin];
+      if (critical_frames <= best || taken[begin] || taken[begin + length - 1]) continue;
+      best_begin = begin;
+      best = critical_frames;
+    }
+    if (best == 0) break;
+
+    CriticalWindow window;
+    window.from_frame = frames_[best_begin].frame;
+    window.to_frame = frames_[best_begin + length - 1].frame;
+    window.critical_frames = best;
+    for (size_t frame = best_begin; frame < best_begin + length; ++frame) {
+      window.min_ttc = std::min(window.min_ttc, frames_[frame].min_ttc);
+      taken[frame] = 1;
+    }
+    windows.push_back(window);
+  }
+  return windows;
+}
+
+bool CriticalityMetrics::WriteCsv(const std::string &frames_file_path, const std::string &pairs_file_path) const {
+  std::ofstream frames(frames_file_path);
+  frames << "frame,objects,pairs,min_distance,min_ttc,min_pet\n";
+  for (const auto &frame : frames_) {
+    frames << frame.frame << "," << frame.objects << "," << frame.pairs << ",";
+    WriteMetric(frames, frame.min_distance);
+    frames << ",";
+    WriteMetric(frames, frame.min_ttc);
+    frames << ",";
+    WriteMetric(frames, frame.min_pet);
+    frames << "\n";
+  }
+
+  // Pairs and encroachments are both sorted by frame
+  std::ofstream pairs(pairs_file_path);
+  pairs << "frame,first_id,second_id,distance,ttc,pet\n";
+  auto pair = pairs_.begin();
+  auto encroachment = encroachments_.begin();
+  while (pair != pairs_.end() || encroachment != encroachments_.end()) {
+    if (encroachment == encroachments_.end() || (pair != pairs_.end() && pair->frame <= encroachment->frame)) {
+      pairs << pair->frame << "," << pair->first_id << "," << pair->second_id << "," << pair->distance << ",";
+      WriteMetric(pairs, pair->ttc);
+      pairs << ",\n";
+      ++pair;
+    }
+    else {
+      pairs << encroachment->frame << "," << encroachment->first_id << "," << encroachment->second_id << ",,,"
+            << encroachment->pet << "\n";
+      ++encroachment;
+    }
+  }
+  return static_cast<bool>(frames.flush()) && static_cast<bool>(pairs.flush());
+}
+
+const std::vector<FrameCriticality> &CriticalityMetrics::GetFrames() const {
+  return frames_;
+}
+
+const std::vector<PairCriticality> &CriticalityMetrics::GetPairs() const {
+  return pairs_;
+}
+
+const std::vector<Encroachment> &CriticalityMetrics::GetEncroachments() const {
+  return encroachments_;
+}
+
+}
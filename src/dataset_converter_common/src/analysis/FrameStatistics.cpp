@@ -0,0 +1,280 @@
+#include "dataset_converter_common/analysis/FrameStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "dataset_converter_common/analysis/OccupancyHistogram.h"
+#include "dataset_converter_common/analysis/ParallelFor.h"
+#include "dataset_converter_common/analysis/PlacementOptimizer.h"
+
+namespace dataset_converter_common {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr size_t kTypes = OccupancyHistogram::kNumberOfTypes;
+constexpr size_t kMaxCellsPerAxis = 1024; ///< Cells per axis before the cell size is increased
+
+}
+
+FrameCounts::FrameCounts(long first_frame, size_t frames, const std::vector<std::atomic<uint32_t>> &counts)
+    : first_frame_(first_frame), frames_(frames), prefix_((frames + 1) * kTypes, 0) {
+  for (size_t frame = 0; frame < frames_; ++frame) {
+    for (size_t type = 0; type < kTypes; ++type) {
+      prefix_[(frame + 1) * kTypes + type] =
+          prefix_[frame * kTypes + type] + counts[frame * kTypes + type].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+uint64_t FrameCounts::Sum(uint32_t type_mask, size_t begin, size_t end) const {
+  uint64_t sum = 0;
+  for (size_t type = 0; type < kTypes; ++type) {
+    if (type_mask & (1u << type)) sum += prefix_[end * kTypes + type] - prefix_[begin * kTypes + type];
+  }
+  return sum;
+}
+
+std::vector<FrameWindow> FrameCounts::FindWindows(size_t length,
+                                                  const std::vector<WindowRequirement> &requirements,
+                                                  size_t count) const {
+  std::vector<FrameWindow> windows;
+  if (frames_ == 0) return windows;
+  length = std::clamp<size_t>(length, 1, frames_);
+
+  auto meets_requirements = [&](size_t begin, size_t end) {
+    return std::all_of(requirements.begin(), requirements.end(), [&](const WindowRequirement &requirement) {
+      return static_cast<double>(Sum(requirement.type_mask, begin, end)) + 1e-9
+          >= requirement.min_count * static_cast<double>(length);
+    });
+  };
+  auto overlaps = [&](size_t begin, size_t end) {
+    return std::any_of(windows.begin(), windows.end(), [&](const FrameWindow &window) {
+      return static_cast<long>(begin) + first_frame_ <= window.to_frame
+          && window.from_frame < static_cast<long>(end) + first_frame_;
+    });
+  };
+
+  while (windows.size() < count) {
+    size_t best_begin = std::numeric_limits<size_t>::max();
+    uint64_t best = 0;
+    for (size_t begin = 0; begin + length <= frames_; ++begin) {
+      size_t end = begin + length;
+      uint64_t object_frames = Sum(OccupancyHistogram::kAllTypes, begin, end);
+      if (best_begin != std::numeric_limits<size_t>::max() && object_frames <= best) continue;
+      if (!meets_requirements(begin, end) || overlaps(begin, end)) continue;
+      best_begin = begin;
+      best = object_frames;
+    }
+    if (best_begin == std::numeric_limits<size_t>::max()) break;
+    windows.push_back({first_frame_ + static_cast<long>(best_begin),
+                       first_frame_ + static_cast<long>(best_begin + length) - 1, best});
+  }
+  return windows;
+}
+
+long FrameCounts::GetFirstFrame() const {
+  return first_frame_;
+}
+
+size_t FrameCounts::GetNumberOfFrames() const {
+  return frames_;
+}
+
+FrameStatistics::FrameStatistics(const cpm_scenario::ScenarioPtr &scenario, double cell_size) {
+  struct RawEntry {
+    Eigen::Vector2d position;
+    long frame;
+    uint32_t type_index;
+    uint32_t object;
+  };
+  std::vector<RawEntry> raw_entries;
+  Eigen::AlignedBox2d bounds;
+  long first_frame = std::numeric_limits<long>::max();
+  long last_frame = std::numeric_limits<long>::min();
+  for (const auto &object : scenario->GetObjects()) {
+    auto type_index = static_cast<uint32_t>(OccupancyHistogram::TypeIndex(object->GetType()));
+    auto object_index = static_cast<uint32_t>(objects_++);
+    for (const auto &state : object->GetStates()) {
+      raw_entries.push_back({state.second->GetPosition(), static_cast<long>(state.first), type_index, object_index});
+      bounds.extend(state.second->GetPosition());
+      first_frame = std::min(first_frame, raw_entries.back().frame);
+      last_frame = std::max(last_frame, raw_entries.back().frame);
+    }
+  }
+  if (raw_entries.empty()) return;
+
+  first_frame_ = first_frame;
+  frames_ = static_cast<size_t>(last_frame - first_frame) + 1;
+  counts_ = std::vector<std::atomic<uint32_t>>(frames_ * kTypes);
+  object_counts_ = std::vector<std::atomic<uint32_t>>(objects_);
+
+  Eigen::Vector2d extent = bounds.sizes();
+  origin_ = bounds.min();
+  cell_size_ = std::max(cell_size, extent.maxCoeff() / static_cast<double>(kMaxCellsPerAxis));
+  width_ = static_cast<size_t>(std::floor(extent.x() / cell_size_)) + 1;
+  height_ = static_cast<size_t>(std::floor(extent.y() / cell_size_)) + 1;
+
+  // Counting sort of the states by cell
+  auto cell_of = [this](const Eigen::Vector2d &position) {
+    Eigen::Vector2d cell = (position - origin_) / cell_size_;
+    auto x = std::min(width_ - 1, static_cast<size_t>(cell.x()));
+    auto y = std::min(height_ - 1, static_cast<size_t>(cell.y()));
+    return y * width_ + x;
+  };
+  cell_begin_.assign(width_ * height_ + 1, 0);
+  for (const auto &entry : raw_entries) {
+    cell_begin_[cell_of(entry.position) + 1]++;
+  }
+  for (size_t cell = 0; cell < width_ * height_; ++cell) {
+    cell_begin_[cell + 1] += cell_begin_[cell];
+  }
+  std::vector<size_t> next(cell_begin_.begin(), cell_begin_.end() - 1);
+  entries_.resize(raw_entries.size());
+  for (const auto &entry : raw_entries) {
+    entries_[next[cell_of(entry.position)]++] =
+        {entry.position, static_cast<uint32_t>(entry.frame - first_frame_), entry.type_index, entry.object};
+  }
+  inside_.assign(entries_.size(), 0);
+
+  // Nothing is inside yet, so the frame range only needs the totals
+  range_end_ = frames_;
+  states_in_range_ = entries_.size();
+  std::vector<uint8_t> has_states(objects_, 0);
+  for (const auto &entry : entries_) {
+    has_states[entry.object] = 1;
+  }
+  objects_in_range_ = static_cast<size_t>(std::count(has_states.begin(), has_states.end(), 1));
+}
+
+FrameStatistics::CellState FrameStatistics::Classify(size_t x, size_t y, const Eigen::Rotation2Dd &rotation,
+                                                     const Eigen::Vector2d &shift) const {
+  Eigen::AlignedBox2d area = PlacementOptimizer::LabArea();
+  Eigen::Vector2d lower = origin_ + Eigen::Vector2d(static_cast<double>(x), static_cast<double>(y)) * cell_size_;
+  const Eigen::Vector2d corners[] = {
+      lower,
+      lower + Eigen::Vector2d(cell_size_, 0.0),
+      lower + Eigen::Vector2d(0.0, cell_size_),
+      lower + Eigen::Vector2d(cell_size_, cell_size_),
+  };
+
+  // The area is convex, so a cell is inside if all its corners are
+  Eigen::AlignedBox2d transformed;
+  bool inside = true;
+  for (const auto &corner : corners) {
+    Eigen::Vector2d position = rotation * corner + shift;
+    transformed.extend(position);
+    inside = inside && area.contains(position);
+  }
+  if (inside) return CellState::kInside;
+  if (!transformed.intersects(area)) return CellState::kOutside;
+  return CellState::kPartial;
+}
+
+size_t FrameStatistics::SetTransformation(double shift_x, double shift_y, double rotation) {
+  Eigen::Rotation2Dd next_rotation(rotation * kPi / 180.0);
+  Eigen::Vector2d next_shift(shift_x, shift_y);
+  Eigen::AlignedBox2d area = PlacementOptimizer::LabArea();
+
+  std::atomic<size_t> tested{0};
+  std::atomic<long> retained_change{0};
+  ParallelFor(height_, [&](size_t, size_t begin, size_t end) {
+    size_t tested_by_worker = 0;
+    long retained_change_by_worker = 0;
+    for (size_t y = begin; y < end; ++y) {
+      for (size_t x = 0; x < width_; ++x) {
+        CellState next = Classify(x, y, next_rotation, next_shift);
+        if (has_transformation_) {
+          CellState previous = Classify(x, y, rotation_, shift_);
+          if (previous == next && next != CellState::kPartial) continue;
+        }
+        else if (next == CellState::kOutside) {
+          continue;
+        }
+
+        // Cells are owned by one worker, only the counts are shared
+        size_t cell = y * width_ + x;
+        for (size_t i = cell_begin_[cell]; i < cell_begin_[cell + 1]; ++i) {
+          const Entry &entry = entries_[i];
+          bool inside = next == CellState::kInside;
+          if (next == CellState::kPartial) {
+            inside = area.contains(next_rotation * entry.position + next_shift);
+            tested_by_worker++;
+          }
+          if (inside == static_cast<bool>(inside_[i])) continue;
+          inside_[i] = inside;
+          auto &count = counts_[entry.frame * kTypes + entry.type_index];
+          if (inside) count.fetch_add(1, std::memory_order_relaxed);
+          else count.fetch_sub(1, std::memory_order_relaxed);
+
+          // An object is retained while any of its states in the frame range is inside
+          if (entry.frame < range_begin_ || entry.frame >= range_end_) continue;
+          auto &object_count = object_counts_[entry.object];
+          if (inside && object_count.fetch_add(1, std::memory_order_relaxed) == 0) retained_change_by_worker++;
+          if (!inside && object_count.fetch_sub(1, std::memory_order_relaxed) == 1) retained_change_by_worker--;
+        }
+      }
+    }
+    tested.fetch_add(tested_by_worker, std::memory_order_relaxed);
+    retained_change.fetch_add(retained_change_by_worker, std::memory_order_relaxed);
+  });
+  retained_objects_ = static_cast<size_t>(static_cast<long>(retained_objects_) + retained_change.load());
+
+  rotation_ = next_rotation;
+  shift_ = next_shift;
+  has_transformation_ = true;
+  return tested.load();
+}
+
+void FrameStatistics::SetFrameRange(long from_frame, long to_frame) {
+  long last_frame = first_frame_ + static_cast<long>(frames_) - 1;
+  if (to_frame == 0 || to_frame > last_frame) to_frame = last_frame;
+  from_frame = std::max(from_frame, first_frame_);
+  size_t range_begin = std::min(frames_, static_cast<size_t>(std::max(0L, from_frame - first_frame_)));
+  size_t range_end = std::max(range_begin, static_cast<size_t>(std::max(0L, to_frame - first_frame_ + 1)));
+  range_end = std::min(range_end, frames_);
+  if (range_begin == range_begin_ && range_end == range_end_) return;
+  range_begin_ = range_begin;
+  range_end_ = range_end;
+
+  std::vector<uint8_t> has_states(objects_, 0);
+  std::vector<uint32_t> object_counts(objects_, 0);
+  states_in_range_ = 0;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const Entry &entry = entries_[i];
+    if (entry.frame < range_begin_ || entry.frame >= range_end_) continue;
+    states_in_range_++;
+    has_states[entry.object] = 1;
+    if (inside_[i]) object_counts[entry.object]++;
+  }
+
+  objects_in_range_ = 0;
+  retained_objects_ = 0;
+  for (size_t object = 0; object < objects_; ++object) {
+    object_counts_[object].store(object_counts[object], std::memory_order_relaxed);
+    objects_in_range_ += has_states[object];
+    if (object_counts[object] > 0) retained_objects_++;
+  }
+}
+
+Retention FrameStatistics::GetRetention() const {
+  Retention retention;
+  retention.objects = retained_objects_;
+  retention.total_objects = objects_in_range_;
+  retention.total_states = states_in_range_;
+  for (size_t i = range_begin_ * kTypes; i < range_end_ * kTypes; ++i) {
+    retention.states += counts_[i].load(std::memory_order_relaxed);
+  }
+  return retention;
+}
+
+FrameCountsPtr FrameStatistics::GetCounts() const {
+  return std::make_shared<const FrameCounts>(first_frame_, frames_, counts_);
+}
+
+size_t FrameStatistics::GetNumberOfStates() const {
+  return entries_.size();
+}
+
+}
@@ -0,0 +1,306 @@
+#include "dataset_converter_common/analysis/LaneExtractor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+
+#include "dataset_converter_common/analysis/FrameGrid.h"
+#include "dataset_converter_common/analysis/OccupancyHistogram.h"
+#include "dataset_converter_common/analysis/ParallelFor.h"
+
+namespace dataset_converter_common {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kMergeCellSize = 0.5; ///< Edge length of the cells samples are merged in
+constexpr int kHeadingBins = 16; ///< Number of heading ranges samples are merged in
+constexpr long kLookback = 4; ///< Steps after which a lane counts its own points as foreign
+constexpr double kSimplifyTolerance = 0.2; ///< Largest distance of a removed vertex from the simplified line
+
+// Douglas Peucker simplification of the vertices between first and last
+void Simplify(const std::vector<Eigen::Vector2d> &line, size_t first, size_t last, std::vector<uint8_t> &keep) {
+  Eigen::Vector2d segment = line[last] - line[first];
+  double length = segment.norm();
+  double largest = 0.0;
+  size_t index = first;
+  for (size_t i = first + 1; i < last; ++i) {
+    Eigen::Vector2d offset = line[i] - line[first];
+    double distance = length > 0.0 ? std::abs(segment.x() * offset.y() - segment.y() * offset.x()) / length
+                                   : offset.norm();
+    if (distance > largest) {
+      largest = distance;
+      index = i;
+    }
+  }
+  if (largest <= kSimplifyTolerance) return;
+  keep[index] = 1;
+  Simplify(line, first, index, keep);
+  Simplify(line, index, last, keep);
+}
+
+}
+
+template<typename Function>
+void LaneExtractor::ForEachNeighbour(const Eigen::Vector2d &position, const Eigen::Vector2d &direction,
+                                     Function &&function) const {
+  double min_alignment = std::cos(kHeadingTolerance);
+  auto x = static_cast<int64_t>(std::floor(position.x() / kSearchRadius));
+  auto y = static_cast<int64_t>(std::floor(position.y() / kSearchRadius));
+  for (int64_t dx = -1; dx <= 1; ++dx) {
+    for (int64_t dy = -1; dy <= 1; ++dy) {
+      auto key = CellKey(x + dx, y + dy);
+      auto range = std::equal_range(cells_.begin(), cells_.end(), std::make_pair(key, uint32_t(0)),
+                                    [](const auto &l, const auto &r) { return l.first < r.first; });
+      for (auto it = range.first; it != range.second; ++it) {
+        const Point &point = points_[it->second];
+        if ((point.position - position).squaredNorm() > kSearchRadius * kSearchRadius) continue;
+        if (point.direction.dot(direction) < min_alignment) continue;
+        function(it->second);
+      }
+    }
+  }
+}
+
+LaneExtractor::LaneExtractor(const cpm_scenario::ScenarioPtr &scenario,
+                             double shift_x,
+                             double shift_y,
+                             double rotation,
+                             const Eigen::AlignedBox2d &area,
+                             double lane_width,
+                             uint32_t types)
+    : lane_width_(lane_width) {
+  Eigen::Rotation2Dd transform(rotation * kPi / 180.0);
+  Eigen::Vector2d shift(shift_x, shift_y);
+  const auto &objects = scenario->GetObjects();
+
+  // A sample every meter driven with the heading of the way since the last sample
+  struct Sample {
+    std::tuple<int64_t, int64_t, int> key;
+    Eigen::Vector2d position;
+    Eigen::Vector2d direction;
+  };
+  std::vector<std::vector<Sample>> worker_samples(NumberOfWorkers());
+  ParallelFor(objects.size(), [&](size_t worker, size_t begin, size_t end) {
+    auto &samples = worker_samples[worker];
+    for (size_t i = begin; i < end; ++i) {
+      if (!(types & (1u << OccupancyHistogram::TypeIndex(objects[i]->GetType())))) continue;
+      bool first = true;
+      Eigen::Vector2d last = Eigen::Vector2d::Zero();
+      for (const auto &state : objects[i]->GetStates()) {
+        Eigen::Vector2d position = transform * state.second->GetPosition() + shift;
+        if (first) {
+          last = position;
+          first = false;
+          continue;
+        }
+        double distance = (position - last).norm();
+        if (distance < kSampleSpacing) continue;
+        Eigen::Vector2d direction = (position - last) / distance;
+        last = position;
+        if (!area.contains(position)) continue;
+        double heading = std::atan2(direction.y(), direction.x());
+        int bin = static_cast<int>(std::floor((heading + kPi) / (2.0 * kPi) * kHeadingBins)) % kHeadingBins;
+        samples.push_back({{static_cast<int64_t>(std::floor(position.x() / kMergeCellSize)),
+                            static_cast<int64_t>(std::floor(position.y() / kMergeCellSize)), bin},
+                           position, direction});
+      }
+    }
+  });
+  std::vector<Sample> samples;
+  for (auto &worker : worker_samples) {
+    samples.insert(samples.end(), worker.begin(), worker.end());
+  }
+  if (samples.empty()) return;
+
+  // Samples of the same cell and heading become one point
+  std::sort(samples.begin(), samples.end(), [](const Sample &a, const Sample &b) { return a.key < b.key; });
+  for (size_t begin = 0; begin < samples.size();) {
+    size_t end = begin;
+    Point point{Eigen::Vector2d::Zero(), Eigen::Vector2d::Zero(), 0.0};
+    for (; end < samples.size() && samples[end].key == samples[begin].key; ++end) {
+      point.position += samples[end].position;
+      point.direction += samples[end].direction;
+      point.weight += 1.0;
+    }
+    point.position /= point.weight;
+    if (point.direction.norm() > 0.0) {
+      point.direction.normalize();
+      points_.push_back(point);
+    }
+    begin = end;
+  }
+
+  // Mean shift perpendicular to the heading collapses the points of a lane onto its center line
+  std::vector<Eigen::Vector2d> shifted(points_.size());
+  for (size_t iteration = 0; iteration < kIterations; ++iteration) {
+    BuildGrid();
+    ParallelFor(points_.size(), [&](size_t, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        const Point &point = points_[i];
+        Neighbourhood neighbourhood = Average(point.position, point.direction);
+        Eigen::Vector2d normal(-point.direction.y(), point.direction.x());
+        shifted[i] = point.position + normal * normal.dot(neighbourhood.position - point.position);
+      }
+    });
+    for (size_t i = 0; i < points_.size(); ++i) {
+      points_[i].position = shifted[i];
+    }
+  }
+  BuildGrid();
+
+  // Densest points first
+  std::vector<double> support(points_.size());
+  ParallelFor(points_.size(), [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      support[i] = Average(points_[i].position, points_[i].direction).weight;
+    }
+  });
+  std::vector<uint32_t> order(points_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return support[a] > support[b]; });
+
+  // Trace a lane through every dense point that is not part of a lane yet
+  auto max_steps = static_cast<size_t>(4.0 * area.diagonal().norm() / kSampleSpacing) + 1;
+  std::vector<int32_t> owner(points_.size(), -1);
+  std::vector<long> mark(points_.size(), 0);
+  std::vector<std::vector<Eigen::Vector2d>> centers;
+  std::vector<bool> connectors;
+  for (uint32_t seed : order) {
+    if (support[seed] < kMinSupport) break;
+    if (owner[seed] != -1) continue;
+    auto lane = static_cast<int32_t>(centers.size());
+    const Point &start = points_[seed];
+    ForEachNeighbour(start.position, start.direction, [&](uint32_t i) {
+      if (owner[i] == -1) {
+        owner[i] = lane;
+        mark[i] = 0;
+      }
+    });
+    bool joins_successor;
+    bool joins_predecessor;
+    auto forward = Walk(start.position, start.direction, 1, lane, max_steps, owner, mark, joins_successor);
+    auto backward = Walk(start.position, start.direction, -1, lane, max_steps, owner, mark, joins_predecessor);
+    std::vector<Eigen::Vector2d> center(backward.rbegin(), backward.rend());
+    center.push_back(start.position);
+    center.insert(center.end(), forward.begin(), forward.end());
+    centers.push_back(std::move(center));
+    connectors.push_back(joins_successor && joins_predecessor);
+  }
+
+  // Short lanes are noise unless they connect two lanes, their points stay claimed so no lane is traced through them
+  // again
+  std::vector<double> weights(centers.size(), 0.0);
+  for (size_t i = 0; i < points_.size(); ++i) {
+    if (owner[i] != -1) weights[owner[i]] += points_[i].weight;
+  }
+  for (size_t lane = 0; lane < centers.size(); ++lane) {
+    const auto &center = centers[lane];
+    double length = 0.0;
+    for (size_t i = 1; i < center.size(); ++i) {
+      length += (center[i] - center[i - 1]).norm();
+    }
+    if (length >= kMinLength || (connectors[lane] && length >= kSearchRadius)) {
+      lanes_.push_back(Fit(center, weights[lane]));
+    }
+  }
+  std::stable_sort(lanes_.begin(), lanes_.end(),
+                   [](const ExtractedLane &a, const ExtractedLane &b) { return a.support > b.support; });
+}
+
+void LaneExtractor::BuildGrid() {
+  cells_.resize(points_.size());
+  for (size_t i = 0; i < points_.size(); ++i) {
+    cells_[i] = {CellKey(static_cast<int64_t>(std::floor(points_[i].position.x() / kSearchRadius)),
+                         static_cast<int64_t>(std::floor(points_[i].position.y() / kSearchRadius))),
+                 static_cast<uint32_t>(i)};
+  }
+  std::sort(cells_.begin(), cells_.end());
+}
+
+LaneExtractor::Neighbourhood LaneExtractor::Average(const Eigen::Vector2d &position,
+                                                    const Eigen::Vector2d &direction) const {
+  Neighbourhood neighbourhood;
+  ForEachNeighbour(position, direction, [&](uint32_t i) {
+    const Point &point = points_[i];
+    neighbourhood.position += point.weight * point.position;
+    neighbourhood.direction += point.weight * point.direction;
+    neighbourhood.weight += point.weight;
+  });
+  if (neighbourhood.weight > 0.0) neighbourhood.position /= neighbourhood.weight;
+  return neighbourhood;
+}
+
+std::vector<Eigen::Vector2d> LaneExtractor::Walk(const Eigen::Vector2d &start,
+                                                 const Eigen::Vector2d &direction,
+                                                 int sign,
+                                                 int32_t lane,
+                                                 size_t max_steps,
+                                                 std::vector<int32_t> &owner,
+                                                 std::vector<long> &mark,
+                                                 bool &joined) const {
+  joined = false;
+  std::vector<Eigen::Vector2d> vertices;
+  Eigen::Vector2d position = start;
+  Eigen::Vector2d heading = direction;
+  for (size_t step = 1; step <= max_steps; ++step) {
+    Eigen::Vector2d ahead = position + sign * kSampleSpacing * heading;
+    Neighbourhood neighbourhood = Average(ahead, heading);
+    if (neighbourhood.weight < kMinSupport || neighbourhood.direction.norm() <= 0.0) break;
+    heading = neighbourhood.direction.normalized();
+    Eigen::Vector2d normal(-heading.y(), heading.x());
+    position = ahead + normal * normal.dot(neighbourhood.position - ahead);
+    vertices.push_back(position);
+
+    // Points of other lanes, or of this lane from long ago, mean the lane joins a lane traced before
+    long current = sign * static_cast<long>(step);
+    double foreign = 0.0;
+    double total = 0.0;
+    ForEachNeighbour(position, heading, [&](uint32_t i) {
+      total += points_[i].weight;
+      if (owner[i] == -1) {
+        owner[i] = lane;
+        mark[i] = current;
+      }
+      else if (owner[i] != lane || std::abs(mark[i] - current) > kLookback) {
+        foreign += points_[i].weight;
+      }
+    });
+    if (foreign > 0.5 * total) {
+      joined = true;
+      break;
+    }
+  }
+  return vertices;
+}
+
+ExtractedLane LaneExtractor::Fit(const std::vector<Eigen::Vector2d> &center, double support) const {
+  std::vector<uint8_t> keep(center.size(), 0);
+  keep.front() = 1;
+  keep.back() = 1;
+  Simplify(center, 0, center.size() - 1, keep);
+
+  ExtractedLane lane;
+  lane.support = support;
+  for (size_t i = 0; i < center.size(); ++i) {
+    if (keep[i]) lane.center.push_back(center[i]);
+  }
+
+  // The y axis points down, so the left side is clockwise of the driving direction
+  for (size_t i = 0; i < lane.center.size(); ++i) {
+    const Eigen::Vector2d &previous = lane.center[i == 0 ? 0 : i - 1];
+    const Eigen::Vector2d &next = lane.center[std::min(i + 1, lane.center.size() - 1)];
+    Eigen::Vector2d direction = (next - previous).normalized();
+    Eigen::Vector2d left(direction.y(), -direction.x());
+    lane.left.push_back(lane.center[i] + left * lane_width_ / 2.0);
+    lane.right.push_back(lane.center[i] - left * lane_width_ / 2.0);
+  }
+  return lane;
+}
+
+const std::vector<ExtractedLane> &LaneExtractor::GetLanes() const {
+  return lanes_;
+}
+
+}
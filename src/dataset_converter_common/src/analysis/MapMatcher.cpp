@@ -0,0 +1,307 @@
+#include "dataset_converter_common/analysis/MapMatcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+
+#include "dataset_converter_common/analysis/ParallelFor.h"
+
+namespace dataset_converter_common {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kMinDeviation = 0.5; ///< Smallest lateral deviation of a state on a narrow lane in meters
+constexpr double kHeadingDeviation = 0.5; ///< Deviation of the orientation from the lane direction in radians
+constexpr double kRouteDeviation = 1.0; ///< Difference of driven and straight distance per unit of cost in meters
+constexpr double kLaneChangeCost = 3.0; ///< Cost of changing to a lane that is not a successor
+constexpr double kOffMapCost = 4.5; ///< Cost of a state off the map, a state three deviations away
+
+// Vertices at equal distances along a polyline
+std::vector<Eigen::Vector2d> Resample(const std::vector<Eigen::Vector2d> &polyline, size_t count) {
+  std::vector<double> distance(polyline.size(), 0.0);
+  for (size_t i = 1; i < polyline.size(); ++i) {
+    distance[i] = distance[i - 1] + (polyline[i] - polyline[i - 1]).norm();
+  }
+  std::vector<Eigen::Vector2d> resampled(count);
+  size_t segment = 0;
+  for (size_t k = 0; k < count; ++k) {
+    double target = distance.back() * static_cast<double>(k) / static_cast<double>(count - 1);
+    while (segment + 2 < polyline.size() && distance[segment + 1] < target) segment++;
+    double length = distance[segment + 1] - distance[segment];
+    double t = length > 0.0 ? std::clamp((target - distance[segment]) / length, 0.0, 1.0) : 0.0;
+    resampled[k] = polyline[segment] + t * (polyline[segment + 1] - polyline[segment]);
+  }
+  return resampled;
+}
+
+}
+
+template<typename Function>
+void MapMatcher::Query(const Eigen::AlignedBox2d &box, Function &&function) const {
+  if (nodes_.empty()) return;
+  std::vector<uint32_t> stack = {static_cast<uint32_t>(nodes_.size() - 1)};
+  while (!stack.empty()) {
+    const Node &node = nodes_[stack.back()];
+    stack.pop_back();
+    for (uint32_t i = node.begin; i < node.end; ++i) {
+      uint32_t child = children_[i];
+      if (node.leaf) {
+        if (segments_[child].bounds.intersects(box)) function(child);
+      }
+      else if (nodes_[child].bounds.intersects(box)) {
+        stack.push_back(child);
+      }
+    }
+  }
+}
+
+MapMatcher::MapMatcher(const std::vector<MapLanelet> &lanelets) {
+  for (const auto &lanelet : lanelets) {
+    if (lanelet.left.size() < 2 || lanelet.right.size() < 2) continue;
+    size_t count = std::max(lanelet.left.size(), lanelet.right.size());
+    auto left = Resample(lanelet.left, count);
+    auto right = Resample(lanelet.right, count);
+
+    Lane lane{lanelet.id, {}, {}, {}, 0.0, {}};
+    double side = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+      lane.center.push_back((left[i] + right[i]) / 2.0);
+      lane.half_width.push_back((left[i] - right[i]).norm() / 2.0);
+      lane.arc_length.push_back(i == 0 ? 0.0 : lane.arc_length.back() + (lane.center[i] - lane.center[i - 1]).norm());
+      if (i > 0) {
+        Eigen::Vector2d direction = lane.center[i] - lane.center[i - 1];
+        Eigen::Vector2d offset = left[i] - lane.center[i];
+        side += direction.x() * offset.y() - direction.y() * offset.x();
+      }
+    }
+    if (lane.arc_length.back() <= 0.0) continue;
+    lane.left_sign = side >= 0.0 ? 1.0 : -1.0;
+
+    auto index = static_cast<uint32_t>(lanes_.size());
+    for (size_t i = 0; i + 1 < count; ++i) {
+      Eigen::AlignedBox2d bounds(lane.center[i]);
+      for (const auto &vertex : {lane.center[i + 1], left[i], left[i + 1], right[i], right[i + 1]}) {
+        bounds.extend(vertex);
+      }
+      segments_.push_back({bounds, index, static_cast<uint32_t>(i)});
+    }
+    lanes_.push_back(std::move(lane));
+  }
+  if (segments_.empty()) return;
+
+  // Sort tile recursive packing, level by level until a single root is left
+  std::vector<uint32_t> level(segments_.size());
+  std::iota(level.begin(), level.end(), 0);
+  bool leaf = true;
+  do {
+    auto center = [this, leaf](uint32_t i) {
+      return (leaf ? segments_[i].bounds : nodes_[i].bounds).center();
+    };
+    size_t pages = (level.size() + kNodeCapacity - 1) / kNodeCapacity;
+    auto slices = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(pages))));
+    size_t slice_size = ((pages + slices - 1) / slices) * kNodeCapacity;
+    std::sort(level.begin(), level.end(), [&](uint32_t a, uint32_t b) { return center(a).x() < center(b).x(); });
+    for (size_t begin = 0; begin < level.size(); begin += slice_size) {
+      size_t end = std::min(level.size(), begin + slice_size);
+      std::sort(level.begin() + static_cast<long>(begin), level.begin() + static_cast<long>(end),
+                [&](uint32_t a, uint32_t b) { return center(a).y() < center(b).y(); });
+    }
+
+    std::vector<uint32_t> parents;
+    for (size_t begin = 0; begin < level.size(); begin += kNodeCapacity) {
+      size_t end = std::min(level.size(), begin + kNodeCapacity);
+      Node node{Eigen::AlignedBox2d(), static_cast<uint32_t>(children_.size()), 0, leaf};
+      for (size_t i = begin; i < end; ++i) {
+        children_.push_back(level[i]);
+        node.bounds.extend(leaf ? segments_[level[i]].bounds : nodes_[level[i]].bounds);
+      }
+      node.end = static_cast<uint32_t>(children_.size());
+      parents.push_back(static_cast<uint32_t>(nodes_.size()));
+      nodes_.push_back(node);
+    }
+    level = std::move(parents);
+    leaf = false;
+  } while (level.size() > 1);
+
+  // Lanes continue into the lanes whose center line starts where their center line ends
+  Eigen::Vector2d gap = Eigen::Vector2d::Constant(kConnectionDistance);
+  for (uint32_t index = 0; index < lanes_.size(); ++index) {
+    Lane &lane = lanes_[index];
+    const Eigen::Vector2d &end = lane.center.back();
+    Query(Eigen::AlignedBox2d(end - gap, end + gap), [&](uint32_t s) {
+      const Segment &segment = segments_[s];
+      if (segment.index != 0 || segment.lane == index) return;
+      if ((lanes_[segment.lane].center.front() - end).norm() <= kConnectionDistance) {
+        lane.successors.push_back(segment.lane);
+      }
+    });
+  }
+}
+
+void MapMatcher::FindCandidates(const Eigen::Vector2d &position, double orientation,
+                                std::vector<Candidate> &candidates) const {
+  candidates.clear();
+  Eigen::Vector2d radius = Eigen::Vector2d::Constant(kSearchRadius);
+  Query(Eigen::AlignedBox2d(position - radius, position + radius), [&](uint32_t s) {
+    const Segment &segment = segments_[s];
+    const Lane &lane = lanes_[segment.lane];
+    const Eigen::Vector2d &begin = lane.center[segment.index];
+    Eigen::Vector2d direction = lane.center[segment.index + 1] - begin;
+    double length = direction.norm();
+    if (length <= 0.0) return;
+
+    // Closest point of the segment
+    double t = std::clamp((position - begin).dot(direction) / (length * length), 0.0, 1.0);
+    Eigen::Vector2d offset = position - (begin + t * direction);
+    double distance = offset.norm();
+    double half_width = lane.half_width[segment.index]
+        + t * (lane.half_width[segment.index + 1] - lane.half_width[segment.index]);
+    if (distance > half_width + kSearchRadius) return;
+
+    double deviation = std::max(half_width, kMinDeviation);
+    double heading = std::remainder(orientation - std::atan2(direction.y(), direction.x()), 2.0 * kPi);
+    double cost = 0.5 * (distance / deviation) * (distance / deviation)
+        + 0.5 * (heading / kHeadingDeviation) * (heading / kHeadingDeviation);
+    double side = direction.x() * offset.y() - direction.y() * offset.x();
+    Candidate candidate{segment.lane, lane.arc_length[segment.index] + t * length,
+                        side * lane.left_sign >= 0.0 ? distance : -distance, cost};
+
+    // Only the closest segment of every lane is a candidate
+    auto existing = std::find_if(candidates.begin(), candidates.end(),
+                                 [&](const Candidate &other) { return other.lane == segment.lane; });
+    if (existing == candidates.end()) candidates.push_back(candidate);
+    else if (cost < existing->cost) *existing = candidate;
+  });
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate &a, const Candidate &b) { return a.cost < b.cost; });
+  if (candidates.size() > kMaxCandidates) candidates.resize(kMaxCandidates);
+  candidates.push_back({kOffMap, 0.0, 0.0, kOffMapCost});
+}
+
+double MapMatcher::TransitionCost(const Candidate &from, const Candidate &to, double distance) const {
+  if (from.lane == kOffMap || to.lane == kOffMap) return from.lane == to.lane ? 0.0 : kLaneChangeCost;
+
+  // Distance driven along the map, lanes that are not connected are reached by the straight line
+  const Lane &lane = lanes_[from.lane];
+  double route = distance;
+  double cost = 0.0;
+  if (from.lane == to.lane) {
+    route = to.arc_length - from.arc_length;
+  }
+  else if (std::find(lane.successors.begin(), lane.successors.end(), to.lane) != lane.successors.end()) {
+    route = lane.arc_length.back() - from.arc_length + to.arc_length;
+  }
+  else {
+    cost = kLaneChangeCost;
+  }
+  return cost + std::abs(distance - route) / kRouteDeviation;
+}
+
+void MapMatcher::MatchObject(const cpm_scenario::ExtendedObject &object, std::vector<LaneletMatch> &matches) const {
+  const auto &states = object.GetStates();
+  if (states.empty()) return;
+
+  // Viterbi, cost of the best path ending in every candidate and the candidate before it
+  std::vector<std::vector<Candidate>> candidates(states.size());
+  std::vector<std::vector<double>> cost(states.size());
+  std::vector<std::vector<uint32_t>> previous(states.size());
+  std::vector<long> frames;
+  Eigen::Vector2d last_position = Eigen::Vector2d::Zero();
+  size_t step = 0;
+  for (const auto &state : states) {
+    Eigen::Vector2d position = state.second->GetPosition();
+    frames.push_back(static_cast<long>(state.first));
+    FindCandidates(position, state.second->GetOrientation(), candidates[step]);
+    const auto &current = candidates[step];
+    cost[step].resize(current.size());
+    previous[step].resize(current.size(), 0);
+    double distance = (position - last_position).norm();
+    for (size_t k = 0; k < current.size(); ++k) {
+      double best = 0.0;
+      if (step > 0) {
+        best = std::numeric_limits<double>::infinity();
+        for (size_t j = 0; j < candidates[step - 1].size(); ++j) {
+          double path = cost[step - 1][j] + TransitionCost(candidates[step - 1][j], current[k], distance);
+          if (path < best) {
+            best = path;
+            previous[step][k] = static_cast<uint32_t>(j);
+          }
+        }
+      }
+      cost[step][k] = best + current[k].cost;
+    }
+    last_position = position;
+    step++;
+  }
+
+  auto index = static_cast<uint32_t>(std::min_element(cost.back().begin(), cost.back().end()) - cost.back().begin());
+  size_t first = matches.size();
+  matches.resize(first + states.size());
+  for (size_t s = states.size(); s-- > 0;) {
+    const Candidate &candidate = candidates[s][index];
+    bool on_map = candidate.lane != kOffMap;
+    matches[first + s] = {static_cast<long>(object.GetId()), frames[s], on_map ? lanes_[candidate.lane].id : 0,
+                          candidate.arc_length, candidate.lateral};
+    index = previous[s][index];
+  }
+}
+
+std::vector<LaneletMatch> MapMatcher::Match(const cpm_scenario::ScenarioPtr &scenario) const {
+  const auto &objects = scenario->GetObjects();
+  std::vector<std::vector<LaneletMatch>> object_matches(objects.size());
+  ParallelFor(objects.size(), [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      MatchObject(*objects[i], object_matches[i]);
+    }
+  });
+
+  std::vector<LaneletMatch> matches;
+  for (const auto &object : object_matches) {
+    matches.insert(matches.end(), object.begin(), object.end());
+  }
+  return matches;
+}
+
+bool MapMatcher::WriteCsv(const std::string &file_path, const std::vector<LaneletMatch> &matches) {
+  std::ofstream stream(file_path);
+  stream << "object_id,frame,lanelet_id,arc_length,lateral\n";
+  for (const auto &match : matches) {
+    stream << match.object_id << "," << match.frame << ",";
+    if (match.lanelet_id != 0) stream << match.lanelet_id << "," << match.arc_length << "," << match.lateral;
+    else stream << ",,";
+    stream << "\n";
+  }
+  return static_cast<bool>(stream.flush());
+}
+
+cpm_scenario::ScenarioPtr MapMatcher::Restrict(const cpm_scenario::ScenarioPtr &scenario,
+                                               std::vector<LaneletMatch> &matches,
+                                               const std::vector<long> &lanelet_ids) {
+  std::unordered_set<long> lanelets(lanelet_ids.begin(), lanelet_ids.end());
+  std::unordered_set<long> objects;
+  for (const auto &match : matches) {
+    if (lanelets.count(match.lanelet_id)) objects.insert(match.object_id);
+  }
+  matches.erase(std::remove_if(matches.begin(), matches.end(),
+                               [&](const LaneletMatch &match) { return !objects.count(match.object_id); }),
+                matches.end());
+
+  auto restricted = std::make_shared<cpm_scenario::Scenario>(scenario->GetName());
+  restricted->SetNumberOfFrames(scenario->GetNumberOfFrames());
+  restricted->SetBackgroundImageSourcePath(scenario->GetBackgroundImageSourcePath());
+  restricted->SetBackgroundImageScaleFactor(scenario->GetBackgroundImageScaleFactor());
+  for (const auto &object : scenario->GetObjects()) {
+    if (objects.count(static_cast<long>(object->GetId()))) restricted->AddObject(object);
+  }
+  return restricted;
+}
+
+bool MapMatcher::IsEmpty() const {
+  return lanes_.empty();
+}
+
+}
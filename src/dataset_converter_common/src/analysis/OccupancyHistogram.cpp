@@ -0,0 +1,135 @@
+#include "dataset_converter_common/analysis/OccupancyHistogram.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <utility>
+
+#include "dataset_converter_common/analysis/ParallelFor.h"
+
+namespace dataset_converter_common {
+
+OccupancyHistogram::OccupancyHistogram(Eigen::Vector2d origin, double cell_size, size_t width, size_t height)
+    : origin_(std::move(origin)),
+      cell_size_(cell_size),
+      width_(width),
+      height_(height),
+      bins_(kNumberOfTypes * width * height, 0),
+      maxima_(kNumberOfTypes, 0) {}
+
+OccupancyHistogram OccupancyHistogram::ForScenario(const cpm_scenario::ScenarioPtr &scenario,
+                                                   double cell_size,
+                                                   size_t max_cells_per_axis) {
+  Eigen::AlignedBox2d bounds;
+  for (const auto &object : scenario->GetObjects()) {
+    for (const auto &state : object->GetStates()) {
+      bounds.extend(state.second->GetPosition());
+    }
+  }
+  if (bounds.isEmpty()) return {};
+
+  // Grow cells until the grid is small enough
+  Eigen::Vector2d extent = bounds.sizes();
+  double required_cell_size = extent.maxCoeff() / static_cast<double>(std::max<size_t>(1, max_cells_per_axis));
+  cell_size = std::max(cell_size, required_cell_size);
+  auto width = static_cast<size_t>(std::floor(extent.x() / cell_size)) + 1;
+  auto height = static_cast<size_t>(std::floor(extent.y() / cell_size)) + 1;
+  return {bounds.min(), cell_size, width, height};
+}
+
+size_t OccupancyHistogram::TypeIndex(cpm_scenario::ExtendedObjectType type) {
+  switch (type) {
+    case cpm_scenario::ExtendedObjectType::CAR: return 0;
+    case cpm_scenario::ExtendedObjectType::PEDESTRIAN: return 1;
+    case cpm_scenario::ExtendedObjectType::BICYCLE_MOTORCYCLES: return 2;
+    case cpm_scenario::ExtendedObjectType::TRUCK_BUS: return 3;
+    case cpm_scenario::ExtendedObjectType::VAN: return 4;
+    case cpm_scenario::ExtendedObjectType::TRAILER: return 5;
+    case cpm_scenario::ExtendedObjectType::UNKNOWN: return 6;
+  }
+  return 6;
+}
+
+bool OccupancyHistogram::Build(const cpm_scenario::ScenarioPtr &scenario,
+                               size_t passes,
+                               const ProgressCallback &callback) {
+  passes_ = std::max<size_t>(1, passes);
+  completed_passes_ = 0;
+  std::fill(bins_.begin(), bins_.end(), 0);
+  std::fill(maxima_.begin(), maxima_.end(), 0);
+  if (bins_.empty()) return true;
+
+  std::vector<cpm_scenario::ExtendedObjectPtr> objects;
+  for (const auto &object : scenario->GetObjects()) {
+    objects.push_back(object);
+  }
+
+  // Cells are rarely hit by two workers at once, so relaxed atomics are cheaper than per worker histograms
+  std::vector<std::atomic<uint32_t>> accumulator(bins_.size());
+  size_t cells = width_ * height_;
+  for (size_t pass = 0; pass < passes_; ++pass) {
+    ParallelFor(objects.size(), [&](size_t, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        const auto &object = objects[i];
+        size_t type_offset = TypeIndex(object->GetType()) * cells;
+        size_t state_index = 0;
+        for (const auto &state : object->GetStates()) {
+          if (state_index++ % passes_ != pass) continue;
+          Eigen::Vector2d cell = (state.second->GetPosition() - origin_) / cell_size_;
+          if (cell.x() < 0 || cell.y() < 0) continue;
+          auto x = static_cast<size_t>(cell.x());
+          auto y = static_cast<size_t>(cell.y());
+          if (x >= width_ || y >= height_) continue;
+          accumulator[type_offset + y * width_ + x].fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+
+    // Publish a consistent snapshot for the callback
+    for (size_t i = 0; i < bins_.size(); ++i) {
+      bins_[i] = accumulator[i].load(std::memory_order_relaxed);
+      maxima_[i / cells] = std::max(maxima_[i / cells], bins_[i]);
+    }
+    completed_passes_ = pass + 1;
+    if (callback && !callback(*this)) return false;
+  }
+  return true;
+}
+
+uint32_t OccupancyHistogram::GetCount(size_t type_index, size_t x, size_t y) const {
+  return bins_[(type_index * height_ + y) * width_ + x];
+}
+
+uint32_t OccupancyHistogram::GetCount(size_t x, size_t y, uint32_t type_mask) const {
+  uint32_t count = 0;
+  for (size_t type_index = 0; type_index < kNumberOfTypes; ++type_index) {
+    if (type_mask & (1u << type_index)) count += GetCount(type_index, x, y);
+  }
+  return count;
+}
+
+uint32_t OccupancyHistogram::GetMaximum(size_t type_index) const {
+  return maxima_.empty() ? 0 : maxima_[type_index];
+}
+
+double OccupancyHistogram::GetCompleteness() const {
+  return static_cast<double>(completed_passes_) / static_cast<double>(passes_);
+}
+
+const Eigen::Vector2d &OccupancyHistogram::GetOrigin() const {
+  return origin_;
+}
+
+double OccupancyHistogram::GetCellSize() const {
+  return cell_size_;
+}
+
+size_t OccupancyHistogram::GetWidth() const {
+  return width_;
+}
+
+size_t OccupancyHistogram::GetHeight() const {
+  return height_;
+}
+
+}
@@ -0,0 +1,269 @@
+#include "dataset_converter_common/analysis/PlacementOptimizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <set>
+
+#include "dataset_converter_common/analysis/ParallelFor.h"
+
+namespace dataset_converter_common {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr size_t kMaxHistogramCellsPerAxis = 2048; ///< Histogram cells per axis before the cell size is increased
+constexpr size_t kMaxSearchCellsPerAxis = 1024; ///< Search grid cells per axis before the cell size is increased
+
+// Maps a rotation in degrees into [0, 360)
+double NormalizeRotation(double rotation) {
+  rotation = std::fmod(rotation, 360.0);
+  return rotation < 0 ? rotation + 360.0 : rotation;
+}
+
+// Smallest difference between two rotations in degrees
+double RotationDistance(double a, double b) {
+  double distance = std::fabs(NormalizeRotation(a) - NormalizeRotation(b));
+  return std::min(distance, 360.0 - distance);
+}
+
+}
+
+PlacementOptimizer::PlacementOptimizer(const cpm_scenario::ScenarioPtr &scenario,
+                                       size_t from_frame,
+                                       size_t to_frame,
+                                       double cell_size) {
+  std::vector<cpm_scenario::ExtendedObjectPtr> objects;
+  for (const auto &object : scenario->GetObjects()) {
+    objects.push_back(object);
+  }
+  auto in_range = [from_frame, to_frame](long frame) {
+    if (frame < static_cast<long>(from_frame)) return false;
+    return to_frame == 0 || frame <= static_cast<long>(to_frame);
+  };
+
+  // Bounds of the states in the frame range
+  std::vector<Eigen::AlignedBox2d> worker_bounds(NumberOfWorkers());
+  ParallelFor(objects.size(), [&](size_t worker, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      for (const auto &state : objects[i]->GetStates()) {
+        if (in_range(state.first)) worker_bounds[worker].extend(state.second->GetPosition());
+      }
+    }
+  });
+  Eigen::AlignedBox2d bounds;
+  for (const auto &box : worker_bounds) {
+    if (!box.isEmpty()) bounds.extend(box);
+  }
+  if (bounds.isEmpty()) return;
+
+  Eigen::Vector2d extent = bounds.sizes();
+  cell_size_ = std::max(cell_size, extent.maxCoeff() / static_cast<double>(kMaxHistogramCellsPerAxis));
+  auto width = static_cast<size_t>(std::floor(extent.x() / cell_size_)) + 1;
+  auto height = static_cast<size_t>(std::floor(extent.y() / cell_size_)) + 1;
+
+  // Count the states, cells are rarely hit by two workers at once
+  std::vector<std::atomic<uint32_t>> bins(width * height);
+  ParallelFor(objects.size(), [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      for (const auto &state : objects[i]->GetStates()) {
+        if (!in_range(state.first)) continue;
+        Eigen::Vector2d cell = (state.second->GetPosition() - bounds.min()) / cell_size_;
+        auto x = std::min(width - 1, static_cast<size_t>(cell.x()));
+        auto y = std::min(height - 1, static_cast<size_t>(cell.y()));
+        bins[y * width + x].fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  });
+
+  for (size_t y = 0; y < height; ++y) {
+    for (size_t x = 0; x < width; ++x) {
+      uint32_t count = bins[y * width + x].load(std::memory_order_relaxed);
+      if (count == 0) continue;
+      Eigen::Vector2d center(static_cast<double>(x) + 0.5, static_cast<double>(y) + 0.5);
+      points_.push_back({bounds.min() + center * cell_size_, count});
+      total_ += count;
+    }
+  }
+}
+
+Eigen::AlignedBox2d PlacementOptimizer::LabArea() {
+  // Export area of the scenario writer in lab meters, the visualisation flips the y axis
+  const Eigen::Vector2d area_min(0.55, 0.55);
+  const Eigen::Vector2d area_size(kLabWidth - 1.1, kLabHeight - 1.1);
+  Eigen::Vector2d min(area_min.x() * kLabScale, (kLabHeight - area_min.y() - area_size.y()) * kLabScale);
+  Eigen::Vector2d max((area_min.x() + area_size.x()) * kLabScale, (kLabHeight - area_min.y()) * kLabScale);
+  return {min, max};
+}
+
+Eigen::AlignedBox2d PlacementOptimizer::LabBounds() {
+  return {Eigen::Vector2d(0.0, 0.0), Eigen::Vector2d(kLabWidth * kLabScale, kLabHeight * kLabScale)};
+}
+
+uint64_t PlacementOptimizer::Score(const Placement &placement) const {
+  Eigen::Rotation2Dd rotation(placement.rotation * kPi / 180.0);
+  Eigen::Vector2d shift(placement.shift_x, placement.shift_y);
+  Eigen::AlignedBox2d area = LabArea();
+  uint64_t count = 0;
+  for (const auto &point : points_) {
+    if (area.contains(rotation * point.position + shift)) count += point.count;
+  }
+  return count;
+}
+
+Placement PlacementOptimizer::SearchShift(double rotation, double cell_size) const {
+  Placement placement;
+  placement.rotation = NormalizeRotation(rotation);
+  if (points_.empty()) return placement;
+
+  Eigen::Rotation2Dd transform(placement.rotation * kPi / 180.0);
+  std::vector<Eigen::Vector2d> rotated(points_.size());
+  Eigen::AlignedBox2d bounds;
+  for (size_t i = 0; i < points_.size(); ++i) {
+    rotated[i] = transform * points_[i].position;
+    bounds.extend(rotated[i]);
+  }
+  Eigen::Vector2d extent = bounds.sizes();
+  cell_size = std::max(cell_size, extent.maxCoeff() / static_cast<double>(kMaxSearchCellsPerAxis));
+  auto width = static_cast<long>(std::floor(extent.x() / cell_size)) + 1;
+  auto height = static_cast<long>(std::floor(extent.y() / cell_size)) + 1;
+
+  // Summed area table with a leading row and column of zeros
+  long stride = width + 1;
+  std::vector<uint64_t> table(static_cast<size_t>(stride * (height + 1)), 0);
+  for (size_t i = 0; i < points_.size(); ++i) {
+    Eigen::Vector2d cell = (rotated[i] - bounds.min()) / cell_size;
+    long x = std::min(width - 1, static_cast<long>(cell.x()));
+    long y = std::min(height - 1, static_cast<long>(cell.y()));
+    table[(y + 1) * stride + x + 1] += points_[i].count;
+  }
+  for (long y = 1; y <= height; ++y) {
+    for (long x = 1; x <= width; ++x) {
+      table[y * stride + x] += table[(y - 1) * stride + x] + table[y * stride + x - 1]
+          - table[(y - 1) * stride + x - 1];
+    }
+  }
+  auto sum = [&](long x0, long y0, long x1, long y1) {
+    x0 = std::clamp(x0, 0L, width);
+    x1 = std::clamp(x1, 0L, width);
+    y0 = std::clamp(y0, 0L, height);
+    y1 = std::clamp(y1, 0L, height);
+    return table[y1 * stride + x1] - table[y0 * stride + x1] - table[y1 * stride + x0] + table[y0 * stride + x0];
+  };
+
+  // The box never reaches beyond the area, cells on its border are left out
+  Eigen::AlignedBox2d area = LabArea();
+  auto box_width = std::max(1L, static_cast<long>(std::floor(area.sizes().x() / cell_size)));
+  auto box_height = std::max(1L, static_cast<long>(std::floor(area.sizes().y() / cell_size)));
+
+  // Lower corners that keep the shift within its limits and the box overlapping the grid
+  auto corner_range = [&](double area_min, double origin, long cells, long box_cells, long &lower, long &upper) {
+    long shift_lower = static_cast<long>(std::ceil((area_min - kMaxShift - origin) / cell_size));
+    long shift_upper = static_cast<long>(std::floor((area_min + kMaxShift - origin) / cell_size));
+    long useful_lower = std::min(0L, cells - box_cells);
+    long useful_upper = std::max(0L, cells - box_cells);
+    lower = std::max(shift_lower, useful_lower);
+    upper = std::min(shift_upper, useful_upper);
+    if (lower > upper) lower = upper = std::clamp(useful_lower, shift_lower, shift_upper);
+  };
+  long x_lower, x_upper, y_lower, y_upper;
+  corner_range(area.min().x(), bounds.min().x(), width, box_width, x_lower, x_upper);
+  corner_range(area.min().y(), bounds.min().y(), height, box_height, y_lower, y_upper);
+
+  long best_x = x_lower;
+  long best_y = y_lower;
+  uint64_t best = 0;
+  for (long y = y_lower; y <= y_upper; ++y) {
+    for (long x = x_lower; x <= x_upper; ++x) {
+      uint64_t count = sum(x, y, x + box_width, y + box_height);
+      if (count > best) {
+        best = count;
+        best_x = x;
+        best_y = y;
+      }
+    }
+  }
+
+  // Center the box inside the area, the area is slightly larger than the box
+  Eigen::Vector2d box_size(static_cast<double>(box_width) * cell_size, static_cast<double>(box_height) * cell_size);
+  Eigen::Vector2d slack = (area.sizes() - box_size) / 2.0;
+  Eigen::Vector2d corner = bounds.min()
+      + Eigen::Vector2d(static_cast<double>(best_x) * cell_size, static_cast<double>(best_y) * cell_size);
+  Eigen::Vector2d shift = area.min() + slack - corner;
+  placement.shift_x = std::clamp(shift.x(), -kMaxShift, kMaxShift);
+  placement.shift_y = std::clamp(shift.y(), -kMaxShift, kMaxShift);
+  placement.object_frames = best;
+  return placement;
+}
+
+std::vector<Placement> PlacementOptimizer::SearchShifts(const std::vector<double> &rotations,
+                                                        double cell_size) const {
+  std::vector<Placement> placements(rotations.size());
+  ParallelFor(rotations.size(), [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      placements[i] = SearchShift(rotations[i], cell_size);
+    }
+  });
+  return placements;
+}
+
+std::vector<Placement> PlacementOptimizer::FindBest(size_t k) const {
+  if (points_.empty() || k == 0) return {};
+
+  size_t candidates = std::max<size_t>(16, 4 * k);
+  const Level levels[] = {
+      {5.0, 360.0, 2.0, candidates},
+      {0.5, 2.5, 0.5, candidates},
+      {0.1, 0.5, cell_size_, candidates},
+  };
+
+  auto by_count = [](const Placement &a, const Placement &b) { return a.object_frames > b.object_frames; };
+  std::vector<Placement> placements;
+  for (const auto &level : levels) {
+    // Rotations around the candidates of the previous level, the first level covers the full circle
+    std::set<long> keys;
+    if (placements.empty()) {
+      for (double rotation = 0.0; rotation < level.rotation_range; rotation += level.rotation_step) {
+        keys.insert(std::lround(rotation / level.rotation_step));
+      }
+    }
+    for (const auto &placement : placements) {
+      for (double offset = -level.rotation_range; offset <= level.rotation_range + 1e-9;
+           offset += level.rotation_step) {
+        keys.insert(std::lround(NormalizeRotation(placement.rotation + offset) / level.rotation_step));
+      }
+    }
+    std::vector<double> rotations;
+    rotations.reserve(keys.size());
+    for (long key : keys) {
+      rotations.push_back(static_cast<double>(key) * level.rotation_step);
+    }
+
+    placements = SearchShifts(rotations, level.cell_size);
+    std::sort(placements.begin(), placements.end(), by_count);
+    if (placements.size() > level.candidates) placements.resize(level.candidates);
+  }
+
+  for (auto &placement : placements) {
+    placement.object_frames = Score(placement);
+  }
+  std::stable_sort(placements.begin(), placements.end(), by_count);
+
+  std::vector<Placement> best;
+  for (const auto &placement : placements) {
+    bool similar = std::any_of(best.begin(), best.end(), [&placement](const Placement &other) {
+      return std::hypot(placement.shift_x - other.shift_x, placement.shift_y - other.shift_y) < 1.0
+          && RotationDistance(placement.rotation, other.rotation) < 1.0;
+    });
+    if (similar) continue;
+    best.push_back(placement);
+    if (best.size() == k) break;
+  }
+  return best;
+}
+
+uint64_t PlacementOptimizer::GetTotal() const {
+  return total_;
+}
+
+}
@@ -0,0 +1,207 @@
+#include "dataset_converter_common/analysis/PolygonRegion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+#include "dataset_converter_common/analysis/ParallelFor.h"
+
+namespace dataset_converter_common {
+
+namespace {
+
+constexpr size_t kMaxCellsPerSide = 1024; ///< Largest number of cells along the longer side of the grid
+
+}
+
+PolygonRegion::PolygonRegion(const std::vector<std::vector<Eigen::Vector2d>> &polygons) {
+  Eigen::AlignedBox2d bounds;
+  size_t edges = 0;
+  for (const auto &polygon : polygons) {
+    if (polygon.size() < 3) continue;
+    for (const auto &vertex : polygon) {
+      bounds.extend(vertex);
+    }
+    edges += polygon.size();
+  }
+  if (edges == 0) return;
+
+  // About one edge per cell along the longer side
+  double longest = std::max(bounds.sizes().maxCoeff(), 1e-6);
+  auto cells_per_side = std::clamp<size_t>(static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(edges)))), 1,
+                                           kMaxCellsPerSide);
+  origin_ = bounds.min();
+  cell_size_ = longest / static_cast<double>(cells_per_side);
+  width_ = static_cast<size_t>(bounds.sizes().x() / cell_size_) + 1;
+  height_ = static_cast<size_t>(bounds.sizes().y() / cell_size_) + 1;
+  auto cell_x = [this](double x) {
+    return std::min(width_ - 1, static_cast<size_t>(std::max(0.0, (x - origin_.x()) / cell_size_)));
+  };
+  auto cell_y = [this](double y) {
+    return std::min(height_ - 1, static_cast<size_t>(std::max(0.0, (y - origin_.y()) / cell_size_)));
+  };
+
+  // Every edge is added to all cells its bounding box overlaps
+  std::vector<std::tuple<uint32_t, uint32_t, const Eigen::Vector2d *, const Eigen::Vector2d *>> entries;
+  for (size_t p = 0; p < polygons.size(); ++p) {
+    const auto &polygon = polygons[p];
+    if (polygon.size() < 3) continue;
+    for (size_t i = 0; i < polygon.size(); ++i) {
+      const Eigen::Vector2d &start = polygon[i];
+      const Eigen::Vector2d &end = polygon[(i + 1) % polygon.size()];
+      for (size_t y = cell_y(std::min(start.y(), end.y())); y <= cell_y(std::max(start.y(), end.y())); ++y) {
+        for (size_t x = cell_x(std::min(start.x(), end.x())); x <= cell_x(std::max(start.x(), end.x())); ++x) {
+          entries.emplace_back(static_cast<uint32_t>(y * width_ + x), static_cast<uint32_t>(p), &start, &end);
+        }
+      }
+    }
+  }
+  std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+    return std::get<0>(a) < std::get<0>(b) || (std::get<0>(a) == std::get<0>(b) && std::get<1>(a) < std::get<1>(b));
+  });
+
+  cell_begin_.assign(width_ * height_ + 1, 0);
+  covered_.assign(width_ * height_, 0);
+  start_x_.reserve(entries.size());
+  start_y_.reserve(entries.size());
+  end_x_.reserve(entries.size());
+  end_y_.reserve(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    auto [cell, polygon, start, end] = entries[i];
+    if (i == 0 || cell != std::get<0>(entries[i - 1]) || polygon != std::get<1>(entries[i - 1])) {
+      auto edge = static_cast<uint32_t>(start_x_.size());
+      groups_.push_back({polygon, false, edge, edge});
+      cell_begin_[cell + 1]++;
+    }
+    start_x_.push_back(start->x());
+    start_y_.push_back(start->y());
+    end_x_.push_back(end->x());
+    end_y_.push_back(end->y());
+    groups_.back().edge_end++;
+  }
+  for (size_t cell = 0; cell < width_ * height_; ++cell) {
+    cell_begin_[cell + 1] += cell_begin_[cell];
+  }
+
+  // Cell centers inside each polygon, row by row with the crossings of the polygon on the row
+  std::vector<double> crossings;
+  for (size_t p = 0; p < polygons.size(); ++p) {
+    const auto &polygon = polygons[p];
+    if (polygon.size() < 3) continue;
+    Eigen::AlignedBox2d polygon_bounds;
+    for (const auto &vertex : polygon) {
+      polygon_bounds.extend(vertex);
+    }
+    for (size_t y = cell_y(polygon_bounds.min().y()); y <= cell_y(polygon_bounds.max().y()); ++y) {
+      double center_y = CellCenter(0, y).y();
+      crossings.clear();
+      for (size_t i = 0; i < polygon.size(); ++i) {
+        const Eigen::Vector2d &start = polygon[i];
+        const Eigen::Vector2d &end = polygon[(i + 1) % polygon.size()];
+        if ((start.y() > center_y) == (end.y() > center_y)) continue;
+        crossings.push_back(start.x() + (center_y - start.y()) * (end.x() - start.x()) / (end.y() - start.y()));
+      }
+      std::sort(crossings.begin(), crossings.end());
+      for (size_t i = 0; i + 1 < crossings.size(); i += 2) {
+        double first = std::ceil((crossings[i] - origin_.x()) / cell_size_ - 0.5);
+        double last = std::ceil((crossings[i + 1] - origin_.x()) / cell_size_ - 0.5);
+        auto begin = static_cast<size_t>(std::clamp(first, 0.0, static_cast<double>(width_)));
+        auto end = static_cast<size_t>(std::clamp(last, 0.0, static_cast<double>(width_)));
+        for (size_t x = begin; x < end; ++x) {
+          size_t cell = y * width_ + x;
+          auto group = std::lower_bound(groups_.begin() + cell_begin_[cell], groups_.begin() + cell_begin_[cell + 1],
+                                        static_cast<uint32_t>(p),
+                                        [](const Group &group, uint32_t polygon) { return group.polygon < polygon; });
+          if (group != groups_.begin() + cell_begin_[cell + 1] && group->polygon == p) group->center_inside = true;
+          else covered_[cell] = 1;
+        }
+      }
+    }
+  }
+}
+
+Eigen::Vector2d PolygonRegion::CellCenter(size_t x, size_t y) const {
+  return origin_ + Eigen::Vector2d(static_cast<double>(x) + 0.5, static_cast<double>(y) + 0.5) * cell_size_;
+}
+
+bool PolygonRegion::Contains(const Eigen::Vector2d &point) const {
+  if (width_ == 0) return false;
+  double fx = (point.x() - origin_.x()) / cell_size_;
+  double fy = (point.y() - origin_.y()) / cell_size_;
+  if (!(fx >= 0.0 && fy >= 0.0 && fx < static_cast<double>(width_) && fy < static_cast<double>(height_))) {
+    return false;
+  }
+  auto x = static_cast<size_t>(fx);
+  auto y = static_cast<size_t>(fy);
+  size_t cell = y * width_ + x;
+  if (covered_[cell]) return true;
+
+  // The line from the center to the point stays inside the cell, so only edges of the cell can cross it
+  Eigen::Vector2d center = CellCenter(x, y);
+  double line_x = point.x() - center.x();
+  double line_y = point.y() - center.y();
+  for (uint32_t g = cell_begin_[cell]; g < cell_begin_[cell + 1]; ++g) {
+    const Group &group = groups_[g];
+    uint32_t count = 0;
+    for (uint32_t e = group.edge_begin; e < group.edge_end; ++e) {
+      double edge_x = end_x_[e] - start_x_[e];
+      double edge_y = end_y_[e] - start_y_[e];
+      bool center_side = edge_x * (center.y() - start_y_[e]) - edge_y * (center.x() - start_x_[e]) > 0.0;
+      bool point_side = edge_x * (point.y() - start_y_[e]) - edge_y * (point.x() - start_x_[e]) > 0.0;
+      bool start_side = line_x * (start_y_[e] - center.y()) - line_y * (start_x_[e] - center.x()) > 0.0;
+      bool end_side = line_x * (end_y_[e] - center.y()) - line_y * (end_x_[e] - center.x()) > 0.0;
+      count += static_cast<uint32_t>((center_side != point_side) & (start_side != end_side));
+    }
+    if (group.center_inside != ((count & 1u) != 0)) return true;
+  }
+  return false;
+}
+
+void PolygonRegion::Contains(const std::vector<Eigen::Vector2d> &points, std::vector<uint8_t> &inside) const {
+  inside.resize(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    inside[i] = Contains(points[i]) ? 1 : 0;
+  }
+}
+
+cpm_scenario::ScenarioPtr PolygonRegion::Restrict(const cpm_scenario::ScenarioPtr &scenario) const {
+  const auto &objects = scenario->GetObjects();
+
+  // Flags of the states of every object in the order of the state map
+  std::vector<std::vector<uint8_t>> inside(objects.size());
+  ParallelFor(objects.size(), [&](size_t, size_t begin, size_t end) {
+    std::vector<Eigen::Vector2d> positions;
+    for (size_t i = begin; i < end; ++i) {
+      positions.clear();
+      for (const auto &state : objects[i]->GetStates()) {
+        positions.push_back(state.second->GetPosition());
+      }
+      Contains(positions, inside[i]);
+    }
+  });
+
+  auto restricted = std::make_shared<cpm_scenario::Scenario>(scenario->GetName());
+  restricted->SetNumberOfFrames(scenario->GetNumberOfFrames());
+  restricted->SetBackgroundImageSourcePath(scenario->GetBackgroundImageSourcePath());
+  restricted->SetBackgroundImageScaleFactor(scenario->GetBackgroundImageScaleFactor());
+  for (size_t i = 0; i < objects.size(); ++i) {
+    if (std::find(inside[i].begin(), inside[i].end(), 1) == inside[i].end()) continue;
+    const auto &object = objects[i];
+    auto copy = std::make_shared<cpm_scenario::ExtendedObject>(object->GetId(),
+                                                               Eigen::Vector2d(object->GetDimension().x(),
+                                                                               object->GetDimension().y()),
+                                                               object->GetType());
+    size_t k = 0;
+    for (const auto &state : object->GetStates()) {
+      if (inside[i][k++]) copy->AddState(state.second);
+    }
+    restricted->AddObject(copy);
+  }
+  return restricted;
+}
+
+bool PolygonRegion::IsEmpty() const {
+  return width_ == 0;
+}
+
+}
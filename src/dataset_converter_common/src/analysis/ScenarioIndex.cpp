@@ -0,0 +1,322 @@
+#include "dataset_converter_common/analysis/ScenarioIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "dataset_converter_common/analysis/FrameStatistics.h"
+#include "dataset_converter_common/analysis/OccupancyHistogram.h"
+#include "dataset_converter_common/analysis/ParallelFor.h"
+
+namespace dataset_converter_common {
+
+namespace {
+
+constexpr size_t kTypes = OccupancyHistogram::kNumberOfTypes;
+constexpr char kMagic[4] = {'D', 'C', 'S', 'I'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kMaxFrames = 1u << 26; ///< Frames of a scenario before a file is considered broken
+
+// Values are written in the byte order of the host
+template<typename T>
+void Write(std::ostream &stream, const T &value) {
+  stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+void WriteVector(std::ostream &stream, const std::vector<T> &values) {
+  Write(stream, static_cast<uint64_t>(values.size()));
+  stream.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+void WriteString(std::ostream &stream, const std::string &value) {
+  Write(stream, static_cast<uint32_t>(value.size()));
+  stream.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+template<typename T>
+bool Read(std::istream &stream, T &value) {
+  return static_cast<bool>(stream.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+template<typename T>
+bool ReadVector(std::istream &stream, std::vector<T> &values, uint64_t max_size) {
+  uint64_t size = 0;
+  if (!Read(stream, size) || size > max_size) return false;
+  values.resize(size);
+  return static_cast<bool>(stream.read(reinterpret_cast<char *>(values.data()),
+                                       static_cast<std::streamsize>(size * sizeof(T))));
+}
+
+bool ReadString(std::istream &stream, std::string &value) {
+  uint32_t size = 0;
+  if (!Read(stream, size) || size > 4096) return false;
+  value.resize(size);
+  return static_cast<bool>(stream.read(&value[0], size));
+}
+
+}
+
+void ScenarioIndex::Add(const std::string &dataset, const cpm_scenario::ScenarioPtr &scenario,
+                        double frames_per_second) {
+  Entry entry;
+  entry.dataset = dataset;
+  entry.scenario = scenario->GetName();
+  entry.frames_per_second = frames_per_second;
+
+  long first_frame = std::numeric_limits<long>::max();
+  long last_frame = std::numeric_limits<long>::min();
+  for (const auto &object : scenario->GetObjects()) {
+    if (object->GetStates().empty()) continue;
+    first_frame = std::min(first_frame, static_cast<long>(object->GetStates().begin()->first));
+    last_frame = std::max(last_frame, static_cast<long>(object->GetStates().rbegin()->first));
+  }
+  if (first_frame <= last_frame) {
+    entry.first_frame = first_frame;
+    entry.frames = static_cast<uint32_t>(std::min<long>(last_frame - first_frame + 1, kMaxFrames));
+  }
+  entry.present.assign(static_cast<size_t>(entry.frames) * kTypes, 0);
+
+  for (const auto &object : scenario->GetObjects()) {
+    if (object->GetStates().empty()) continue;
+    ObjectSpan span;
+    span.type_index = static_cast<uint8_t>(OccupancyHistogram::TypeIndex(object->GetType()));
+    span.first = std::numeric_limits<uint32_t>::max();
+    for (const auto &state : object->GetStates()) {
+      long offset = static_cast<long>(state.first) - entry.first_frame;
+      if (offset < 0 || offset >= static_cast<long>(entry.frames)) continue;
+      auto frame = static_cast<uint32_t>(offset);
+      span.first = std::min(span.first, frame);
+      span.last = std::max(span.last, frame);
+      uint16_t &present = entry.present[frame * kTypes + span.type_index];
+      if (present < std::numeric_limits<uint16_t>::max()) present++;
+      if (state.second->GetVelocity().norm() <= kMovingSpeed) continue;
+      if (!span.moving) span.first_moving = frame;
+      span.last_moving = frame;
+      span.moving = true;
+    }
+    if (span.first != std::numeric_limits<uint32_t>::max()) entry.objects.push_back(span);
+  }
+  BuildSums(entry);
+
+  auto existing = std::find_if(entries_.begin(), entries_.end(), [&entry](const Entry &other) {
+    return other.dataset == entry.dataset && other.scenario == entry.scenario;
+  });
+  if (existing != entries_.end()) *existing = std::move(entry);
+  else entries_.push_back(std::move(entry));
+}
+
+void ScenarioIndex::BuildSums(Entry &entry) {
+  size_t size = (static_cast<size_t>(entry.frames) + 1) * kTypes;
+  entry.started.assign(size, 0);
+  entry.ended.assign(size, 0);
+  entry.started_moving.assign(size, 0);
+  entry.ended_moving.assign(size, 0);
+
+  // Count every span at the frame it starts or ends, then sum up
+  for (const auto &span : entry.objects) {
+    entry.started[(span.first + 1) * kTypes + span.type_index]++;
+    entry.ended[(span.last + 1) * kTypes + span.type_index]++;
+    if (!span.moving) continue;
+    entry.started_moving[(span.first_moving + 1) * kTypes + span.type_index]++;
+    entry.ended_moving[(span.last_moving + 1) * kTypes + span.type_index]++;
+  }
+  for (size_t i = kTypes; i < size; ++i) {
+    entry.started[i] += entry.started[i - kTypes];
+    entry.ended[i] += entry.ended[i - kTypes];
+    entry.started_moving[i] += entry.started_moving[i - kTypes];
+    entry.ended_moving[i] += entry.ended_moving[i - kTypes];
+  }
+}
+
+bool ScenarioIndex::Save(const std::string &file_path) const {
+  std::ofstream stream(file_path, std::ios::binary | std::ios::trunc);
+  if (!stream) return false;
+
+  stream.write(kMagic, sizeof(kMagic));
+  Write(stream, kVersion);
+  Write(stream, static_cast<uint32_t>(entries_.size()));
+  for (const auto &entry : entries_) {
+    WriteString(stream, entry.dataset);
+    WriteString(stream, entry.scenario);
+    Write(stream, entry.frames_per_second);
+    Write(stream, static_cast<int64_t>(entry.first_frame));
+    Write(stream, entry.frames);
+    WriteVector(stream, entry.present);
+    Write(stream, static_cast<uint64_t>(entry.objects.size()));
+    for (const auto &span : entry.objects) {
+      Write(stream, span.type_index);
+      Write(stream, static_cast<uint8_t>(span.moving));
+      Write(stream, span.first);
+      Write(stream, span.last);
+      Write(stream, span.first_moving);
+      Write(stream, span.last_moving);
+    }
+  }
+  return static_cast<bool>(stream.flush());
+}
+
+bool ScenarioIndex::Load(const std::string &file_path) {
+  entries_.clear();
+  std::ifstream stream(file_path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  uint32_t version = 0;
+  uint32_t scenarios = 0;
+  if (!stream.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kMagic)) return false;
+  if (!Read(stream, version) || version != kVersion || !Read(stream, scenarios)) return false;
+
+  std::vector<Entry> entries;
+  for (uint32_t scenario = 0; scenario < scenarios; ++scenario) {
+    Entry entry;
+    int64_t first_frame = 0;
+    uint64_t objects = 0;
+    if (!ReadString(stream, entry.dataset) || !ReadString(stream, entry.scenario)) return false;
+    if (!Read(stream, entry.frames_per_second) || !Read(stream, first_frame) || !Read(stream, entry.frames)) {
+      return false;
+    }
+    if (entry.frames > kMaxFrames || !ReadVector(stream, entry.present, static_cast<uint64_t>(entry.frames) * kTypes)
+        || entry.present.size() != static_cast<size_t>(entry.frames) * kTypes || !Read(stream, objects)) {
+      return false;
+    }
+    entry.first_frame = static_cast<long>(first_frame);
+
+    for (uint64_t i = 0; i < objects; ++i) {
+      ObjectSpan span;
+      uint8_t moving = 0;
+      if (!Read(stream, span.type_index) || !Read(stream, moving) || !Read(stream, span.first)
+          || !Read(stream, span.last) || !Read(stream, span.first_moving) || !Read(stream, span.last_moving)) {
+        return false;
+      }
+      span.moving = moving != 0;
+      if (span.type_index >= kTypes || span.first > span.last || span.last >= entry.frames) return false;
+      if (span.moving && (span.first_moving > span.last_moving || span.last_moving >= entry.frames)) return false;
+      entry.objects.push_back(span);
+    }
+    BuildSums(entry);
+    entries.push_back(std::move(entry));
+  }
+  entries_ = std::move(entries);
+  return true;
+}
+
+std::vector<IndexMatch> ScenarioIndex::Search(const Entry &entry,
+                                              double window_seconds,
+                                              const std::vector<IndexCondition> &conditions) {
+  std::vector<IndexMatch> matches;
+  auto length = static_cast<size_t>(std::max(1L, std::lround(window_seconds * entry.frames_per_second)));
+  if (length > entry.frames) return matches;
+  size_t windows = entry.frames - length + 1;
+
+  // Smallest number of objects present at once of every window, with a monotone queue over the frames
+  std::vector<std::vector<uint32_t>> minima(conditions.size());
+  for (size_t c = 0; c < conditions.size(); ++c) {
+    if (conditions[c].measure != IndexCondition::Measure::kMinimum) continue;
+    auto present = [&](size_t frame) {
+      uint32_t count = 0;
+      for (size_t type = 0; type < kTypes; ++type) {
+        if (conditions[c].type_mask & (1u << type)) count += entry.present[frame * kTypes + type];
+      }
+      return count;
+    };
+    minima[c].resize(windows);
+    std::deque<std::pair<size_t, uint32_t>> queue;
+    for (size_t frame = 0; frame < entry.frames; ++frame) {
+      uint32_t count = present(frame);
+      while (!queue.empty() && queue.back().second >= count) queue.pop_back();
+      queue.emplace_back(frame, count);
+      if (queue.front().first + length <= frame) queue.pop_front();
+      if (frame + 1 >= length) minima[c][frame + 1 - length] = queue.front().second;
+    }
+  }
+
+  // Objects of a window [begin, end) are those started before end minus those ended before begin
+  auto count = [&](const IndexCondition &condition, size_t begin, size_t end) {
+    bool moving = condition.measure == IndexCondition::Measure::kMoving;
+    const auto &started = moving ? entry.started_moving : entry.started;
+    const auto &ended = moving ? entry.ended_moving : entry.ended;
+    uint32_t objects = 0;
+    for (size_t type = 0; type < kTypes; ++type) {
+      if (condition.type_mask & (1u << type)) objects += started[end * kTypes + type] - ended[begin * kTypes + type];
+    }
+    return objects;
+  };
+
+  for (size_t begin = 0; begin < windows;) {
+    bool match = true;
+    for (size_t c = 0; c < conditions.size() && match; ++c) {
+      uint32_t objects = conditions[c].measure == IndexCondition::Measure::kMinimum
+          ? minima[c][begin] : count(conditions[c], begin, begin + length);
+      match = objects >= conditions[c].min_count;
+    }
+    if (!match) {
+      begin++;
+      continue;
+    }
+    matches.push_back({entry.dataset, entry.scenario, entry.first_frame + static_cast<long>(begin),
+                       entry.first_frame + static_cast<long>(begin + length) - 1, entry.frames_per_second});
+    begin += length;
+  }
+  return matches;
+}
+
+std::vector<IndexMatch> ScenarioIndex::Query(double window_seconds,
+                                             const std::vector<IndexCondition> &conditions) const {
+  std::vector<std::vector<IndexMatch>> scenario_matches(entries_.size());
+  ParallelFor(entries_.size(), [&](size_t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      scenario_matches[i] = Search(entries_[i], window_seconds, conditions);
+    }
+  });
+
+  std::vector<IndexMatch> matches;
+  for (auto &found : scenario_matches) {
+    matches.insert(matches.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+  }
+  return matches;
+}
+
+bool ScenarioIndex::ParseCondition(const std::string &text, IndexCondition &condition) {
+  std::vector<std::string> parts;
+  std::stringstream stream(text);
+  std::string part;
+  while (std::getline(stream, part, ':')) {
+    parts.push_back(part);
+  }
+  if (parts.size() != 3) return false;
+
+  condition.type_mask = 0;
+  std::stringstream types(parts[0]);
+  std::string type;
+  while (std::getline(types, type, '+')) {
+    if (type == "car") condition.type_mask |= 1u << 0;
+    else if (type == "pedestrian") condition.type_mask |= 1u << 1;
+    else if (type == "bicycle") condition.type_mask |= 1u << 2;
+    else if (type == "truck_bus") condition.type_mask |= 1u << 3;
+    else if (type == "van") condition.type_mask |= 1u << 4;
+    else if (type == "trailer") condition.type_mask |= 1u << 5;
+    else if (type == "unknown") condition.type_mask |= 1u << 6;
+    else if (type == "vehicle") condition.type_mask |= FrameCounts::kVehicleTypes;
+    else if (type == "any") condition.type_mask |= OccupancyHistogram::kAllTypes;
+    else return false;
+  }
+
+  if (parts[1] == "distinct") condition.measure = IndexCondition::Measure::kDistinct;
+  else if (parts[1] == "moving") condition.measure = IndexCondition::Measure::kMoving;
+  else if (parts[1] == "minimum") condition.measure = IndexCondition::Measure::kMinimum;
+  else return false;
+
+  if (parts[2].empty() || parts[2].size() > 9 || parts[2].find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  condition.min_count = static_cast<uint32_t>(std::stoul(parts[2]));
+  return true;
+}
+
+size_t ScenarioIndex::GetNumberOfScenarios() const {
+  return entries_.size();
+}
+
+}
@@ -0,0 +1,227 @@
+#include "dataset_converter_common/analysis/TrajectorySmoother.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Dense>
+
+#include "dataset_converter_common/analysis/ParallelFor.h"
+
+namespace dataset_converter_common {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+}
+
+TrajectorySmoother::TrajectorySmoother(double window_duration) : window_duration_(window_duration) {}
+
+TrajectorySmoother::Kernel TrajectorySmoother::MakeKernel(size_t size) {
+  Kernel kernel;
+  kernel.size = size;
+  kernel.value.resize(size * size);
+  kernel.slope.resize(size * size);
+
+  // Least squares fit of a polynomial in the frame offset to the samples of the window, evaluated at every position
+  Eigen::MatrixXd vandermonde(size, kOrder + 1);
+  for (size_t position = 0; position < size; ++position) {
+    for (size_t k = 0; k < size; ++k) {
+      double offset = static_cast<double>(k) - static_cast<double>(position);
+      for (size_t power = 0; power <= kOrder; ++power) {
+        vandermonde(static_cast<Eigen::Index>(k), static_cast<Eigen::Index>(power)) = std::pow(offset, power);
+      }
+    }
+    Eigen::MatrixXd fit = (vandermonde.transpose() * vandermonde).ldlt().solve(vandermonde.transpose());
+    for (size_t k = 0; k < size; ++k) {
+      kernel.value[position * size + k] = fit(0, static_cast<Eigen::Index>(k));
+      kernel.slope[position * size + k] = fit(1, static_cast<Eigen::Index>(k));
+    }
+  }
+  return kernel;
+}
+
+void TrajectorySmoother::Filter(const Kernel &kernel, size_t begin, size_t end, Buffers &buffers) {
+  size_t size = kernel.size;
+  size_t half = size / 2;
+  const double *x = buffers.x.data();
+  const double *y = buffers.y.data();
+  double *smooth_x = buffers.smooth_x.data();
+  double *smooth_y = buffers.smooth_y.data();
+  double *velocity_x = buffers.velocity_x.data();
+  double *velocity_y = buffers.velocity_y.data();
+
+  // Interior states with the window centered on them, one pass per coefficient over the contiguous arrays
+  size_t interior_begin = begin + half;
+  size_t interior_end = end - (size - 1 - half);
+  std::fill(smooth_x + interior_begin, smooth_x + interior_end, 0.0);
+  std::fill(smooth_y + interior_begin, smooth_y + interior_end, 0.0);
+  std::fill(velocity_x + interior_begin, velocity_x + interior_end, 0.0);
+  std::fill(velocity_y + interior_begin, velocity_y + interior_end, 0.0);
+  std::fill(buffers.centered.begin() + static_cast<long>(begin), buffers.centered.begin() + static_cast<long>(end), 0);
+  std::fill(buffers.centered.begin() + static_cast<long>(interior_begin),
+            buffers.centered.begin() + static_cast<long>(interior_end), 1);
+  const double *value = kernel.value.data() + half * size;
+  const double *slope = kernel.slope.data() + half * size;
+  size_t interior = interior_end - interior_begin;
+  for (size_t k = 0; k < size; ++k) {
+    double value_k = value[k];
+    double slope_k = slope[k];
+    const double *window_x = x + begin + k;
+    const double *window_y = y + begin + k;
+    double *out_x = smooth_x + interior_begin;
+    double *out_y = smooth_y + interior_begin;
+    double *out_velocity_x = velocity_x + interior_begin;
+    double *out_velocity_y = velocity_y + interior_begin;
+    for (size_t i = 0; i < interior; ++i) {
+      out_x[i] += value_k * window_x[i];
+      out_y[i] += value_k * window_y[i];
+      out_velocity_x[i] += slope_k * window_x[i];
+      out_velocity_y[i] += slope_k * window_y[i];
+    }
+  }
+
+  // States at both ends use the window at the end of the run
+  auto evaluate = [&](size_t i, size_t window_begin) {
+    const double *value = kernel.value.data() + (i - window_begin) * size;
+    const double *slope = kernel.slope.data() + (i - window_begin) * size;
+    double sx = 0.0, sy = 0.0, vx = 0.0, vy = 0.0;
+    for (size_t k = 0; k < size; ++k) {
+      sx += value[k] * x[window_begin + k];
+      sy += value[k] * y[window_begin + k];
+      vx += slope[k] * x[window_begin + k];
+      vy += slope[k] * y[window_begin + k];
+    }
+    smooth_x[i] = sx;
+    smooth_y[i] = sy;
+    velocity_x[i] = vx;
+    velocity_y[i] = vy;
+  };
+  for (size_t i = begin; i < interior_begin; ++i) {
+    evaluate(i, begin);
+  }
+  for (size_t i = interior_end; i < end; ++i) {
+    evaluate(i, end - size);
+  }
+}
+
+void TrajectorySmoother::SmoothObject(const cpm_scenario::ExtendedObject &object,
+                                      const std::vector<Kernel> &kernels,
+                                      double frames_per_second,
+                                      Buffers &buffers) {
+  const auto &states = object.GetStates();
+  size_t count = states.size();
+  if (count == 0) return;
+  buffers.x.resize(count);
+  buffers.y.resize(count);
+  buffers.smooth_x.resize(count);
+  buffers.smooth_y.resize(count);
+  buffers.velocity_x.resize(count);
+  buffers.velocity_y.resize(count);
+  buffers.centered.assign(count, 1);
+
+  // Recorded values are kept for runs too short to fit
+  size_t i = 0;
+  for (const auto &state : states) {
+    buffers.x[i] = buffers.smooth_x[i] = state.second->GetPosition().x();
+    buffers.y[i] = buffers.smooth_y[i] = state.second->GetPosition().y();
+    buffers.velocity_x[i] = state.second->GetVelocity().x() / frames_per_second;
+    buffers.velocity_y[i] = state.second->GetVelocity().y() / frames_per_second;
+    ++i;
+  }
+
+  // Runs of consecutive frames are filtered separately, a gap would distort the fit
+  auto filter_run = [&](size_t begin, size_t end) {
+    if (end - begin <= kOrder) return;
+    Filter(kernels[std::min(end - begin, kernels.size() - 1)], begin, end, buffers);
+  };
+  size_t begin = 0;
+  long last_frame = 0;
+  i = 0;
+  for (const auto &state : states) {
+    long frame = static_cast<long>(state.first);
+    if (i > 0 && frame != last_frame + 1) {
+      filter_run(begin, i);
+      begin = i;
+    }
+    last_frame = frame;
+    ++i;
+  }
+  filter_run(begin, count);
+
+  // States before the first one with a heading take its heading, the recorded orientation is kept if there is none
+  bool reversible = object.GetType() != cpm_scenario::ExtendedObjectType::PEDESTRIAN
+      && object.GetType() != cpm_scenario::ExtendedObjectType::BICYCLE_MOTORCYCLES;
+  double min_speed = kMinHeadingSpeed / frames_per_second;
+  auto has_heading = [&](size_t i) {
+    return buffers.centered[i] && std::hypot(buffers.velocity_x[i], buffers.velocity_y[i]) >= min_speed;
+  };
+  auto heading = [&](size_t i, double recorded) {
+    double orientation = std::atan2(buffers.velocity_y[i], buffers.velocity_x[i]);
+    if (reversible && std::cos(orientation - recorded) < 0.0) orientation += kPi;
+    return std::remainder(orientation, 2.0 * kPi);
+  };
+  bool moving = false;
+  double orientation = 0.0;
+  i = 0;
+  for (const auto &state : states) {
+    if (has_heading(i)) {
+      orientation = heading(i, state.second->GetOrientation());
+      moving = true;
+      break;
+    }
+    ++i;
+  }
+
+  i = 0;
+  for (const auto &state : states) {
+    if (moving && has_heading(i)) orientation = heading(i, state.second->GetOrientation());
+    state.second->SetPosition({buffers.smooth_x[i], buffers.smooth_y[i]});
+    state.second->SetVelocity({buffers.velocity_x[i] * frames_per_second, buffers.velocity_y[i] * frames_per_second});
+    if (moving) state.second->SetOrientation(orientation);
+    ++i;
+  }
+}
+
+void TrajectorySmoother::Smooth(const cpm_scenario::ScenarioPtr &scenario, double frames_per_second) const {
+  if (frames_per_second <= 0.0) return;
+
+  // Odd number of frames so the window is centered on the smoothed state
+  auto size = static_cast<size_t>(std::lround(window_duration_ * frames_per_second)) | 1u;
+  if (size <= kOrder) return;
+
+  // Runs shorter than the window are fitted over the whole run, the kernel of every occurring length is made once
+  const auto &objects = scenario->GetObjects();
+  std::vector<Kernel> kernels(size + 1);
+  kernels[size] = MakeKernel(size);
+  auto make_kernel = [&](size_t run) {
+    if (run > kOrder && run < size && kernels[run].size == 0) kernels[run] = MakeKernel(run);
+  };
+  for (const auto &object : objects) {
+    size_t run = 0;
+    long last_frame = 0;
+    for (const auto &state : object->GetStates()) {
+      long frame = static_cast<long>(state.first);
+      if (run > 0 && frame != last_frame + 1) {
+        make_kernel(run);
+        run = 0;
+      }
+      last_frame = frame;
+      ++run;
+    }
+    make_kernel(run);
+  }
+
+  ParallelFor(objects.size(), [&](size_t, size_t begin, size_t end) {
+    Buffers buffers;
+    for (size_t i = begin; i < end; ++i) {
+      SmoothObject(*objects[i], kernels, frames_per_second, buffers);
+    }
+  });
+}
+
+double TrajectorySmoother::GetWindowDuration() const {
+  return window_duration_;
+}
+
+}
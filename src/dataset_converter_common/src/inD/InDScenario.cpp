@@ -116,4 +116,8 @@ void InDScenario::Parse(const std::string &dataset_root_directory) {
   this->ParserTrackFile();
 }
 
+double InDScenario::GetFramesPerSecond() const {
+  return FRAMES_PER_SECOND;
+}
+
 }
\ No newline at end of file
@@ -122,4 +122,8 @@ void RounDScenario::Parse(const std::string &dataset_root_directory) {
   this->ParserTrackFile();
 }
 
+double RounDScenario::GetFramesPerSecond() const {
+  return FRAMES_PER_SECOND;
+}
+
 }
\ No newline at end of file